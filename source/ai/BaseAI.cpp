@@ -424,13 +424,13 @@ bool BaseAI::digWayToTile(Tile* tileStart, Tile* tileEnd)
     if (worker == nullptr)
         return false;
 
-    std::list<Tile*> pathToDig = mGameMap.path(tileEnd, tileStart, worker, seat, true);
+    std::vector<Tile*> pathToDig = mGameMap.path(tileEnd, tileStart, worker, seat, true);
     if (pathToDig.empty())
         return false;
 
     // We search for the first reachable tile in the list
     bool isPathFound = false;
-    for(std::list<Tile*>::iterator it = pathToDig.begin(); it != pathToDig.end();)
+    for(std::vector<Tile*>::iterator it = pathToDig.begin(); it != pathToDig.end();)
     {
         Tile* tile = *it;
         if(!isPathFound &&
@@ -82,6 +82,7 @@ bool KeeperAI::doTurn(double timeSinceLastTurn)
     if(!mIsFirstUpkeepDone)
     {
         mIsFirstUpkeepDone = true;
+        mRandom = Random::createStream(Random::Subsystem::keeperAI, static_cast<uint64_t>(mPlayer.getSeat()->getId()));
         handleFirstTurn();
     }
 
@@ -122,7 +123,7 @@ bool KeeperAI::checkTreasury()
         --mCooldownCheckTreasury;
         return false;
     }
-    mCooldownCheckTreasury = Random::Int(10,30);
+    mCooldownCheckTreasury = mRandom.Int(10,30);
 
     int totalGold = 0;
     int totalStorage = 0;
@@ -289,7 +290,7 @@ bool KeeperAI::handleRooms()
         return false;
     }
 
-    mCooldownLookingForRooms = Random::Int(mCooldownLookingForRoomsMin, mCooldownLookingForRoomsMax);
+    mCooldownLookingForRooms = mRandom.Int(mCooldownLookingForRoomsMin, mCooldownLookingForRoomsMax);
 
     // We check if the last built room is done
     if(mRoomSize != -1)
@@ -366,7 +367,7 @@ bool KeeperAI::lookForGold()
         return false;
     }
 
-    mCooldownLookingForGold = Random::Int(70,120);
+    mCooldownLookingForGold = mRandom.Int(70,120);
 
     // Do we need gold ?
     int emptyStorage = 0;
@@ -399,7 +400,7 @@ bool KeeperAI::lookForGold()
             {
                 // If we already have a tile at same distance, we randomly change to
                 // try to not be too predictable
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // North-West
@@ -408,7 +409,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - k, central->getY() + distance);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -416,7 +417,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() + k, central->getY() - distance);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // South-West
@@ -425,7 +426,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - k, central->getY() - distance);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -433,7 +434,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() + distance, central->getY() + k);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // East-South
@@ -442,7 +443,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() + distance, central->getY() - k);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -450,7 +451,7 @@ bool KeeperAI::lookForGold()
             t = mGameMap.getTile(central->getX() - distance, central->getY() + k);
             if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
             {
-                if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                     firstGoldTile = t;
             }
             // West-South
@@ -459,7 +460,7 @@ bool KeeperAI::lookForGold()
                 t = mGameMap.getTile(central->getX() - distance, central->getY() - k);
                 if(t != nullptr && t->getType() == TileType::gold && t->getFullness() > 0.0)
                 {
-                    if((firstGoldTile == nullptr) || (Random::Uint(1,2) == 1))
+                    if((firstGoldTile == nullptr) || (mRandom.Uint(1,2) == 1))
                         firstGoldTile = t;
                 }
             }
@@ -607,7 +608,7 @@ void KeeperAI::saveWoundedCreatures()
         --mCooldownSaveWoundedCreatures;
         return;
     }
-    mCooldownSaveWoundedCreatures = Random::Int(mCooldownSaveWoundedCreaturesMin, mCooldownSaveWoundedCreaturesMax);
+    mCooldownSaveWoundedCreatures = mRandom.Int(mCooldownSaveWoundedCreaturesMin, mCooldownSaveWoundedCreaturesMax);
 
     Tile* dungeonTempleTile = getDungeonTemple()->getCentralTile();
     if(dungeonTempleTile == nullptr)
@@ -650,7 +651,7 @@ void KeeperAI::handleDefense()
         --mCooldownDefense;
         return;
     }
-    mCooldownDefense = Random::Int(mCooldownDefenseMin, mCooldownDefenseMax);
+    mCooldownDefense = mRandom.Int(mCooldownDefenseMin, mCooldownDefenseMax);
 
     Seat* seat = mPlayer.getSeat();
     // We drop creatures nearby owned or allied attacked creatures
@@ -706,7 +707,7 @@ bool KeeperAI::handleWorkers()
         return false;
     }
 
-    mCooldownWorkers = Random::Int(3,10);
+    mCooldownWorkers = mRandom.Int(3,10);
 
     // We want to use the first covered tile because the central might be destroyed and enemy claimed
     // and, if it is the case, we will not be able to spawn a worker.
@@ -719,7 +720,7 @@ bool KeeperAI::handleWorkers()
     // If we have less than 4 workers or we have the chance, we summon
     int nbWorkers = mPlayer.getSeat()->getNumCreaturesWorkers();
     if((nbWorkers < 4) ||
-       (Random::Int(0, nbWorkers * 3) == 0))
+       (mRandom.Int(0, nbWorkers * 3) == 0))
     {
         Tile* tile = getDungeonTemple()->getCoveredTile(0);
         std::vector<Tile*> tiles;
@@ -741,7 +742,7 @@ bool KeeperAI::repairRooms()
         return false;
     }
 
-    mCooldownRepairRooms = Random::Int(20,60);
+    mCooldownRepairRooms = mRandom.Int(20,60);
 
     Seat* seat = mPlayer.getSeat();
     for(Room* room : mGameMap.getRooms())
@@ -19,6 +19,7 @@
 #define KEEPERAI_H
 
 #include "ai/BaseAI.h"
+#include "utils/Random.h"
 
 enum class RoomType;
 
@@ -102,6 +103,9 @@ private:
     int mCooldownSaveWoundedCreaturesMin;
     int mCooldownSaveWoundedCreaturesMax;
     bool mIsFirstUpkeepDone;
+
+    //! \brief Random stream of the seat, created at the first upkeep
+    RandomStream mRandom;
 };
 
 #endif // KEEPERAI_H
@@ -87,6 +87,17 @@ public:
     //! to call the expected action from CreatureAction with the good parameters.
     virtual std::function<bool()> action() = 0;
 
+    //! \brief Returns true if the action searches tiles in an order that can be prepared (see prepareSearchOrder)
+    virtual bool hasSearchOrder() const
+    { return false; }
+
+    //! \brief Called for the current action of every creature before the upkeep to sort the tiles the
+    //! action will search (see TileSearchOrder). The creatures are processed in parallel so it should only
+    //! write into the action and only read what the upkeep cannot change (like tile positions). It only
+    //! makes action() faster: action() should give the same result whether it has been called or not.
+    virtual void prepareSearchOrder()
+    {}
+
     //! \brief Returns the mood value modifier that should be applied to the creature
     //! when this action is in its list. The value should be used as defined
     //! in CreatureMoodValues
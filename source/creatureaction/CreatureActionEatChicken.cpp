@@ -83,7 +83,7 @@ bool CreatureActionEatChicken::handleEatChicken(Creature& creature, ChickenEntit
     if(dist > 1)
     {
         // We walk to the chicken
-        std::list<Tile*> pathToChicken = creature.getGameMap()->path(&creature, chickenTile);
+        std::vector<Tile*> pathToChicken = creature.getGameMap()->path(&creature, chickenTile);
         if(pathToChicken.empty())
         {
             OD_LOG_ERR("creature=" + creature.getName() + " posTile=" + Tile::displayAsString(myTile) + " empty path to chicken tile=" + Tile::displayAsString(chickenTile));
@@ -109,7 +109,7 @@ bool CreatureActionEatChicken::handleEatChicken(Creature& creature, ChickenEntit
     // We can eat the chicken
     chicken->eatChicken(&creature);
     creature.foodEaten(ConfigManager::getSingleton().getRoomConfigDouble("HatcheryHungerPerChicken"));
-    creature.setJobCooldown(Random::Int(ConfigManager::getSingleton().getRoomConfigUInt32("HatcheryCooldownChickenMin"),
+    creature.setJobCooldown(creature.getRandom().Int(ConfigManager::getSingleton().getRoomConfigUInt32("HatcheryCooldownChickenMin"),
         ConfigManager::getSingleton().getRoomConfigUInt32("HatcheryCooldownChickenMax")));
     creature.setHP(creature.getHP() + ConfigManager::getSingleton().getRoomConfigDouble("HatcheryHpRecoveredPerChicken"));
     creature.computeCreatureOverlayHealthValue();
@@ -144,7 +144,7 @@ bool CreatureActionFight::handleFight(Creature& creature, GameEntity* entityAtta
             }
 
             // We need to move
-            std::list<Tile*> result = creature.getGameMap()->path(&creature, tilePosition);
+            std::vector<Tile*> result = creature.getGameMap()->path(&creature, tilePosition);
             if(result.empty())
             {
                 OD_LOG_ERR("name=" + creature.getName() + ", myTile=" + Tile::displayAsString(myTile) + ", dest=" + Tile::displayAsString(tilePosition));
@@ -181,7 +181,7 @@ bool CreatureActionFight::handleFight(Creature& creature, GameEntity* entityAtta
             }
 
             // We need to move to the entity
-            std::list<Tile*> result = creature.getGameMap()->path(&creature, tilePosition);
+            std::vector<Tile*> result = creature.getGameMap()->path(&creature, tilePosition);
             if(result.empty())
             {
                 OD_LOG_ERR("name" + creature.getName() + ", myTile=" + Tile::displayAsString(myTile) + ", dest=" + Tile::displayAsString(tilePosition));
@@ -79,7 +79,7 @@ bool CreatureActionLeaveDungeon::handleLeaveDungeon(Creature& creature)
 
     creature.fireChatMsgLeavingDungeon();
 
-    int index = Random::Int(0, tempRooms.size() - 1);
+    int index = creature.getRandom().Int(0, tempRooms.size() - 1);
     Room* room = tempRooms[index];
     Tile* tile = room->getCentralTile();
     if(!creature.setDestination(tile))
@@ -149,7 +149,7 @@ bool CreatureActionSearchEntityToCarry::handleSearchEntityToCarry(Creature& crea
     }
 
     // We randomly choose one of the visible carryable entities
-    uint32_t index = Random::Uint(0,availableEntities.size()-1);
+    uint32_t index = creature.getRandom().Uint(0,availableEntities.size()-1);
     GameEntity* entity = availableEntities[index];
     creature.pushAction(Utils::make_unique<CreatureActionGrabEntity>(creature, *entity));
     return true;
@@ -144,7 +144,7 @@ bool CreatureActionSearchFood::handleSearchFood(Creature& creature, bool forced)
     }
 
     Tile* chosenTile = nullptr;
-    std::list<Tile*> pathToHatchery = creature.getGameMap()->findBestPath(&creature, myTile, hatcheriesTiles, chosenTile);
+    std::vector<Tile*> pathToHatchery = creature.getGameMap()->findBestPathToSharedDests(&creature, myTile, hatcheriesTiles, chosenTile);
     if(chosenTile == nullptr)
     {
         // We couldn't find a path !
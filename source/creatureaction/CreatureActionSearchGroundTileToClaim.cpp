@@ -43,10 +43,16 @@ CreatureActionSearchGroundTileToClaim::~CreatureActionSearchGroundTileToClaim()
 std::function<bool()> CreatureActionSearchGroundTileToClaim::action()
 {
     return std::bind(&CreatureActionSearchGroundTileToClaim::handleSearchGroundTileToClaim,
-        std::ref(mCreature), getNbTurns(), mForced);
+        std::ref(mCreature), getNbTurns(), mForced, std::cref(mSearchOrder));
 }
 
-bool CreatureActionSearchGroundTileToClaim::handleSearchGroundTileToClaim(Creature& creature, int32_t nbTurns, bool forced)
+void CreatureActionSearchGroundTileToClaim::prepareSearchOrder()
+{
+    mCreature.computeTileSearchOrder(mSearchOrder, false);
+}
+
+bool CreatureActionSearchGroundTileToClaim::handleSearchGroundTileToClaim(Creature& creature, int32_t nbTurns, bool forced,
+    const TileSearchOrder<Tile>& searchOrder)
 {
     if(creature.getClaimRate() <= 0.0)
         return false;
@@ -126,39 +132,36 @@ bool CreatureActionSearchGroundTileToClaim::handleSearchGroundTileToClaim(Creatu
     }
 
     // If we still haven't found a tile to claim, we try to take the closest one
-    float distBest = -1;
     Tile* tileToClaim = nullptr;
-    for (Tile* tile : creature.getTilesWithinSightRadius())
+    if(creature.isTileSearchOrderValid(searchOrder))
     {
-        // if this tile is not fully claimed yet or the tile is of another player's color
-        if(tile == nullptr)
-            continue;
-        if(tile->isFullTile())
-            continue;
-        if(!tile->isGroundClaimable(creature.getSeat()))
-            continue;
-        if(!creature.getGameMap()->pathExists(&creature, myTile, tile))
-            continue;
-        if(!tile->canWorkerClaim(creature))
-            continue;
-
-        float dist = Pathfinding::squaredDistanceTile(*myTile, *tile);
-        if((distBest != -1) && (distBest <= dist))
-            continue;
+        // The tiles are sorted by distance so the first matching one is the closest
+        for(const TileSearchOrder<Tile>::Candidate& candidate : searchOrder.getCandidates())
+        {
+            if(!isGroundTileToClaim(creature, *myTile, *candidate.mTile))
+                continue;
 
-        // Check to see if one of the tile's neighbors is claimed for our color
-        for (Tile* neigh : tile->getAllNeighbors())
+            tileToClaim = candidate.mTile;
+            break;
+        }
+    }
+    else
+    {
+        float distBest = -1;
+        for (Tile* tile : creature.getTilesWithinSightRadius())
         {
-            if(neigh->isFullTile())
+            if(tile == nullptr)
                 continue;
-            if(!neigh->isClaimedForSeat(creature.getSeat()))
+
+            float dist = Pathfinding::squaredDistanceTile(*myTile, *tile);
+            if((distBest != -1) && (distBest <= dist))
                 continue;
-            if(neigh->getClaimedPercentage() < 1.0)
+
+            if(!isGroundTileToClaim(creature, *myTile, *tile))
                 continue;
 
             distBest = dist;
             tileToClaim = tile;
-            break;
         }
     }
 
@@ -174,3 +177,31 @@ bool CreatureActionSearchGroundTileToClaim::handleSearchGroundTileToClaim(Creatu
     creature.popAction();
     return true;
 }
+
+bool CreatureActionSearchGroundTileToClaim::isGroundTileToClaim(Creature& creature, Tile& myTile, Tile& tile)
+{
+    // if this tile is not fully claimed yet or the tile is of another player's color
+    if(tile.isFullTile())
+        return false;
+    if(!tile.isGroundClaimable(creature.getSeat()))
+        return false;
+    if(!creature.getGameMap()->pathExists(&creature, &myTile, &tile))
+        return false;
+    if(!tile.canWorkerClaim(creature))
+        return false;
+
+    // Check to see if one of the tile's neighbors is claimed for our color
+    for (Tile* neigh : tile.getAllNeighbors())
+    {
+        if(neigh->isFullTile())
+            continue;
+        if(!neigh->isClaimedForSeat(creature.getSeat()))
+            continue;
+        if(neigh->getClaimedPercentage() < 1.0)
+            continue;
+
+        return true;
+    }
+
+    return false;
+}
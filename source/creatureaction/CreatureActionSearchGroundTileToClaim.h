@@ -19,6 +19,9 @@
 #define CREATUREACTIONSEARCHGROUNDTILETOCLAIM_H
 
 #include "creatureaction/CreatureAction.h"
+#include "gamemap/TileSearchOrder.h"
+
+class Tile;
 
 class CreatureActionSearchGroundTileToClaim : public CreatureAction
 {
@@ -31,10 +34,20 @@ public:
 
     std::function<bool()> action() override;
 
-    static bool handleSearchGroundTileToClaim(Creature& creature, int32_t nbTurns, bool forced);
+    bool hasSearchOrder() const override
+    { return true; }
+
+    void prepareSearchOrder() override;
+
+    static bool handleSearchGroundTileToClaim(Creature& creature, int32_t nbTurns, bool forced,
+        const TileSearchOrder<Tile>& searchOrder);
 
 private:
     bool mForced;
+    TileSearchOrder<Tile> mSearchOrder;
+
+    //! \brief Returns true if the worker can go to tile and claim it
+    static bool isGroundTileToClaim(Creature& creature, Tile& myTile, Tile& tile);
 };
 
 #endif // CREATUREACTIONSEARCHGROUNDTILETOCLAIM_H
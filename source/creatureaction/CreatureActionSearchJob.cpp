@@ -57,7 +57,7 @@ bool CreatureActionSearchJob::handleSearchJob(Creature& creature, bool forced)
         case CreatureMoodLevel::Upset:
         {
             // 20% chances of not working
-            if(Random::Int(0, 100) < 20)
+            if(creature.getRandom().Int(0, 100) < 20)
             {
                 creature.popAction();
                 return true;
@@ -151,7 +151,7 @@ bool CreatureActionSearchJob::handleSearchJob(Creature& creature, bool forced)
             if((affinity.getEfficiency() <= 0) ||
                (room->getType() == RoomType::hatchery))
             {
-                int index = Random::Int(0, room->numCoveredTiles() - 1);
+                int index = creature.getRandom().Int(0, room->numCoveredTiles() - 1);
                 Tile* tileDest = room->getCoveredTile(index);
                 creature.setDestination(tileDest);
                 return false;
@@ -194,7 +194,7 @@ bool CreatureActionSearchJob::handleSearchJob(Creature& creature, bool forced)
             continue;
 
         Tile* chosenTile = nullptr;
-        std::list<Tile*> tilePath = creature.getGameMap()->findBestPath(&creature, myTile, rooms, chosenTile);
+        std::vector<Tile*> tilePath = creature.getGameMap()->findBestPathToSharedDests(&creature, myTile, rooms, chosenTile);
 
         if(tilePath.empty() || (chosenTile == nullptr))
             continue;
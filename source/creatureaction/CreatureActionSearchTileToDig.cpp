@@ -46,10 +46,16 @@ CreatureActionSearchTileToDig::~CreatureActionSearchTileToDig()
 std::function<bool()> CreatureActionSearchTileToDig::action()
 {
     return std::bind(&CreatureActionSearchTileToDig::handleSearchTileToDig,
-        std::ref(mCreature), getNbTurns(), mForced);
+        std::ref(mCreature), getNbTurns(), mForced, std::cref(mSearchOrder));
 }
 
-bool CreatureActionSearchTileToDig::handleSearchTileToDig(Creature& creature, int32_t nbTurns, bool forced)
+void CreatureActionSearchTileToDig::prepareSearchOrder()
+{
+    mCreature.computeTileSearchOrder(mSearchOrder, true);
+}
+
+bool CreatureActionSearchTileToDig::handleSearchTileToDig(Creature& creature, int32_t nbTurns, bool forced,
+    const TileSearchOrder<Tile>& searchOrder)
 {
     if(creature.getDigRate() <= 0.0)
         return false;
@@ -109,34 +115,52 @@ bool CreatureActionSearchTileToDig::handleSearchTileToDig(Creature& creature, in
     }
 
     // Find the closest tile to dig
-    float distBest = -1;
     Tile* tileToDig = nullptr;
     Tile* tilePos = nullptr;
-    for (Tile* tile : creature.getTilesWithinSightRadius())
+    if(creature.isTileSearchOrderValid(searchOrder))
     {
-        // Check to see whether the tile is marked for digging
-        if(!tile->getMarkedForDigging(tempPlayer))
-            continue;
-
-        // and there is still room to work on it
-        std::vector<Tile*> tiles;
-        tile->canWorkerDig(creature, tiles);
-        if(tiles.empty())
-            continue;
+        // The neighbors are sorted by distance so the first one a marked tile can be dug from is the closest
+        for(const TileSearchOrder<Tile>::Candidate& candidate : searchOrder.getCandidates())
+        {
+            if(!candidate.mTile->getMarkedForDigging(tempPlayer))
+                continue;
+            if(!candidate.mTile->canWorkerDigFrom(creature, static_cast<uint32_t>(candidate.mNeighborIndex)))
+                continue;
 
-        // We search for the closest neighbor tile
-        for (Tile* neighborTile : tiles)
+            tileToDig = candidate.mTile;
+            tilePos = candidate.mTarget;
+            break;
+        }
+    }
+    else
+    {
+        float distBest = -1;
+        for (Tile* tile : creature.getTilesWithinSightRadius())
         {
-            if (!creature.getGameMap()->pathExists(&creature, myTile, neighborTile))
+            // Check to see whether the tile is marked for digging
+            if(!tile->getMarkedForDigging(tempPlayer))
                 continue;
 
-            float dist = Pathfinding::squaredDistanceTile(*myTile, *neighborTile);
-            if((distBest != -1) && (distBest <= dist))
+            // and there is still room to work on it
+            std::vector<Tile*> tiles;
+            tile->canWorkerDig(creature, tiles);
+            if(tiles.empty())
                 continue;
 
-            distBest = dist;
-            tileToDig = tile;
-            tilePos = neighborTile;
+            // We search for the closest neighbor tile
+            for (Tile* neighborTile : tiles)
+            {
+                if (!creature.getGameMap()->pathExists(&creature, myTile, neighborTile))
+                    continue;
+
+                float dist = Pathfinding::squaredDistanceTile(*myTile, *neighborTile);
+                if((distBest != -1) && (distBest <= dist))
+                    continue;
+
+                distBest = dist;
+                tileToDig = tile;
+                tilePos = neighborTile;
+            }
         }
     }
 
@@ -19,6 +19,9 @@
 #define CREATUREACTIONSEARCHTILETODIG_H
 
 #include "creatureaction/CreatureAction.h"
+#include "gamemap/TileSearchOrder.h"
+
+class Tile;
 
 class CreatureActionSearchTileToDig : public CreatureAction
 {
@@ -31,10 +34,18 @@ public:
 
     std::function<bool()> action() override;
 
-    static bool handleSearchTileToDig(Creature& creature, int32_t nbTurns, bool forced);
+    bool hasSearchOrder() const override
+    { return true; }
+
+    void prepareSearchOrder() override;
+
+    static bool handleSearchTileToDig(Creature& creature, int32_t nbTurns, bool forced,
+        const TileSearchOrder<Tile>& searchOrder);
 
 private:
     bool mForced;
+    //! \brief Tiles are dug from one of their neighbors so the order is computed for them
+    TileSearchOrder<Tile> mSearchOrder;
 };
 
 #endif // CREATUREACTIONSEARCHTILETODIG_H
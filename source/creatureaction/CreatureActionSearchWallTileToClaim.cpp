@@ -42,10 +42,16 @@ CreatureActionSearchWallTileToClaim::~CreatureActionSearchWallTileToClaim()
 std::function<bool()> CreatureActionSearchWallTileToClaim::action()
 {
     return std::bind(&CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim,
-        std::ref(mCreature), getNbTurns(), mForced);
+        std::ref(mCreature), getNbTurns(), mForced, std::cref(mSearchOrder));
 }
 
-bool CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim(Creature& creature, int32_t nbTurns, bool forced)
+void CreatureActionSearchWallTileToClaim::prepareSearchOrder()
+{
+    mCreature.computeTileSearchOrder(mSearchOrder, true);
+}
+
+bool CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim(Creature& creature, int32_t nbTurns, bool forced,
+    const TileSearchOrder<Tile>& searchOrder)
 {
     if(creature.getClaimRate() <= 0.0)
         return false;
@@ -70,14 +76,9 @@ bool CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim(Creature&
     }
 
     // See if any of the tiles is one of our neighbors
-    Player* tempPlayer = creature.getSeat()->getPlayer();
     for (Tile* tile : myTile->getAllNeighbors())
     {
-        if (tile->getMarkedForDigging(tempPlayer))
-            continue;
-        if (!tile->isWallClaimable(creature.getSeat()))
-            continue;
-        if (!tile->canWorkerClaim(creature))
+        if (!isWallTileToClaim(creature, *tile))
             continue;
 
         creature.pushAction(Utils::make_unique<CreatureActionClaimWallTile>(creature, *tile));
@@ -85,30 +86,43 @@ bool CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim(Creature&
     }
 
     // Find paths to all of the neighbor tiles for all of the visible wall tiles.
-    float distBest = -1;
     Tile* tileToClaim = nullptr;
-    for(Tile* tile : creature.getTilesWithinSightRadius())
+    if(creature.isTileSearchOrderValid(searchOrder))
     {
-        // Check to see whether the tile is a claimable wall
-        if(tile->getMarkedForDigging(tempPlayer))
-            continue;
-        if(!tile->isWallClaimable(creature.getSeat()))
-            continue;
-        if (!tile->canWorkerClaim(creature))
-            continue;
-
-        // and can be reached by the creature
-        for(Tile* neigh : tile->getAllNeighbors())
+        // The neighbors are sorted by distance so the first reachable one of a claimable wall is the closest
+        for(const TileSearchOrder<Tile>::Candidate& candidate : searchOrder.getCandidates())
         {
-            if(!creature.getGameMap()->pathExists(&creature, myTile, neigh))
+            if(!isWallTileToClaim(creature, *candidate.mTile))
+                continue;
+            if(!creature.getGameMap()->pathExists(&creature, myTile, candidate.mTarget))
                 continue;
 
-            float dist = Pathfinding::squaredDistanceTile(*myTile, *neigh);
-            if((distBest != -1) && (distBest <= dist))
+            tileToClaim = candidate.mTile;
+            break;
+        }
+    }
+    else
+    {
+        float distBest = -1;
+        for(Tile* tile : creature.getTilesWithinSightRadius())
+        {
+            // Check to see whether the tile is a claimable wall
+            if(!isWallTileToClaim(creature, *tile))
                 continue;
 
-            distBest = dist;
-            tileToClaim = tile;
+            // and can be reached by the creature
+            for(Tile* neigh : tile->getAllNeighbors())
+            {
+                if(!creature.getGameMap()->pathExists(&creature, myTile, neigh))
+                    continue;
+
+                float dist = Pathfinding::squaredDistanceTile(*myTile, *neigh);
+                if((distBest != -1) && (distBest <= dist))
+                    continue;
+
+                distBest = dist;
+                tileToClaim = tile;
+            }
         }
     }
 
@@ -123,3 +137,15 @@ bool CreatureActionSearchWallTileToClaim::handleSearchWallTileToClaim(Creature&
     creature.popAction();
     return true;
 }
+
+bool CreatureActionSearchWallTileToClaim::isWallTileToClaim(Creature& creature, Tile& tile)
+{
+    if(tile.getMarkedForDigging(creature.getSeat()->getPlayer()))
+        return false;
+    if(!tile.isWallClaimable(creature.getSeat()))
+        return false;
+    if(!tile.canWorkerClaim(creature))
+        return false;
+
+    return true;
+}
@@ -19,6 +19,9 @@
 #define CREATUREACTIONSEARCHWALLTILETOCLAIM_H
 
 #include "creatureaction/CreatureAction.h"
+#include "gamemap/TileSearchOrder.h"
+
+class Tile;
 
 class CreatureActionSearchWallTileToClaim : public CreatureAction
 {
@@ -31,10 +34,20 @@ public:
 
     std::function<bool()> action() override;
 
-    static bool handleSearchWallTileToClaim(Creature& creature, int32_t nbTurns, bool forced);
+    bool hasSearchOrder() const override
+    { return true; }
+
+    void prepareSearchOrder() override;
+
+    static bool handleSearchWallTileToClaim(Creature& creature, int32_t nbTurns, bool forced,
+        const TileSearchOrder<Tile>& searchOrder);
 
 private:
     bool mForced;
+    //! \brief Claimed walls are reached from one of their neighbors so the order is computed for them
+    TileSearchOrder<Tile> mSearchOrder;
+
+    static bool isWallTileToClaim(Creature& creature, Tile& tile);
 };
 
 #endif // CREATUREACTIONSEARCHWALLTILETOCLAIM_H
@@ -63,7 +63,7 @@ bool CreatureBehaviourAttackEnemy::processBehaviour(Creature& creature) const
         case CreatureMoodLevel::Angry:
         case CreatureMoodLevel::Furious:
         {
-            if(Random::Int(0,100) > 80)
+            if(creature.getRandom().Int(0,100) > 80)
             {
                 creature.flee();
                 return false;
@@ -67,7 +67,7 @@ bool CreatureBehaviourEngageNaturalEnemy::processBehaviour(Creature& creature) c
     if(creature.getMoodValue() < CreatureMoodLevel::Upset)
         return true;
 
-    if(Random::Int(0, 100) < 80)
+    if(creature.getRandom().Int(0, 100) < 80)
         return true;
 
     // If the creature is already fighting, it should not engage another creature
@@ -95,7 +95,7 @@ bool CreatureBehaviourEngageNaturalEnemy::processBehaviour(Creature& creature) c
     if(alliedNaturalEnemies.empty())
         return true;
 
-    uint32_t index = Random::Uint(0, alliedNaturalEnemies.size() - 1);
+    uint32_t index = creature.getRandom().Uint(0, alliedNaturalEnemies.size() - 1);
     Creature& target = *alliedNaturalEnemies.at(index);
     creature.engageAlliedNaturalEnemy(target);
     target.engageAlliedNaturalEnemy(creature);
@@ -18,6 +18,7 @@
 #include "entities/Building.h"
 
 #include "entities/BuildingObject.h"
+#include "entities/Creature.h"
 #include "entities/RenderedMovableEntity.h"
 #include "entities/Tile.h"
 #include "game/Player.h"
@@ -30,6 +31,25 @@
 
 const double Building::DEFAULT_TILE_HP = 10.0;
 
+bool TilePositionLess::operator()(const Tile* tile1, const Tile* tile2) const
+{
+    if((tile1 == nullptr) || (tile2 == nullptr))
+        return (tile1 == nullptr) && (tile2 != nullptr);
+
+    if(tile1->getY() != tile2->getY())
+        return tile1->getY() < tile2->getY();
+
+    return tile1->getX() < tile2->getX();
+}
+
+bool CreatureNameLess::operator()(const Creature* creature1, const Creature* creature2) const
+{
+    if((creature1 == nullptr) || (creature2 == nullptr))
+        return (creature1 == nullptr) && (creature2 != nullptr);
+
+    return creature1->getName() < creature2->getName();
+}
+
 Building::~Building()
 {
     for(std::pair<Tile* const, TileData*>& p : mTileData)
@@ -246,7 +266,7 @@ double Building::getHP(Tile *tile) const
 {
     if (tile != nullptr)
     {
-        std::map<Tile*, TileData*>::const_iterator tileSearched = mTileData.find(tile);
+        std::map<Tile*, TileData*, TilePositionLess>::const_iterator tileSearched = mTileData.find(tile);
         if(tileSearched == mTileData.end())
         {
             OD_LOG_ERR("couldn't find requested tile=" + Tile::displayAsString(tile));
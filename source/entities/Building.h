@@ -26,6 +26,7 @@
 #include "entities/GameEntity.h"
 
 class BuildingObject;
+class Creature;
 class GameMap;
 class Tile;
 class Room;
@@ -55,6 +56,20 @@ public:
     std::vector<Seat*> mSeatsVision;
 };
 
+//! \brief Orders tiles by position. Used by the maps of building tiles so that iterating over them
+//! does not depend on where the tiles are in memory
+struct TilePositionLess
+{
+    bool operator()(const Tile* tile1, const Tile* tile2) const;
+};
+
+//! \brief Orders creatures by name. Used by the maps of the creatures using a room so that the
+//! creature picked first does not depend on where the creatures are in memory
+struct CreatureNameLess
+{
+    bool operator()(const Creature* creature1, const Creature* creature2) const;
+};
+
 /*! \class Building
  *  \brief This class holds elements that are common to Building like Rooms or Traps
  *
@@ -198,10 +213,10 @@ protected:
     void fireRemoveEntity(Seat* seat) override
     {}
 
-    std::map<Tile*, BuildingObject*> mBuildingObjects;
+    std::map<Tile*, BuildingObject*, TilePositionLess> mBuildingObjects;
     std::vector<Tile*> mCoveredTiles;
     std::vector<Tile*> mCoveredTilesDestroyed;
-    std::map<Tile*, TileData*> mTileData;
+    std::map<Tile*, TileData*, TilePositionLess> mTileData;
 };
 
 #endif // BUILDING_H_
@@ -127,11 +127,13 @@ void BuildingObject::fireRefresh()
         const std::string& name = getName();
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::entitiesRefresh, seat->getPlayer());
+        serverNotification->setCoalescingKey(name);
         uint32_t nb = 1;
         GameEntityType entityType = getObjectType();
         serverNotification->mPacket << nb;
+        uint32_t nameId = ODServer::getSingleton().internString(name);
         serverNotification->mPacket << entityType;
-        serverNotification->mPacket << name;
+        serverNotification->mPacket << nameId;
         exportToPacketForUpdate(serverNotification->mPacket, seat);
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
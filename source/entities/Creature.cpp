@@ -98,6 +98,18 @@
 
 static const Ogre::Real CANNON_MISSILE_HEIGHT = 0.3;
 
+//! \brief Values sent by Creature::exportUpdateToPacket. Only the ones that changed are sent
+namespace CreatureUpdateFields
+{
+    const uint32_t Level = 0x0001;
+    const uint32_t Seat = 0x0002;
+    const uint32_t OverlayHealth = 0x0004;
+    const uint32_t OverlayMood = 0x0008;
+    const uint32_t Speeds = 0x0010;
+    const uint32_t SeatPrison = 0x0020;
+    const uint32_t All = Level | Seat | OverlayHealth | OverlayMood | Speeds | SeatPrison;
+}
+
 const int32_t Creature::NB_TURNS_BEFORE_CHECKING_TASK = 15;
 const uint32_t Creature::NB_OVERLAY_HEALTH_VALUES = 8;
 
@@ -160,6 +172,10 @@ Creature::Creature(GameMap* gameMap, const CreatureDefinition* definition, Seat*
     mWeaponDropDeath         ("none"),
     mStatsWindow             (nullptr),
     mNbTurnsWithoutBattle    (0),
+    mVisibleTilesCenter      (nullptr),
+    mVisibleTilesRadius      (0),
+    mTilesInSightVersion     (0),
+    mVisionUpdate            (VisionUpdate::none),
     mCarriedEntity           (nullptr),
     mMoodCooldownTurns       (0),
     mMoodValue               (CreatureMoodLevel::Neutral),
@@ -239,6 +255,10 @@ Creature::Creature(GameMap* gameMap) :
     mWeaponDropDeath         ("none"),
     mStatsWindow             (nullptr),
     mNbTurnsWithoutBattle    (0),
+    mVisibleTilesCenter      (nullptr),
+    mVisibleTilesRadius      (0),
+    mTilesInSightVersion     (0),
+    mVisionUpdate            (VisionUpdate::none),
     mCarriedEntity           (nullptr),
     mMoodCooldownTurns       (0),
     mMoodValue               (CreatureMoodLevel::Neutral),
@@ -325,6 +345,7 @@ void Creature::addToGameMap()
     if(!getIsOnServerMap())
         return;
 
+    mRandom = Random::createStream(Random::Subsystem::creature, getName());
     getGameMap()->addActiveObject(this);
 }
 
@@ -339,6 +360,8 @@ void Creature::removeFromGameMap()
     if(!getIsOnServerMap())
         return;
 
+    getGameMap()->getVisionMap().clearVision(mVisionContribution);
+
     // If the creature has a homeTile where it sleeps, its bed needs to be destroyed.
     if (getHomeTile() != nullptr)
     {
@@ -680,27 +703,82 @@ void Creature::update(Ogre::Real timeSinceLastFrame)
     }
 }
 
-void Creature::computeVisibleTiles()
+void Creature::prepareSearchOrder()
 {
-    // dead Creatures do not give vision
-    if (getHP() <= 0.0)
+    if(mActions.empty())
         return;
 
-    // KO Creatures do not give vision
-    if (isKo())
+    CreatureAction* action = mActions.back().get();
+    if(!action->hasSearchOrder())
         return;
 
+    action->prepareSearchOrder();
+}
+
+void Creature::computeVisibleTiles(TileContainer::SightWorkspace& workspace)
+{
+    const VisionMap& visionMap = getGameMap()->getVisionMap();
+    Tile* posTile = getPositionTile();
+
+    // dead Creatures do not give vision
+    // KO Creatures do not give vision
     // creatures in jail do not give vision
-    if (mSeatPrison != nullptr)
+    if ((getHP() <= 0.0) ||
+        isKo() ||
+        (mSeatPrison != nullptr) ||
+        !getIsOnMap() ||
+        (posTile == nullptr))
+    {
+        mVisionUpdate = VisionUpdate::clear;
         return;
+    }
 
-    if (!getIsOnMap())
+    mVisionUpdate = VisionUpdate::none;
+    int sightRadius = mDefinition->getSightRadius();
+    if (!visionMap.needsUpdate(mVisionContribution, getSeat(), posTile, sightRadius))
         return;
 
     // Look at the surrounding area
-    updateTilesInSight();
-    for(Tile* tile : mVisibleTiles)
-        tile->notifyVision(getSeat());
+    updateTilesInSight(workspace);
+    mVisionUpdate = VisionUpdate::set;
+}
+
+void Creature::updateVision()
+{
+    VisionMap& visionMap = getGameMap()->getVisionMap();
+    switch(mVisionUpdate)
+    {
+        case VisionUpdate::none:
+            break;
+        case VisionUpdate::clear:
+            visionMap.clearVision(mVisionContribution);
+            break;
+        case VisionUpdate::set:
+            visionMap.setVision(mVisionContribution, getSeat(), mVisibleTilesCenter, mVisibleTilesRadius, mVisibleTiles);
+            break;
+        default:
+            OD_LOG_ERR("creature=" + getName() + ", unexpected vision update=" + Helper::toString(static_cast<int>(mVisionUpdate)));
+            break;
+    }
+    mVisionUpdate = VisionUpdate::none;
+}
+
+void Creature::computeTileSearchOrder(TileSearchOrder<Tile>& order, bool withNeighbors) const
+{
+    Tile* posTile = getPositionTile();
+    if(posTile == nullptr)
+        return;
+
+    if(isTileSearchOrderValid(order))
+        return;
+
+    order.compute(posTile, mTilesWithinSightRadius, mTilesInSightVersion, withNeighbors);
+}
+
+bool Creature::isTileSearchOrderValid(const TileSearchOrder<Tile>& order) const
+{
+    // The tiles in sight are computed from the position tile but the creature may have moved since
+    return (mVisibleTilesCenter == getPositionTile()) && order.isValid(mVisibleTilesCenter, mTilesInSightVersion);
 }
 
 void Creature::setLevel(unsigned int level)
@@ -915,7 +993,7 @@ void Creature::doUpkeep()
     {
         computeMood();
         computeCreatureOverlayMoodValue();
-        mMoodCooldownTurns = Random::Int(0, 5);
+        mMoodCooldownTurns = mRandom.Int(0, 5);
     }
 
     if(mMoodValue < CreatureMoodLevel::Furious)
@@ -1094,10 +1172,12 @@ bool Creature::handleIdleAction()
         if(!reachableCallToWars.empty())
         {
             // We go there
-            uint32_t index = Random::Uint(0,reachableCallToWars.size()-1);
+            uint32_t index = mRandom.Uint(0,reachableCallToWars.size()-1);
             Spell* callToWar = reachableCallToWars[index];
-            Tile* callToWarTile = callToWar->getPositionTile();
-            std::list<Tile*> tempPath = getGameMap()->path(this, callToWarTile);
+            // Every creature answering the call heads to the same tile so they share the same flow field
+            std::vector<Tile*> callToWarTiles(1, callToWar->getPositionTile());
+            Tile* callToWarTile = nullptr;
+            std::vector<Tile*> tempPath = getGameMap()->findBestPathToSharedDests(this, getPositionTile(), callToWarTiles, callToWarTile);
             // If we are 5 tiles from the call to war, we don't go there
             if(tempPath.size() >= 5)
             {
@@ -1115,7 +1195,7 @@ bool Creature::handleIdleAction()
     if (!mDefinition->isWorker() &&
         !hasActionBeenTried(CreatureActionType::findHome) &&
         (mHomeTile == nullptr) &&
-        (Random::Double(0.0, 1.0) < 0.5))
+        (mRandom.Double(0.0, 1.0) < 0.5))
     {
         pushAction(Utils::make_unique<CreatureActionFindHome>(*this, false));
         return true;
@@ -1125,7 +1205,7 @@ bool Creature::handleIdleAction()
     if (!mDefinition->isWorker() &&
         !hasActionBeenTried(CreatureActionType::sleep) &&
         (mHomeTile != nullptr) &&
-        (Random::Double(20.0, 30.0) > mWakefulness))
+        (mRandom.Double(20.0, 30.0) > mWakefulness))
     {
         pushAction(Utils::make_unique<CreatureActionSleep>(*this));
         return true;
@@ -1134,7 +1214,7 @@ bool Creature::handleIdleAction()
     // If we are hungry, we go to eat
     if (!mDefinition->isWorker() &&
         !hasActionBeenTried(CreatureActionType::searchFood) &&
-        (Random::Double(70.0, 80.0) < mHunger))
+        (mRandom.Double(70.0, 80.0) < mHunger))
     {
         pushAction(Utils::make_unique<CreatureActionSearchFood>(*this, false));
         return true;
@@ -1145,7 +1225,7 @@ bool Creature::handleIdleAction()
     // creatures more likely to steal gold than others
     if (!mDefinition->isWorker() &&
         !hasActionBeenTried(CreatureActionType::stealFreeGold) &&
-        (Random::Uint(0, 10) > 8))
+        (mRandom.Uint(0, 10) > 8))
     {
         pushAction(Utils::make_unique<CreatureActionStealFreeGold>(*this));
         return true;
@@ -1154,7 +1234,7 @@ bool Creature::handleIdleAction()
     // Otherwise, we try to work
     if (!mDefinition->isWorker() &&
         !hasActionBeenTried(CreatureActionType::searchJob) &&
-        (Random::Double(0.0, 1.0) < 0.4))
+        (mRandom.Double(0.0, 1.0) < 0.4))
     {
         pushAction(Utils::make_unique<CreatureActionSearchJob>(*this, false));
         return true;
@@ -1177,7 +1257,7 @@ bool Creature::handleIdleAction()
         // Non-workers only.
 
         // Check to see if we want to try to follow a worker around or if we want to try to explore.
-        double r = Random::Double(0.0, 1.0);
+        double r = mRandom.Double(0.0, 1.0);
         if (r < 0.7)
         {
             bool workerFound = false;
@@ -1194,18 +1274,18 @@ bool Creature::handleIdleAction()
                     {
                         // Worker is digging, get near it since it could expose enemies.
                         int x = static_cast<int>(static_cast<double>(tempTile->getX()) + 3.0
-                                * Random::gaussianRandomDouble());
+                                * mRandom.gaussianRandomDouble());
                         int y = static_cast<int>(static_cast<double>(tempTile->getY()) + 3.0
-                                * Random::gaussianRandomDouble());
+                                * mRandom.gaussianRandomDouble());
                         tileDest = getGameMap()->getTile(x, y);
                     }
                     else
                     {
                         // Worker is not digging, wander a bit farther around the worker.
                         int x = static_cast<int>(static_cast<double>(tempTile->getX()) + 8.0
-                                * Random::gaussianRandomDouble());
+                                * mRandom.gaussianRandomDouble());
                         int y = static_cast<int>(static_cast<double>(tempTile->getY()) + 8.0
-                                * Random::gaussianRandomDouble());
+                                * mRandom.gaussianRandomDouble());
                         tileDest = getGameMap()->getTile(x, y);
                     }
                     workerFound = true;
@@ -1216,7 +1296,7 @@ bool Creature::handleIdleAction()
                 {
                     if (!reachableTiles.empty())
                     {
-                        tileDest = reachableTiles[static_cast<unsigned int>(Random::Double(0.6, 0.8)
+                        tileDest = reachableTiles[static_cast<unsigned int>(mRandom.Double(0.6, 0.8)
                                                                            * (reachableTiles.size() - 1))];
                     }
                 }
@@ -1228,7 +1308,7 @@ bool Creature::handleIdleAction()
             if (!reachableTiles.empty())
             {
                 unsigned int tileIndex = static_cast<unsigned int>(reachableTiles.size()
-                                                                   * Random::Double(0.1, 0.3));
+                                                                   * mRandom.Double(0.1, 0.3));
                 tileDest = reachableTiles[tileIndex];
             }
         }
@@ -1240,7 +1320,7 @@ bool Creature::handleIdleAction()
         // Choose a tile far away from our current position to wander to.
         if (!reachableTiles.empty())
         {
-            tileDest = reachableTiles[Random::Uint(reachableTiles.size() / 2,
+            tileDest = reachableTiles[mRandom.Uint(reachableTiles.size() / 2,
                                                    reachableTiles.size() - 1)];
         }
     }
@@ -1346,7 +1426,7 @@ bool Creature::searchBestTargetInList(const std::vector<GameEntity*>& listObject
         int bestScoreAttack = -1;
         std::vector<Tile*> tiles;
         if(tilesFilter.empty())
-            tiles = getGameMap()->visibleTiles(tileAttackCheck->getX(), tileAttackCheck->getY(), skillRangeMaxInt);
+            getGameMap()->visibleTiles(tileAttackCheck->getX(), tileAttackCheck->getY(), skillRangeMaxInt, tiles);
         else
         {
             float radiusSquared = skillRangeMaxInt * skillRangeMaxInt;
@@ -1402,7 +1482,7 @@ bool Creature::searchBestTargetInList(const std::vector<GameEntity*>& listObject
         Tile* fleeTile = nullptr;
         std::vector<Tile*> tiles;
         if(tilesFilter.empty())
-            tiles = getGameMap()->visibleTiles(tileEntityFlee->getX(), tileEntityFlee->getY(), fightIdleDist);
+            getGameMap()->visibleTiles(tileEntityFlee->getX(), tileEntityFlee->getY(), fightIdleDist, tiles);
         else
         {
             float radiusSquared = fightIdleDist * fightIdleDist;
@@ -1564,56 +1644,114 @@ void Creature::checkLevelUp()
 }
 
 void Creature::exportToPacketForUpdate(ODPacket& os, const Seat* seat) const
+{
+    // Without previous state, every value is exported
+    UpdateState state;
+    exportUpdateToPacket(os, seat, state);
+}
+
+void Creature::exportUpdateToPacket(ODPacket& os, const Seat* seat, UpdateState& lastState) const
 {
     MovableGameEntity::exportToPacketForUpdate(os, seat);
 
-    int seatId = getSeat()->getId();
-    os << mLevel;
-    os << seatId;
-    os << mOverlayHealthValue;
+    UpdateState state;
+    state.mIsSent = true;
+    state.mLevel = mLevel;
+    state.mSeatId = getSeat()->getId();
+    state.mOverlayHealthValue = mOverlayHealthValue;
 
     // Only allied players should see creature mood (except some states)
-    uint32_t moodValue = 0;
     if(seat->isAlliedSeat(getSeat()))
-        moodValue = mOverlayMoodValue;
+        state.mOverlayMoodValue = mOverlayMoodValue;
     else if(mSeatPrison != nullptr)
     {
         if(mSeatPrison->isAlliedSeat(seat))
-            moodValue = mOverlayMoodValue & CreatureMoodValues::MoodPrisonFiltersPrisonAllies;
+            state.mOverlayMoodValue = mOverlayMoodValue & CreatureMoodValues::MoodPrisonFiltersPrisonAllies;
         else
-            moodValue = mOverlayMoodValue & CreatureMoodValues::MoodPrisonFiltersAllPlayers;
+            state.mOverlayMoodValue = mOverlayMoodValue & CreatureMoodValues::MoodPrisonFiltersAllPlayers;
     }
 
-    os << moodValue;
-    os << mGroundSpeed;
-    os << mWaterSpeed;
-    os << mLavaSpeed;
-    os << mSpeedModifier;
-
-    int seatPrisonId = -1;
+    state.mGroundSpeed = mGroundSpeed;
+    state.mWaterSpeed = mWaterSpeed;
+    state.mLavaSpeed = mLavaSpeed;
+    state.mSpeedModifier = mSpeedModifier;
     if(mSeatPrison != nullptr)
-        seatPrisonId = mSeatPrison->getId();
+        state.mSeatPrisonId = mSeatPrison->getId();
+
+    uint32_t fields = CreatureUpdateFields::All;
+    if(lastState.mIsSent)
+    {
+        fields = 0;
+        if(state.mLevel != lastState.mLevel)
+            fields |= CreatureUpdateFields::Level;
+        if(state.mSeatId != lastState.mSeatId)
+            fields |= CreatureUpdateFields::Seat;
+        if(state.mOverlayHealthValue != lastState.mOverlayHealthValue)
+            fields |= CreatureUpdateFields::OverlayHealth;
+        if(state.mOverlayMoodValue != lastState.mOverlayMoodValue)
+            fields |= CreatureUpdateFields::OverlayMood;
+        if((state.mGroundSpeed != lastState.mGroundSpeed) ||
+           (state.mWaterSpeed != lastState.mWaterSpeed) ||
+           (state.mLavaSpeed != lastState.mLavaSpeed) ||
+           (state.mSpeedModifier != lastState.mSpeedModifier))
+        {
+            fields |= CreatureUpdateFields::Speeds;
+        }
+        if(state.mSeatPrisonId != lastState.mSeatPrisonId)
+            fields |= CreatureUpdateFields::SeatPrison;
+    }
 
-    os << seatPrisonId;
+    os.writeVarUInt(fields);
+    if((fields & CreatureUpdateFields::Level) != 0)
+        os.writeVarUInt(state.mLevel);
+    if((fields & CreatureUpdateFields::Seat) != 0)
+        os.writeVarInt(state.mSeatId);
+    if((fields & CreatureUpdateFields::OverlayHealth) != 0)
+        os.writeVarUInt(state.mOverlayHealthValue);
+    if((fields & CreatureUpdateFields::OverlayMood) != 0)
+        os.writeVarUInt(state.mOverlayMoodValue);
+    if((fields & CreatureUpdateFields::Speeds) != 0)
+        os << state.mGroundSpeed << state.mWaterSpeed << state.mLavaSpeed << state.mSpeedModifier;
+    if((fields & CreatureUpdateFields::SeatPrison) != 0)
+        os.writeVarInt(state.mSeatPrisonId);
+
+    lastState = state;
 }
 
 void Creature::updateFromPacket(ODPacket& is)
 {
     MovableGameEntity::updateFromPacket(is);
 
-    int seatId;
-    OD_ASSERT_TRUE(is >> mLevel);
-    OD_ASSERT_TRUE(is >> seatId);
-    OD_ASSERT_TRUE(is >> mOverlayHealthValue);
-    OD_ASSERT_TRUE(is >> mOverlayMoodValue);
-    OD_ASSERT_TRUE(is >> mGroundSpeed);
-    OD_ASSERT_TRUE(is >> mWaterSpeed);
-    OD_ASSERT_TRUE(is >> mLavaSpeed);
-    OD_ASSERT_TRUE(is >> mSpeedModifier);
+    uint32_t fields;
+    OD_ASSERT_TRUE(is.readVarUInt(fields));
+    if((fields & CreatureUpdateFields::Level) != 0)
+    {
+        uint32_t level;
+        OD_ASSERT_TRUE(is.readVarUInt(level));
+        mLevel = level;
+    }
+
+    int32_t seatId = getSeat()->getId();
+    if((fields & CreatureUpdateFields::Seat) != 0)
+    {
+        OD_ASSERT_TRUE(is.readVarInt(seatId));
+    }
+    if((fields & CreatureUpdateFields::OverlayHealth) != 0)
+    {
+        OD_ASSERT_TRUE(is.readVarUInt(mOverlayHealthValue));
+    }
+    if((fields & CreatureUpdateFields::OverlayMood) != 0)
+    {
+        OD_ASSERT_TRUE(is.readVarUInt(mOverlayMoodValue));
+    }
+    if((fields & CreatureUpdateFields::Speeds) != 0)
+    {
+        OD_ASSERT_TRUE(is >> mGroundSpeed >> mWaterSpeed >> mLavaSpeed >> mSpeedModifier);
+    }
 
     // We do not scale the creature if it is picked up (because it is already not at its normal size). It will be
     // resized anyway when dropped
-    if(getIsOnMap())
+    if(getIsOnMap() && ((fields & CreatureUpdateFields::Level) != 0))
         RenderManager::getSingleton().rrScaleCreature(*this);
 
     if(getSeat()->getId() != seatId)
@@ -1629,7 +1767,10 @@ void Creature::updateFromPacket(ODPacket& is)
         }
     }
 
-    OD_ASSERT_TRUE(is >> seatId);
+    if((fields & CreatureUpdateFields::SeatPrison) == 0)
+        return;
+
+    OD_ASSERT_TRUE(is.readVarInt(seatId));
     if(seatId == -1)
         mSeatPrison = nullptr;
     else
@@ -1642,7 +1783,26 @@ void Creature::updateFromPacket(ODPacket& is)
     }
 }
 
+Creature::UpdateState& Creature::getLastUpdateState(const Seat* seat)
+{
+    for(std::pair<const Seat*, UpdateState>& p : mLastUpdateStates)
+    {
+        if(p.first == seat)
+            return p.second;
+    }
+
+    mLastUpdateStates.push_back(std::make_pair(seat, UpdateState()));
+    return mLastUpdateStates.back().second;
+}
+
 void Creature::updateTilesInSight()
+{
+    getGameMap()->buildSightData(mDefinition->getSightRadius());
+    TileContainer::SightWorkspace workspace;
+    updateTilesInSight(workspace);
+}
+
+void Creature::updateTilesInSight(TileContainer::SightWorkspace& workspace)
 {
     Tile* posTile = getPositionTile();
     if (posTile == nullptr)
@@ -1652,7 +1812,10 @@ void Creature::updateTilesInSight()
     mTilesWithinSightRadius = getGameMap()->circularRegion(posTile->getX(), posTile->getY(), mDefinition->getSightRadius());
 
     // Only the tiles the creature can "see".
-    mVisibleTiles = getGameMap()->visibleTiles(posTile->getX(), posTile->getY(), mDefinition->getSightRadius());
+    getGameMap()->visibleTiles(posTile->getX(), posTile->getY(), mDefinition->getSightRadius(), mVisibleTiles, workspace);
+    mVisibleTilesCenter = posTile;
+    mVisibleTilesRadius = mDefinition->getSightRadius();
+    ++mTilesInSightVersion;
 }
 
 std::vector<GameEntity*> Creature::getVisibleEnemyObjects()
@@ -1711,7 +1874,10 @@ std::vector<GameEntity*> Creature::getVisibleAlliedObjects()
 
 std::vector<GameEntity*> Creature::getVisibleForce(Seat* seat, bool invert)
 {
-    return getGameMap()->getVisibleForce(mVisibleTiles, seat, invert);
+    if(mVisibleTilesCenter == nullptr)
+        return getGameMap()->getVisibleForce(mVisibleTiles, seat, invert);
+
+    return getGameMap()->getVisibleForce(mVisibleTiles, mVisibleTilesCenter, mVisibleTilesRadius, seat, invert);
 }
 
 void Creature::computeVisualDebugEntities()
@@ -2354,7 +2520,7 @@ bool Creature::parkToWallTile(Tile* wallTile, Tile* nTile)
     ss << "wallTile->getPosition(): " << wallTile->getPosition();
     ss << "nTile->getPosition(): " << nTile->getPosition();
     
-    std::list<Tile*> result = getGameMap()->path(this, nTile);
+    std::vector<Tile*> result = getGameMap()->path(this, nTile);
 
     std::vector<Ogre::Vector3> path;
     tileToVector3(result, path, true, 0.0);
@@ -2377,7 +2543,7 @@ bool Creature::setDestination(Tile* tile)
     if(posTile == nullptr)
         return false;
 
-    std::list<Tile*> result = getGameMap()->path(this, tile);
+    std::vector<Tile*> result = getGameMap()->path(this, tile);
 
     std::vector<Ogre::Vector3> path;
     tileToVector3(result, path, true, 0.0);
@@ -2403,7 +2569,7 @@ bool Creature::wanderRandomly(const std::string& animationState)
     if (reachableTiles.empty())
         return false;
 
-    Tile* tileDestination = reachableTiles[Random::Uint(0, reachableTiles.size() - 1)];
+    Tile* tileDestination = reachableTiles[mRandom.Uint(0, reachableTiles.size() - 1)];
     setDestination(tileDestination);
     return false;
 }
@@ -2497,8 +2663,10 @@ void Creature::releaseCarriedEntity()
 
         ServerNotification* serverNotification = new ServerNotification(
             ServerNotificationType::releaseCarriedEntity, seat->getPlayer());
-        serverNotification->mPacket << getName() << carriedEntity->getObjectType();
-        serverNotification->mPacket << carriedEntity->getName();
+        uint32_t nameId = ODServer::getSingleton().internString(getName());
+        uint32_t carriedNameId = ODServer::getSingleton().internString(carriedEntity->getName());
+        serverNotification->mPacket << nameId << carriedEntity->getObjectType();
+        serverNotification->mPacket << carriedNameId;
         serverNotification->mPacket << mPosition;
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
@@ -2557,6 +2725,9 @@ void Creature::slap()
 
 void Creature::fireAddEntity(Seat* seat, bool async)
 {
+    // The seat will get the whole creature. The next update will be sent entirely
+    getLastUpdateState(seat) = UpdateState();
+
     if(async)
     {
         ServerNotification serverNotification(
@@ -2584,8 +2755,10 @@ void Creature::fireAddEntity(Seat* seat, bool async)
 
         serverNotification = new ServerNotification(
             ServerNotificationType::carryEntity, seat->getPlayer());
-        serverNotification->mPacket << getName() << mCarriedEntity->getObjectType();
-        serverNotification->mPacket << mCarriedEntity->getName();
+        uint32_t nameId = ODServer::getSingleton().internString(getName());
+        uint32_t carriedNameId = ODServer::getSingleton().internString(mCarriedEntity->getName());
+        serverNotification->mPacket << nameId << mCarriedEntity->getObjectType();
+        serverNotification->mPacket << carriedNameId;
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -2597,20 +2770,32 @@ void Creature::fireRemoveEntity(Seat* seat)
     {
         ServerNotification* serverNotification = new ServerNotification(
             ServerNotificationType::releaseCarriedEntity, seat->getPlayer());
-        serverNotification->mPacket << getName() << mCarriedEntity->getObjectType();
-        serverNotification->mPacket << mCarriedEntity->getName();
+        uint32_t nameId = ODServer::getSingleton().internString(getName());
+        uint32_t carriedNameId = ODServer::getSingleton().internString(mCarriedEntity->getName());
+        serverNotification->mPacket << nameId << mCarriedEntity->getObjectType();
+        serverNotification->mPacket << carriedNameId;
         serverNotification->mPacket << mPosition;
         ODServer::getSingleton().queueServerNotification(serverNotification);
 
         mCarriedEntity->removeSeatWithVision(seat);
     }
 
+    for(auto it = mLastUpdateStates.begin(); it != mLastUpdateStates.end(); ++it)
+    {
+        if(it->first != seat)
+            continue;
+
+        mLastUpdateStates.erase(it);
+        break;
+    }
+
     const std::string& name = getName();
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::removeEntity, seat->getPlayer());
     GameEntityType type = getObjectType();
+    uint32_t nameId = ODServer::getSingleton().internString(name);
     serverNotification->mPacket << type;
-    serverNotification->mPacket << name;
+    serverNotification->mPacket << nameId;
     ODServer::getSingleton().queueServerNotification(serverNotification);
 }
 
@@ -2630,11 +2815,13 @@ void Creature::fireCreatureRefreshIfNeeded()
         const std::string& name = getName();
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::entitiesRefresh, seat->getPlayer());
+        // Updates only contain what changed since the previous one so they cannot be coalesced
         uint32_t nbCreature = 1;
         serverNotification->mPacket << nbCreature;
+        uint32_t nameId = ODServer::getSingleton().internString(name);
         serverNotification->mPacket << GameEntityType::creature;
-        serverNotification->mPacket << name;
-        exportToPacketForUpdate(serverNotification->mPacket, seat);
+        serverNotification->mPacket << nameId;
+        exportUpdateToPacket(serverNotification->mPacket, seat, getLastUpdateState(seat));
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -2846,7 +3033,8 @@ void Creature::fireCreatureSound(CreatureSound sound)
 
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::playSpatialSound, seat->getPlayer());
-        serverNotification->mPacket << soundComplete << posTile->getX() << posTile->getY();
+        uint32_t soundId = ODServer::getSingleton().internString(soundComplete);
+        serverNotification->mPacket << soundId << posTile->getX() << posTile->getY();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -3038,13 +3226,13 @@ void Creature::correctEntityMovePosition(Ogre::Vector3& position)
 {
     static const double offset = 0.3;
     if(position.x > 0)
-        position.x += Random::Double(-offset, offset);
+        position.x += mRandom.Double(-offset, offset);
 
     if(position.y > 0)
-        position.y += Random::Double(-offset, offset);
+        position.y += mRandom.Double(-offset, offset);
 
     if(position.z > 0)
-        position.z += Random::Double(-offset, offset);
+        position.z += mRandom.Double(-offset, offset);
 }
 
 void Creature::checkWalkPathValid()
@@ -22,6 +22,10 @@
 #define CREATURE_H
 
 #include "entities/MovableGameEntity.h"
+#include "gamemap/TileContainer.h"
+#include "gamemap/TileSearchOrder.h"
+#include "gamemap/VisionMap.h"
+#include "utils/Random.h"
 
 #include <OgreVector2.h>
 #include <OgreVector3.h>
@@ -256,8 +260,27 @@ public:
      */
     void doUpkeep() override;
 
-    //! \brief Computes the visible tiles and tags them to know which are visible
-    void computeVisibleTiles();
+    //! \brief Prepares the tile search of the current action (see CreatureAction::prepareSearchOrder).
+    //! Called for every creature in parallel before the upkeep. The rest of the upkeep (like the mood,
+    //! the fight targets or the paths) depends on what the creatures processed before do so it stays serial
+    void prepareSearchOrder();
+
+    //! \brief Updates the tiles this creature gives vision on. They are only recomputed if
+    //! the creature has moved or if a tile around has started or stopped blocking vision.
+    //! Creatures can compute their visible tiles in parallel (each with its own workspace and
+    //! once GameMap::buildSightData has been called for their sight radius). The vision map
+    //! is only updated when updateVision is called
+    void computeVisibleTiles(TileContainer::SightWorkspace& workspace);
+
+    //! \brief Gives the seat vision on the tiles computed by computeVisibleTiles. Should be called
+    //! for every creature in the same order each turn
+    void updateVision();
+
+    //! \brief Computes the given order from the tiles within sight radius if it is not valid anymore
+    void computeTileSearchOrder(TileSearchOrder<Tile>& order, bool withNeighbors) const;
+
+    //! \brief Returns true if the given order has been computed for the current position and tiles in sight
+    bool isTileSearchOrderValid(const TileSearchOrder<Tile>& order) const;
 
     virtual bool isAttackable(Tile* tile, Seat* seat) const override;
 
@@ -271,6 +294,7 @@ public:
     //! \brief Updates the lists of tiles within sight radius.
     //! And the tiles the creature can "see" (removing the ones behind walls).
     void updateTilesInSight();
+    void updateTilesInSight(TileContainer::SightWorkspace& workspace);
 
     //! \brief Loops over the visibleTiles and adds all enemy creatures in each tile to a list which it returns.
     std::vector<GameEntity*> getVisibleEnemyObjects();
@@ -408,6 +432,12 @@ public:
     inline const std::vector<Tile*>& getTilesWithinSightRadius() const
     { return mTilesWithinSightRadius; }
 
+    //! \brief Random stream of this creature. It is created from the session seed and the creature
+    //! name when the creature is added to the server gamemap so that it does not depend on what the
+    //! other creatures do
+    inline RandomStream& getRandom()
+    { return mRandom; }
+
     inline const std::vector<GameEntity*>& getVisibleEnemyObjects() const
     { return mVisibleEnemyObjects; }
 
@@ -693,6 +723,27 @@ private:
     //! used for actions linked to enemies.
     std::vector<Tile*>              mVisibleTiles;
 
+    //! \brief Tile and radius mVisibleTiles has been computed from
+    Tile*                           mVisibleTilesCenter;
+    int                             mVisibleTilesRadius;
+
+    //! \brief Incremented each time the tiles in sight are recomputed
+    uint32_t                        mTilesInSightVersion;
+
+    //! \brief What updateVision should do with the tiles computed by computeVisibleTiles
+    enum class VisionUpdate
+    {
+        none,
+        clear,
+        set
+    };
+    VisionUpdate                    mVisionUpdate;
+
+    //! \brief Tiles this creature gives vision on to its seat
+    VisionMap::Contribution         mVisionContribution;
+
+    RandomStream                    mRandom;
+
     std::vector<GameEntity*>        mVisibleEnemyObjects;
     std::vector<GameEntity*>        mVisibleAlliedObjects;
     std::vector<GameEntity*>        mReachableAlliedObjects;
@@ -733,6 +784,39 @@ private:
     //! level or HP)
     bool                            mNeedFireRefresh;
 
+    //! \brief Values sent by a creature update. Only the values that changed since the last update sent to a seat
+    //! are sent to it
+    struct UpdateState
+    {
+        UpdateState() :
+            mIsSent(false),
+            mLevel(0),
+            mSeatId(-1),
+            mOverlayHealthValue(0),
+            mOverlayMoodValue(0),
+            mGroundSpeed(0.0),
+            mWaterSpeed(0.0),
+            mLavaSpeed(0.0),
+            mSpeedModifier(0.0),
+            mSeatPrisonId(-1)
+        {}
+
+        //! \brief false if nothing has been sent yet. In this case, every value will be sent
+        bool mIsSent;
+        uint32_t mLevel;
+        int32_t mSeatId;
+        uint32_t mOverlayHealthValue;
+        uint32_t mOverlayMoodValue;
+        double mGroundSpeed;
+        double mWaterSpeed;
+        double mLavaSpeed;
+        double mSpeedModifier;
+        int32_t mSeatPrisonId;
+    };
+
+    //! \brief Used on server side. Last update sent to the seats the creature has been added to
+    std::vector<std::pair<const Seat*, UpdateState>> mLastUpdateStates;
+
     //! \brief Used on client side. When a creature is dropped, this cooldown will be set to a value > 0
     //! and decreased at each turn. Until it is > 0, the creature cannot be slapped. That's to avoid
     //! slapping creatures to death when dropping many.
@@ -788,6 +872,14 @@ private:
     void computeMood();
 
     void computeCreatureOverlayMoodValue();
+
+    /*! \brief Exports to the packet the values that changed since lastState for the given seat and
+     * sets lastState with the exported values. The packet should be read by updateFromPacket
+     */
+    void exportUpdateToPacket(ODPacket& os, const Seat* seat, UpdateState& lastState) const;
+
+    //! \brief Returns the last update sent to the given seat
+    UpdateState& getLastUpdateState(const Seat* seat);
 };
 
 #endif // CREATURE_H
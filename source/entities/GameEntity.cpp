@@ -26,6 +26,7 @@
 #include "entities/Tile.h"
 #include "game/Player.h"
 #include "game/Seat.h"
+#include "gamemap/EntityRegistry.h"
 #include "gamemap/GameMap.h"
 #include "network/ODPacket.h"
 #include "network/ODServer.h"
@@ -88,6 +89,7 @@ GameEntity::GameEntity(
           ) :
     mPosition          (Ogre::Vector3::ZERO),
     mName              (name),
+    mHandle            (EntityRegistry::INVALID_HANDLE),
     mMeshName          (meshName),
     mMeshExists        (false),
     mSeat              (seat),
@@ -101,6 +103,8 @@ GameEntity::GameEntity(
     mEntityParentNodeAttach     (EntityParentNodeAttach::ATTACHED)
 {
     assert(mGameMap != nullptr);
+    for(uint32_t& position : mEntityListPositions)
+        position = EntityList<GameEntity>::INVALID_POSITION;
 }
 
 GameEntity::~GameEntity()
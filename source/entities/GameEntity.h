@@ -23,6 +23,8 @@
 #ifndef GAMEENTITY_H
 #define GAMEENTITY_H
 
+#include "gamemap/EntityList.h"
+
 #include <OgreVector3.h>
 #include <string>
 #include <vector>
@@ -172,6 +174,11 @@ class GameEntity
     inline const std::string& getMeshName() const
     { return mMeshName; }
 
+    //! \brief Handle of the entity in the gamemap EntityRegistry. EntityRegistry::INVALID_HANDLE
+    //! if the entity is not on the gamemap
+    inline uint32_t getHandle() const
+    { return mHandle; }
+
     //! \brief Get the seat that the object belongs to
     inline Seat* getSeat() const
     { return mSeat; }
@@ -193,6 +200,16 @@ class GameEntity
     inline void setName(const std::string& name)
     { mName = name; }
 
+    inline void setHandle(uint32_t handle)
+    { mHandle = handle; }
+
+    //! \brief Position of the entity in the GameMap EntityList of the given type
+    inline uint32_t getEntityListPosition(EntityListType type) const
+    { return mEntityListPositions[static_cast<uint32_t>(type)]; }
+
+    inline void setEntityListPosition(EntityListType type, uint32_t position)
+    { mEntityListPositions[static_cast<uint32_t>(type)] = position; }
+
     //! \brief Set the name of the mesh file
     inline void setMeshName(const std::string& meshName)
     { mMeshName = meshName; }
@@ -426,6 +443,8 @@ class GameEntity
     //! brief The name of the entity
     std::string mName;
 
+    uint32_t mHandle;
+
     //! \brief The name of the mesh
     std::string mMeshName;
 
@@ -486,6 +505,8 @@ class GameEntity
 
     //! \brief List of the entity listening for events (removed from gamemap, picked up, ...) on this game entity
     std::vector<GameEntityListener*> mGameEntityListeners;
+
+    uint32_t mEntityListPositions[static_cast<uint32_t>(EntityListType::nbTypes)];
 };
 
 #endif // GAMEENTITY_H
@@ -48,9 +48,10 @@ bool MovableGameEntity::isMoving()
     return !mWalkQueue.empty();
 }
 
-void MovableGameEntity::tileToVector3(const std::list<Tile*>& tiles, std::vector<Ogre::Vector3>& path,
+void MovableGameEntity::tileToVector3(const std::vector<Tile*>& tiles, std::vector<Ogre::Vector3>& path,
     bool skipFirst, Ogre::Real z)
 {
+    path.reserve(path.size() + tiles.size());
     for(Tile* tile : tiles)
     {
         if(skipFirst)
@@ -99,12 +100,21 @@ void MovableGameEntity::setWalkPath(const std::string& walkAnim, const std::stri
             continue;
 
         const std::string& name = getName();
+        uint32_t nameId = ODServer::getSingleton().internString(name);
+        uint32_t walkAnimId = ODServer::getSingleton().internString(walkAnim);
+        uint32_t endAnimId = ODServer::getSingleton().internString(endAnim);
         uint32_t nbDest = mWalkQueue.size();
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::animatedObjectSetWalkPath, seat->getPlayer());
-        serverNotification->mPacket << walkDistortion << name << walkAnim << endAnim << loopEndAnim << playIdleWhenAnimationEnds << nbDest;
+        serverNotification->setCoalescingKey(name);
+        serverNotification->mPacket << walkDistortion << nameId << walkAnimId << endAnimId << loopEndAnim << playIdleWhenAnimationEnds << nbDest;
+        // Each destination is sent relative to the previous one
+        Ogre::Vector3 previous = Ogre::Vector3::ZERO;
         for(const Ogre::Vector3& v : mWalkQueue)
-            serverNotification->mPacket << v;
+        {
+            serverNotification->mPacket.writePositionDelta(v, previous);
+            previous = v;
+        }
 
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
@@ -123,11 +133,15 @@ void MovableGameEntity::clearDestinations(const std::string& animation, bool loo
             continue;
 
         const std::string& name = getName();
-        const std::string emptyString;
+        uint32_t nameId = ODServer::getSingleton().internString(name);
+        uint32_t emptyStringId = ODServer::getSingleton().internString(std::string());
+        uint32_t animationId = ODServer::getSingleton().internString(animation);
+        bool walkDistortion = false;
         uint32_t nbDest = 0;
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::animatedObjectSetWalkPath, seat->getPlayer());
-        serverNotification->mPacket << name << emptyString << animation
+        serverNotification->setCoalescingKey(name);
+        serverNotification->mPacket << walkDistortion << nameId << emptyStringId << animationId
             << loopAnim << playIdleWhenAnimationEnds << nbDest;
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
@@ -309,8 +323,9 @@ void MovableGameEntity::fireObjectAnimationState(const std::string& state, bool
 
         ServerNotification* serverNotification = new ServerNotification(
             ServerNotificationType::setObjectAnimationState, seat->getPlayer());
-        const std::string& name = getName();
-        serverNotification->mPacket << name << state << loop << playIdleWhenAnimationEnds;
+        uint32_t nameId = ODServer::getSingleton().internString(getName());
+        uint32_t stateId = ODServer::getSingleton().internString(state);
+        serverNotification->mPacket << nameId << stateId << loop << playIdleWhenAnimationEnds;
         if(direction != Ogre::Vector3::ZERO)
             serverNotification->mPacket << true << direction;
         else if(mWalkDirection != Ogre::Vector3::ZERO)
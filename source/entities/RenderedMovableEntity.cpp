@@ -129,8 +129,8 @@ void RenderedMovableEntity::setMeshOpacity(float opacity)
 
             ServerNotification* serverNotification = new ServerNotification(
                 ServerNotificationType::setEntityOpacity, seat->getPlayer());
-            const std::string& name = getName();
-            serverNotification->mPacket << name << opacity;
+            uint32_t nameId = ODServer::getSingleton().internString(getName());
+            serverNotification->mPacket << nameId << opacity;
             ODServer::getSingleton().queueServerNotification(serverNotification);
         }
         return;
@@ -176,8 +176,9 @@ void RenderedMovableEntity::fireRemoveEntity(Seat* seat)
         ServerNotificationType::removeEntity, seat->getPlayer());
     const std::string& name = getName();
     GameEntityType type = getObjectType();
+    uint32_t nameId = ODServer::getSingleton().internString(name);
     serverNotification->mPacket << type;
-    serverNotification->mPacket << name;
+    serverNotification->mPacket << nameId;
     ODServer::getSingleton().queueServerNotification(serverNotification);
 }
 
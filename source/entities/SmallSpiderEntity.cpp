@@ -145,13 +145,13 @@ void SmallSpiderEntity::correctEntityMovePosition(Ogre::Vector3& position)
 {
     static const double offset = 0.3;
     if(position.x > 0)
-        position.x += Random::Double(-offset, offset);
+        position.x += Random::getStream(Random::Subsystem::client).Double(-offset, offset);
 
     if(position.y > 0)
-        position.y += Random::Double(-offset, offset);
+        position.y += Random::getStream(Random::Subsystem::client).Double(-offset, offset);
 
     if(position.z > 0)
-        position.z += Random::Double(-offset, offset);
+        position.z += Random::getStream(Random::Subsystem::client).Double(-offset, offset);
 }
 
 void SmallSpiderEntity::addTileToListIfPossible(int x, int y, Room* currentCrypt, std::vector<Tile*>& possibleTileMove)
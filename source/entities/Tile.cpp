@@ -551,117 +551,21 @@ bool Tile::isSameFloodFill(Seat* seat, FloodFillType type, Tile* tile) const
     return getFloodFillValue(seat, type) == tile->getFloodFillValue(seat, type);
 }
 
-void Tile::resetFloodFill()
-{
-    for(std::vector<uint32_t>& values : mFloodFillColor)
-    {
-        for(uint32_t& floodFillValue : values)
-        {
-            floodFillValue = NO_FLOODFILL;
-        }
-    }
-}
-
 bool Tile::updateFloodFillFromTile(Seat* seat, FloodFillType type, Tile* tile)
 {
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size()))
-                + ", fullness=" + Helper::toString(getFullness()));
-        }
-        return false;
-    }
-
-    std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
-        return false;
-    }
-
-    if((values[intType] != NO_FLOODFILL) ||
+    if((getFloodFillValue(seat, type) != NO_FLOODFILL) ||
        (tile->getFloodFillValue(seat, type) == NO_FLOODFILL))
     {
         return false;
     }
 
-    values[intType] = tile->getFloodFillValue(seat, type);
+    getGameMap()->setFloodFillValue(*this, seat, type, tile->getFloodFillValue(seat, type));
     return true;
 }
 
 void Tile::replaceFloodFill(Seat* seat, FloodFillType type, uint32_t newValue)
 {
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size())));
-        }
-        return;
-    }
-
-    std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
-        return;
-    }
-
-    values[intType] = newValue;
-}
-
-void Tile::copyFloodFillToOtherSeats(Seat* seatToCopy)
-{
-    if(seatToCopy->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seatToCopy->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seatToCopy->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size())));
-        }
-        return;
-    }
-
-    std::vector<uint32_t>& valuesToCopy = mFloodFillColor[seatToCopy->getTeamIndex()];
-    for(uint32_t indexFloodFill = 0; indexFloodFill < mFloodFillColor.size(); ++indexFloodFill)
-    {
-        if(seatToCopy->getTeamIndex() == indexFloodFill)
-            continue;
-
-        std::vector<uint32_t>& values = mFloodFillColor[indexFloodFill];
-        for(uint32_t intType = 0; intType < static_cast<uint32_t>(FloodFillType::nbValues); ++intType)
-            values[intType] = valuesToCopy[intType];
-
-    }
+    getGameMap()->setFloodFillValue(*this, seat, type, newValue);
 }
 
 void Tile::logFloodFill() const
@@ -670,14 +574,11 @@ void Tile::logFloodFill() const
         + " - type=" + Tile::tileVisualToString(getTileVisual())
         + " - fullness=" + Helper::toString(getFullness())
         + " - seatId=" + std::string(getSeat() == nullptr ? "-1" : Helper::toString(getSeat()->getId()));
-    for(const std::vector<uint32_t>& values : mFloodFillColor)
+    for(Seat* seat : getGameMap()->getFloodFillSeats())
     {
-        int cpt = 0;
-        for(const uint32_t& floodFill : values)
-        {
-            str += ", [" + Helper::toString(cpt) + "]=" + Helper::toString(floodFill);
-            ++cpt;
-        }
+        str += ", teamIndex=" + Helper::toString(seat->getTeamIndex());
+        for(uint32_t i = 0; i < static_cast<uint32_t>(FloodFillType::nbValues); ++i)
+            str += ", [" + Helper::toString(i) + "]=" + Helper::toString(getFloodFillValue(seat, static_cast<FloodFillType>(i)));
     }
     OD_LOG_INF(str);
 }
@@ -724,17 +625,13 @@ void Tile::clearVision()
     mSeatsWithVision.clear();
 }
 
-void Tile::notifyVision(Seat* seat)
+void Tile::setVisionForSeat(Seat* seat, bool vision)
 {
-    if(std::find(mSeatsWithVision.begin(), mSeatsWithVision.end(), seat) != mSeatsWithVision.end())
-        return;
-
-    seat->notifyVisionOnTile(this);
-    mSeatsWithVision.push_back(seat);
-
-    // We also notify vision for allied seats
-    for(Seat* alliedSeat : seat->getAlliedSeats())
-        notifyVision(alliedSeat);
+    auto it = std::find(mSeatsWithVision.begin(), mSeatsWithVision.end(), seat);
+    if(vision && (it == mSeatsWithVision.end()))
+        mSeatsWithVision.push_back(seat);
+    else if(!vision && (it != mSeatsWithVision.end()))
+        mSeatsWithVision.erase(it);
 }
 
 void Tile::setSeats(const std::vector<Seat*>& seats)
@@ -842,41 +739,7 @@ void Tile::computeTileVisual()
 
 uint32_t Tile::getFloodFillValue(Seat* seat, FloodFillType type) const
 {
-    if(seat->getTeamIndex() >= mFloodFillColor.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", seatIndex=" + Helper::toString(seat->getTeamIndex()) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillColor.size()))
-                + ", fullness=" + Helper::toString(getFullness()));
-        }
-        return NO_FLOODFILL;
-    }
-
-    const std::vector<uint32_t>& values = mFloodFillColor[seat->getTeamIndex()];
-    uint32_t intType = static_cast<uint32_t>(type);
-    if(intType >= values.size())
-    {
-        static bool logMsg = false;
-        if(!logMsg)
-        {
-            logMsg = true;
-            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
-                + ", tile=" + Tile::displayAsString(this)
-                + ", intType=" + Helper::toString(intType) + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(values.size())));
-        }
-        return NO_FLOODFILL;
-    }
-
-    return values.at(intType);
-}
-
-void Tile::setTeamsNumber(uint32_t nbTeams)
-{
-    mFloodFillColor = std::vector<std::vector<uint32_t>>(nbTeams, std::vector<uint32_t>(static_cast<uint32_t>(FloodFillType::nbValues), NO_FLOODFILL));
+    return getGameMap()->getFloodFillValue(*this, seat, type);
 }
 
 bool Tile::shouldColorTileMesh() const
@@ -909,6 +772,9 @@ void Tile::setFullness(double f)
         setMarkedForDiggingForAllPlayersExcept(false, nullptr);
     }
 
+    if ((oldFullness > 0.0) != (mFullness > 0.0))
+        getGameMap()->tilePassabilityChanged(*this);
+
     if ((oldFullness > 0.0) && (mFullness == 0.0))
     {
         fireTileSound(TileSound::Digged);
@@ -916,7 +782,7 @@ void Tile::setFullness(double f)
         if(!getGameMap()->isInEditorMode())
         {
             // Do a flood fill to update the contiguous region touching the tile.
-            for(Seat* seat : getGameMap()->getSeats())
+            for(Seat* seat : getGameMap()->getFloodFillSeats())
                 getGameMap()->refreshFloodFill(seat, this);
         }
     }
@@ -971,7 +837,15 @@ void Tile::setCoveringBuilding(Building *building)
             seatChanged.second = true;
         }
     }
+    if(mCoveringBuilding != nullptr)
+        getGameMap()->getEntityGrid().removeBuildingTile(mCoveringBuilding, getX(), getY());
+
     mCoveringBuilding = building;
+    if(mCoveringBuilding != nullptr)
+        getGameMap()->getEntityGrid().addBuildingTile(mCoveringBuilding, getX(), getY());
+
+    // Bridges change the tiles creatures can walk on
+    getGameMap()->tilePassabilityChanged(*this);
     mIsRoom = false;
     if(getCoveringRoom() != nullptr)
     {
@@ -1000,6 +874,7 @@ void Tile::setCoveringBuilding(Building *building)
         setSeat(mCoveringBuilding->getSeat());
         mClaimedPercentage = 1.0;
     }
+    getGameMap()->getVisionMap().tileClaimChanged(*this);
 }
 
 bool Tile::isGroundClaimable(Seat* seat) const
@@ -1195,6 +1070,9 @@ bool Tile::addEntity(GameEntity *entity)
     }
 
     mEntitiesInTile.push_back(entity);
+    if(entity->getObjectType() == GameEntityType::creature)
+        getGameMap()->getEntityGrid().addCreature(entity, getX(), getY());
+
     if(!getGameMap()->isServerGameMap())
     {
         // On client side, we cull any movable entity that walks over a
@@ -1217,6 +1095,9 @@ void Tile::removeEntity(GameEntity *entity)
     }
 
     mEntitiesInTile.erase(it);
+    if(entity->getObjectType() == GameEntityType::creature)
+        getGameMap()->getEntityGrid().removeCreature(entity, getX(), getY());
+
     fireTileStateChanged();
 }
 
@@ -1262,6 +1143,8 @@ void Tile::claimForSeat(Seat* seat, double nDanceRate)
     {
         claimTile(seat);
     }
+
+    getGameMap()->getVisionMap().tileClaimChanged(*this);
 }
 
 void Tile::claimTile(Seat* seat)
@@ -1273,6 +1156,7 @@ void Tile::claimTile(Seat* seat)
     // We need this because if we are a client, the tile may be from a non allied seat
     setSeat(seat);
     mClaimedPercentage = 1.0;
+    getGameMap()->getVisionMap().tileClaimChanged(*this);
 
     if(isFullTile())
         fireTileSound(TileSound::ClaimWall);
@@ -1308,6 +1192,7 @@ void Tile::unclaimTile()
 
     setSeat(nullptr);
     mClaimedPercentage = 0.0;
+    getGameMap()->getVisionMap().tileClaimChanged(*this);
 
     computeTileVisual();
     setDirtyForAllSeats();
@@ -1706,28 +1591,6 @@ bool Tile::checkCoveringTrapType(TrapType type) const
     return (coveringTrap->getType() == type);
 }
 
-void Tile::computeVisibleTiles()
-{
-    if(!getGameMap()->getIsFOWActivated())
-    {
-        // If the FOW is deactivated, we allow vision for every seat
-        for(Seat* seat : getGameMap()->getSeats())
-            notifyVision(seat);
-
-        return;
-    }
-
-    if(!isClaimed())
-        return;
-
-    // A claimed tile can see it self and its neighboors
-    notifyVision(getSeat());
-    for(Tile* tile : mNeighbors)
-    {
-        tile->notifyVision(getSeat());
-    }
-}
-
 void Tile::setDirtyForAllSeats()
 {
     if(!getIsOnServerMap())
@@ -1874,31 +1737,40 @@ void Tile::canWorkerDig(const Creature& worker, std::vector<Tile*>& tiles)
 
     for(uint32_t i = 0; i < mNeighbors.size(); ++i)
     {
-        Tile* neigh = mNeighbors[i];
-        if(neigh->isFullTile())
+        if(!canWorkerDigFrom(worker, i))
             continue;
 
-        if(!getGameMap()->pathExists(&worker, myTile, neigh))
-            continue;
+        tiles.push_back(mNeighbors[i]);
+    }
+}
 
-        if(i >= mNbWorkersDigging.size())
-        {
-            static bool log = true;
-            if(log)
-            {
-                log = false;
-                OD_LOG_ERR("worker=" + worker.getName() + ", myTile=" + Tile::displayAsString(myTile)
-                    + ", neigh=" + Tile::displayAsString(neigh) + ", i=" + Helper::toString(i)
-                    + ", size=" + Helper::toString(mNbWorkersDigging.size()));
-            }
-            continue;
-        }
+bool Tile::canWorkerDigFrom(const Creature& worker, uint32_t neighborIndex)
+{
+    Tile* myTile = worker.getPositionTile();
+    if((myTile == nullptr) || (neighborIndex >= mNeighbors.size()))
+        return false;
 
-        if(mNbWorkersDigging[i] >= ConfigManager::getSingleton().getNbWorkersDigSameFaceTile())
-            continue;
+    Tile* neigh = mNeighbors[neighborIndex];
+    if(neigh->isFullTile())
+        return false;
 
-        tiles.push_back(neigh);
+    if(!getGameMap()->pathExists(&worker, myTile, neigh))
+        return false;
+
+    if(neighborIndex >= mNbWorkersDigging.size())
+    {
+        static bool log = true;
+        if(log)
+        {
+            log = false;
+            OD_LOG_ERR("worker=" + worker.getName() + ", myTile=" + Tile::displayAsString(myTile)
+                + ", neigh=" + Tile::displayAsString(neigh) + ", i=" + Helper::toString(neighborIndex)
+                + ", size=" + Helper::toString(mNbWorkersDigging.size()));
+        }
+        return false;
     }
+
+    return mNbWorkersDigging[neighborIndex] < ConfigManager::getSingleton().getNbWorkersDigSameFaceTile();
 }
 
 bool Tile::addWorkerDigging(const Creature& worker, Tile& tile)
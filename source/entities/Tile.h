@@ -19,6 +19,7 @@
 #define TILE_H
 
 #include "entities/GameEntity.h"
+#include "gamemap/PathfindingGrid.h"
 
 #include <OgreVector3.h>
 
@@ -99,15 +100,6 @@ ODPacket& operator>>(ODPacket& is, TileVisual& type);
 std::ostream& operator<<(std::ostream& os, const TileVisual& type);
 std::istream& operator>>(std::istream& is, TileVisual& type);
 
-enum class FloodFillType
-{
-    ground = 0,
-    groundWater,
-    groundLava,
-    groundWaterLava,
-    nbValues
-};
-
 /*! \brief Tile for listening for tile state events (like claiming or entity added/removed)
  */
 class TileStateListener
@@ -366,10 +358,9 @@ public:
     //! Fills the given vector with corresponding entities on this tile.
     void fillWithEntities(std::vector<GameEntity*>& entities, SelectionEntityWanted entityWanted, Player* player);
 
-    //! \brief Computes the visible tiles and tags them to know which are visible
-    void computeVisibleTiles();
+    //! \brief Seats with vision on this tile. They are maintained by the GameMap VisionMap
     void clearVision();
-    void notifyVision(Seat* seat);
+    void setVisionForSeat(Seat* seat, bool vision);
 
     void setSeats(const std::vector<Seat*>& seats);
     bool hasChangedForSeat(Seat* seat) const;
@@ -380,8 +371,6 @@ public:
     const std::vector<Seat*>& getSeatsWithVision()
     { return mSeatsWithVision; }
 
-    void resetFloodFill();
-
     static std::string toString(FloodFillType type);
 
     bool isSameFloodFill(Seat* seat, FloodFillType type, Tile* tile) const;
@@ -393,8 +382,7 @@ public:
     //! Sets the floodfill value corresponding at type to newValue
     void replaceFloodFill(Seat* seat, FloodFillType type, uint32_t newValue);
 
-    void copyFloodFillToOtherSeats(Seat* seatToCopy);
-
+    //! Floodfill values are stored by the GameMap (see GameMap::getFloodFillValue)
     uint32_t getFloodFillValue(Seat* seat, FloodFillType type) const;
 
     void logFloodFill() const;
@@ -413,9 +401,6 @@ public:
     //! server and client
     bool isFullTile() const;
 
-    //! Sets the number of teams in this gamemap (after seat configuration). This number includes the rogue team.
-    void setTeamsNumber(uint32_t nbTeams);
-
     //! \brief returns true if the mesh from the tileset should be displayed and false otherwise
     inline bool shouldDisplayTileMesh() const
     { return mDisplayTileMesh; }
@@ -453,6 +438,8 @@ public:
     //! \brief Feels the tile vector with the available tiles the worker can
     //! go to
     void canWorkerDig(const Creature& worker, std::vector<Tile*>& tiles);
+    //! \brief Returns true if the worker can dig the tile from the neighbor with the given index (in getAllNeighbors)
+    bool canWorkerDigFrom(const Creature& worker, uint32_t neighborIndex);
     bool addWorkerDigging(const Creature& worker, Tile& tile);
     bool removeWorkerDigging(const Creature& worker, Tile& tile);
 
@@ -514,9 +501,6 @@ private:
     std::vector<GameEntity*> mEntitiesInTile;
 
     Building* mCoveringBuilding;
-    //! Floodfill values per seat and per floodfill type
-    std::vector<std::vector<uint32_t>> mFloodFillColor;
-
     //! \brief The tile claiming. Used on server side only
     double mClaimedPercentage;
 
@@ -43,6 +43,7 @@
 #include "utils/LogManager.h"
 #include "utils/Random.h"
 
+#include <algorithm>
 #include <istream>
 #include <ostream>
 
@@ -225,24 +226,7 @@ void Seat::addAlliedSeat(Seat* seat)
     mAlliedSeats.push_back(seat);
 }
 
-void Seat::clearTilesWithVision()
-{
-    if(mPlayer == nullptr)
-        return;
-    if(!mPlayer->getIsHuman())
-        return;
-
-    for(std::vector<TileStateNotified>& vec : mTilesStates)
-    {
-        for(TileStateNotified& p : vec)
-        {
-            p.mVisionTurnLast = p.mVisionTurnCurrent;
-            p.mVisionTurnCurrent = false;
-        }
-    }
-}
-
-void Seat::notifyVisionOnTile(Tile* tile)
+void Seat::setVisionOnTile(Tile* tile, bool vision)
 {
     if(mPlayer == nullptr)
         return;
@@ -261,7 +245,8 @@ void Seat::notifyVisionOnTile(Tile* tile)
     }
 
     TileStateNotified& tileState = mTilesStates[tile->getX()][tile->getY()];
-    tileState.mVisionTurnCurrent = true;
+    tileState.mVisionTurnCurrent = vision;
+    mTilesVisionChanged.push_back(tile);
 }
 
 void Seat::notifyTileClaimedByEnemy(Tile* tile)
@@ -284,10 +269,12 @@ void Seat::notifyTileClaimedByEnemy(Tile* tile)
 
     TileStateNotified& tileState = mTilesStates[tile->getX()][tile->getY()];
 
-    // By default, we set the tile like if it was not claimed anymore
+    // By default, we set the tile like if it was not claimed anymore. We give vision on the
+    // tile until the next call to sendVisibleTiles so that the change is notified
     tileState.mSeatIdOwner = -1;
     tileState.mTileVisual = TileVisual::dirtGround;
     tileState.mVisionTurnCurrent = true;
+    mTilesVisionChanged.push_back(tile);
 }
 
 const std::string Seat::getFactionFromLine(const std::string& line)
@@ -439,10 +426,7 @@ void Seat::initSeat()
 
         if(!tilesRefresh.empty())
         {
-            ServerNotification *serverNotification = new ServerNotification(
-                ServerNotificationType::refreshTiles, getPlayer());
-            uint32_t nbTiles = tilesRefresh.size();
-            serverNotification->mPacket << nbTiles;
+            std::vector<Tile*> tilesToNotify;
             for(Tile* tile : tilesRefresh)
             {
                 std::pair<int, int> tileCoords(tile->getX(), tile->getY());
@@ -461,11 +445,16 @@ void Seat::initSeat()
                     continue;
                 }
                 mTilesStates[tile->getX()][tile->getY()] = tileState;
+                tilesToNotify.push_back(tile);
+            }
 
-                // Then, we export tile state to the client
-                mGameMap->tileToPacket(serverNotification->mPacket, tile);
+            // Then, we export tile states to the client in the order of the tile set
+            ServerNotification *serverNotification = new ServerNotification(
+                ServerNotificationType::refreshTiles, getPlayer());
+            mGameMap->tilesToPacket(serverNotification->mPacket, tilesToNotify);
+            for(Tile* tile : tilesToNotify)
                 tile->exportToPacketForUpdate(serverNotification->mPacket, this);
-            }
+
             ODServer::getSingleton().queueServerNotification(serverNotification);
         }
 
@@ -624,13 +613,11 @@ void Seat::notifyChangedVisibleTiles()
     if(tilesToNotify.empty())
         return;
 
-    uint32_t nbTiles = tilesToNotify.size();
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::refreshTiles, getPlayer());
-    serverNotification->mPacket << nbTiles;
+    mGameMap->tilesToPacket(serverNotification->mPacket, tilesToNotify);
     for(Tile* tile : tilesToNotify)
     {
-        mGameMap->tileToPacket(serverNotification->mPacket, tile);
         updateTileStateForSeat(tile, false);
         tile->exportToPacketForUpdate(serverNotification->mPacket, this);
     }
@@ -755,50 +742,38 @@ void Seat::sendVisibleTiles()
     if(!getPlayer()->getIsHuman())
         return;
 
-    uint32_t nbTiles;
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::refreshVisibleTiles, getPlayer());
     std::vector<Tile*> tilesVisionGained;
     std::vector<Tile*> tilesVisionLost;
-    // Tiles we gained vision
-    int xMax = static_cast<int>(mTilesStates.size());
-    for(int xxx = 0; xxx < xMax; ++xxx)
-    {
-        int yMax = static_cast<int>(mTilesStates[xxx].size());
-        for(int yyy = 0; yyy < yMax; ++yyy)
-        {
-            if(mTilesStates[xxx][yyy].mVisionTurnCurrent == mTilesStates[xxx][yyy].mVisionTurnLast)
-                continue;
+    // We only check the tiles where vision has changed since the last call
+    for(Tile* tile : mTilesVisionChanged)
+    {
+        TileStateNotified& tileState = mTilesStates[tile->getX()][tile->getY()];
+        // Vision may have been given temporarily by notifyTileClaimedByEnemy
+        const std::vector<Seat*>& seatsWithVision = tile->getSeatsWithVision();
+        tileState.mVisionTurnCurrent = (std::find(seatsWithVision.begin(), seatsWithVision.end(), this) != seatsWithVision.end());
+        if(tileState.mVisionTurnCurrent == tileState.mVisionTurnLast)
+            continue;
 
-            Tile* tile = mGameMap->getTile(xxx, yyy);
-            if(mTilesStates[xxx][yyy].mVisionTurnCurrent)
-            {
-                // Vision gained
-                tilesVisionGained.push_back(tile);
-            }
-            else
-            {
-                // Vision lost
-                tilesVisionLost.push_back(tile);
-            }
+        tileState.mVisionTurnLast = tileState.mVisionTurnCurrent;
+        if(tileState.mVisionTurnCurrent)
+        {
+            // Vision gained
+            tilesVisionGained.push_back(tile);
+        }
+        else
+        {
+            // Vision lost
+            tilesVisionLost.push_back(tile);
         }
     }
+    mTilesVisionChanged.clear();
 
-    // Notify tiles we gained vision
-    nbTiles = tilesVisionGained.size();
-    serverNotification->mPacket << nbTiles;
-    for(Tile* tile : tilesVisionGained)
-    {
-        mGameMap->tileToPacket(serverNotification->mPacket, tile);
-    }
-
-    // Notify tiles we lost vision
-    nbTiles = tilesVisionLost.size();
-    serverNotification->mPacket << nbTiles;
-    for(Tile* tile : tilesVisionLost)
-    {
-        mGameMap->tileToPacket(serverNotification->mPacket, tile);
-    }
+    // Notify tiles we gained vision then tiles we lost vision. Vision changes
+    // usually cover whole areas so they are sent as compressed tile sets
+    mGameMap->tilesToPacket(serverNotification->mPacket, tilesVisionGained);
+    mGameMap->tilesToPacket(serverNotification->mPacket, tilesVisionLost);
     ODServer::getSingleton().queueServerNotification(serverNotification);
 }
 
@@ -200,8 +200,8 @@ public:
     bool canOwnedCreatureUseRoomFrom(const Seat* seat) const;
     bool canBuildingBeDestroyedBy(const Seat* seat) const;
 
-    void clearTilesWithVision();
-    void notifyVisionOnTile(Tile* tile);
+    //! \brief Called by the VisionMap when this seat gains or loses vision on the given tile
+    void setVisionOnTile(Tile* tile, bool vision);
     void notifyTileClaimedByEnemy(Tile* tile);
 
     //! \brief Returns true if this seat can see the given tile and false otherwise
@@ -361,6 +361,10 @@ private:
     //! state (last tile state notified, vision last turn for this seat, vision for current turn, ...
     std::vector<std::vector<TileStateNotified>> mTilesStates;
 
+    //! \brief Tiles whose vision may have changed since the last call to sendVisibleTiles. It
+    //! may contain duplicates
+    std::vector<Tile*> mTilesVisionChanged;
+
     std::map<std::pair<int, int>, TileStateNotified> mTilesStateLoaded;
 
     std::vector<Tile*> mVisualDebugEntityTiles;
@@ -0,0 +1,143 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/AstarSearch.h"
+
+AstarSearch::AstarSearch() :
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mGeneration(0),
+    mNextOrder(0)
+{
+}
+
+void AstarSearch::resize(int mapSizeX, int mapSizeY)
+{
+    if((mapSizeX == mMapSizeX) && (mapSizeY == mMapSizeY))
+        return;
+
+    mMapSizeX = mapSizeX;
+    mMapSizeY = mapSizeY;
+    mGeneration = 0;
+    Node node;
+    node.mGeneration = 0;
+    node.mClosed = false;
+    node.mParent = -1;
+    node.mHeapPosition = 0;
+    node.mOrder = 0;
+    node.mG = 0.0;
+    node.mH = 0.0;
+    mNodes.assign(static_cast<uint32_t>(mapSizeX * mapSizeY), node);
+    mHeap.clear();
+    mHeap.reserve(static_cast<uint32_t>(mapSizeX + mapSizeY) * 4);
+}
+
+void AstarSearch::newSearch()
+{
+    mHeap.clear();
+    mNextOrder = 0;
+    ++mGeneration;
+    if(mGeneration != 0)
+        return;
+
+    // The generation counter wrapped. We have to reset the nodes to be sure
+    // no node from an old search is considered as visited
+    for(Node& node : mNodes)
+        node.mGeneration = 0;
+
+    mGeneration = 1;
+}
+
+void AstarSearch::open(int index, double g, double h, int parent)
+{
+    Node& node = mNodes[index];
+    node.mGeneration = mGeneration;
+    node.mClosed = false;
+    node.mParent = parent;
+    node.mOrder = mNextOrder++;
+    node.mG = g;
+    node.mH = h;
+    node.mHeapPosition = static_cast<uint32_t>(mHeap.size());
+    mHeap.push_back(index);
+    siftUp(node.mHeapPosition);
+}
+
+void AstarSearch::decreaseG(int index, double g, int parent)
+{
+    Node& node = mNodes[index];
+    node.mG = g;
+    node.mParent = parent;
+    // The node is considered as pushed again in the open list
+    node.mOrder = mNextOrder++;
+    siftUp(node.mHeapPosition);
+}
+
+int AstarSearch::popLowest()
+{
+    int32_t index = mHeap.front();
+    mHeap.front() = mHeap.back();
+    mNodes[mHeap.front()].mHeapPosition = 0;
+    mHeap.pop_back();
+    if(!mHeap.empty())
+        siftDown(0);
+
+    mNodes[index].mClosed = true;
+    return index;
+}
+
+void AstarSearch::siftUp(uint32_t position)
+{
+    int32_t index = mHeap[position];
+    while(position > 0)
+    {
+        uint32_t parentPosition = (position - 1) / 2;
+        int32_t parentIndex = mHeap[parentPosition];
+        if(!isLower(index, parentIndex))
+            break;
+
+        mHeap[position] = parentIndex;
+        mNodes[parentIndex].mHeapPosition = position;
+        position = parentPosition;
+    }
+    mHeap[position] = index;
+    mNodes[index].mHeapPosition = position;
+}
+
+void AstarSearch::siftDown(uint32_t position)
+{
+    uint32_t size = static_cast<uint32_t>(mHeap.size());
+    int32_t index = mHeap[position];
+    while(true)
+    {
+        uint32_t childPosition = position * 2 + 1;
+        if(childPosition >= size)
+            break;
+
+        if((childPosition + 1 < size) && isLower(mHeap[childPosition + 1], mHeap[childPosition]))
+            ++childPosition;
+
+        int32_t childIndex = mHeap[childPosition];
+        if(!isLower(childIndex, index))
+            break;
+
+        mHeap[position] = childIndex;
+        mNodes[childIndex].mHeapPosition = position;
+        position = childPosition;
+    }
+    mHeap[position] = index;
+    mNodes[index].mHeapPosition = position;
+}
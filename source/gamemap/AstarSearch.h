@@ -0,0 +1,128 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASTARSEARCH_H
+#define ASTARSEARCH_H
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Reusable storage for the A* search done in GameMap::path.
+ *
+ * There is one node per map tile. Nodes are allocated once (when the map size
+ * changes) and reused from one search to the next: each search bumps a generation
+ * counter and a node is only considered as used if its generation matches the current
+ * one. That way, starting a new search costs O(1) regardless of the map size.
+ *
+ * The open list is an indexed binary heap allowing to decrease the cost of an already
+ * opened node. Nodes with the same cost are returned in the order they have been
+ * opened (or their cost lowered) so that the computed paths are the same as when the
+ * open list was a sorted vector.
+ */
+class AstarSearch
+{
+public:
+    AstarSearch();
+
+    //! \brief Allocates the nodes to fit a map of the given size. Does nothing if
+    //! the size did not change.
+    void resize(int mapSizeX, int mapSizeY);
+
+    //! \brief Starts a new search. Every node is considered as not visited after this call.
+    void newSearch();
+
+    inline int toIndex(int x, int y) const
+    { return x + y * mMapSizeX; }
+
+    inline int indexToX(int index) const
+    { return index % mMapSizeX; }
+
+    inline int indexToY(int index) const
+    { return index / mMapSizeX; }
+
+    //! \brief Returns true if the given node has been opened during the current search
+    //! (it may already be closed)
+    inline bool isVisited(int index) const
+    { return mNodes[index].mGeneration == mGeneration; }
+
+    //! \brief Returns true if the given node has been closed during the current search
+    inline bool isClosed(int index) const
+    { return isVisited(index) && mNodes[index].mClosed; }
+
+    inline double getG(int index) const
+    { return mNodes[index].mG; }
+
+    //! \brief Returns the index of the node we come from or -1 if there is none
+    inline int getParent(int index) const
+    { return mNodes[index].mParent; }
+
+    //! \brief Adds the given node to the open list
+    void open(int index, double g, double h, int parent);
+
+    //! \brief Sets a lower cost to an already opened node and reorders the open list
+    void decreaseG(int index, double g, int parent);
+
+    inline bool isOpenListEmpty() const
+    { return mHeap.empty(); }
+
+    //! \brief Removes the node with the lowest cost from the open list, closes it
+    //! and returns its index
+    int popLowest();
+
+private:
+    struct Node
+    {
+        uint32_t mGeneration;
+        bool mClosed;
+        int32_t mParent;
+        uint32_t mHeapPosition;
+        //! \brief Incremented each time the node is pushed in the open list or its cost changes.
+        //! Used to break ties between nodes with the same cost
+        uint64_t mOrder;
+        double mG;
+        double mH;
+
+        inline double fCost() const
+        { return mG + mH; }
+    };
+
+    int mMapSizeX;
+    int mMapSizeY;
+    uint32_t mGeneration;
+    uint64_t mNextOrder;
+    std::vector<Node> mNodes;
+
+    //! \brief Binary heap of node indexes. The lowest cost is at index 0
+    std::vector<int32_t> mHeap;
+
+    inline bool isLower(int32_t index1, int32_t index2) const
+    {
+        const Node& n1 = mNodes[index1];
+        const Node& n2 = mNodes[index2];
+        double f1 = n1.fCost();
+        double f2 = n2.fCost();
+        if(f1 != f2)
+            return f1 < f2;
+
+        return n1.mOrder < n2.mOrder;
+    }
+
+    void siftUp(uint32_t position);
+    void siftDown(uint32_t position);
+};
+
+#endif // ASTARSEARCH_H
@@ -0,0 +1,95 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/DisjointSet.h"
+
+#include <algorithm>
+
+uint32_t DisjointSet::find(uint32_t value) const
+{
+    uint32_t root = value;
+    while((root < mParents.size()) && (mParents[root] != root))
+        root = mParents[root];
+
+    if(root >= mRepresentatives.size())
+        return root;
+
+    return mRepresentatives[root];
+}
+
+uint32_t DisjointSet::findRootAndCompress(uint32_t value)
+{
+    uint32_t root = value;
+    while((root < mParents.size()) && (mParents[root] != root))
+        root = mParents[root];
+
+    // Every value on the path now points directly to the root
+    while(value != root)
+    {
+        uint32_t parent = mParents[value];
+        mParents[value] = root;
+        value = parent;
+    }
+
+    return root;
+}
+
+void DisjointSet::grow(uint32_t value)
+{
+    if(value < mParents.size())
+        return;
+
+    uint32_t oldSize = static_cast<uint32_t>(mParents.size());
+    mParents.resize(value + 1);
+    mRanks.resize(value + 1, 0);
+    mRepresentatives.resize(value + 1);
+    for(uint32_t i = oldSize; i <= value; ++i)
+    {
+        mParents[i] = i;
+        mRepresentatives[i] = i;
+    }
+}
+
+void DisjointSet::merge(uint32_t value, uint32_t representative)
+{
+    uint32_t rootValue = findRootAndCompress(value);
+    uint32_t rootRepresentative = findRootAndCompress(representative);
+    if(rootValue == rootRepresentative)
+        return;
+
+    grow(std::max(rootValue, rootRepresentative));
+    uint32_t newRepresentative = mRepresentatives[rootRepresentative];
+
+    // The shallowest tree is attached to the root of the other one
+    uint32_t root = rootRepresentative;
+    if(mRanks[rootValue] < mRanks[rootRepresentative])
+    {
+        mParents[rootValue] = rootRepresentative;
+    }
+    else if(mRanks[rootValue] > mRanks[rootRepresentative])
+    {
+        mParents[rootRepresentative] = rootValue;
+        root = rootValue;
+    }
+    else
+    {
+        mParents[rootValue] = rootRepresentative;
+        ++mRanks[rootRepresentative];
+    }
+
+    mRepresentatives[root] = newRepresentative;
+}
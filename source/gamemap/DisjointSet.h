@@ -0,0 +1,70 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Union-find structure over unsigned values.
+ *
+ * Used to merge flood fill colors: when 2 areas get connected, their colors are merged
+ * instead of repainting every tile of one of the areas. Values that were never merged
+ * are their own representative so the structure only grows with the merged values.
+ *
+ * Sets are merged by rank so that the trees stay shallow. As the representative of a set
+ * is chosen by the caller, it is stored for each root instead of being the root itself.
+ * find does not modify the structure so it can be called from several threads as long as
+ * no merge happens at the same time. Paths are only compressed by merge.
+ */
+class DisjointSet
+{
+public:
+    //! \brief Every value becomes its own representative again
+    void clear()
+    {
+        mParents.clear();
+        mRanks.clear();
+        mRepresentatives.clear();
+    }
+
+    //! \brief Returns the representative of the set containing value
+    uint32_t find(uint32_t value) const;
+
+    //! \brief Merges the set containing value into the set containing representative.
+    //! After this call, find(value) returns the same as find(representative) did before
+    void merge(uint32_t value, uint32_t representative);
+
+private:
+    //! \brief mParents[value] is the parent of value. Values beyond the size are their own parent
+    std::vector<uint32_t> mParents;
+
+    //! \brief Upper bound of the height of the tree of each root
+    std::vector<uint8_t> mRanks;
+
+    //! \brief Representative of the set of each root
+    std::vector<uint32_t> mRepresentatives;
+
+    //! \brief Returns the root of the tree containing value and makes every value on the path point to it
+    uint32_t findRootAndCompress(uint32_t value);
+
+    //! \brief Makes sure value is stored. The added values are their own parent and representative
+    void grow(uint32_t value);
+};
+
+#endif // DISJOINTSET_H
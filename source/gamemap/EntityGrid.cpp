@@ -0,0 +1,117 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/EntityGrid.h"
+
+#include <algorithm>
+
+const int EntityGrid::BUCKET_SIZE = 8;
+
+EntityGrid::EntityGrid() :
+    mNbBucketsX(0),
+    mNbBucketsY(0)
+{
+}
+
+void EntityGrid::reset(int mapSizeX, int mapSizeY)
+{
+    mBuckets.clear();
+    mNbBucketsX = 0;
+    mNbBucketsY = 0;
+    if((mapSizeX <= 0) || (mapSizeY <= 0))
+        return;
+
+    mNbBucketsX = (mapSizeX + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    mNbBucketsY = (mapSizeY + BUCKET_SIZE - 1) / BUCKET_SIZE;
+    mBuckets.resize(mNbBucketsX * mNbBucketsY);
+}
+
+EntityGrid::Bucket* EntityGrid::getBucket(int x, int y)
+{
+    if((x < 0) || (y < 0))
+        return nullptr;
+
+    int bx = x / BUCKET_SIZE;
+    int by = y / BUCKET_SIZE;
+    if((bx >= mNbBucketsX) || (by >= mNbBucketsY))
+        return nullptr;
+
+    return &mBuckets[bx + by * mNbBucketsX];
+}
+
+void EntityGrid::addCreature(GameEntity* creature, int x, int y)
+{
+    Bucket* bucket = getBucket(x, y);
+    if(bucket == nullptr)
+        return;
+
+    bucket->mCreatures.push_back(creature);
+}
+
+void EntityGrid::removeCreature(GameEntity* creature, int x, int y)
+{
+    Bucket* bucket = getBucket(x, y);
+    if(bucket == nullptr)
+        return;
+
+    // Buckets only hold a few creatures and the order does not matter
+    std::vector<GameEntity*>::iterator it = std::find(bucket->mCreatures.begin(), bucket->mCreatures.end(), creature);
+    if(it == bucket->mCreatures.end())
+        return;
+
+    *it = bucket->mCreatures.back();
+    bucket->mCreatures.pop_back();
+}
+
+void EntityGrid::addBuildingTile(GameEntity* building, int x, int y)
+{
+    Bucket* bucket = getBucket(x, y);
+    if(bucket == nullptr)
+        return;
+
+    for(std::pair<GameEntity*, uint32_t>& p : bucket->mBuildings)
+    {
+        if(p.first != building)
+            continue;
+
+        ++p.second;
+        return;
+    }
+
+    bucket->mBuildings.push_back(std::make_pair(building, 1));
+}
+
+void EntityGrid::removeBuildingTile(GameEntity* building, int x, int y)
+{
+    Bucket* bucket = getBucket(x, y);
+    if(bucket == nullptr)
+        return;
+
+    for(std::pair<GameEntity*, uint32_t>& p : bucket->mBuildings)
+    {
+        if(p.first != building)
+            continue;
+
+        --p.second;
+        if(p.second == 0)
+        {
+            p = bucket->mBuildings.back();
+            bucket->mBuildings.pop_back();
+        }
+        return;
+    }
+}
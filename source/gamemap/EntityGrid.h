@@ -0,0 +1,117 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITYGRID_H
+#define ENTITYGRID_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class GameEntity;
+
+/*! \brief Coarse grid of the creatures and buildings on the gamemap.
+ *
+ * The map is split in square buckets of BUCKET_SIZE tiles. Each bucket knows the creatures standing
+ * on its tiles and the buildings covering some of them. It allows to know quickly if there is no
+ * entity matching some criteria (for example, no enemy) around a given place. Because the seat of
+ * an entity can change while it is on the map, the buckets only store the entities and the criteria
+ * are checked when querying.
+ */
+class EntityGrid
+{
+public:
+    static const int BUCKET_SIZE;
+
+    EntityGrid();
+
+    //! \brief Removes every entity and resizes the grid for the given map size
+    void reset(int mapSizeX, int mapSizeY);
+
+    void addCreature(GameEntity* creature, int x, int y);
+    void removeCreature(GameEntity* creature, int x, int y);
+
+    //! \brief To be called for each tile covered by the building
+    void addBuildingTile(GameEntity* building, int x, int y);
+    void removeBuildingTile(GameEntity* building, int x, int y);
+
+    /*! \brief Returns true if one of the creatures (or buildings if withBuildings is true) in the buckets
+     * intersecting the given area matches pred. Note that entities in the buckets but out of the area
+     * might be checked as well. If false is returned, no entity in the area matches pred.
+     */
+    template<typename Pred>
+    bool anyInArea(int xMin, int yMin, int xMax, int yMax, bool withBuildings, Pred pred) const
+    {
+        if(mBuckets.empty())
+            return false;
+
+        int bxMin = toBucket(xMin, mNbBucketsX);
+        int byMin = toBucket(yMin, mNbBucketsY);
+        int bxMax = toBucket(xMax, mNbBucketsX);
+        int byMax = toBucket(yMax, mNbBucketsY);
+        for(int by = byMin; by <= byMax; ++by)
+        {
+            for(int bx = bxMin; bx <= bxMax; ++bx)
+            {
+                const Bucket& bucket = mBuckets[bx + by * mNbBucketsX];
+                for(GameEntity* creature : bucket.mCreatures)
+                {
+                    if(pred(creature))
+                        return true;
+                }
+
+                if(!withBuildings)
+                    continue;
+
+                for(const std::pair<GameEntity*, uint32_t>& building : bucket.mBuildings)
+                {
+                    if(pred(building.first))
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Bucket
+    {
+        std::vector<GameEntity*> mCreatures;
+        //! \brief Buildings covering tiles of this bucket with the number of covered tiles
+        std::vector<std::pair<GameEntity*, uint32_t>> mBuildings;
+    };
+
+    int mNbBucketsX;
+    int mNbBucketsY;
+    std::vector<Bucket> mBuckets;
+
+    //! \brief Bucket coordinate for the given tile coordinate. Coordinates out of the map are clamped
+    static inline int toBucket(int coord, int nbBuckets)
+    {
+        int bucket = coord / BUCKET_SIZE;
+        if(coord < 0)
+            return 0;
+        if(bucket >= nbBuckets)
+            return nbBuckets - 1;
+        return bucket;
+    }
+
+    Bucket* getBucket(int x, int y);
+};
+
+#endif // ENTITYGRID_H
@@ -0,0 +1,176 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITYLIST_H
+#define ENTITYLIST_H
+
+#include <cstdint>
+#include <vector>
+
+//! \brief The kinds of GameMap lists an entity can belong to. An entity is in at most one list
+//! of each kind. For example, a creature is in the creature list (byType), in the animated
+//! objects and in the active objects.
+enum class EntityListType
+{
+    byType,
+    animated,
+    active,
+    clientUpkeep,
+    nbTypes
+};
+
+/*! \brief List of entities with constant time add and remove.
+ *
+ * Each entity stores its position in the list (for the list type given at construction) so
+ * that removing it does not need any search. The removed entity is replaced by the last one.
+ * The order only depends on the sequence of adds and removes so it is the same on every run.
+ * T should provide getEntityListPosition(EntityListType) and setEntityListPosition(EntityListType, uint32_t).
+ *
+ * While forEach is running, removed entities are replaced by nullptr and the list is compacted
+ * at the end. Entities added while iterating are not iterated. That way, entities can add or
+ * remove themselves (or other entities) from their upkeep without the list being copied.
+ */
+template<typename T>
+class EntityList
+{
+public:
+    static const uint32_t INVALID_POSITION = 0xFFFFFFFF;
+
+    EntityList(EntityListType type) :
+        mType(type),
+        mNbIterations(0),
+        mNbEntities(0)
+    {}
+
+    //! \brief Entities in the list. Should not be used during forEach because it may contain nullptr
+    inline const std::vector<T*>& getEntities() const
+    { return mEntities; }
+
+    inline typename std::vector<T*>::const_iterator begin() const
+    { return mEntities.begin(); }
+
+    inline typename std::vector<T*>::const_iterator end() const
+    { return mEntities.end(); }
+
+    inline uint32_t size() const
+    { return mNbEntities; }
+
+    inline bool empty() const
+    { return mNbEntities == 0; }
+
+    inline bool contains(const T* entity) const
+    {
+        uint32_t pos = entity->getEntityListPosition(mType);
+        return (pos < mEntities.size()) && (mEntities[pos] == entity);
+    }
+
+    //! \brief Returns false if the entity is already in the list
+    bool add(T* entity)
+    {
+        if(contains(entity))
+            return false;
+
+        entity->setEntityListPosition(mType, static_cast<uint32_t>(mEntities.size()));
+        mEntities.push_back(entity);
+        ++mNbEntities;
+        return true;
+    }
+
+    //! \brief Returns false if the entity is not in the list
+    bool remove(T* entity)
+    {
+        if(!contains(entity))
+            return false;
+
+        uint32_t pos = entity->getEntityListPosition(mType);
+        entity->setEntityListPosition(mType, INVALID_POSITION);
+        --mNbEntities;
+        if(mNbIterations > 0)
+        {
+            mEntities[pos] = nullptr;
+            mHoles.push_back(pos);
+        }
+        else
+            fillHole(pos);
+
+        return true;
+    }
+
+    //! \brief Removes every entity from the list. Should not be called during forEach
+    void clear()
+    {
+        for(T* entity : mEntities)
+        {
+            if(entity != nullptr)
+                entity->setEntityListPosition(mType, INVALID_POSITION);
+        }
+        mEntities.clear();
+        mHoles.clear();
+        mNbEntities = 0;
+    }
+
+    //! \brief Calls func for every entity in the list when the call starts and that is still in it
+    template<typename Func>
+    void forEach(Func func)
+    {
+        ++mNbIterations;
+        uint32_t nbEntities = static_cast<uint32_t>(mEntities.size());
+        for(uint32_t i = 0; i < nbEntities; ++i)
+        {
+            T* entity = mEntities[i];
+            if(entity != nullptr)
+                func(entity);
+        }
+        --mNbIterations;
+
+        if(mNbIterations > 0)
+            return;
+
+        for(uint32_t pos : mHoles)
+        {
+            if((pos < mEntities.size()) && (mEntities[pos] == nullptr))
+                fillHole(pos);
+        }
+        mHoles.clear();
+    }
+
+private:
+    EntityListType mType;
+    std::vector<T*> mEntities;
+    //! \brief Positions of the entities removed during forEach
+    std::vector<uint32_t> mHoles;
+    uint32_t mNbIterations;
+    uint32_t mNbEntities;
+
+    //! \brief Moves the last entity to the given position (the entity there has already been removed)
+    void fillHole(uint32_t pos)
+    {
+        mEntities[pos] = nullptr;
+        while(!mEntities.empty() && (mEntities.back() == nullptr))
+            mEntities.pop_back();
+
+        if(pos >= mEntities.size())
+            return;
+
+        T* last = mEntities.back();
+        mEntities.pop_back();
+        mEntities[pos] = last;
+        last->setEntityListPosition(mType, pos);
+    }
+};
+
+#endif // ENTITYLIST_H
@@ -0,0 +1,110 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/EntityRegistry.h"
+
+const uint32_t EntityRegistry::INVALID_HANDLE = 0;
+
+//! \brief 20 bits for the slot index and 12 bits for its generation. Generation 0 is never
+//! used so that no valid handle equals INVALID_HANDLE
+static const uint32_t INDEX_BITS = 20;
+static const uint32_t INDEX_MASK = (static_cast<uint32_t>(1) << INDEX_BITS) - 1;
+static const uint32_t MAX_GENERATION = (static_cast<uint32_t>(1) << (32 - INDEX_BITS)) - 1;
+
+EntityRegistry::EntityRegistry() :
+    mNbHandles(0),
+    mNames(static_cast<uint32_t>(EntityIndex::nbIndexes))
+{
+}
+
+uint32_t EntityRegistry::addHandle(GameEntity* entity)
+{
+    uint32_t index;
+    if(!mFreeSlots.empty())
+    {
+        index = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+    else
+    {
+        if(mSlots.size() > INDEX_MASK)
+            return INVALID_HANDLE;
+
+        index = static_cast<uint32_t>(mSlots.size());
+        Slot slot;
+        slot.mEntity = nullptr;
+        slot.mGeneration = 1;
+        mSlots.push_back(slot);
+    }
+
+    Slot& slot = mSlots[index];
+    slot.mEntity = entity;
+    ++mNbHandles;
+    return (slot.mGeneration << INDEX_BITS) | index;
+}
+
+bool EntityRegistry::removeHandle(uint32_t handle)
+{
+    if(getEntity(handle) == nullptr)
+        return false;
+
+    uint32_t index = handle & INDEX_MASK;
+    Slot& slot = mSlots[index];
+    slot.mEntity = nullptr;
+    slot.mGeneration = (slot.mGeneration >= MAX_GENERATION) ? 1 : slot.mGeneration + 1;
+    mFreeSlots.push_back(index);
+    --mNbHandles;
+    return true;
+}
+
+GameEntity* EntityRegistry::getEntity(uint32_t handle) const
+{
+    uint32_t index = handle & INDEX_MASK;
+    if(index >= mSlots.size())
+        return nullptr;
+
+    const Slot& slot = mSlots[index];
+    if(slot.mGeneration != (handle >> INDEX_BITS))
+        return nullptr;
+
+    return slot.mEntity;
+}
+
+bool EntityRegistry::addName(EntityIndex index, const std::string& name, GameEntity* entity)
+{
+    return mNames[static_cast<uint32_t>(index)].insert(std::make_pair(name, entity)).second;
+}
+
+void EntityRegistry::removeName(EntityIndex index, const std::string& name, GameEntity* entity)
+{
+    std::unordered_map<std::string, GameEntity*>& names = mNames[static_cast<uint32_t>(index)];
+    std::unordered_map<std::string, GameEntity*>::iterator it = names.find(name);
+    if((it == names.end()) || (it->second != entity))
+        return;
+
+    names.erase(it);
+}
+
+GameEntity* EntityRegistry::getEntityByName(EntityIndex index, const std::string& name) const
+{
+    const std::unordered_map<std::string, GameEntity*>& names = mNames[static_cast<uint32_t>(index)];
+    std::unordered_map<std::string, GameEntity*>::const_iterator it = names.find(name);
+    if(it == names.end())
+        return nullptr;
+
+    return it->second;
+}
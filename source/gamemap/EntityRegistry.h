@@ -0,0 +1,92 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITYREGISTRY_H
+#define ENTITYREGISTRY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GameEntity;
+
+//! \brief The lists of GameMap entities that can be searched by name
+enum class EntityIndex
+{
+    creature,
+    renderedMovableEntity,
+    spell,
+    mapLight,
+    room,
+    trap,
+    animatedObject,
+    nbIndexes
+};
+
+/*! \brief Allows to find the entities on the gamemap in constant time.
+ *
+ * Each entity on the gamemap gets a 32 bits handle from a generational slot map: the low bits
+ * are the slot index and the high bits the generation of the slot. When an entity is removed,
+ * its slot generation is incremented so that the old handle does not resolve to the next
+ * entity using the slot.
+ * Names are indexed by hash for each EntityIndex. Note that the name of an entity should not
+ * change while it is indexed.
+ */
+class EntityRegistry
+{
+public:
+    static const uint32_t INVALID_HANDLE;
+
+    EntityRegistry();
+
+    //! \brief Returns a new handle for the given entity or INVALID_HANDLE if every slot is used
+    uint32_t addHandle(GameEntity* entity);
+
+    //! \brief Frees the given handle. It will not resolve anymore. Returns false if the handle was not valid
+    bool removeHandle(uint32_t handle);
+
+    //! \brief Returns the entity with the given handle or nullptr if the handle is not valid anymore
+    GameEntity* getEntity(uint32_t handle) const;
+
+    //! \brief Indexes the entity with the given name. If another entity is already indexed with the
+    //! same name, it is kept and false is returned
+    bool addName(EntityIndex index, const std::string& name, GameEntity* entity);
+
+    //! \brief Removes the given entity from the index. Does nothing if another entity is indexed with the name
+    void removeName(EntityIndex index, const std::string& name, GameEntity* entity);
+
+    GameEntity* getEntityByName(EntityIndex index, const std::string& name) const;
+
+    inline uint32_t getNbHandles() const
+    { return mNbHandles; }
+
+private:
+    struct Slot
+    {
+        GameEntity* mEntity;
+        uint32_t mGeneration;
+    };
+
+    std::vector<Slot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+    uint32_t mNbHandles;
+
+    std::vector<std::unordered_map<std::string, GameEntity*>> mNames;
+};
+
+#endif // ENTITYREGISTRY_H
@@ -0,0 +1,293 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/FlowFieldCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+const uint32_t FlowFieldCache::MAX_FLOW_FIELDS = 16;
+const int FlowFieldCache::NO_TEAM = -1;
+
+// Same neighbours order as GameMap::computePath. The 4 first ones are the adjacent tiles. A diagonal
+// tile can be reached only if the 2 adjacent tiles it is next to are passable
+static const int dirX[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+static const int dirY[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+static const int diagSides[4][2] = { { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 } };
+
+bool FlowFieldCache::Walker::operator==(const Walker& walker) const
+{
+    return (mTeamId == walker.mTeamId) &&
+        (mIsBlockedByAllDoors == walker.mIsBlockedByAllDoors) &&
+        (mSpeedGround == walker.mSpeedGround) &&
+        (mSpeedWater == walker.mSpeedWater) &&
+        (mSpeedLava == walker.mSpeedLava);
+}
+
+FlowFieldCache::FlowFieldCache(const PathfindingGrid& grid) :
+    mGrid(grid),
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mNbRequests(0),
+    mNbHits(0),
+    mNbMisses(0)
+{
+}
+
+void FlowFieldCache::reset(int mapSizeX, int mapSizeY)
+{
+    mMapSizeX = mapSizeX;
+    mMapSizeY = mapSizeY;
+    mFlowFields.clear();
+    mLockedDoors.assign(static_cast<uint32_t>(mMapSizeX * mMapSizeY), NO_TEAM);
+    mSearch.resize(mMapSizeX, mMapSizeY);
+}
+
+void FlowFieldCache::tilePassabilityChanged(int x, int y)
+{
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return;
+
+    int xMin = std::max(x - 1, 0);
+    int xMax = std::min(x + 1, mMapSizeX - 1);
+    int yMin = std::max(y - 1, 0);
+    int yMax = std::min(y + 1, mMapSizeY - 1);
+    for(FlowField& flowField : mFlowFields)
+    {
+        if(flowField.mIsOutdated)
+            continue;
+
+        // A tile that becomes passable can only change the flow field if it is next to a reachable tile (or
+        // if it is a destination). A tile that becomes impassable only matters if it was reachable
+        if(std::binary_search(flowField.mDestinations.begin(), flowField.mDestinations.end(), toIndex(x, y)))
+        {
+            flowField.mIsOutdated = true;
+            continue;
+        }
+
+        for(int yy = yMin; (yy <= yMax) && !flowField.mIsOutdated; ++yy)
+        {
+            for(int xx = xMin; xx <= xMax; ++xx)
+            {
+                if(flowField.mCosts[toIndex(xx, yy)] < 0.0f)
+                    continue;
+
+                flowField.mIsOutdated = true;
+                break;
+            }
+        }
+    }
+}
+
+void FlowFieldCache::setDoorLocked(int x, int y, int teamId, bool locked)
+{
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return;
+
+    mLockedDoors[toIndex(x, y)] = locked ? teamId : NO_TEAM;
+    tilePassabilityChanged(x, y);
+}
+
+double FlowFieldCache::getSpeed(int x, int y, const Walker& walker) const
+{
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return 0.0;
+
+    int doorTeamId = mLockedDoors[toIndex(x, y)];
+    if((doorTeamId != NO_TEAM) && (walker.mIsBlockedByAllDoors || (doorTeamId == walker.mTeamId)))
+        return 0.0;
+
+    switch(mGrid.getPathfindingGround(x, y))
+    {
+        case PathfindingGround::ground:
+            return walker.mSpeedGround;
+        case PathfindingGround::water:
+            return walker.mSpeedWater;
+        case PathfindingGround::lava:
+            return walker.mSpeedLava;
+        default:
+            return 0.0;
+    }
+}
+
+FlowFieldCache::FlowField& FlowFieldCache::getFlowField(const Walker& walker)
+{
+    ++mNbRequests;
+    for(FlowField& flowField : mFlowFields)
+    {
+        if(!(flowField.mWalker == walker) ||
+           (flowField.mDestinations != mKey))
+        {
+            continue;
+        }
+
+        flowField.mLastUse = mNbRequests;
+        if(!flowField.mIsOutdated)
+        {
+            ++mNbHits;
+            return flowField;
+        }
+
+        ++mNbMisses;
+        computeFlowField(flowField);
+        return flowField;
+    }
+
+    ++mNbMisses;
+    if(mFlowFields.size() >= MAX_FLOW_FIELDS)
+    {
+        // We reuse the least recently used flow field
+        auto it = std::min_element(mFlowFields.begin(), mFlowFields.end(), [](const FlowField& f1, const FlowField& f2)
+            { return f1.mLastUse < f2.mLastUse; });
+        mFlowFields.erase(it);
+    }
+
+    FlowField flowField;
+    flowField.mWalker = walker;
+    flowField.mDestinations = mKey;
+    flowField.mLastUse = mNbRequests;
+    mFlowFields.push_back(flowField);
+    computeFlowField(mFlowFields.back());
+    return mFlowFields.back();
+}
+
+void FlowFieldCache::computeFlowField(FlowField& flowField)
+{
+    flowField.mIsOutdated = false;
+    flowField.mCosts.assign(static_cast<uint32_t>(mMapSizeX * mMapSizeY), -1.0f);
+
+    // Dijkstra search starting from every destination. Like in GameMap::computePath, going
+    // from a tile to its neighbour costs the Manhattan distance divided by the speed on the
+    // tile we leave. As we search backwards, that is the speed on the neighbour
+    const Walker& walker = flowField.mWalker;
+    mSearch.newSearch();
+    for(int32_t index : flowField.mDestinations)
+    {
+        if(getSpeed(mSearch.indexToX(index), mSearch.indexToY(index), walker) <= 0.0)
+            continue;
+
+        mSearch.open(index, 0.0, 0.0, -1);
+    }
+
+    while(!mSearch.isOpenListEmpty())
+    {
+        int current = mSearch.popLowest();
+        int currentX = mSearch.indexToX(current);
+        int currentY = mSearch.indexToY(current);
+        double currentCost = mSearch.getG(current);
+        flowField.mCosts[current] = static_cast<float>(currentCost);
+
+        bool areTilesPassable[4] = { false, false, false, false };
+        for(int i = 0; i < 8; ++i)
+        {
+            if((i >= 4) && (!areTilesPassable[diagSides[i - 4][0]] || !areTilesPassable[diagSides[i - 4][1]]))
+                continue;
+
+            int neighX = currentX + dirX[i];
+            int neighY = currentY + dirY[i];
+            double speed = getSpeed(neighX, neighY, walker);
+            if(speed <= 0.0)
+                continue;
+
+            if(i < 4)
+                areTilesPassable[i] = true;
+
+            int neighIndex = mSearch.toIndex(neighX, neighY);
+            if(mSearch.isClosed(neighIndex))
+                continue;
+
+            double cost = currentCost + (std::abs(dirX[i]) + std::abs(dirY[i])) / speed;
+            if(!mSearch.isVisited(neighIndex))
+                mSearch.open(neighIndex, cost, 0.0, current);
+            else if(cost < mSearch.getG(neighIndex))
+                mSearch.decreaseG(neighIndex, cost, current);
+        }
+    }
+}
+
+bool FlowFieldCache::findPath(const std::vector<int32_t>& destinations, const Walker& walker, int startX, int startY,
+    std::vector<int32_t>& path)
+{
+    path.clear();
+    if(mLockedDoors.empty() || destinations.empty())
+        return false;
+
+    if((startX < 0) || (startY < 0) || (startX >= mMapSizeX) || (startY >= mMapSizeY))
+        return false;
+
+    mKey = destinations;
+    std::sort(mKey.begin(), mKey.end());
+    mKey.erase(std::unique(mKey.begin(), mKey.end()), mKey.end());
+
+    const FlowField& flowField = getFlowField(walker);
+    const std::vector<float>& costs = flowField.mCosts;
+    int x = startX;
+    int y = startY;
+    float cost = costs[toIndex(x, y)];
+    if(cost < 0.0f)
+        return false;
+
+    path.push_back(toIndex(x, y));
+    // We follow the neighbour giving the lowest cost to the destination, with the same moves as GameMap::path
+    while(!std::binary_search(mKey.begin(), mKey.end(), toIndex(x, y)))
+    {
+        double speed = getSpeed(x, y, walker);
+        bool areTilesPassable[4] = { false, false, false, false };
+        int bestX = -1;
+        int bestY = -1;
+        double bestCost = 0.0;
+        for(int i = 0; i < 8; ++i)
+        {
+            if((i >= 4) && (!areTilesPassable[diagSides[i - 4][0]] || !areTilesPassable[diagSides[i - 4][1]]))
+                continue;
+
+            int neighX = x + dirX[i];
+            int neighY = y + dirY[i];
+            if(getSpeed(neighX, neighY, walker) <= 0.0)
+                continue;
+
+            if(i < 4)
+                areTilesPassable[i] = true;
+
+            float neighCost = costs[toIndex(neighX, neighY)];
+            if((neighCost < 0.0f) || (neighCost >= cost))
+                continue;
+
+            double totalCost = neighCost + (std::abs(dirX[i]) + std::abs(dirY[i])) / speed;
+            if((bestX >= 0) && (totalCost >= bestCost))
+                continue;
+
+            bestX = neighX;
+            bestY = neighY;
+            bestCost = totalCost;
+        }
+
+        // Should not happen since costs decrease until a destination
+        if(bestX < 0)
+        {
+            path.clear();
+            return false;
+        }
+
+        x = bestX;
+        y = bestY;
+        cost = costs[toIndex(x, y)];
+        path.push_back(toIndex(x, y));
+    }
+
+    return true;
+}
@@ -0,0 +1,136 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLOWFIELDCACHE_H
+#define FLOWFIELDCACHE_H
+
+#include "gamemap/AstarSearch.h"
+#include "gamemap/PathfindingGrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Cache of distance maps (flow fields) towards a set of destination tiles.
+ *
+ * When a lot of creatures look for the same destinations (hatcheries, treasuries, a
+ * call to war, ...), computing an A* for each of them is expensive. Instead, the cost
+ * to go from every tile of the map to the closest destination is computed once with a
+ * Dijkstra search using the same weights as GameMap::path. Then, any creature walking the
+ * same way can follow the decreasing costs from its tile to get its path in O(path length).
+ * As each new set of destinations costs a search over the whole map, the cache is only
+ * used for destinations shared by many creatures (see GameMap::findBestPathToSharedDests).
+ *
+ * Flow fields are keyed by the destination tiles and by the way the creature walks (its
+ * speeds and the locked doors blocking it). When the passability of a tile changes (tile
+ * dug, building placed, door locked, ...), only the flow fields that could reach it are
+ * recomputed the next time they are requested.
+ */
+class FlowFieldCache
+{
+public:
+    //! \brief Maximum number of flow fields kept. The least recently used is dropped when more are needed
+    static const uint32_t MAX_FLOW_FIELDS;
+
+    //! \brief Team id used for walkers that are not blocked by any door and for tiles without locked door
+    static const int NO_TEAM;
+
+    //! \brief How a creature walks. Creatures with the same walker share flow fields
+    struct Walker
+    {
+        Walker() :
+            mTeamId(NO_TEAM),
+            mIsBlockedByAllDoors(false),
+            mSpeedGround(0.0),
+            mSpeedWater(0.0),
+            mSpeedLava(0.0)
+        {}
+
+        //! \brief Locked doors of this team block the walker
+        int mTeamId;
+        //! \brief Workers do not go through any locked door (see GameMap::pathExists)
+        bool mIsBlockedByAllDoors;
+        double mSpeedGround;
+        double mSpeedWater;
+        double mSpeedLava;
+
+        bool operator==(const Walker& walker) const;
+    };
+
+    FlowFieldCache(const PathfindingGrid& grid);
+
+    //! \brief Drops every flow field and resizes to the given map size
+    void reset(int mapSizeX, int mapSizeY);
+
+    //! \brief Called when the passability of the given tile changed. Flow fields reaching
+    //! it or one of its neighbours become outdated
+    void tilePassabilityChanged(int x, int y);
+
+    //! \brief Locked doors block the creatures of the door team and workers
+    void setDoorLocked(int x, int y, int teamId, bool locked);
+
+    /*! \brief Fills path with the indexes (x + y * mapSizeX) of the tiles to follow from start to the
+     * closest tile in destinations. The flow field is computed if it is not already known.
+     * Returns false if no destination can be reached from start.
+     * Note that the returned path only follows the walker speeds and the locked doors. The
+     * caller is responsible for checking that the creature can really walk on it.
+     */
+    bool findPath(const std::vector<int32_t>& destinations, const Walker& walker, int startX, int startY,
+        std::vector<int32_t>& path);
+
+    inline uint64_t getNbHits() const
+    { return mNbHits; }
+
+    inline uint64_t getNbMisses() const
+    { return mNbMisses; }
+
+private:
+    struct FlowField
+    {
+        Walker mWalker;
+        //! \brief Sorted indexes of the destination tiles
+        std::vector<int32_t> mDestinations;
+        bool mIsOutdated;
+        uint64_t mLastUse;
+        //! \brief Cost to go from each tile to the closest destination. Negative if not reachable
+        std::vector<float> mCosts;
+    };
+
+    const PathfindingGrid& mGrid;
+    int mMapSizeX;
+    int mMapSizeY;
+    uint64_t mNbRequests;
+    uint64_t mNbHits;
+    uint64_t mNbMisses;
+    std::vector<FlowField> mFlowFields;
+
+    //! \brief For each tile, team of the locked door covering it (NO_TEAM if none)
+    std::vector<int> mLockedDoors;
+
+    AstarSearch mSearch;
+    std::vector<int32_t> mKey;
+
+    inline int toIndex(int x, int y) const
+    { return x + y * mMapSizeX; }
+
+    //! \brief Speed of the walker when leaving the given tile. 0 if it cannot go there
+    double getSpeed(int x, int y, const Walker& walker) const;
+
+    FlowField& getFlowField(const Walker& walker);
+    void computeFlowField(FlowField& flowField);
+};
+
+#endif // FLOWFIELDCACHE_H
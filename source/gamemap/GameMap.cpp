@@ -60,11 +60,13 @@
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 #include "utils/ResourceManager.h"
+#include "utils/ThreadPool.h"
 
 #include <OgreTimer.h>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -75,80 +77,23 @@ const std::string DEFAULT_NICK = "You";
 
 using namespace std;
 
-/*! \brief A helper class for the A* search in the GameMap::path function.
-*
-* This class stores the requisite information about a tile which is placed in
-* the search queue for the A-star, or A*, algorithm which is used to
-* calculate paths in the path function.
-*
-* The A* description can be found here:
-* http://en.wikipedia.org/wiki/A*_search_algorithm
-*/
-class AstarEntry
+//! \brief Manhattan distance used as heuristic and as base weight by the A* search in GameMap::path
+static inline double astarDistance(int x1, int y1, int x2, int y2)
 {
-public:
-    AstarEntry() :
-        tile    (nullptr),
-        parent  (nullptr),
-        g       (0.0),
-        h       (0.0)
-    {}
-
-    AstarEntry(Tile* tile, int x1, int y1, int x2, int y2) :
-        tile    (tile),
-        parent  (nullptr),
-        g       (0.0),
-        h       (0.0),
-        mHasBeenProcessed (false)
-    {
-        h = computeHeuristic(x1, y1, x2, y2);
-    }
-
-    static double computeHeuristic(const int& x1, const int& y1, const int& x2, const int& y2)
-    {
-        return fabs(static_cast<double>(x2 - x1)) + fabs(static_cast<double>(y2 - y1));
-    }
+    return std::fabs(static_cast<double>(x2 - x1)) + std::fabs(static_cast<double>(y2 - y1));
+}
 
-    void setHeuristic(const int& x1, const int& y1, const int& x2, const int& y2)
+//! \brief Index of the given seat in seats or seats.size() if it is not there. Used to index
+//! the per seat sums in GameMap::doMiscUpkeep
+static inline uint32_t seatIndex(const std::vector<Seat*>& seats, const Seat* seat)
+{
+    for(uint32_t i = 0; i < seats.size(); ++i)
     {
-        h = fabs(static_cast<double>(x2 - x1)) + fabs(static_cast<double>(y2 - y1));
+        if(seats[i] == seat)
+            return i;
     }
-
-    inline double fCost() const
-    { return g + h; }
-
-    inline Tile* getTile() const
-    { return tile; }
-
-    inline bool getHasBeenProcessed() const
-    { return mHasBeenProcessed; }
-
-    inline void setHasBeenProcessed()
-    { mHasBeenProcessed = true; }
-
-    inline void setTile(Tile* newTile)
-    { tile = newTile; }
-
-    inline AstarEntry* getParent() const
-    { return parent; }
-
-    inline void setParent(AstarEntry* newParent)
-    { parent = newParent; }
-
-    inline const double& getG() const
-    { return g; }
-
-    inline void setG(const double& newG)
-    { g = newG; }
-
-private:
-    Tile*       tile;
-    AstarEntry* parent;
-    double      g;
-    double      h;
-    bool        mHasBeenProcessed;
-};
-
+    return static_cast<uint32_t>(seats.size());
+}
 
 GameMap::GameMap(bool isServerGameMap) :
         TileContainer(isServerGameMap ? 15 : 0),
@@ -158,13 +103,31 @@ GameMap::GameMap(bool isServerGameMap) :
         mTurnNumber(-1),
         mIsPaused(false),
         mTimePayDay(0),
+        mCreatures(EntityListType::byType),
+        mAnimatedObjects(EntityListType::animated),
+        mRooms(EntityListType::byType),
+        mTraps(EntityListType::byType),
+        mMapLights(EntityListType::byType),
+        mGameEntityClientUpkeep(EntityListType::clientUpkeep),
         mFloodFillEnabled(false),
         mIsFOWActivated(true),
+        mIsLockstep(false),
+        mActiveObjects(EntityListType::active),
         mNumCallsTo_path(0),
+        mHierarchicalPathfinding(*this),
+        mFlowFieldCache(*this),
+        mVisionMap(*this),
+        mRenderedMovableEntities(EntityListType::byType),
+        mSpells(EntityListType::byType),
         mAiManager(*this),
         mTileSet(nullptr)
 {
     resetUniqueNumbers();
+    if(mIsServerGameMap)
+    {
+        mThreadPool.reset(new ThreadPool);
+        mSightWorkspaces.resize(mThreadPool->getNbThreads());
+    }
 }
 
 GameMap::~GameMap()
@@ -172,6 +135,16 @@ GameMap::~GameMap()
     clearAll();
 }
 
+void GameMap::setNbThreads(uint32_t nbThreads)
+{
+    if(!mIsServerGameMap)
+        return;
+
+    mThreadPool.reset(new ThreadPool(nbThreads));
+    mSightWorkspaces.clear();
+    mSightWorkspaces.resize(mThreadPool->getNbThreads());
+}
+
 std::string GameMap::serverStr()
 {
     if (mIsServerGameMap)
@@ -226,6 +199,8 @@ bool GameMap::createNewMap(int sizeX, int sizeY)
     if (!allocateMapMemory(sizeX, sizeY))
         return false;
 
+    mEntityGrid.reset(mMapSizeX, mMapSizeY);
+
     for (int jj = 0; jj < mMapSizeY; ++jj)
     {
         for (int ii = 0; ii < mMapSizeX; ++ii)
@@ -285,6 +260,7 @@ void GameMap::clearAll()
     processDeletionQueues();
 
     clearTiles();
+    mEntityGrid.reset(0, 0);
     processDeletionQueues();
 
     clearGoalsForAllSeats();
@@ -296,6 +272,8 @@ void GameMap::clearAll()
 
     mLocalPlayerNick = DEFAULT_NICK;
     mTurnNumber = -1;
+    mStateChecksum = StateChecksum();
+    mTurnTimings = TurnTimings();
     resetUniqueNumbers();
     mIsFOWActivated = true;
     mTimePayDay = 0;
@@ -303,7 +281,7 @@ void GameMap::clearAll()
     // We check if the different vectors are empty
     if(!mActiveObjects.empty())
     {
-        OD_LOG_ERR("mActiveObjects not empty size=" + Helper::toString(static_cast<uint32_t>(mActiveObjects.size())));
+        OD_LOG_ERR("mActiveObjects not empty size=" + Helper::toString(mActiveObjects.size()));
         for(GameEntity* entity : mActiveObjects)
         {
             OD_LOG_ERR("entity not removed=" + entity->getName());
@@ -312,7 +290,7 @@ void GameMap::clearAll()
     }
     if(!mAnimatedObjects.empty())
     {
-        OD_LOG_ERR("mAnimatedObjects not empty size=" + Helper::toString(static_cast<uint32_t>(mAnimatedObjects.size())));
+        OD_LOG_ERR("mAnimatedObjects not empty size=" + Helper::toString(mAnimatedObjects.size()));
         for(GameEntity* entity : mAnimatedObjects)
         {
             OD_LOG_ERR("entity not removed=" + entity->getName());
@@ -330,7 +308,7 @@ void GameMap::clearAll()
     }
     if(!mGameEntityClientUpkeep.empty())
     {
-        OD_LOG_ERR("mGameEntityClientUpkeep not empty size=" + Helper::toString(static_cast<uint32_t>(mGameEntityClientUpkeep.size())));
+        OD_LOG_ERR("mGameEntityClientUpkeep not empty size=" + Helper::toString(mGameEntityClientUpkeep.size()));
         for(GameEntity* entity : mGameEntityClientUpkeep)
         {
             OD_LOG_ERR("entity not removed=" + entity->getName());
@@ -342,7 +320,7 @@ void GameMap::clearAll()
 void GameMap::clearCreatures()
 {
     // We need to work on a copy of mCreatures because removeFromGameMap will remove them from this vector
-    std::vector<Creature*> creatures = mCreatures;
+    std::vector<Creature*> creatures = mCreatures.getEntities();
     for (Creature* creature : creatures)
     {
         creature->removeFromGameMap();
@@ -388,7 +366,7 @@ void GameMap::clearWeapons()
 void GameMap::clearRenderedMovableEntities()
 {
     // We need to work on a copy of mRenderedMovableEntities because removeFromGameMap will remove them from this vector
-    std::vector<RenderedMovableEntity*> renderedMovableEntities = mRenderedMovableEntities;
+    std::vector<RenderedMovableEntity*> renderedMovableEntities = mRenderedMovableEntities.getEntities();
     for (RenderedMovableEntity* obj : renderedMovableEntities)
     {
         obj->removeFromGameMap();
@@ -415,6 +393,8 @@ void GameMap::resetUniqueNumbers()
     mUniqueNumberTrap = 0;
     mUniqueNumberMapLight = 0;
     mUniqueFloodFillValue = 0;
+    // Floodfill colors are meaningless once the values restart
+    mFloodFillPlanes.clear();
 }
 
 void GameMap::addClassDescription(const CreatureDefinition *c)
@@ -503,21 +483,21 @@ void GameMap::addCreature(Creature *cc)
     OD_LOG_INF(serverStr() + "Adding Creature " + cc->getName()
         + ", seatId=" + (cc->getSeat() != nullptr ? Helper::toString(cc->getSeat()->getId()) : std::string("null")));
 
-    mCreatures.push_back(cc);
+    mCreatures.add(cc);
+    registerEntity(EntityIndex::creature, cc);
 }
 
 void GameMap::removeCreature(Creature *c)
 {
     OD_LOG_INF(serverStr() + "Removing Creature " + c->getName());
 
-    std::vector<Creature*>::iterator it = std::find(mCreatures.begin(), mCreatures.end(), c);
-    if(it == mCreatures.end())
+    if(!mCreatures.remove(c))
     {
         OD_LOG_ERR("creature name=" + c->getName());
         return;
     }
 
-    mCreatures.erase(it);
+    unregisterEntity(EntityIndex::creature, c);
 }
 
 void GameMap::queueEntityForDeletion(GameEntity *ge)
@@ -819,58 +799,47 @@ Creature* GameMap::getFighterToPickupBySeat(Seat* seat)
 
 void GameMap::addAnimatedObject(MovableGameEntity *a)
 {
-    mAnimatedObjects.push_back(a);
+    mAnimatedObjects.add(a);
+    mEntityRegistry.addName(EntityIndex::animatedObject, a->getName(), a);
 }
 
 void GameMap::removeAnimatedObject(MovableGameEntity *a)
 {
-    std::vector<MovableGameEntity*>::iterator it = std::find(mAnimatedObjects.begin(), mAnimatedObjects.end(), a);
-    if(it == mAnimatedObjects.end())
+    if(!mAnimatedObjects.remove(a))
         return;
 
-    mAnimatedObjects.erase(it);
+    mEntityRegistry.removeName(EntityIndex::animatedObject, a->getName(), a);
 }
 
 MovableGameEntity* GameMap::getAnimatedObject(const std::string& name) const
 {
-    for (MovableGameEntity* mge : mAnimatedObjects)
-    {
-        if (mge->getName().compare(name) == 0)
-            return mge;
-    }
-
-    return nullptr;
+    return static_cast<MovableGameEntity*>(mEntityRegistry.getEntityByName(EntityIndex::animatedObject, name));
 }
 
 void GameMap::addRenderedMovableEntity(RenderedMovableEntity *obj)
 {
     OD_LOG_INF(serverStr() + "Adding rendered object " + obj->getName()
         + ",MeshName=" + obj->getMeshName());
-    mRenderedMovableEntities.push_back(obj);
+    mRenderedMovableEntities.add(obj);
+    registerEntity(EntityIndex::renderedMovableEntity, obj);
 }
 
 void GameMap::removeRenderedMovableEntity(RenderedMovableEntity *obj)
 {
     OD_LOG_INF(serverStr() + "Removing rendered object " + obj->getName()
         + ",MeshName=" + obj->getMeshName());
-    std::vector<RenderedMovableEntity*>::iterator it = std::find(mRenderedMovableEntities.begin(), mRenderedMovableEntities.end(), obj);
-    if(it == mRenderedMovableEntities.end())
+    if(!mRenderedMovableEntities.remove(obj))
     {
         OD_LOG_ERR("obj name=" + obj->getName());
         return;
     }
 
-    mRenderedMovableEntities.erase(it);
+    unregisterEntity(EntityIndex::renderedMovableEntity, obj);
 }
 
 RenderedMovableEntity* GameMap::getRenderedMovableEntity(const std::string& name)
 {
-    for(RenderedMovableEntity* renderedMovableEntity : mRenderedMovableEntities)
-    {
-        if(name.compare(renderedMovableEntity->getName()) == 0)
-            return renderedMovableEntity;
-    }
-    return nullptr;
+    return static_cast<RenderedMovableEntity*>(mEntityRegistry.getEntityByName(EntityIndex::renderedMovableEntity, name));
 }
 
 void GameMap::addActiveObject(GameEntity *a)
@@ -879,7 +848,7 @@ void GameMap::addActiveObject(GameEntity *a)
     if(!isServerGameMap())
         return;
 
-    mActiveObjects.push_back(a);
+    mActiveObjects.add(a);
 }
 
 void GameMap::removeActiveObject(GameEntity *a)
@@ -888,14 +857,8 @@ void GameMap::removeActiveObject(GameEntity *a)
     if(!isServerGameMap())
         return;
 
-    auto it = std::find(mActiveObjects.begin(), mActiveObjects.end(), a);
-    if(it == mActiveObjects.end())
-    {
+    if(!mActiveObjects.remove(a))
         OD_LOG_ERR("ActiveObject name=" + a->getName());
-        return;
-    }
-
-    mActiveObjects.erase(it);
 }
 
 unsigned int GameMap::numClassDescriptions()
@@ -1078,21 +1041,19 @@ void GameMap::destroyAllEntities()
 
 Creature* GameMap::getCreature(const std::string& cName) const
 {
-    for (Creature* creature : mCreatures)
-    {
-        if (creature->getName().compare(cName) == 0)
-            return creature;
-    }
-    return nullptr;
+    return static_cast<Creature*>(mEntityRegistry.getEntityByName(EntityIndex::creature, cName));
 }
 
 void GameMap::doTurn(double timeSinceLastTurn)
 {
     OD_LOG_INF("Computing turn " + Helper::toString(mTurnNumber) + ", timeSinceLastTurn=" + Helper::toString(timeSinceLastTurn));
     unsigned int numCallsTo_path_atStart = mNumCallsTo_path;
+    uint64_t flowFieldHits_atStart = mFlowFieldCache.getNbHits();
+    uint64_t flowFieldMisses_atStart = mFlowFieldCache.getNbMisses();
 
     uint32_t miscUpkeepTime = doMiscUpkeep(timeSinceLastTurn);
 
+    Ogre::Timer stopwatch;
     for (Seat* seat : mSeats)
     {
         if(seat->getPlayer() == nullptr)
@@ -1100,21 +1061,95 @@ void GameMap::doTurn(double timeSinceLastTurn)
 
         seat->getPlayer()->upkeepPlayer(timeSinceLastTurn);
     }
+    mTurnTimings.mPlayers += stopwatch.getMicroseconds();
 
     OD_LOG_INF("During this turn there were " + Helper::toString(mNumCallsTo_path - numCallsTo_path_atStart)
-        + " calls to GameMap::path(), miscUpkeepTime=" + Helper::toString(miscUpkeepTime));
+        + " calls to GameMap::path(), flowFieldHits=" + Helper::toString(mFlowFieldCache.getNbHits() - flowFieldHits_atStart)
+        + ", flowFieldMisses=" + Helper::toString(mFlowFieldCache.getNbMisses() - flowFieldMisses_atStart)
+        + ", miscUpkeepTime=" + Helper::toString(miscUpkeepTime));
+
+    if(mIsLockstep)
+        updateStateChecksum();
+}
+
+void GameMap::updateStateChecksum()
+{
+    // Entities are hashed in list order. It only depends on the order they have been added in
+    // so it is the same for 2 simulations with the same inputs
+    StateHasher tilesHasher;
+    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    {
+        for (int ii = 0; ii < getMapSizeX(); ++ii)
+        {
+            Tile* tile = getTile(ii, jj);
+            tilesHasher.add(static_cast<int32_t>(tile->getType()));
+            tilesHasher.add(tile->getFullness());
+            tilesHasher.add(tile->getClaimedPercentage());
+            tilesHasher.add((tile->getSeat() == nullptr) ? -1 : tile->getSeat()->getId());
+        }
+    }
+    mStateChecksum.update(StateChecksum::Subsystem::tiles, tilesHasher.getHash());
+
+    StateHasher creaturesHasher;
+    for (Creature* creature : mCreatures.getEntities())
+    {
+        if(creature == nullptr)
+            continue;
+
+        creaturesHasher.add(creature->getName());
+        creaturesHasher.add((creature->getSeat() == nullptr) ? -1 : creature->getSeat()->getId());
+        const Ogre::Vector3& position = creature->getPosition();
+        creaturesHasher.add(static_cast<double>(position.x));
+        creaturesHasher.add(static_cast<double>(position.y));
+        creaturesHasher.add(static_cast<double>(position.z));
+        creaturesHasher.add(creature->getHP());
+        creaturesHasher.add(creature->getLevel());
+        creaturesHasher.add(creature->getWakefulness());
+        creaturesHasher.add(creature->getHunger());
+        creaturesHasher.add(creature->getGoldCarried());
+        for (const std::unique_ptr<CreatureAction>& action : creature->getActions())
+            creaturesHasher.add(static_cast<int32_t>(action->getType()));
+    }
+    mStateChecksum.update(StateChecksum::Subsystem::creatures, creaturesHasher.getHash());
+
+    StateHasher seatsHasher;
+    for (Seat* seat : mSeats)
+    {
+        seatsHasher.add(seat->getId());
+        seatsHasher.add(seat->getGold());
+        seatsHasher.add(seat->getGoldMax());
+        seatsHasher.add(seat->getGoldMined());
+        seatsHasher.add(seat->getMana());
+        seatsHasher.add(seat->getNumClaimedTiles());
+        seatsHasher.add(seat->getNumCreaturesFighters());
+        seatsHasher.add(seat->getNumCreaturesWorkers());
+    }
+    mStateChecksum.update(StateChecksum::Subsystem::seats, seatsHasher.getHash());
+
+    StateHasher roomsHasher;
+    for (Room* room : getRooms())
+    {
+        roomsHasher.add(room->getName());
+        roomsHasher.add(static_cast<int32_t>(room->getType()));
+        roomsHasher.add((room->getSeat() == nullptr) ? -1 : room->getSeat()->getId());
+        roomsHasher.add(room->numCoveredTiles());
+        roomsHasher.add(room->getTotalGoldStored());
+    }
+    mStateChecksum.update(StateChecksum::Subsystem::rooms, roomsHasher.getHash());
 }
 
 void GameMap::doPlayerAITurn(double timeSinceLastTurn)
 {
+    Ogre::Timer stopwatch;
     mAiManager.doTurn(timeSinceLastTurn);
+    mTurnTimings.mAI += stopwatch.getMicroseconds();
 }
 
 unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
 {
-    Tile *tempTile;
     Ogre::Timer stopwatch;
     unsigned long int timeTaken;
+    unsigned long int phaseStart = 0;
 
     // We check if it is pay day
     mTimePayDay += timeSinceLastTurn;
@@ -1198,31 +1233,42 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
             ++(tempSeat->mNumCreaturesFighters);
     }
 
-    // At each upkeep, we re-compute tiles with vision
-    for (Seat* seat : mSeats)
-        seat->clearTilesWithVision();
-
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    timeTaken = stopwatch.getMicroseconds();
+    mTurnTimings.mMisc += timeTaken - phaseStart;
+    phaseStart = timeTaken;
+
+    // Vision is not recomputed from scratch. Claimed tiles, creatures and spells only update
+    // their contribution if something they depend on has changed. We need to compute every
+    // seats including AI because a human can be allied with an AI and they would share vision
+    mVisionMap.update();
+
+    // The visible tiles only depend on the tiles, which do not change here, so they are computed in
+    // parallel. The vision map is then updated in the creature order so that the seats are notified
+    // the same way whatever the number of threads
+    const std::vector<Creature*>& creatures = mCreatures.getEntities();
+    for (Creature* creature : creatures)
     {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->clearVision();
-        }
+        if(creature == nullptr)
+            continue;
+
+        buildSightData(creature->getDefinition()->getSightRadius());
     }
 
-    // Compute vision. We need to compute every seats including AI because
-    // a human can be allied with an AI and they would share vision
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    mThreadPool->parallelFor(static_cast<uint32_t>(creatures.size()), 16, [this, &creatures](uint32_t index, uint32_t threadIndex)
     {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->computeVisibleTiles();
-        }
-    }
+        Creature* creature = creatures[index];
+        if(creature == nullptr)
+            return;
 
-    for (Creature* creature : mCreatures)
+        creature->computeVisibleTiles(mSightWorkspaces[threadIndex]);
+    });
+
+    for (Creature* creature : creatures)
     {
-        creature->computeVisibleTiles();
+        if(creature == nullptr)
+            continue;
+
+        creature->updateVision();
     }
 
     for (Spell* spell : mSpells)
@@ -1230,6 +1276,8 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
         spell->computeVisibleTiles();
     }
 
+    mVisionMap.endTurn();
+
     for (Seat* seat : mSeats)
     {
         if(!seat->getIsDebuggingVision())
@@ -1242,17 +1290,59 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
     for (Seat* seat : mSeats)
         seat->sendVisibleTiles();
 
+    timeTaken = stopwatch.getMicroseconds();
+    mTurnTimings.mVision += timeTaken - phaseStart;
+    phaseStart = timeTaken;
+
+    // The tiles searched by the workers (to dig or to claim) are sorted by distance in parallel. The
+    // upkeep would have done it anyway so its result does not depend on it. The rest of the upkeep,
+    // like the mood, the fight targets or the paths, stays serial: it reads the HP, positions and
+    // seats of the other creatures, which the upkeep of the creatures processed before can change
+    mThreadPool->parallelFor(static_cast<uint32_t>(creatures.size()), 8, [&creatures](uint32_t index, uint32_t)
+    {
+        Creature* creature = creatures[index];
+        if(creature == nullptr)
+            return;
+
+        creature->prepareSearchOrder();
+    });
+
+    timeTaken = stopwatch.getMicroseconds();
+    mTurnTimings.mSearchOrder += timeTaken - phaseStart;
+    phaseStart = timeTaken;
+
     // Carry out the upkeep round of all the active objects in the game.
-    // Here, we work on a copy of the active objects list because they might
-    // try to remove themselves which would break the iterator
-    std::vector<GameEntity*> activeObjects = mActiveObjects;
-    for(GameEntity* ge : activeObjects)
+    // They might remove themselves or other objects. In this case, removed objects
+    // are skipped and the list is compacted after the loop
+    mActiveObjects.forEach([](GameEntity* ge)
+    {
         ge->doUpkeep();
+    });
+
+    timeTaken = stopwatch.getMicroseconds();
+    mTurnTimings.mUpkeep += timeTaken - phaseStart;
+    phaseStart = timeTaken;
+
+    // Sum the gold stored in the rooms of each seat in a single pass over the rooms. There are
+    // only a few dozen rooms so it is done serially: waking the worker threads costs more
+    uint32_t nbSeats = static_cast<uint32_t>(mSeats.size());
+    std::vector<int> seatGold(nbSeats, 0);
+    std::vector<int> seatGoldMax(nbSeats, 0);
+    for (Room* room : getRooms())
+    {
+        uint32_t seat = seatIndex(mSeats, room->getSeat());
+        if(seat >= nbSeats)
+            continue;
+
+        seatGold[seat] += room->getTotalGoldStored();
+        seatGoldMax[seat] += room->getTotalGoldStorage();
+    }
 
     // Carry out the upkeep round for each seat. This means recomputing how much gold is
     // available in their treasuries, how much mana they gain/lose during this turn, etc.
-    for (Seat* seat : mSeats)
+    for (uint32_t i = 0; i < nbSeats; ++i)
     {
+        Seat* seat = mSeats[i];
         if(seat->getPlayer() == nullptr)
             continue;
 
@@ -1274,16 +1364,8 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
         }
 
         // Update the count on how much gold is available in all of the treasuries claimed by the given seat.
-        seat->mGold = 0;
-        seat->mGoldMax = 0;
-        for (Room* room : getRooms())
-        {
-            if(room->getSeat() != seat)
-                continue;
-
-            seat->mGold += room->getTotalGoldStored();
-            seat->mGoldMax += room->getTotalGoldStorage();
-        }
+        seat->mGold = seatGold[i];
+        seat->mGoldMax = seatGoldMax[i];
     }
 
     // Determine the number of tiles claimed by each seat.
@@ -1296,18 +1378,19 @@ unsigned long int GameMap::doMiscUpkeep(double timeSinceLastTurn)
     {
         for (int ii = 0; ii < getMapSizeX(); ++ii)
         {
-            tempTile = getTile(ii,jj);
+            Tile* tile = getTile(ii, jj);
 
             // Check to see if the current tile is claimed by anyone.
-            if (tempTile->isClaimed())
+            if (tile->isClaimed())
             {
                 // Increment the count of the seat who owns the tile.
-                tempTile->getSeat()->incrementNumClaimedTiles();
+                tile->getSeat()->incrementNumClaimedTiles();
             }
         }
     }
 
     timeTaken = stopwatch.getMicroseconds();
+    mTurnTimings.mSeats += timeTaken - phaseStart;
     return timeTaken;
 }
 
@@ -1320,8 +1403,10 @@ void GameMap::updateAnimations(Ogre::Real timeSinceLastFrame)
         return;
 
     // Update the animations on all AnimatedObjects
-    for(MovableGameEntity* mge : mAnimatedObjects)
+    mAnimatedObjects.forEach([timeSinceLastFrame](MovableGameEntity* mge)
+    {
         mge->update(timeSinceLastFrame);
+    });
 }
 
 void GameMap::playerIsFighting(Player* player, Tile* tile)
@@ -1348,11 +1433,11 @@ void GameMap::playerIsFighting(Player* player, Tile* tile)
     }
 }
 
-std::list<Tile*> GameMap::findBestPath(const Creature* creature, Tile* tileStart, const std::vector<Tile*> possibleDests,
+std::vector<Tile*> GameMap::findBestPath(const Creature* creature, Tile* tileStart, const std::vector<Tile*> possibleDests,
     Tile*& chosenTile)
 {
     chosenTile = nullptr;
-    std::list<Tile*> returnList;
+    std::vector<Tile*> returnList;
     if(possibleDests.empty())
         return returnList;
 
@@ -1384,7 +1469,7 @@ std::list<Tile*> GameMap::findBestPath(const Creature* creature, Tile* tileStart
         if(walkableDist < (dist * magic))
             continue;
 
-        std::list<Tile*> pathTmp = path(tileStart, tile, creature, creature->getSeat(), false);
+        std::vector<Tile*> pathTmp = path(tileStart, tile, creature, creature->getSeat(), false);
         if(pathTmp.size() < returnList.size())
         {
             // The path is shorter
@@ -1395,35 +1480,97 @@ std::list<Tile*> GameMap::findBestPath(const Creature* creature, Tile* tileStart
     return returnList;
 }
 
-bool GameMap::pathExists(const Creature* creature, Tile* tileStart, Tile* tileEnd)
+std::vector<Tile*> GameMap::findBestPathToSharedDests(const Creature* creature, Tile* tileStart,
+    const std::vector<Tile*>& possibleDests, Tile*& chosenTile)
 {
-    // If floodfill is not enabled, we cannot check if the path exists so we return true
-    if(!mFloodFillEnabled)
-        return true;
+    chosenTile = nullptr;
+    std::vector<Tile*> returnList;
+    if(possibleDests.empty())
+        return returnList;
 
-    // We check if the tile we are heading to is walkable. We don't do the same for the start tile because it might
-    //not be the case if a creature is on a door tile while it is closed
-    if(creature == nullptr)
+    if(mFloodFillEnabled && (creature != nullptr) &&
+       findBestPathFlowField(*creature, *tileStart, possibleDests, chosenTile, returnList))
+    {
+        return returnList;
+    }
+
+    return findBestPath(creature, tileStart, possibleDests, chosenTile);
+}
+
+bool GameMap::findBestPathFlowField(const Creature& creature, Tile& tileStart, const std::vector<Tile*>& possibleDests,
+    Tile*& chosenTile, std::vector<Tile*>& returnList)
+{
+    FlowFieldCache::Walker walker;
+    // Like in pathExists, workers are blocked by any locked door and fighters only by the ones of their team
+    // (they attack the enemy ones)
+    if(creature.getDefinition()->isWorker())
+        walker.mIsBlockedByAllDoors = true;
+    else if(creature.getSeat() != nullptr)
+        walker.mTeamId = creature.getSeat()->getTeamId();
+    walker.mSpeedGround = creature.getMoveSpeedGround();
+    walker.mSpeedWater = creature.getMoveSpeedWater();
+    walker.mSpeedLava = creature.getMoveSpeedLava();
+
+    std::vector<int32_t> destinations;
+    destinations.reserve(possibleDests.size());
+    for(Tile* tile : possibleDests)
+        destinations.push_back(tile->getX() + tile->getY() * getMapSizeX());
+
+    std::vector<int32_t> path;
+    if(!mFlowFieldCache.findPath(destinations, walker, tileStart.getX(), tileStart.getY(), path))
         return false;
 
+    // The flow field does not know about the creature specific constraints. If the creature cannot
+    // follow the path, we search it as usual. Like in path(), the start tile may not be passable
+    returnList.resize(path.size());
+    for(uint32_t i = 0; i < path.size(); ++i)
+    {
+        returnList[i] = getTile(path[i] % getMapSizeX(), path[i] / getMapSizeX());
+        if((i == 0) || creature.canGoThroughTile(returnList[i]))
+            continue;
+
+        returnList.clear();
+        return false;
+    }
+
+    chosenTile = returnList.back();
+    return true;
+}
+
+FloodFillType GameMap::getFloodFillTypeForCreature(const Creature& creature)
+{
     FloodFillType floodFill = FloodFillType::ground;
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedWater() > 0.0) &&
-        (creature->getMoveSpeedLava() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedWater() > 0.0) &&
+        (creature.getMoveSpeedLava() > 0.0))
     {
         floodFill = FloodFillType::groundWaterLava;
     }
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedWater() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedWater() > 0.0))
     {
         floodFill = FloodFillType::groundWater;
     }
-    if((creature->getMoveSpeedGround() > 0.0) &&
-        (creature->getMoveSpeedLava() > 0.0))
+    if((creature.getMoveSpeedGround() > 0.0) &&
+        (creature.getMoveSpeedLava() > 0.0))
     {
         floodFill = FloodFillType::groundLava;
     }
+    return floodFill;
+}
+
+bool GameMap::pathExists(const Creature* creature, Tile* tileStart, Tile* tileEnd)
+{
+    // If floodfill is not enabled, we cannot check if the path exists so we return true
+    if(!mFloodFillEnabled)
+        return true;
+
+    // We check if the tile we are heading to is walkable. We don't do the same for the start tile because it might
+    //not be the case if a creature is on a door tile while it is closed
+    if(creature == nullptr)
+        return false;
 
+    FloodFillType floodFill = getFloodFillTypeForCreature(*creature);
     if(creature->getDefinition()->isWorker())
     {
         // Workers can go on a tile if and only if the path is open for any creature. If it is closed, that
@@ -1446,59 +1593,124 @@ bool GameMap::pathExists(const Creature* creature, Tile* tileStart, Tile* tileEn
     }
 }
 
-std::list<Tile*> GameMap::path(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
+std::vector<Tile*> GameMap::path(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
 {
     ++mNumCallsTo_path;
-    std::list<Tile*> returnList;
+    // Most searches take a few microseconds so the time is counted in nanoseconds
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<Tile*> returnList;
+    searchPath(x1, y1, x2, y2, creature, seat, throughDiggableTiles, returnList);
+    mTurnTimings.mPath += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return returnList;
+}
 
+void GameMap::searchPath(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles,
+    std::vector<Tile*>& returnList)
+{
     // If the start tile was not found return an empty path
     Tile* start = getTile(x1, y1);
     if (start == nullptr)
-        return returnList;
+        return;
 
     // If the end tile was not found return an empty path
     Tile* destination = getTile(x2, y2);
     if (destination == nullptr)
-        return returnList;
+        return;
 
     if (creature == nullptr)
-        return returnList;
+        return;
 
     // If flood filling is enabled, we can possibly eliminate this path by checking to see if they two tiles are floodfilled differently.
     if (!throughDiggableTiles && !pathExists(creature, start, destination))
-        return returnList;
+        return;
+
+    // For long paths, we first search the cluster abstraction and only compute the real path between
+    // the waypoints. The abstraction does not handle digging
+    if (!throughDiggableTiles && mFloodFillEnabled &&
+        (astarDistance(x1, y1, x2, y2) >= HierarchicalPathfinding::MIN_DISTANCE) &&
+        computeHierarchicalPath(*start, *destination, *creature, seat, returnList))
+    {
+        return;
+    }
 
-    AstarEntry *currentEntry = new AstarEntry(start, x1, y1, x2, y2);
-    AstarEntry neighbor;
+    computePath(*start, *destination, *creature, seat, throughDiggableTiles, returnList);
+}
 
-    std::vector<AstarEntry*> openList;
-    openList.push_back(currentEntry);
+bool GameMap::computeHierarchicalPath(Tile& start, Tile& destination, const Creature& creature, Seat* seat, std::vector<Tile*>& returnList)
+{
+    // Like in pathExists, workers are blocked by any locked door and fighters only by the ones of their team
+    int teamId = HierarchicalPathfinding::NO_TEAM;
+    if (creature.getDefinition()->isWorker())
+        teamId = HierarchicalPathfinding::ALL_TEAMS;
+    else if (creature.getSeat() != nullptr)
+        teamId = creature.getSeat()->getTeamId();
 
-    // This list will contain the processed and the to process entries
-    // allowing to quickly know if a tile has been processed or not
-    std::vector<std::vector<AstarEntry*>> processList(getMapSizeX(), std::vector<AstarEntry*>(getMapSizeY(), nullptr));
-    processList[currentEntry->getTile()->getX()][currentEntry->getTile()->getY()] = currentEntry;
-    AstarEntry* destinationEntry = nullptr;
-    while (true)
+    std::vector<int32_t> waypoints;
+    if (!mHierarchicalPathfinding.findWaypoints(start.getX(), start.getY(), destination.getX(), destination.getY(),
+        getFloodFillTypeForCreature(creature), teamId, waypoints))
     {
-        // if the openList is empty we failed to find a path
-        if (openList.empty())
-            break;
+        return false;
+    }
+
+    std::vector<Tile*> segment;
+    for (uint32_t i = 1; i < waypoints.size(); ++i)
+    {
+        Tile* segmentStart = getTile(waypoints[i - 1] % getMapSizeX(), waypoints[i - 1] / getMapSizeX());
+        Tile* segmentEnd = getTile(waypoints[i] % getMapSizeX(), waypoints[i] / getMapSizeX());
+
+        // If a segment cannot be walked by this creature (for example, if its speed is null on some tiles the
+        // abstraction considers as passable), we let the caller search the whole path
+        if (!computePath(*segmentStart, *segmentEnd, creature, seat, false, segment))
+        {
+            returnList.clear();
+            return false;
+        }
+
+        // The first tile of each segment is the last one of the previous segment
+        returnList.insert(returnList.end(), returnList.empty() ? segment.begin() : segment.begin() + 1, segment.end());
+    }
+
+    return true;
+}
+
+bool GameMap::computePath(Tile& start, Tile& destination, const Creature& creature, Seat* seat, bool throughDiggableTiles, std::vector<Tile*>& returnList)
+{
+    returnList.clear();
+    int x1 = start.getX();
+    int y1 = start.getY();
+    int x2 = destination.getX();
+    int y2 = destination.getY();
 
-        // openList being sorted, the last element is the smallest
-        AstarEntry* smallestAstar = *openList.rbegin();
-        openList.pop_back();
+    // The nodes are reused from one search to another. Starting a new search only invalidates them
+    mAstarSearch.resize(getMapSizeX(), getMapSizeY());
+    mAstarSearch.newSearch();
+    mAstarSearch.open(mAstarSearch.toIndex(x1, y1), 0.0, astarDistance(x1, y1, x2, y2), -1);
 
-        currentEntry = smallestAstar;
-        currentEntry->setHasBeenProcessed();
+    const int destinationIndex = mAstarSearch.toIndex(x2, y2);
+    bool isDestinationReached = false;
+    while (!mAstarSearch.isOpenListEmpty())
+    {
+        int currentIndex = mAstarSearch.popLowest();
 
         // We found the path, break out of the search loop
-        if (currentEntry->getTile() == destination)
+        if (currentIndex == destinationIndex)
         {
-            destinationEntry = currentEntry;
+            isDestinationReached = true;
             break;
         }
 
+        Tile* currentTile = getTile(mAstarSearch.indexToX(currentIndex), mAstarSearch.indexToY(currentIndex));
+        int currentX = currentTile->getX();
+        int currentY = currentTile->getY();
+
+        // The cost to leave the current tile does not depend on the neighbor
+        double currentSpeed;
+        if(currentTile->getFullness() == 0)
+            currentSpeed = creature.getMoveSpeed(currentTile);
+        else
+            currentSpeed = creature.getMoveSpeedGround();
+
         // Check the tiles surrounding the current square
         bool areTilesPassable[4] = {false, false, false, false};
         // Note : to disable diagonals, process tiles from 0 to 3. To allow them, process tiles from 0 to 7
@@ -1509,34 +1721,34 @@ std::list<Tile*> GameMap::path(int x1, int y1, int x2, int y2, const Creature* c
             {
                 // We process the 4 adjacent tiles
                 case 0:
-                    neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY());
+                    neighborTile = getTile(currentX - 1, currentY);
                     break;
                 case 1:
-                    neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY());
+                    neighborTile = getTile(currentX + 1, currentY);
                     break;
                 case 2:
-                    neighborTile = getTile(currentEntry->getTile()->getX(), currentEntry->getTile()->getY() - 1);
+                    neighborTile = getTile(currentX, currentY - 1);
                     break;
                 case 3:
-                    neighborTile = getTile(currentEntry->getTile()->getX(), currentEntry->getTile()->getY() + 1);
+                    neighborTile = getTile(currentX, currentY + 1);
                     break;
                 // We process the 4 diagonal tiles. We only process a diagonal tile if the 2 tiles adjacent to the original one are
                 // passable.
                 case 4:
                     if(areTilesPassable[0] && areTilesPassable[2])
-                        neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY() - 1);
+                        neighborTile = getTile(currentX - 1, currentY - 1);
                     break;
                 case 5:
                     if(areTilesPassable[0] && areTilesPassable[3])
-                        neighborTile = getTile(currentEntry->getTile()->getX() - 1, currentEntry->getTile()->getY() + 1);
+                        neighborTile = getTile(currentX - 1, currentY + 1);
                     break;
                 case 6:
                     if(areTilesPassable[1] && areTilesPassable[2])
-                        neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY() - 1);
+                        neighborTile = getTile(currentX + 1, currentY - 1);
                     break;
                 case 7:
                     if(areTilesPassable[1] && areTilesPassable[3])
-                        neighborTile = getTile(currentEntry->getTile()->getX() + 1, currentEntry->getTile()->getY() + 1);
+                        neighborTile = getTile(currentX + 1, currentY + 1);
                     break;
                 default:
                     break;
@@ -1544,123 +1756,56 @@ std::list<Tile*> GameMap::path(int x1, int y1, int x2, int y2, const Creature* c
             if(neighborTile == nullptr)
                 continue;
 
-            neighbor.setTile(neighborTile);
-
             bool processNeighbor = false;
             // We process the tile if the creature can go through. But if it is the first tile that is
             // not passable, we also process it. That happens if a door is closed
-            if((creature->canGoThroughTile(neighbor.getTile())) ||
-               (neighbor.getTile() == start))
+            if((creature.canGoThroughTile(neighborTile)) ||
+               (neighborTile == &start))
             {
                 processNeighbor = true;
                 // We set passability for the 4 adjacent tiles only
                 if(i < 4)
                     areTilesPassable[i] = true;
              }
-            else if(throughDiggableTiles && neighbor.getTile()->isDiggable(seat))
+            else if(throughDiggableTiles && neighborTile->isDiggable(seat))
                 processNeighbor = true;
 
             if (!processNeighbor)
                 continue;
 
             // See if the neighbor has already been processed
-            AstarEntry* neighborEntry = processList[neighbor.getTile()->getX()][neighbor.getTile()->getY()];
-            if ((neighborEntry != nullptr) && (neighborEntry->getHasBeenProcessed()))
+            int neighborX = neighborTile->getX();
+            int neighborY = neighborTile->getY();
+            int neighborIndex = mAstarSearch.toIndex(neighborX, neighborY);
+            if (mAstarSearch.isClosed(neighborIndex))
                 continue;
 
-            // If the neighbor is not in the open list
-            if (neighborEntry == nullptr)
-            {
-                double weightToParent = AstarEntry::computeHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(),
-                    currentEntry->getTile()->getX(), currentEntry->getTile()->getY());
-
-                if(currentEntry->getTile()->getFullness() == 0)
-                    weightToParent /= creature->getMoveSpeed(currentEntry->getTile());
-                else
-                    weightToParent /= creature->getMoveSpeedGround();
-                neighbor.setG(currentEntry->getG() + weightToParent);
-
-                // Use the manhattan distance for the heuristic
-                neighbor.setHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(), x2, y2);
-                neighbor.setParent(currentEntry);
-
-                AstarEntry* entry = new AstarEntry(neighbor);
-                auto itr = openList.begin();
-                while((itr != openList.end()) &&
-                      ((*itr)->fCost() > entry->fCost()))
-                {
-                    ++itr;
-                }
-
-                openList.insert(itr, entry);
-                processList[neighbor.getTile()->getX()][neighbor.getTile()->getY()] = entry;
-            }
-            else
-            {
-                // If this path to the given neighbor tile is a shorter path than the
-                // one already given, make this the new parent.
-                double weightToParent = AstarEntry::computeHeuristic(neighbor.getTile()->getX(), neighbor.getTile()->getY(),
-                    currentEntry->getTile()->getX(), currentEntry->getTile()->getY());
-
-                if(currentEntry->getTile()->getFullness() == 0)
-                    weightToParent /= creature->getMoveSpeed(currentEntry->getTile());
-                else
-                    weightToParent /= creature->getMoveSpeedGround();
+            double weightToParent = astarDistance(neighborX, neighborY, currentX, currentY) / currentSpeed;
+            double g = mAstarSearch.getG(currentIndex) + weightToParent;
 
-                if (currentEntry->getG() + weightToParent < neighborEntry->getG())
-                {
-                    neighborEntry->setG(currentEntry->getG() + weightToParent);
-                    neighborEntry->setParent(currentEntry);
-
-                    // The cost changed. We need to re-order openList
-                    auto itr = std::find(openList.begin(), openList.end(), neighborEntry);
-                    if(itr == openList.end())
-                    {
-                        OD_LOG_ERR("Unexpected entry not found tileStart=" + Tile::displayAsString(start)
-                            + ", tileDest=" + Tile::displayAsString(destination)
-                            + ", tile=" + Tile::displayAsString(neighborEntry->getTile()));
-                    }
-                    else
-                    {
-                        itr = openList.erase(itr);
-                        // We look for the new location
-                        while((itr != openList.end()) &&
-                              ((*itr)->fCost() > neighborEntry->fCost()))
-                        {
-                            ++itr;
-                        }
-
-                        openList.insert(itr, neighborEntry);
-                    }
-                }
-            }
+            // If the neighbor is not in the open list, we add it. Otherwise, if this path to the
+            // given neighbor tile is a shorter path than the one already given, make this the new parent.
+            if (!mAstarSearch.isVisited(neighborIndex))
+                mAstarSearch.open(neighborIndex, g, astarDistance(neighborX, neighborY, x2, y2), currentIndex);
+            else if (g < mAstarSearch.getG(neighborIndex))
+                mAstarSearch.decreaseG(neighborIndex, g, currentIndex);
         }
     }
 
-    if (destinationEntry != nullptr)
-    {
-        // Follow the parent chain back the the starting tile
-        AstarEntry* curEntry = destinationEntry;
-        do
-        {
-            if (curEntry->getTile() != nullptr)
-            {
-                returnList.push_front(curEntry->getTile());
-                curEntry = curEntry->getParent();
-            }
+    if (!isDestinationReached)
+        return false;
 
-        } while (curEntry != nullptr);
-    }
+    // Follow the parent chain back the the starting tile. We count the tiles first
+    // to fill the path in place
+    uint32_t nbTiles = 0;
+    for(int index = destinationIndex; index >= 0; index = mAstarSearch.getParent(index))
+        ++nbTiles;
 
-    // Clean up the memory we allocated by deleting the astarEntries.  Note that
-    // processList contains all the created entries so it is enough to clean it.
-    for (std::vector<AstarEntry*>& column : processList)
-    {
-        for (AstarEntry* entry : column)
-            delete entry;
-    }
+    returnList.resize(nbTiles);
+    for(int index = destinationIndex; index >= 0; index = mAstarSearch.getParent(index))
+        returnList[--nbTiles] = getTile(mAstarSearch.indexToX(index), mAstarSearch.indexToY(index));
 
-    return returnList;
+    return true;
 }
 
 bool GameMap::addPlayer(Player* player)
@@ -1757,6 +1902,38 @@ std::vector<GameEntity*> GameMap::getVisibleForce(const std::vector<Tile*>& visi
     return returnList;
 }
 
+std::vector<GameEntity*> GameMap::getVisibleForce(const std::vector<Tile*>& visibleTiles, const Tile* center, int radius,
+    Seat* seat, bool enemyForce)
+{
+    if(!mayHaveForceAround(center, radius, seat, enemyForce, true))
+        return std::vector<GameEntity*>();
+
+    return getVisibleForce(visibleTiles, seat, enemyForce);
+}
+
+std::vector<GameEntity*> GameMap::getVisibleCreatures(const std::vector<Tile*>& visibleTiles, const Tile* center, int radius,
+    Seat* seat, bool enemyCreatures)
+{
+    if(!mayHaveForceAround(center, radius, seat, enemyCreatures, false))
+        return std::vector<GameEntity*>();
+
+    return getVisibleCreatures(visibleTiles, seat, enemyCreatures);
+}
+
+bool GameMap::mayHaveForceAround(const Tile* center, int radius, Seat* seat, bool enemyForce, bool withBuildings) const
+{
+    radius = std::abs(radius);
+    return mEntityGrid.anyInArea(center->getX() - radius, center->getY() - radius,
+        center->getX() + radius, center->getY() + radius, withBuildings,
+        [seat, enemyForce](GameEntity* entity)
+        {
+            if(entity->getSeat() == nullptr)
+                return false;
+
+            return seat->isAlliedSeat(entity->getSeat()) != enemyForce;
+        });
+}
+
 std::vector<GameEntity*> GameMap::getVisibleCreatures(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyCreatures)
 {
     std::vector<GameEntity*> returnList;
@@ -1805,7 +1982,7 @@ std::vector<GameEntity*> GameMap::getCarryableEntities(Creature* carrier, const
 void GameMap::clearRooms()
 {
     // We need to work on a copy of mRooms because removeFromGameMap will remove them from this vector
-    std::vector<Room*> rooms = mRooms;
+    std::vector<Room*> rooms = mRooms.getEntities();
     for (Room *tempRoom : rooms)
     {
         tempRoom->removeFromGameMap();
@@ -1825,7 +2002,8 @@ void GameMap::addRoom(Room *r)
         OD_LOG_INF(serverStr() + "Adding room " + r->getName() + ", tile=" + Tile::displayAsString(tile));
     }
 
-    mRooms.push_back(r);
+    mRooms.add(r);
+    registerEntity(EntityIndex::room, r);
 }
 
 void GameMap::removeRoom(Room *r)
@@ -1833,14 +2011,13 @@ void GameMap::removeRoom(Room *r)
     OD_LOG_INF(serverStr() + "Removing room " + r->getName());
     // Rooms are removed when absorbed by another room or when they have no more tile
     // In both cases, the client have enough information to do that alone so no need to notify him
-    std::vector<Room*>::iterator it = std::find(mRooms.begin(), mRooms.end(), r);
-    if(it == mRooms.end())
+    if(!mRooms.remove(r))
     {
         OD_LOG_ERR("Room name=" + r->getName());
         return;
     }
 
-    mRooms.erase(it);
+    unregisterEntity(EntityIndex::room, r);
 }
 
 std::vector<Room*> GameMap::getRoomsByType(RoomType type) const
@@ -1946,30 +2123,18 @@ std::vector<Building*> GameMap::getReachableBuildingsPerSeat(Seat* seat,
 
 Room* GameMap::getRoomByName(const std::string& name)
 {
-    for (Room* room : mRooms)
-    {
-        if(room->getName().compare(name) == 0)
-            return room;
-    }
-
-    return nullptr;
+    return static_cast<Room*>(mEntityRegistry.getEntityByName(EntityIndex::room, name));
 }
 
 Trap* GameMap::getTrapByName(const std::string& name)
 {
-    for (Trap* trap : mTraps)
-    {
-        if(trap->getName().compare(name) == 0)
-            return trap;
-    }
-
-    return nullptr;
+    return static_cast<Trap*>(mEntityRegistry.getEntityByName(EntityIndex::trap, name));
 }
 
 void GameMap::clearTraps()
 {
     // We need to work on a copy of mTraps because removeFromGameMap will remove them from this vector
-    std::vector<Trap*> traps = mTraps;
+    std::vector<Trap*> traps = mTraps.getEntities();
     for (Trap* trap : traps)
     {
         trap->removeFromGameMap();
@@ -1985,20 +2150,20 @@ void GameMap::addTrap(Trap *trap)
     OD_LOG_INF(serverStr() + "Adding trap " + trap->getName() + ", nbTiles="
         + Helper::toString(nbTiles) + ", seatId=" + Helper::toString(trap->getSeat()->getId()));
 
-    mTraps.push_back(trap);
+    mTraps.add(trap);
+    registerEntity(EntityIndex::trap, trap);
 }
 
 void GameMap::removeTrap(Trap *t)
 {
     OD_LOG_INF(serverStr() + "Removing trap " + t->getName());
-    std::vector<Trap*>::iterator it = std::find(mTraps.begin(), mTraps.end(), t);
-    if(it == mTraps.end())
+    if(!mTraps.remove(t))
     {
         OD_LOG_ERR("Trap name=" + t->getName());
         return;
     }
 
-    mTraps.erase(it);
+    unregisterEntity(EntityIndex::trap, t);
 }
 
 bool GameMap::withdrawFromTreasuries(int gold, Seat* seat)
@@ -2026,7 +2191,7 @@ bool GameMap::withdrawFromTreasuries(int gold, Seat* seat)
 void GameMap::clearMapLights()
 {
     // We need to work on a copy of mMapLights because removeFromGameMap will remove them from this vector
-    std::vector<MapLight*> mapLights = mMapLights;
+    std::vector<MapLight*> mapLights = mMapLights.getEntities();
     for (MapLight* mapLight : mapLights)
     {
         mapLight->removeFromGameMap();
@@ -2039,32 +2204,26 @@ void GameMap::clearMapLights()
 void GameMap::addMapLight(MapLight *m)
 {
     OD_LOG_INF(serverStr() + "Adding MapLight " + m->getName());
-    mMapLights.push_back(m);
+    mMapLights.add(m);
+    registerEntity(EntityIndex::mapLight, m);
 }
 
 void GameMap::removeMapLight(MapLight *m)
 {
     OD_LOG_INF(serverStr() + "Removing MapLight " + m->getName());
 
-    std::vector<MapLight*>::iterator it = std::find(mMapLights.begin(), mMapLights.end(), m);
-    if(it == mMapLights.end())
+    if(!mMapLights.remove(m))
     {
         OD_LOG_ERR("MapLight name=" + m->getName());
         return;
     }
 
-    mMapLights.erase(it);
+    unregisterEntity(EntityIndex::mapLight, m);
 }
 
 MapLight* GameMap::getMapLight(const std::string& name) const
 {
-    for (MapLight* mapLight : mMapLights)
-    {
-        if (mapLight->getName() == name)
-            return mapLight;
-    }
-
-    return nullptr;
+    return static_cast<MapLight*>(mEntityRegistry.getEntityByName(EntityIndex::mapLight, name));
 }
 
 void GameMap::clearSeats()
@@ -2217,21 +2376,92 @@ bool GameMap::doFloodFill(Seat* seat, Tile* tile)
 
 void GameMap::replaceFloodFill(Seat* seat, FloodFillType floodFillType, uint32_t colorOld, uint32_t colorNew)
 {
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
+    FloodFillPlane* plane = getFloodFillPlane(seat);
+    if(plane == nullptr)
+        return;
+
+    if((colorOld == Tile::NO_FLOODFILL) || (colorNew == Tile::NO_FLOODFILL))
+        return;
+
+    // Instead of repainting every tile with colorOld, we merge the colors. Tiles will then
+    // return colorNew as their floodfill value
+    plane->mSets[static_cast<uint32_t>(floodFillType)].merge(colorOld, colorNew);
+}
+
+GameMap::FloodFillPlane* GameMap::getFloodFillPlane(const Seat* seat) const
+{
+    if(seat->getTeamIndex() >= mFloodFillPlanes.size())
     {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
+        static bool logMsg = false;
+        if(!logMsg)
         {
-            Tile* tile = getTile(ii,jj);
-            if(tile->getFloodFillValue(seat, floodFillType) != colorOld)
-                continue;
-
-            tile->replaceFloodFill(seat, floodFillType, colorNew);
+            logMsg = true;
+            OD_LOG_ERR("Wrong floodfill seat index seatId=" + Helper::toString(seat->getId())
+                + ", seatIndex=" + Helper::toString(seat->getTeamIndex())
+                + ", floodfillsize=" + Helper::toString(static_cast<uint32_t>(mFloodFillPlanes.size())));
         }
+        return nullptr;
     }
+
+    return mFloodFillPlanes[seat->getTeamIndex()].get();
+}
+
+uint32_t GameMap::getFloodFillValue(const Tile& tile, const Seat* seat, FloodFillType type) const
+{
+    const FloodFillPlane* plane = getFloodFillPlane(seat);
+    if(plane == nullptr)
+        return Tile::NO_FLOODFILL;
+
+    uint32_t intType = static_cast<uint32_t>(type);
+    uint32_t index = static_cast<uint32_t>(tile.getX() + tile.getY() * getMapSizeX()) * static_cast<uint32_t>(FloodFillType::nbValues) + intType;
+    return plane->mSets[intType].find(plane->mColors[index]);
+}
+
+void GameMap::setFloodFillValue(const Tile& tile, const Seat* seat, FloodFillType type, uint32_t color)
+{
+    FloodFillPlane* plane = getFloodFillPlane(seat);
+    if(plane == nullptr)
+        return;
+
+    uint32_t index = static_cast<uint32_t>(tile.getX() + tile.getY() * getMapSizeX()) * static_cast<uint32_t>(FloodFillType::nbValues)
+        + static_cast<uint32_t>(type);
+    plane->mColors[index] = color;
+}
+
+std::vector<Seat*> GameMap::getFloodFillSeats() const
+{
+    std::vector<Seat*> seats;
+    std::vector<const FloodFillPlane*> planes;
+    for(Seat* seat : mSeats)
+    {
+        const FloodFillPlane* plane = getFloodFillPlane(seat);
+        if(plane == nullptr)
+            continue;
+
+        if(std::find(planes.begin(), planes.end(), plane) != planes.end())
+            continue;
+
+        planes.push_back(plane);
+        seats.push_back(seat);
+    }
+    return seats;
+}
+
+void GameMap::makeFloodFillPlanePrivate(const Seat* seat)
+{
+    if(seat->getTeamIndex() >= mFloodFillPlanes.size())
+        return;
+
+    std::shared_ptr<FloodFillPlane>& plane = mFloodFillPlanes[seat->getTeamIndex()];
+    if(plane.use_count() <= 1)
+        return;
+
+    plane = std::make_shared<FloodFillPlane>(*plane);
 }
 
 void GameMap::refreshFloodFill(Seat* seat, Tile* tile)
 {
+    Ogre::Timer stopwatch;
     std::vector<uint32_t> colors(static_cast<uint32_t>(FloodFillType::nbValues), Tile::NO_FLOODFILL);
 
     // If the tile has opened a new place, we use the same floodfillcolor for all the areas
@@ -2286,32 +2516,35 @@ void GameMap::refreshFloodFill(Seat* seat, Tile* tile)
             replaceFloodFill(seat, type, neighColor, color);
         }
     }
+
+    mTurnTimings.mFloodFill += stopwatch.getMicroseconds();
+    ++mTurnTimings.mNbFloodFillRefreshes;
 }
 
 void GameMap::enableFloodFill()
 {
     // Carry out a flood fill of the whole level to make sure everything is good.
-    // Start by setting the flood fill color for every tile on the map to -1.
-    for (int jj = 0; jj < getMapSizeY(); ++jj)
-    {
-        for (int ii = 0; ii < getMapSizeX(); ++ii)
-        {
-            getTile(ii,jj)->resetFloodFill();
-        }
-    }
+    // Every team shares the same colors until one of them locks a door (see doorLock)
+    std::shared_ptr<FloodFillPlane> plane = std::make_shared<FloodFillPlane>();
+    plane->mColors.assign(static_cast<uint32_t>(getMapSizeX() * getMapSizeY()) * static_cast<uint32_t>(FloodFillType::nbValues),
+        Tile::NO_FLOODFILL);
+    plane->mSets.resize(static_cast<uint32_t>(FloodFillType::nbValues));
+    mFloodFillPlanes.assign(mTeamIds.size(), plane);
 
     // The algorithm used to find a path is efficient when the path exists but not if it doesn't.
     // To improve path finding, we tag the contiguous tiles to know if a path exists between 2 tiles or not.
     // Because creatures can go through ground, water or lava, we process all of theses.
     // Note : when a tile is digged, floodfill will have to be refreshed.
     mFloodFillEnabled = true;
+    mHierarchicalPathfinding.reset(getMapSizeX(), getMapSizeY());
+    mFlowFieldCache.reset(getMapSizeX(), getMapSizeY());
 
     // To optimize floodfilling, we start by tagging the dirt tiles with fullness = 0
     // because they are walkable for most creatures. When we will have tagged all
     // thoses, we will deal with water/lava remaining (there can be some left if
     // surrounded by not passable tiles).
     FloodFillType currentType = FloodFillType::ground;
-    // We do the floodfill for the rogue seat. Then, once it is done, we copy for the other seats.
+    // We do the floodfill for the rogue seat. As every team shares the same plane, it is done for all the seats.
     // If there are locked doors, floodfill will be refreshed when they are added
     Seat* rogueSeat = getSeatRogue();
     while(true)
@@ -2440,40 +2673,27 @@ void GameMap::enableFloodFill()
                 ++yy;
         }
     }
-
-    // We copy floodfill for all seats
-    for(int xx = 0; xx < getMapSizeX(); ++xx)
-    {
-        for(int yy = 0; yy < getMapSizeY(); ++yy)
-        {
-            Tile* tile = getTile(xx, yy);
-            if(tile == nullptr)
-                continue;
-
-            tile->copyFloodFillToOtherSeats(rogueSeat);
-        }
-    }
 }
 
-std::list<Tile*> GameMap::path(Creature *c1, Creature *c2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
+std::vector<Tile*> GameMap::path(Creature *c1, Creature *c2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
 {
     return path(c1->getPositionTile()->getX(), c1->getPositionTile()->getY(),
                 c2->getPositionTile()->getX(), c2->getPositionTile()->getY(), creature, seat, throughDiggableTiles);
 }
 
-std::list<Tile*> GameMap::path(Tile *t1, Tile *t2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
+std::vector<Tile*> GameMap::path(Tile *t1, Tile *t2, const Creature* creature, Seat* seat, bool throughDiggableTiles)
 {
     return path(t1->getX(), t1->getY(), t2->getX(), t2->getY(), creature, seat, throughDiggableTiles);
 }
 
-std::list<Tile*> GameMap::path(const Creature* creature, Tile* destination, bool throughDiggableTiles)
+std::vector<Tile*> GameMap::path(const Creature* creature, Tile* destination, bool throughDiggableTiles)
 {
     if (destination == nullptr)
-        return std::list<Tile*>();
+        return std::vector<Tile*>();
 
     Tile* positionTile = creature->getPositionTile();
     if (positionTile == nullptr)
-        return std::list<Tile*>();
+        return std::vector<Tile*>();
 
     return path(positionTile->getX(), positionTile->getY(),
                 destination->getX(), destination->getY(),
@@ -2483,7 +2703,13 @@ std::list<Tile*> GameMap::path(const Creature* creature, Tile* destination, bool
 void GameMap::processDeletionQueues()
 {
     for(GameEntity* entity : mEntitiesToDelete)
+    {
+        // No message can use the name of the entity anymore
+        if(mIsServerGameMap)
+            ODServer::getSingleton().releaseString(entity->getName());
+
         delete entity;
+    }
 
     mEntitiesToDelete.clear();
 }
@@ -2721,6 +2947,31 @@ GameEntity* GameMap::getEntityFromTypeAndName(GameEntityType entityType,
     return nullptr;
 }
 
+void GameMap::registerEntity(EntityIndex index, GameEntity* entity)
+{
+    if(mEntityRegistry.getEntity(entity->getHandle()) != nullptr)
+    {
+        OD_LOG_ERR("Entity already registered name=" + entity->getName());
+        return;
+    }
+
+    entity->setHandle(mEntityRegistry.addHandle(entity));
+    if(entity->getHandle() == EntityRegistry::INVALID_HANDLE)
+        OD_LOG_ERR("Cannot allocate handle for entity name=" + entity->getName());
+
+    if(!mEntityRegistry.addName(index, entity->getName(), entity))
+        OD_LOG_ERR("Duplicate entity name=" + entity->getName());
+}
+
+void GameMap::unregisterEntity(EntityIndex index, GameEntity* entity)
+{
+    mEntityRegistry.removeName(index, entity->getName(), entity);
+    if(!mEntityRegistry.removeHandle(entity->getHandle()))
+        OD_LOG_ERR("Invalid handle=" + Helper::toString(entity->getHandle()) + ", name=" + entity->getName());
+
+    entity->setHandle(EntityRegistry::INVALID_HANDLE);
+}
+
 void GameMap::logFloodFileTiles()
 {
     for(int yy = 0; yy < getMapSizeY(); ++yy)
@@ -2782,6 +3033,7 @@ void GameMap::consoleSetLevelCreature(const std::string& creatureName, uint32_t
 void GameMap::consoleAskToggleFOW()
 {
     mIsFOWActivated = !mIsFOWActivated;
+    mVisionMap.setAllTilesVisible(!mIsFOWActivated);
 }
 
 void GameMap::consoleAskUnlockSkills()
@@ -2844,37 +3096,32 @@ void GameMap::addSpell(Spell *spell)
 {
     OD_LOG_INF(serverStr() + "Adding spell " + spell->getName()
         + ",MeshName=" + spell->getMeshName());
-    mSpells.push_back(spell);
+    mSpells.add(spell);
+    registerEntity(EntityIndex::spell, spell);
 }
 
 void GameMap::removeSpell(Spell *spell)
 {
     OD_LOG_INF(serverStr() + "Removing spell " + spell->getName()
         + ",MeshName=" + spell->getMeshName());
-    std::vector<Spell*>::iterator it = std::find(mSpells.begin(), mSpells.end(), spell);
-    if(it == mSpells.end())
+    if(!mSpells.remove(spell))
     {
         OD_LOG_ERR("spell name=" + spell->getName());
         return;
     }
 
-    mSpells.erase(it);
+    unregisterEntity(EntityIndex::spell, spell);
 }
 
 Spell* GameMap::getSpell(const std::string& name) const
 {
-    for(Spell* spell : mSpells)
-    {
-        if(name.compare(spell->getName()) == 0)
-            return spell;
-    }
-    return nullptr;
+    return static_cast<Spell*>(mEntityRegistry.getEntityByName(EntityIndex::spell, name));
 }
 
 void GameMap::clearSpells()
 {
     // We need to work on a copy of mSpells because removeFromGameMap will remove them from this vector
-    std::vector<Spell*> spells = mSpells;
+    std::vector<Spell*> spells = mSpells.getEntities();
     for (Spell* spell : spells)
     {
         spell->removeFromGameMap();
@@ -3047,16 +3294,12 @@ void GameMap::addClientUpkeepEntity(GameEntity* entity)
     if(isServerGameMap())
         return;
 
-    mGameEntityClientUpkeep.push_back(entity);
+    mGameEntityClientUpkeep.add(entity);
 }
 
 void GameMap::removeClientUpkeepEntity(GameEntity* entity)
 {
-    auto it = std::find(mGameEntityClientUpkeep.begin(), mGameEntityClientUpkeep.end(), entity);
-    if(it == mGameEntityClientUpkeep.end())
-        return;
-
-    mGameEntityClientUpkeep.erase(it);
+    mGameEntityClientUpkeep.remove(entity);
 }
 
 void GameMap::clientUpKeep(int64_t turnNumber)
@@ -3064,14 +3307,56 @@ void GameMap::clientUpKeep(int64_t turnNumber)
     mTurnNumber = turnNumber;
     mLocalPlayer->decreaseSpellCooldowns();
 
-    for(GameEntity* entity : mGameEntityClientUpkeep)
+    mGameEntityClientUpkeep.forEach([](GameEntity* entity)
     {
         entity->clientUpkeep();
+    });
+}
+
+void GameMap::tilePassabilityChanged(Tile& tile)
+{
+    mHierarchicalPathfinding.tilePassabilityChanged(tile.getX(), tile.getY());
+    mFlowFieldCache.tilePassabilityChanged(tile.getX(), tile.getY());
+    mVisionMap.tileVisionChanged(tile);
+}
+
+PathfindingGround GameMap::getPathfindingGround(int x, int y) const
+{
+    Tile* tile = getTile(x, y);
+    if((tile == nullptr) || (tile->getFullness() > 0.0))
+        return PathfindingGround::none;
+
+    // Bridges allow ground creatures to go over water and lava
+    Room* room = tile->getCoveringRoom();
+    if((room != nullptr) && room->isBridge())
+        return PathfindingGround::ground;
+
+    switch(tile->getType())
+    {
+        case TileType::dirt:
+        case TileType::gold:
+        case TileType::rock:
+            return PathfindingGround::ground;
+        case TileType::water:
+            return PathfindingGround::water;
+        case TileType::lava:
+            return PathfindingGround::lava;
+        default:
+            return PathfindingGround::none;
     }
 }
 
 void GameMap::doorLock(Tile* tileDoor, Seat* seat, bool locked)
 {
+    mHierarchicalPathfinding.setDoorLocked(tileDoor->getX(), tileDoor->getY(), seat->getTeamId(), locked);
+    mFlowFieldCache.setDoorLocked(tileDoor->getX(), tileDoor->getY(), seat->getTeamId(), locked);
+    // Locked doors block vision
+    mVisionMap.tileVisionChanged(*tileDoor);
+
+    // Only the door team is blocked. It cannot share its floodfill colors with the other teams anymore
+    if(locked)
+        makeFloodFillPlanePrivate(seat);
+
     if(!locked)
     {
         // When a door is unlocked, we check all its neighboors to find a floodfill value for each possible
@@ -3174,6 +3459,7 @@ void GameMap::doorLock(Tile* tileDoor, Seat* seat, bool locked)
 void GameMap::changeFloodFillConnectedTiles(Tile* startTile, Seat* seat, const std::vector<uint32_t>& oldColors,
     const std::vector<uint32_t>& newColors, Tile* tileIgnored)
 {
+    Ogre::Timer stopwatch;
     std::vector<Tile*> tiles;
     tiles.push_back(startTile);
     while(!tiles.empty())
@@ -3218,6 +3504,9 @@ void GameMap::changeFloodFillConnectedTiles(Tile* startTile, Seat* seat, const s
                 tile->replaceFloodFill(seat, type, newColors[i]);
         }
     }
+
+    mTurnTimings.mFloodFill += stopwatch.getMicroseconds();
+    ++mTurnTimings.mNbFloodFillRefreshes;
 }
 
 void GameMap::notifySeatsConfigured()
@@ -3247,20 +3536,9 @@ void GameMap::notifySeatsConfigured()
         seat->setTeamIndex(teamIndex);
     }
 
-    uint32_t nbTeams = mTeamIds.size();
-    for(int xxx = 0; xxx < getMapSizeX(); ++xxx)
-    {
-        for(int yyy = 0; yyy < getMapSizeY(); ++yyy)
-        {
-            Tile* tile = getTile(xxx, yyy);
-            if(tile == nullptr)
-                continue;
-
-            tile->setTeamsNumber(nbTeams);
-        }
-    }
-    // Now that team ids are set and tiles are configured, we can compute floodfill
+    // Now that team ids are set, we can compute floodfill and vision
     enableFloodFill();
+    mVisionMap.reset();
 }
 
 void GameMap::fireGameSound(Tile& tile, const std::string& soundFamily)
@@ -3275,7 +3553,8 @@ void GameMap::fireGameSound(Tile& tile, const std::string& soundFamily)
 
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::playSpatialSound, seat->getPlayer());
-        serverNotification->mPacket << sound << tile.getX() << tile.getY();
+        uint32_t soundId = ODServer::getSingleton().internString(sound);
+        serverNotification->mPacket << soundId << tile.getX() << tile.getY();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -18,7 +18,17 @@
 #ifndef GAMEMAP_H
 #define GAMEMAP_H
 
+#include "gamemap/AstarSearch.h"
+#include "gamemap/DisjointSet.h"
+#include "gamemap/EntityGrid.h"
+#include "gamemap/EntityList.h"
+#include "gamemap/EntityRegistry.h"
+#include "gamemap/FlowFieldCache.h"
+#include "gamemap/HierarchicalPathfinding.h"
+#include "gamemap/PathfindingGrid.h"
+#include "gamemap/StateChecksum.h"
 #include "gamemap/TileContainer.h"
+#include "gamemap/VisionMap.h"
 
 #include "ai/AIManager.h"
 
@@ -53,6 +63,7 @@ class Room;
 class Spell;
 class TileSet;
 class TileSetValue;
+class ThreadPool;
 
 enum class GameEntityType;
 enum class FloodFillType;
@@ -94,7 +105,7 @@ enum class SelectionEntityWanted
  * sortest path between two tiles" or "what creatures are in some particular
  * tile".
  */
-class GameMap : public TileContainer
+class GameMap : public TileContainer, public PathfindingGrid
 {
 
 friend class RenderManager;
@@ -160,12 +171,71 @@ public:
     inline bool getIsFOWActivated() const
     { return mIsFOWActivated; }
 
+    //! \brief In lockstep mode, a turn only depends on the random seed and on the client inputs (the server
+    //! uses a fixed turn length) and the state checksum is updated at the end of each turn
+    inline void setLockstep(bool lockstep)
+    { mIsLockstep = lockstep; }
+
+    inline bool isLockstep() const
+    { return mIsLockstep; }
+
+    inline const StateChecksum& getStateChecksum() const
+    { return mStateChecksum; }
+
+    //! \brief Combines the current state of the tiles, creatures, seats and rooms with the state checksum
+    void updateStateChecksum();
+
+    //! \brief Time spent in each phase of the turns (in microseconds) since the last call to
+    //! resetTurnTimings. The floodfill refreshes happen during the upkeep so they are also counted in mUpkeep
+    struct TurnTimings
+    {
+        TurnTimings() :
+            mMisc(0),
+            mVision(0),
+            mSearchOrder(0),
+            mUpkeep(0),
+            mSeats(0),
+            mPlayers(0),
+            mAI(0),
+            mFloodFill(0),
+            mNbFloodFillRefreshes(0),
+            mPath(0)
+        {}
+
+        //! \brief Pay day, goals and creature count
+        uint64_t mMisc;
+        uint64_t mVision;
+        uint64_t mSearchOrder;
+        uint64_t mUpkeep;
+        //! \brief Mana, gold and claimed tiles of each seat
+        uint64_t mSeats;
+        uint64_t mPlayers;
+        uint64_t mAI;
+        uint64_t mFloodFill;
+        uint64_t mNbFloodFillRefreshes;
+        //! \brief Time spent in path(), in nanoseconds. It is also counted in the phase calling it
+        uint64_t mPath;
+    };
+
+    inline const TurnTimings& getTurnTimings() const
+    { return mTurnTimings; }
+
+    inline void resetTurnTimings()
+    { mTurnTimings = TurnTimings(); }
+
+    //! \brief Number of calls to path() since the game map was created
+    inline unsigned int getNumCallsToPath() const
+    { return mNumCallsTo_path; }
+
+    inline const FlowFieldCache& getFlowFieldCache() const
+    { return mFlowFieldCache; }
+
     //! \brief Returns a vector containing all the creatures controlled by the given seat.
     std::vector<Creature*> getCreaturesByAlliedSeat(const Seat* seat) const;
     std::vector<Creature*> getCreaturesBySeat(const Seat* seat) const;
 
     inline const std::vector<Creature*>& getCreatures() const
-    { return mCreatures; }
+    { return mCreatures.getEntities(); }
 
     Creature* getWorkerToPickupBySeat(Seat* seat);
     Creature* getFighterToPickupBySeat(Seat* seat);
@@ -227,7 +297,7 @@ public:
 
     //! \brief A simple accessor method to return the number of Rooms stored in the GameMap.
     inline const std::vector<Room*>& getRooms() const
-    { return mRooms; }
+    { return mRooms.getEntities(); }
 
     std::vector<Room*> getRoomsByType(RoomType type) const;
     std::vector<Room*> getRoomsByTypeAndSeat(RoomType type,
@@ -248,7 +318,7 @@ public:
     void addTrap(Trap *t);
     void removeTrap(Trap *t);
     inline const std::vector<Trap*>& getTraps() const
-    { return mTraps; }
+    { return mTraps.getEntities(); }
 
     //! \brief Map Lights related functions.
     void clearMapLights();
@@ -256,7 +326,7 @@ public:
     void removeMapLight(MapLight *m);
     MapLight* getMapLight(const std::string& name) const;
     inline const std::vector<MapLight*>& getMapLights() const
-    { return mMapLights; }
+    { return mMapLights.getEntities(); }
 
     //! \brief Deletes the data structure for all the players in the GameMap.
     void clearPlayers();
@@ -356,9 +426,19 @@ public:
      * Note that this function will use some magic numbers to avoid computing paths that are likely to be
      * further
      */
-    std::list<Tile*> findBestPath(const Creature* creature, Tile* tileStart, const std::vector<Tile*> possibleDests,
+    std::vector<Tile*> findBestPath(const Creature* creature, Tile* tileStart, const std::vector<Tile*> possibleDests,
         Tile*& chosenTile);
 
+    /*! \brief Same as findBestPath but for destinations a lot of creatures head to (room entrances, call to war
+     * tile, dungeon temple, ...). The path is taken from a flow field shared by every creature walking the same
+     * way and looking for the same destinations. Unlike findBestPath, the closest reachable destination is always
+     * chosen. If the flow field cannot be used, findBestPath is called.
+     * It should not be used for destinations depending on the creature as each new set of destinations computes a
+     * distance map of the whole map.
+     */
+    std::vector<Tile*> findBestPathToSharedDests(const Creature* creature, Tile* tileStart,
+        const std::vector<Tile*>& possibleDests, Tile*& chosenTile);
+
     /*! \brief Calculates the walkable path between tiles (x1, y1) and (x2, y2).
      *
      * The search is carried out using the A-star search algorithm.
@@ -368,23 +448,39 @@ public:
      * the 4 nearest neighbors of the previous tile in the path.
      * When building the path, we check if a diagonal can be used. We consider it can
      * if the creature can go through the 4 tiles.
+     * Long paths (see HierarchicalPathfinding::MIN_DISTANCE) not going through diggable tiles
+     * are refined from the waypoints of the cluster abstraction. They are always walkable but
+     * may be a bit longer than the shortest one. Other paths are the exact A* result.
      * \param seat The seat is used when searching a diggable path to know
      * what tile actually diggable for the given team.
      */
-    std::list<Tile*> path(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
-    std::list<Tile*> path(Creature *c1, Creature *c2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
-    std::list<Tile*> path(Tile *t1, Tile *t2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
+    std::vector<Tile*> path(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
+    std::vector<Tile*> path(Creature *c1, Creature *c2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
+    std::vector<Tile*> path(Tile *t1, Tile *t2, const Creature* creature, Seat* seat, bool throughDiggableTiles = false);
     //! \note Returns a path for the given creature to the given destination.
-    std::list<Tile*> path(const Creature* creature, Tile* destination, bool throughDiggableTiles = false);
+    std::vector<Tile*> path(const Creature* creature, Tile* destination, bool throughDiggableTiles = false);
 
     //! \brief Loops over the visibleTiles and returns any creature/room/trap in those tiles allied with the given seat
     //! (or if enemyForce is true, is not allied)
     std::vector<GameEntity*> getVisibleForce(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyForce);
 
+    //! \brief Same as above when every visible tile is within radius of center. The tiles are not looped over
+    //! if the entity grid shows no matching entity around center
+    std::vector<GameEntity*> getVisibleForce(const std::vector<Tile*>& visibleTiles, const Tile* center, int radius,
+        Seat* seat, bool enemyForce);
+
     //! \brief Loops over the visibleTiles and returns any creature in those tiles allied with the given seat.
     //! (or if enemyCreatures is true, is not allied)
     std::vector<GameEntity*> getVisibleCreatures(const std::vector<Tile*>& visibleTiles, Seat* seat, bool enemyCreatures);
 
+    //! \brief Same as above when every visible tile is within radius of center
+    std::vector<GameEntity*> getVisibleCreatures(const std::vector<Tile*>& visibleTiles, const Tile* center, int radius,
+        Seat* seat, bool enemyCreatures);
+
+    //! \brief Returns false if there is for sure no creature (or building if withBuildings is true) allied
+    //! with the given seat (or not allied if enemyForce is true) within radius of center
+    bool mayHaveForceAround(const Tile* center, int radius, Seat* seat, bool enemyForce, bool withBuildings) const;
+
     //! \brief Loops over the given tiles and returns any carryable entity in those tiles
     std::vector<GameEntity*> getCarryableEntities(Creature* carrier, const std::vector<Tile*>& tiles);
 
@@ -393,8 +489,40 @@ public:
     //! already know that no path exists.
     bool doFloodFill(Seat* seat, Tile* tile);
     void refreshFloodFill(Seat* seat, Tile* tile);
+    //! \brief Merges colorOld into colorNew: every tile with colorOld will be considered as having colorNew.
+    //! Both colors are expected to be values returned by Tile::getFloodFillValue
     void replaceFloodFill(Seat* seat, FloodFillType floodFillType, uint32_t colorOld, uint32_t colorNew);
 
+    //! \brief Floodfill values of the given tile for the given seat team
+    uint32_t getFloodFillValue(const Tile& tile, const Seat* seat, FloodFillType type) const;
+    void setFloodFillValue(const Tile& tile, const Seat* seat, FloodFillType type, uint32_t color);
+
+    //! \brief Returns one seat for each distinct floodfill plane. Updates that do not depend on the seat (tile
+    //! dug, bridge built, ...) should be done for these seats only because the other ones share the same colors
+    std::vector<Seat*> getFloodFillSeats() const;
+
+    //! \brief To be called when the given tile may have become passable or not passable (dug, bridge built, ...)
+    void tilePassabilityChanged(Tile& tile);
+
+    PathfindingGround getPathfindingGround(int x, int y) const override;
+
+    //! \brief Server side vision of the seats. Entities giving vision should update their contribution
+    //! in computeVisibleTiles (called once per turn)
+    inline VisionMap& getVisionMap()
+    { return mVisionMap; }
+
+    //! \brief Creatures and buildings by area. Kept up to date by the tiles
+    inline EntityGrid& getEntityGrid()
+    { return mEntityGrid; }
+
+    //! \brief Worker threads used to process the upkeep in parallel. Only created on the server game map
+    inline ThreadPool* getThreadPool()
+    { return mThreadPool.get(); }
+
+    //! \brief Recreates the worker threads of the server game map with the given number of threads
+    //! (0 for the number of hardware threads). The turns give the same result whatever the number of threads
+    void setNbThreads(uint32_t nbThreads);
+
     //! \brief Temporarily disables the flood fill computations on this game map.
     void disableFloodFill()
     { mFloodFillEnabled = false; }
@@ -477,9 +605,13 @@ public:
     GameEntity* getEntityFromTypeAndName(GameEntityType entityType,
         const std::string& entityName);
 
+    //! \brief Returns the entity with the given handle or nullptr if it is not on the gamemap anymore
+    inline GameEntity* getEntityFromHandle(uint32_t handle) const
+    { return mEntityRegistry.getEntity(handle); }
+
     //! brief Functions to add/remove/get Spells
     inline const std::vector<Spell*>& getSpells() const
-    { return mSpells; }
+    { return mSpells.getEntities(); }
     void addSpell(Spell *spell);
     void removeSpell(Spell *spell);
     Spell* getSpell(const std::string& name) const;
@@ -500,7 +632,7 @@ public:
     void fireRefreshEntities();
 
     inline const std::vector<RenderedMovableEntity*>& getRenderedMovableEntities() const
-    { return mRenderedMovableEntities; }
+    { return mRenderedMovableEntities.getEntities(); }
 
     inline void setTileSetName(const std::string& tileSetName)
     { mTileSetName = tileSetName; }
@@ -565,6 +697,18 @@ private:
     int mUniqueNumberMapLight;
     uint32_t mUniqueFloodFillValue;
 
+    //! \brief Floodfill colors of every tile with the merged colors for each FloodFillType
+    struct FloodFillPlane
+    {
+        //! \brief Raw tile colors. Index is (x + y * mapSizeX) * FloodFillType::nbValues + type
+        std::vector<uint32_t> mColors;
+        std::vector<DisjointSet> mSets;
+    };
+
+    //! \brief Floodfill plane used by each team. Teams share the same plane until one of them
+    //! locks a door (copy on write)
+    std::vector<std::shared_ptr<FloodFillPlane>> mFloodFillPlanes;
+
     //! \brief When paused, the GameMap is not updated.
     bool mIsPaused;
 
@@ -579,7 +723,7 @@ private:
     std::string mMapInfoMusicFile;
     std::string mMapInfoFightMusicFile;
 
-    std::vector<Creature*> mCreatures;
+    EntityList<Creature> mCreatures;
 
     //! \brief The creature definition data. We use a pair to be able to make the difference between the original
     //! data from the global creature definition file and the specific data from the level file. With this trick,
@@ -589,12 +733,12 @@ private:
     std::vector<std::pair<const Weapon*,Weapon*> > mWeapons;
 
     //Mutable to allow locking in const functions.
-    std::vector<MovableGameEntity*> mAnimatedObjects;
+    EntityList<MovableGameEntity> mAnimatedObjects;
 
     //! \brief Map Entities
-    std::vector<Room*> mRooms;
-    std::vector<Trap*> mTraps;
-    std::vector<MapLight*> mMapLights;
+    EntityList<Room> mRooms;
+    EntityList<Trap> mTraps;
+    EntityList<MapLight> mMapLights;
 
     //! \brief Players and available game player slots (Seats)
     std::vector<Player*> mPlayers;
@@ -605,7 +749,7 @@ private:
     std::vector<std::unique_ptr<Goal>> mGoalsForAllSeats;
 
     //! \brief Entities that want to be notified for upkeep on client side
-    std::vector<GameEntity*> mGameEntityClientUpkeep;
+    EntityList<GameEntity> mGameEntityClientUpkeep;
 
     //! \brief Tells whether the map color flood filling is enabled.
     bool mFloodFillEnabled;
@@ -613,7 +757,10 @@ private:
     //! When true, fog of war will work normally. When false, every connected client will see the whole map
     bool mIsFOWActivated;
 
-    std::vector<GameEntity*> mActiveObjects;
+    bool mIsLockstep;
+    StateChecksum mStateChecksum;
+
+    EntityList<GameEntity> mActiveObjects;
 
     //! \brief Useless entities that need to be deleted. They will be deleted when processDeletionQueues is called
     std::vector<GameEntity*> mEntitiesToDelete;
@@ -621,9 +768,39 @@ private:
     //! \brief Debug member used to know how many call to pathfinding has been made within the same turn.
     unsigned int mNumCallsTo_path;
 
-    std::vector<RenderedMovableEntity*> mRenderedMovableEntities;
+    TurnTimings mTurnTimings;
 
-    std::vector<Spell*> mSpells;
+    //! \brief Nodes and open list used by path(). Kept between calls to avoid allocating them for each search.
+    AstarSearch mAstarSearch;
+
+    //! \brief Cluster abstraction of the map used by path() to speed up long searches.
+    HierarchicalPathfinding mHierarchicalPathfinding;
+
+    //! \brief Distance maps shared by the creatures heading to the same destinations (see findBestPath).
+    FlowFieldCache mFlowFieldCache;
+
+    //! \brief Number of vision sources of each team on each tile.
+    VisionMap mVisionMap;
+
+    //! \brief Handles and name indexes of the entities on the gamemap.
+    EntityRegistry mEntityRegistry;
+
+    //! \brief Creatures and buildings by area, used to skip the visible tiles when there is nobody around.
+    EntityGrid mEntityGrid;
+
+    //! \brief Worker threads for the parallel parts of the upkeep (see doMiscUpkeep)
+    std::unique_ptr<ThreadPool> mThreadPool;
+
+    //! \brief One sight workspace for each thread of mThreadPool
+    std::vector<TileContainer::SightWorkspace> mSightWorkspaces;
+
+    //! \brief Gives a handle to the entity and indexes its name. Used by the add*/remove* functions
+    void registerEntity(EntityIndex index, GameEntity* entity);
+    void unregisterEntity(EntityIndex index, GameEntity* entity);
+
+    EntityList<RenderedMovableEntity> mRenderedMovableEntities;
+
+    EntityList<Spell> mSpells;
 
     std::vector<int> mTeamIds;
 
@@ -640,6 +817,32 @@ private:
 
     //! \brief Resets the unique numbers
     void resetUniqueNumbers();
+
+    FloodFillPlane* getFloodFillPlane(const Seat* seat) const;
+
+    //! \brief Gives the team of the given seat its own copy of its floodfill plane if it is shared
+    void makeFloodFillPlanePrivate(const Seat* seat);
+
+    //! \brief Fills returnList with the path to the closest tile in possibleDests using a cached flow field.
+    //! Returns false if the flow field gives no path the creature can walk
+    bool findBestPathFlowField(const Creature& creature, Tile& tileStart, const std::vector<Tile*>& possibleDests,
+        Tile*& chosenTile, std::vector<Tile*>& returnList);
+
+    //! \brief Returns the flood fill type matching the tiles the given creature can walk on
+    static FloodFillType getFloodFillTypeForCreature(const Creature& creature);
+
+    //! \brief Fills returnList with the path between tiles (x1, y1) and (x2, y2). See path()
+    void searchPath(int x1, int y1, int x2, int y2, const Creature* creature, Seat* seat, bool throughDiggableTiles,
+        std::vector<Tile*>& returnList);
+
+    //! \brief A* search used by path(). Fills returnList and returns true if a path was found
+    bool computePath(Tile& start, Tile& destination, const Creature& creature, Seat* seat,
+        bool throughDiggableTiles, std::vector<Tile*>& returnList);
+
+    //! \brief Searches a path using mHierarchicalPathfinding to get waypoints and computes the real
+    //! path between each of them. Returns false if the abstraction could not give a valid path
+    bool computeHierarchicalPath(Tile& start, Tile& destination, const Creature& creature, Seat* seat,
+        std::vector<Tile*>& returnList);
 };
 
 #endif // GAMEMAP_H
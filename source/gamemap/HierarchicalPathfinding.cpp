@@ -0,0 +1,410 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/HierarchicalPathfinding.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+const int HierarchicalPathfinding::CLUSTER_SIZE = 10;
+const int HierarchicalPathfinding::MIN_DISTANCE = 2 * CLUSTER_SIZE;
+const int HierarchicalPathfinding::NO_TEAM = -1;
+const int HierarchicalPathfinding::ALL_TEAMS = -2;
+
+//! \brief Entrances on a border are placed at the middle of each passable span. If a span
+//! is longer than this, one entrance is placed at each end instead
+static const int MAX_SINGLE_ENTRANCE_SPAN = 5;
+
+static inline int manhattanDistance(int x1, int y1, int x2, int y2)
+{
+    return std::abs(x2 - x1) + std::abs(y2 - y1);
+}
+
+HierarchicalPathfinding::HierarchicalPathfinding(const PathfindingGrid& grid) :
+    mGrid(grid),
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mNbClustersX(0),
+    mNbClustersY(0)
+{
+}
+
+void HierarchicalPathfinding::reset(int mapSizeX, int mapSizeY)
+{
+    mMapSizeX = mapSizeX;
+    mMapSizeY = mapSizeY;
+    mNbClustersX = (mapSizeX + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+    mNbClustersY = (mapSizeY + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    mTeamGraphs.clear();
+    mLockedDoors.assign(static_cast<uint32_t>(mapSizeX * mapSizeY), NO_TEAM);
+    mSearch.resize(mapSizeX, mapSizeY);
+    mBfsDistances.assign(static_cast<uint32_t>(CLUSTER_SIZE * CLUSTER_SIZE), -1);
+    mGoalDistances.assign(static_cast<uint32_t>(CLUSTER_SIZE * CLUSTER_SIZE), -1);
+    mBfsQueue.clear();
+    mBfsQueue.reserve(static_cast<uint32_t>(CLUSTER_SIZE * CLUSTER_SIZE));
+}
+
+void HierarchicalPathfinding::tilePassabilityChanged(int x, int y)
+{
+    if(mLockedDoors.empty())
+        return;
+
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return;
+
+    int clusterX = x / CLUSTER_SIZE;
+    int clusterY = y / CLUSTER_SIZE;
+    markDirty(clusterX, clusterY);
+
+    // If the tile is on a border, the entrances of the neighbour cluster depend on it too
+    if((x % CLUSTER_SIZE) == 0)
+        markDirty(clusterX - 1, clusterY);
+    if((x % CLUSTER_SIZE) == CLUSTER_SIZE - 1)
+        markDirty(clusterX + 1, clusterY);
+    if((y % CLUSTER_SIZE) == 0)
+        markDirty(clusterX, clusterY - 1);
+    if((y % CLUSTER_SIZE) == CLUSTER_SIZE - 1)
+        markDirty(clusterX, clusterY + 1);
+}
+
+void HierarchicalPathfinding::setDoorLocked(int x, int y, int teamId, bool locked)
+{
+    if(mLockedDoors.empty())
+        return;
+
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return;
+
+    mLockedDoors[toTileIndex(x, y)] = locked ? teamId : NO_TEAM;
+    tilePassabilityChanged(x, y);
+}
+
+void HierarchicalPathfinding::markDirty(int clusterX, int clusterY)
+{
+    if((clusterX < 0) || (clusterY < 0) || (clusterX >= mNbClustersX) || (clusterY >= mNbClustersY))
+        return;
+
+    for(TeamGraph& graph : mTeamGraphs)
+    {
+        graph.mDirtyClusters[clusterX + clusterY * mNbClustersX] = true;
+        graph.mHasDirtyClusters = true;
+    }
+}
+
+HierarchicalPathfinding::TeamGraph& HierarchicalPathfinding::getTeamGraph(int teamId)
+{
+    for(TeamGraph& graph : mTeamGraphs)
+    {
+        if(graph.mTeamId == teamId)
+            return graph;
+    }
+
+    uint32_t nbClusters = static_cast<uint32_t>(mNbClustersX * mNbClustersY);
+    TeamGraph graph;
+    graph.mTeamId = teamId;
+    graph.mNodes.assign(static_cast<uint32_t>(FloodFillType::nbValues), std::vector<std::vector<ClusterNode>>(nbClusters));
+    graph.mDirtyClusters.assign(nbClusters, true);
+    graph.mHasDirtyClusters = (nbClusters > 0);
+    mTeamGraphs.push_back(graph);
+    return mTeamGraphs.back();
+}
+
+bool HierarchicalPathfinding::isPassable(int x, int y, FloodFillType type, int teamId) const
+{
+    if((x < 0) || (y < 0) || (x >= mMapSizeX) || (y >= mMapSizeY))
+        return false;
+
+    int doorTeamId = mLockedDoors[toTileIndex(x, y)];
+    if((doorTeamId != NO_TEAM) && ((teamId == ALL_TEAMS) || (doorTeamId == teamId)))
+        return false;
+
+    return PathfindingGrid::isPassable(mGrid.getPathfindingGround(x, y), type);
+}
+
+int HierarchicalPathfinding::clusterLocalIndex(int x, int y) const
+{
+    return (x % CLUSTER_SIZE) + (y % CLUSTER_SIZE) * CLUSTER_SIZE;
+}
+
+void HierarchicalPathfinding::computeClusterDistances(int x, int y, FloodFillType type, int teamId, std::vector<int32_t>& distances)
+{
+    std::fill(distances.begin(), distances.end(), -1);
+    if(!isPassable(x, y, type, teamId))
+        return;
+
+    int minX = (x / CLUSTER_SIZE) * CLUSTER_SIZE;
+    int minY = (y / CLUSTER_SIZE) * CLUSTER_SIZE;
+    int maxX = std::min(minX + CLUSTER_SIZE, mMapSizeX);
+    int maxY = std::min(minY + CLUSTER_SIZE, mMapSizeY);
+
+    // Diagonal moves cost the same as 2 straight moves in GameMap::path so a breadth
+    // first search on the 4 neighbours gives the exact distance
+    static const int dirX[4] = { 1, -1, 0, 0 };
+    static const int dirY[4] = { 0, 0, 1, -1 };
+
+    mBfsQueue.clear();
+    distances[clusterLocalIndex(x, y)] = 0;
+    mBfsQueue.push_back(toTileIndex(x, y));
+    for(uint32_t i = 0; i < mBfsQueue.size(); ++i)
+    {
+        int current = mBfsQueue[i];
+        int currentX = mSearch.indexToX(current);
+        int currentY = mSearch.indexToY(current);
+        int32_t currentDistance = distances[clusterLocalIndex(currentX, currentY)];
+        for(int dir = 0; dir < 4; ++dir)
+        {
+            int neighX = currentX + dirX[dir];
+            int neighY = currentY + dirY[dir];
+            if((neighX < minX) || (neighY < minY) || (neighX >= maxX) || (neighY >= maxY))
+                continue;
+
+            int32_t& neighDistance = distances[clusterLocalIndex(neighX, neighY)];
+            if(neighDistance >= 0)
+                continue;
+
+            if(!isPassable(neighX, neighY, type, teamId))
+                continue;
+
+            neighDistance = currentDistance + 1;
+            mBfsQueue.push_back(toTileIndex(neighX, neighY));
+        }
+    }
+}
+
+void HierarchicalPathfinding::addBorderEntrances(int x, int y, int stepX, int stepY, int dx, int dy, int length,
+    FloodFillType type, int teamId, std::vector<ClusterNode>& nodes)
+{
+    // Both clusters sharing a border compute the same entrances because the result only depends
+    // on the tiles on each side of the border
+    int spanStart = -1;
+    for(int i = 0; i <= length; ++i)
+    {
+        int tileX = x + i * stepX;
+        int tileY = y + i * stepY;
+        bool passable = (i < length) &&
+            isPassable(tileX, tileY, type, teamId) &&
+            isPassable(tileX + dx, tileY + dy, type, teamId);
+
+        if(passable)
+        {
+            if(spanStart < 0)
+                spanStart = i;
+            continue;
+        }
+
+        if(spanStart < 0)
+            continue;
+
+        int spanLength = i - spanStart;
+        int entrances[2];
+        int nbEntrances;
+        if(spanLength <= MAX_SINGLE_ENTRANCE_SPAN)
+        {
+            entrances[0] = spanStart + spanLength / 2;
+            nbEntrances = 1;
+        }
+        else
+        {
+            entrances[0] = spanStart;
+            entrances[1] = i - 1;
+            nbEntrances = 2;
+        }
+        spanStart = -1;
+
+        for(int k = 0; k < nbEntrances; ++k)
+        {
+            int entranceX = x + entrances[k] * stepX;
+            int entranceY = y + entrances[k] * stepY;
+            int32_t entranceTile = toTileIndex(entranceX, entranceY);
+            Link link;
+            link.mTile = toTileIndex(entranceX + dx, entranceY + dy);
+            link.mCost = 1;
+
+            // A corner tile may be an entrance for 2 borders
+            auto it = std::find_if(nodes.begin(), nodes.end(), [entranceTile](const ClusterNode& node)
+                { return node.mTile == entranceTile; });
+            if(it == nodes.end())
+            {
+                ClusterNode node;
+                node.mTile = entranceTile;
+                nodes.push_back(node);
+                it = nodes.end() - 1;
+            }
+            it->mLinks.push_back(link);
+        }
+    }
+}
+
+void HierarchicalPathfinding::rebuildCluster(int clusterX, int clusterY, FloodFillType type, int teamId,
+    std::vector<ClusterNode>& nodes)
+{
+    nodes.clear();
+
+    int minX = clusterX * CLUSTER_SIZE;
+    int minY = clusterY * CLUSTER_SIZE;
+    int maxX = std::min(minX + CLUSTER_SIZE, mMapSizeX) - 1;
+    int maxY = std::min(minY + CLUSTER_SIZE, mMapSizeY) - 1;
+    int width = maxX - minX + 1;
+    int height = maxY - minY + 1;
+
+    if(clusterY > 0)
+        addBorderEntrances(minX, minY, 1, 0, 0, -1, width, type, teamId, nodes);
+    if(clusterY < mNbClustersY - 1)
+        addBorderEntrances(minX, maxY, 1, 0, 0, 1, width, type, teamId, nodes);
+    if(clusterX > 0)
+        addBorderEntrances(minX, minY, 0, 1, -1, 0, height, type, teamId, nodes);
+    if(clusterX < mNbClustersX - 1)
+        addBorderEntrances(maxX, minY, 0, 1, 1, 0, height, type, teamId, nodes);
+
+    // Links between the entrances of the cluster
+    for(ClusterNode& node : nodes)
+    {
+        computeClusterDistances(mSearch.indexToX(node.mTile), mSearch.indexToY(node.mTile), type, teamId, mBfsDistances);
+        for(const ClusterNode& other : nodes)
+        {
+            if(other.mTile == node.mTile)
+                continue;
+
+            int32_t distance = mBfsDistances[clusterLocalIndex(mSearch.indexToX(other.mTile), mSearch.indexToY(other.mTile))];
+            if(distance < 0)
+                continue;
+
+            Link link;
+            link.mTile = other.mTile;
+            link.mCost = distance;
+            node.mLinks.push_back(link);
+        }
+    }
+}
+
+void HierarchicalPathfinding::rebuildDirtyClusters(TeamGraph& graph)
+{
+    if(!graph.mHasDirtyClusters)
+        return;
+
+    for(int clusterY = 0; clusterY < mNbClustersY; ++clusterY)
+    {
+        for(int clusterX = 0; clusterX < mNbClustersX; ++clusterX)
+        {
+            uint32_t clusterIndex = static_cast<uint32_t>(clusterX + clusterY * mNbClustersX);
+            if(!graph.mDirtyClusters[clusterIndex])
+                continue;
+
+            for(uint32_t i = 0; i < static_cast<uint32_t>(FloodFillType::nbValues); ++i)
+                rebuildCluster(clusterX, clusterY, static_cast<FloodFillType>(i), graph.mTeamId, graph.mNodes[i][clusterIndex]);
+
+            graph.mDirtyClusters[clusterIndex] = false;
+        }
+    }
+    graph.mHasDirtyClusters = false;
+}
+
+bool HierarchicalPathfinding::findWaypoints(int startX, int startY, int destX, int destY, FloodFillType type, int teamId,
+    std::vector<int32_t>& waypoints)
+{
+    waypoints.clear();
+    if(mLockedDoors.empty())
+        return false;
+
+    int startCluster = clusterIndexOf(startX, startY);
+    int destCluster = clusterIndexOf(destX, destY);
+    if(startCluster == destCluster)
+        return false;
+
+    if(!isPassable(startX, startY, type, teamId) || !isPassable(destX, destY, type, teamId))
+        return false;
+
+    TeamGraph& graph = getTeamGraph(teamId);
+    rebuildDirtyClusters(graph);
+
+    const std::vector<std::vector<ClusterNode>>& nodes = graph.mNodes[static_cast<uint32_t>(type)];
+    int startTile = toTileIndex(startX, startY);
+    int destTile = toTileIndex(destX, destY);
+
+    // The start and destination tiles are linked to the entrances of their cluster
+    computeClusterDistances(startX, startY, type, teamId, mBfsDistances);
+    computeClusterDistances(destX, destY, type, teamId, mGoalDistances);
+
+    mSearch.newSearch();
+    mSearch.open(startTile, 0.0, manhattanDistance(startX, startY, destX, destY), -1);
+    while(!mSearch.isOpenListEmpty())
+    {
+        int current = mSearch.popLowest();
+        if(current == destTile)
+            break;
+
+        int currentX = mSearch.indexToX(current);
+        int currentY = mSearch.indexToY(current);
+        int currentCluster = clusterIndexOf(currentX, currentY);
+        double currentG = mSearch.getG(current);
+
+        auto visit = [&](int32_t tile, int32_t cost)
+        {
+            if(mSearch.isClosed(tile))
+                return;
+
+            double g = currentG + cost;
+            if(!mSearch.isVisited(tile))
+            {
+                double h = manhattanDistance(mSearch.indexToX(tile), mSearch.indexToY(tile), destX, destY);
+                mSearch.open(tile, g, h, current);
+            }
+            else if(g < mSearch.getG(tile))
+            {
+                mSearch.decreaseG(tile, g, current);
+            }
+        };
+
+        if(current == startTile)
+        {
+            for(const ClusterNode& node : nodes[startCluster])
+            {
+                int32_t distance = mBfsDistances[clusterLocalIndex(mSearch.indexToX(node.mTile), mSearch.indexToY(node.mTile))];
+                if(distance >= 0)
+                    visit(node.mTile, distance);
+            }
+        }
+
+        for(const ClusterNode& node : nodes[currentCluster])
+        {
+            if(node.mTile != current)
+                continue;
+
+            for(const Link& link : node.mLinks)
+                visit(link.mTile, link.mCost);
+
+            break;
+        }
+
+        if(currentCluster == destCluster)
+        {
+            int32_t distance = mGoalDistances[clusterLocalIndex(currentX, currentY)];
+            if(distance >= 0)
+                visit(destTile, distance);
+        }
+    }
+
+    if(!mSearch.isClosed(destTile))
+        return false;
+
+    for(int index = destTile; index != -1; index = mSearch.getParent(index))
+        waypoints.push_back(index);
+
+    std::reverse(waypoints.begin(), waypoints.end());
+    return true;
+}
@@ -0,0 +1,161 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIERARCHICALPATHFINDING_H
+#define HIERARCHICALPATHFINDING_H
+
+#include "gamemap/AstarSearch.h"
+#include "gamemap/PathfindingGrid.h"
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Abstraction of the map used to speed up long path searches (HPA*).
+ *
+ * The map is split in square clusters of CLUSTER_SIZE tiles. On each border between 2
+ * clusters, entrances are placed on the walkable tiles. For each FloodFillType, the
+ * distance between every entrance of a cluster is computed once and cached. A long
+ * path is first searched on this small graph. The returned waypoints are then used
+ * by GameMap::path to compute the real path step by step.
+ *
+ * The passability used here only depends on the tiles (PathfindingGrid and locked
+ * doors). It does not depend on the creature speed so the waypoints may not
+ * give the fastest path. But as the refined path uses the creature constraints, it is
+ * always valid.
+ * Note that, unlike a plain A* search, the path going through the waypoints is only
+ * near optimal: the entrances are fixed tiles on the cluster borders and the path has
+ * to go through them.
+ *
+ * Like in GameMap::path, a locked door only blocks the creatures of its team. Every team
+ * that searches a path gets its own abstract graph where only its doors are locked. The
+ * graphs are built when a team first needs one.
+ *
+ * When a tile passability changes, the clusters it belongs to are marked as dirty
+ * and will be rebuilt the next time a path is requested.
+ */
+class HierarchicalPathfinding
+{
+public:
+    //! \brief Number of tiles in each direction of a cluster
+    static const int CLUSTER_SIZE;
+
+    //! \brief Team id used for tiles without locked door and for searches not blocked by any door
+    static const int NO_TEAM;
+
+    //! \brief Team id used for searches blocked by every locked door (workers, see GameMap::pathExists)
+    static const int ALL_TEAMS;
+
+    //! \brief Paths with a manhattan distance lower than this should not use the abstraction
+    static const int MIN_DISTANCE;
+
+    HierarchicalPathfinding(const PathfindingGrid& grid);
+
+    //! \brief Discards every computed cluster and resizes the abstraction to fit the given
+    //! map size. Clusters will be computed when they are needed.
+    void reset(int mapSizeX, int mapSizeY);
+
+    //! \brief To be called when the given tile passability may have changed (dug, claimed,
+    //! bridge built, ...). The clusters it belongs to will be rebuilt when needed.
+    void tilePassabilityChanged(int x, int y);
+
+    //! \brief Locked doors are considered as not passable by the creatures of the given team.
+    void setDoorLocked(int x, int y, int teamId, bool locked);
+
+    /*! \brief Searches the abstract graph between start and dest for the given flood fill type.
+     * The locked doors of teamId block the search (every locked door if teamId is ALL_TEAMS).
+     * If a path is found, waypoints is filled with the indexes (x + y * mapSizeX) of the tiles
+     * (start and dest included) that should be reached one after the other and true is returned.
+     * Consecutive waypoints are always in the same cluster or in adjacent clusters.
+     * Returns false if no path could be found or if start and dest are in the same cluster.
+     */
+    bool findWaypoints(int startX, int startY, int destX, int destY, FloodFillType type, int teamId,
+        std::vector<int32_t>& waypoints);
+
+private:
+    struct Link
+    {
+        int32_t mTile;
+        int32_t mCost;
+    };
+
+    //! \brief Entrance tile of a cluster with the tiles that can be reached from it
+    struct ClusterNode
+    {
+        int32_t mTile;
+        std::vector<Link> mLinks;
+    };
+
+    //! \brief Abstract graph seen by the creatures of a team
+    struct TeamGraph
+    {
+        int mTeamId;
+
+        //! \brief Cluster nodes for each FloodFillType. mNodes[type][clusterIndex]
+        std::vector<std::vector<std::vector<ClusterNode>>> mNodes;
+
+        //! \brief Clusters that need to be rebuilt
+        std::vector<bool> mDirtyClusters;
+        bool mHasDirtyClusters;
+    };
+
+    const PathfindingGrid& mGrid;
+    int mMapSizeX;
+    int mMapSizeY;
+    int mNbClustersX;
+    int mNbClustersY;
+
+    std::vector<TeamGraph> mTeamGraphs;
+
+    //! \brief For each tile, team of the locked door covering it (NO_TEAM if none)
+    std::vector<int> mLockedDoors;
+
+    //! \brief Search state for the abstract graph. Nodes are identified by their tile index
+    AstarSearch mSearch;
+
+    //! \brief Scratch buffers used by the breadth first searches inside a cluster
+    std::vector<int32_t> mBfsDistances;
+    std::vector<int32_t> mBfsQueue;
+    std::vector<int32_t> mGoalDistances;
+
+    inline int toTileIndex(int x, int y) const
+    { return mSearch.toIndex(x, y); }
+
+    inline int clusterIndexOf(int x, int y) const
+    { return (x / CLUSTER_SIZE) + (y / CLUSTER_SIZE) * mNbClustersX; }
+
+    bool isPassable(int x, int y, FloodFillType type, int teamId) const;
+
+    void markDirty(int clusterX, int clusterY);
+
+    //! \brief Returns the graph of the given team. It is created (with every cluster dirty) if needed
+    TeamGraph& getTeamGraph(int teamId);
+    void rebuildDirtyClusters(TeamGraph& graph);
+    void rebuildCluster(int clusterX, int clusterY, FloodFillType type, int teamId, std::vector<ClusterNode>& nodes);
+
+    //! \brief Adds to nodes the entrances on the border between the tile line starting at (x, y) and the
+    //! adjacent line at (x + dx, y + dy). The line is followed along (stepX, stepY) for length tiles
+    void addBorderEntrances(int x, int y, int stepX, int stepY, int dx, int dy, int length,
+        FloodFillType type, int teamId, std::vector<ClusterNode>& nodes);
+
+    //! \brief Computes the walking distance from (x, y) to every tile of its cluster. Unreachable
+    //! tiles get -1. Distances are indexed by the tile position inside the cluster
+    void computeClusterDistances(int x, int y, FloodFillType type, int teamId, std::vector<int32_t>& distances);
+
+    int clusterLocalIndex(int x, int y) const;
+};
+
+#endif // HIERARCHICALPATHFINDING_H
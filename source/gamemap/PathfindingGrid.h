@@ -0,0 +1,69 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATHFINDINGGRID_H
+#define PATHFINDINGGRID_H
+
+enum class FloodFillType
+{
+    ground = 0,
+    groundWater,
+    groundLava,
+    groundWaterLava,
+    nbValues
+};
+
+//! \brief What a creature walks on when going through a tile
+enum class PathfindingGround
+{
+    none, // Full tiles and tiles no creature can walk on
+    ground, // Bridges over water or lava are ground
+    water,
+    lava
+};
+
+/*! \brief Passability of the map tiles as seen by the pathfinding helpers (HierarchicalPathfinding
+ * and FlowFieldCache). GameMap implements it from its tiles. The helpers do not depend on the real
+ * tiles so that they can be tested on simple grids.
+ */
+class PathfindingGrid
+{
+public:
+    virtual ~PathfindingGrid()
+    {}
+
+    //! \brief Only called for coordinates within the map
+    virtual PathfindingGround getPathfindingGround(int x, int y) const = 0;
+
+    //! \brief Returns true if a creature with the given flood fill type can walk on ground
+    static inline bool isPassable(PathfindingGround ground, FloodFillType type)
+    {
+        switch(ground)
+        {
+            case PathfindingGround::ground:
+                return true;
+            case PathfindingGround::water:
+                return (type == FloodFillType::groundWater) || (type == FloodFillType::groundWaterLava);
+            case PathfindingGround::lava:
+                return (type == FloodFillType::groundLava) || (type == FloodFillType::groundWaterLava);
+            default:
+                return false;
+        }
+    }
+};
+
+#endif // PATHFINDINGGRID_H
@@ -0,0 +1,404 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/SightTemplate.h"
+
+#include <algorithm>
+
+const uint32_t SightTemplate::NB_OCTANTS = 8;
+
+namespace
+{
+struct Entry
+{
+    int mX;
+    int mY;
+    int mDistSquared;
+};
+
+bool sortByDistSquared(const Entry& entry1, const Entry& entry2)
+{
+    return entry1.mDistSquared < entry2.mDistSquared;
+}
+}
+
+SightTemplate::SightTemplate(int radius) :
+    mRadius(radius),
+    mNbEntries(0),
+    mNbWords(0)
+{
+    // We compute the entries of the first octant (0 <= y <= x). If we look a grid (each letter
+    // represents a tile at the same distance from the center: a):
+    //    j
+    //   fi
+    //  ceh
+    // abdg
+    // The other octants are deduced by symmetry
+    int radiusSquared = radius * radius;
+    std::vector<Entry> entries;
+    for(int y = 0; y <= radius; ++y)
+    {
+        for(int x = y; x <= radius; ++x)
+        {
+            int distSquared = x * x + y * y;
+            if(distSquared > radiusSquared)
+                continue;
+
+            Entry entry;
+            entry.mX = x;
+            entry.mY = y;
+            entry.mDistSquared = distSquared;
+            entries.push_back(entry);
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), sortByDistSquared);
+
+    mNbEntries = static_cast<uint32_t>(entries.size());
+    mNbWords = (mNbEntries + 63) / 64;
+    uint32_t stride = getStride();
+
+    // The octants are processed in this order (c being the viewer):
+    // 514
+    // 2c0
+    // 637
+    mSlotsX.assign(NB_OCTANTS * stride, 0);
+    mSlotsY.assign(NB_OCTANTS * stride, 0);
+    mDiagonalMask.assign(mNbWords, 0);
+    for(uint32_t i = 0; i < mNbEntries; ++i)
+    {
+        int x = entries[i].mX;
+        int y = entries[i].mY;
+        const int slotsX[8] = {  x,  y, -x, -y,  y,  x, -y, -x };
+        const int slotsY[8] = {  y, -x, -y,  x,  x, -y, -x,  y };
+        for(uint32_t k = 0; k < NB_OCTANTS; ++k)
+        {
+            mSlotsX[k * stride + i] = slotsX[k];
+            mSlotsY[k * stride + i] = slotsY[k];
+        }
+
+        if((y > 0) && (x == y))
+            mDiagonalMask[i / 64] |= (static_cast<uint64_t>(1) << (i % 64));
+    }
+
+    // Horizontal tiles are common to 2 consecutive octants and diagonal tiles are merged in
+    // computeHidden. We only output them for the 4 first octants. The viewer tile is only output once
+    for(uint32_t i = 0; i < mNbEntries; ++i)
+    {
+        for(uint32_t k = 0; k < NB_OCTANTS; ++k)
+        {
+            if((k > 0) && (entries[i].mDistSquared == 0))
+                continue;
+
+            if((k > 3) && (entries[i].mY == 0 || entries[i].mX == entries[i].mY))
+                continue;
+
+            mOutputSlots.push_back(k * stride + i);
+        }
+    }
+
+    // We compute how each entry hides the others when it blocks vision
+    mHiddenMasks.assign(mNbEntries * mNbWords, 0);
+    mPartialMasks.assign(mNbEntries * mNbWords, 0);
+    mPartialHidingBegin.assign(mNbEntries + 1, 0);
+    for(uint32_t i = 0; i < mNbEntries; ++i)
+    {
+        mPartialHidingBegin[i] = static_cast<uint32_t>(mPartialHidings.size());
+        for(uint32_t j = 0; j < mNbEntries; ++j)
+        {
+            bool north;
+            double value;
+            if(!computeHiding(entries[i].mX, entries[i].mY, entries[j].mX, entries[j].mY, north, value))
+                continue;
+
+            if(value > 0.5)
+            {
+                mHiddenMasks[i * mNbWords + j / 64] |= (static_cast<uint64_t>(1) << (j % 64));
+                continue;
+            }
+
+            if(value <= 0.0)
+                continue;
+
+            mPartialMasks[i * mNbWords + j / 64] |= (static_cast<uint64_t>(1) << (j % 64));
+            PartialHiding partialHiding;
+            partialHiding.mTarget = j;
+            partialHiding.mNorth = north;
+            partialHiding.mValue = value;
+            mPartialHidings.push_back(partialHiding);
+        }
+    }
+    mPartialHidingBegin[mNbEntries] = static_cast<uint32_t>(mPartialHidings.size());
+}
+
+void SightTemplate::computeHidden(const std::vector<uint64_t>& blocking, Buffers& buffers) const
+{
+    uint32_t stride = getStride();
+    buffers.mHidden.assign(NB_OCTANTS * mNbWords, 0);
+    buffers.mPartial.assign(NB_OCTANTS * mNbWords, 0);
+    if(buffers.mHiddenNorth.size() < NB_OCTANTS * stride)
+    {
+        buffers.mHiddenNorth.assign(NB_OCTANTS * stride, 0.0);
+        buffers.mHiddenSouth.assign(NB_OCTANTS * stride, 0.0);
+    }
+
+    // We propagate the hidden parts from the blocking entries
+    for(uint32_t k = 0; k < NB_OCTANTS; ++k)
+    {
+        uint64_t* hiddenOctant = &buffers.mHidden[k * mNbWords];
+        uint64_t* partialOctant = &buffers.mPartial[k * mNbWords];
+        double* hiddenNorthOctant = &buffers.mHiddenNorth[k * stride];
+        double* hiddenSouthOctant = &buffers.mHiddenSouth[k * stride];
+        for(uint32_t w = 0; w < mNbWords; ++w)
+        {
+            uint64_t bits = blocking[k * mNbWords + w];
+            for(uint32_t i = w * 64; bits != 0; ++i, bits >>= 1)
+            {
+                if((bits & 1) == 0)
+                    continue;
+
+                const uint64_t* hiddenMask = &mHiddenMasks[i * mNbWords];
+                const uint64_t* partialMask = &mPartialMasks[i * mNbWords];
+                for(uint32_t ww = 0; ww < mNbWords; ++ww)
+                {
+                    hiddenOctant[ww] |= hiddenMask[ww];
+                    partialOctant[ww] |= partialMask[ww];
+                }
+
+                for(uint32_t p = mPartialHidingBegin[i]; p < mPartialHidingBegin[i + 1]; ++p)
+                {
+                    const PartialHiding& partialHiding = mPartialHidings[p];
+                    double& value = partialHiding.mNorth ? hiddenNorthOctant[partialHiding.mTarget] : hiddenSouthOctant[partialHiding.mTarget];
+                    if(partialHiding.mValue > value)
+                        value = partialHiding.mValue;
+                }
+            }
+        }
+    }
+
+    // Then, we check the entries hidden by 2 partial parts. Diagonal entries are merged with
+    // the next octants. Because they are inverted, south hidden value becomes north and vice-versa
+    for(uint32_t k = 0; k < NB_OCTANTS; ++k)
+    {
+        uint64_t* hiddenOctant = &buffers.mHidden[k * mNbWords];
+        for(uint32_t w = 0; w < mNbWords; ++w)
+        {
+            uint64_t bits = buffers.mPartial[k * mNbWords + w];
+            if(k < 4)
+            {
+                const uint32_t wordOpposite = (k + 4) * mNbWords + w;
+                bits |= (buffers.mPartial[wordOpposite] | buffers.mHidden[wordOpposite]) & mDiagonalMask[w];
+            }
+            bits &= ~hiddenOctant[w];
+
+            for(uint32_t i = w * 64; bits != 0; ++i, bits >>= 1)
+            {
+                if((bits & 1) == 0)
+                    continue;
+
+                uint64_t bit = static_cast<uint64_t>(1) << (i % 64);
+                double north = buffers.mHiddenNorth[k * stride + i];
+                double south = buffers.mHiddenSouth[k * stride + i];
+                if(((mDiagonalMask[w] & bit) != 0) && (k < 4))
+                {
+                    if((buffers.mHidden[(k + 4) * mNbWords + w] & bit) != 0)
+                    {
+                        hiddenOctant[w] |= bit;
+                        continue;
+                    }
+
+                    north = std::max(north, buffers.mHiddenSouth[(k + 4) * stride + i]);
+                    south = std::max(south, buffers.mHiddenNorth[(k + 4) * stride + i]);
+                }
+
+                if((north + south) > 0.5)
+                    hiddenOctant[w] |= bit;
+            }
+        }
+    }
+
+    // We reset the partial values for the next call
+    for(uint32_t k = 0; k < NB_OCTANTS; ++k)
+    {
+        for(uint32_t w = 0; w < mNbWords; ++w)
+        {
+            uint64_t bits = buffers.mPartial[k * mNbWords + w];
+            for(uint32_t i = w * 64; bits != 0; ++i, bits >>= 1)
+            {
+                if((bits & 1) == 0)
+                    continue;
+
+                buffers.mHiddenNorth[k * stride + i] = 0.0;
+                buffers.mHiddenSouth[k * stride + i] = 0.0;
+            }
+        }
+    }
+}
+
+bool SightTemplate::computeHiding(int blockerX, int blockerY, int targetX, int targetY, bool& north, double& value)
+{
+    // The viewer tile cannot hide anything
+    if((blockerX == 0) && (blockerY == 0))
+        return false;
+
+    // A tile can only hide tiles behind (x > tile.x and y > tile.y)
+    if(targetX < blockerX)
+        return false;
+    if(targetY < blockerY)
+        return false;
+
+    // We don't want a tile to hide itself
+    if((targetX == blockerX) && (targetY == blockerY))
+        return false;
+
+    double coefNorth = (static_cast<double>(blockerY) + 0.5) / (static_cast<double>(blockerX) - 0.5);
+    double coefSouth = (static_cast<double>(blockerY) - 0.5) / (static_cast<double>(blockerX) + 0.5);
+    double xTileDeb = static_cast<double>(targetX) - 0.5;
+    double xTileEnd = xTileDeb + 1.0;
+    double yTileDeb = static_cast<double>(targetY) - 0.5;
+    double yTileEnd = yTileDeb + 1.0;
+    double yHideDebNorth = coefNorth * xTileDeb;
+    double yHideEndNorth = coefNorth * xTileEnd;
+
+    if(blockerY == 0)
+    {
+        // For horizontal tiles, we hide following tiles (x > tile.x). But we process
+        // north tiles normally
+        north = false;
+        if(targetY == 0)
+        {
+            value = 1.0;
+            return true;
+        }
+
+        // If the tile is over the North ray, it is not hidden
+        if(yHideEndNorth <= yTileDeb)
+            return false;
+
+        // We check which part of the tile is hidden
+        if((yHideDebNorth >= yTileDeb) &&
+           (yHideEndNorth <= yTileEnd))
+        {
+            // The ray hits the left side of the tile and the right side.
+            // The south part is partially hidden
+            value = (yHideEndNorth - yHideDebNorth) / 2.0;
+            value += yHideDebNorth - yTileDeb;
+        }
+        else if((yHideDebNorth < yTileDeb) &&
+                (yHideEndNorth > yTileDeb))
+        {
+            // The ray hits the bottom side of the tile but hits the right side. We compute
+            // the south visible part
+            double xHit = yTileDeb / coefNorth;
+            value = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+        }
+        else if((yHideDebNorth < yTileEnd) &&
+                (yHideEndNorth > yTileEnd))
+        {
+            // The ray hits the left side of the tile but is over the right side. We compute
+            // the hidden part on north.
+            double xHit = yTileEnd / coefNorth;
+            double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
+            value = 1.0 - visibleArea;
+        }
+        else
+        {
+            // The entire tile is hidden
+            value = 1.0;
+        }
+
+        return true;
+    }
+
+    // We check if the current tile is hidden by the tile. To consider that the
+    // tile is hidden by the south, as we know the angle will be between 0 and 45 degrees,
+    // we consider that the tile has to be hit by the ray passing through the hiding tile
+    // on the left side of the tile (otherwise, the hidden part will be too small).
+    double yHideDebSouth = coefSouth * xTileDeb;
+    double yHideEndSouth = coefSouth * xTileEnd;
+    // We check if at least a part of the tile is hidden
+    if((yHideDebSouth >= yTileEnd) ||
+       (yHideEndNorth <= yTileDeb))
+    {
+        return false;
+    }
+
+    if((yHideDebSouth >= yTileDeb) &&
+       (yHideEndSouth <= yTileEnd))
+    {
+        // The ray hits the left side of the tile and the right side.
+        // The south part is partially hidden
+        // The visible part is composed from a square between the tile inferior part and
+        // the triangle made by the ray
+        double visibleArea = (yHideEndSouth - yHideDebSouth) / 2.0;
+        visibleArea += yHideDebSouth - yTileDeb;
+        north = true;
+        value = 1.0 - visibleArea;
+    }
+    else if((yHideDebSouth < yTileDeb) &&
+            (yHideEndSouth > yTileDeb))
+    {
+        // The ray hits the bottom side of the tile but hits the right side. We compute
+        // the south visible part
+        double xHit = yTileDeb / coefSouth;
+        double visibleArea = (yHideEndSouth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+        north = true;
+        value = 1.0 - visibleArea;
+    }
+    else if((yHideDebSouth < yTileEnd) &&
+            (yHideEndSouth > yTileEnd))
+    {
+        // The ray hits the left side of the tile but is over the right side. We compute
+        // the hidden part on north.
+        double xHit = yTileEnd / coefSouth;
+        north = true;
+        value = (yTileEnd - yHideDebSouth) * (xHit - xTileDeb) / 2.0;
+    }
+    else if((yHideDebNorth >= yTileDeb) &&
+       (yHideEndNorth <= yTileEnd))
+    {
+        north = false;
+        value = (yHideEndNorth - yHideDebNorth) / 2.0;
+        value += yHideDebNorth - yTileDeb;
+    }
+    else if((yHideDebNorth < yTileDeb) &&
+            (yHideEndNorth > yTileDeb))
+    {
+        // The ray hits the bottom side of the tile but hits the right side. We compute
+        // the south visible part
+        double xHit = yTileDeb / coefNorth;
+        north = false;
+        value = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
+    }
+    else if((yHideDebNorth < yTileEnd) &&
+            (yHideEndNorth > yTileEnd))
+    {
+        // The ray hits the left side of the tile but is over the right side. We compute
+        // the hidden part on north.
+        double xHit = yTileEnd / coefNorth;
+        double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
+        north = false;
+        value = 1.0 - visibleArea;
+    }
+    else
+    {
+        // The entire tile is hidden
+        north = false;
+        value = 1.0;
+    }
+
+    return true;
+}
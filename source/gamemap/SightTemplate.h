@@ -0,0 +1,127 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIGHTTEMPLATE_H
+#define SIGHTTEMPLATE_H
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Precomputed line of sight for a given radius.
+ *
+ * The area around the viewer is split in 8 octants. In each octant, the tiles within radius
+ * are sorted from the closest to the furthest and each of them is an entry. For each entry,
+ * we precompute the entries it hides when it blocks vision. Hiding an entry by more than
+ * half is stored in a bitmask. Smaller hidden parts are stored with their value because 2
+ * of them (one from the north and one from the south) can hide an entry.
+ *
+ * Everything that only depends on the radius is computed once. When computing the visible
+ * tiles, the caller only has to give, for each slot (octant * getStride() + entry), if the
+ * tile blocks vision. See TileContainer::visibleTiles.
+ */
+class SightTemplate
+{
+public:
+    static const uint32_t NB_OCTANTS;
+
+    SightTemplate(int radius);
+
+    inline int getRadius() const
+    { return mRadius; }
+
+    //! \brief Number of entries in each octant
+    inline uint32_t getNbEntries() const
+    { return mNbEntries; }
+
+    //! \brief Number of slots reserved for each octant. Multiple of 64 so that each octant starts with a new word
+    inline uint32_t getStride() const
+    { return mNbWords * 64; }
+
+    //! \brief Number of 64 bits words used for each octant
+    inline uint32_t getNbWords() const
+    { return mNbWords; }
+
+    //! \brief Position of the given slot relative to the viewer. Only valid for the slots with entry < getNbEntries()
+    inline int getSlotX(uint32_t slot) const
+    { return mSlotsX[slot]; }
+
+    inline int getSlotY(uint32_t slot) const
+    { return mSlotsY[slot]; }
+
+    //! \brief Slots to check to get every tile within radius once, from the closest to the furthest
+    inline const std::vector<uint32_t>& getOutputSlots() const
+    { return mOutputSlots; }
+
+    //! \brief Working buffers used by computeHidden. They can be shared by templates with different radius
+    struct Buffers
+    {
+        //! \brief One bit per slot. Set if the slot cannot be seen
+        std::vector<uint64_t> mHidden;
+        //! \brief One bit per slot. Set if the slot is partially hidden
+        std::vector<uint64_t> mPartial;
+        //! \brief Biggest partially hidden parts of each slot. Kept to 0 between calls
+        std::vector<double> mHiddenNorth;
+        std::vector<double> mHiddenSouth;
+    };
+
+    /*! \brief Computes the hidden slots.
+     * blocking has NB_OCTANTS * getNbWords() words. The bit for a slot should be set if the corresponding tile
+     * blocks vision. After the call, isHidden can be used to know if a slot can be seen.
+     */
+    void computeHidden(const std::vector<uint64_t>& blocking, Buffers& buffers) const;
+
+    static inline bool isHidden(const Buffers& buffers, uint32_t slot)
+    { return (buffers.mHidden[slot / 64] & (static_cast<uint64_t>(1) << (slot % 64))) != 0; }
+
+    /*! \brief Computes how much the tile at target (in the first octant: 0 <= y <= x) is hidden by
+     * a vision blocking tile at blocker. Returns false if target is not hidden at all. Otherwise, north is set
+     * to true if the hidden part is on the north side of the target and value to the hidden part (from 0 to 1).
+     * A tile is hidden if the sum of the biggest north value and the biggest south value is more than 0.5.
+     */
+    static bool computeHiding(int blockerX, int blockerY, int targetX, int targetY, bool& north, double& value);
+
+private:
+    struct PartialHiding
+    {
+        uint32_t mTarget;
+        bool mNorth;
+        double mValue;
+    };
+
+    int mRadius;
+    uint32_t mNbEntries;
+    uint32_t mNbWords;
+
+    std::vector<int> mSlotsX;
+    std::vector<int> mSlotsY;
+    std::vector<uint32_t> mOutputSlots;
+
+    //! \brief Bit set for the diagonal entries. They are shared by 2 octants that do not hide them from the same side
+    std::vector<uint64_t> mDiagonalMask;
+
+    //! \brief For each entry, mask of the entries it hides by more than half (mNbWords words per entry)
+    std::vector<uint64_t> mHiddenMasks;
+
+    //! \brief For each entry, mask of the entries it partially hides (mNbWords words per entry)
+    std::vector<uint64_t> mPartialMasks;
+
+    //! \brief Entries partially hidden by each entry: from mPartialHidingBegin[entry] to mPartialHidingBegin[entry + 1]
+    std::vector<uint32_t> mPartialHidingBegin;
+    std::vector<PartialHiding> mPartialHidings;
+};
+
+#endif // SIGHTTEMPLATE_H
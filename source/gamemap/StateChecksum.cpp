@@ -0,0 +1,132 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/StateChecksum.h"
+
+#include "network/ODPacket.h"
+
+#include <cstring>
+
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+void StateHasher::add(uint64_t value)
+{
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        mHash ^= (value >> (i * 8)) & 0xFF;
+        mHash *= FNV_PRIME;
+    }
+}
+
+void StateHasher::add(double value)
+{
+    uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "double should be 64 bits");
+    std::memcpy(&bits, &value, sizeof(bits));
+    add(bits);
+}
+
+void StateHasher::add(const std::string& value)
+{
+    add(static_cast<uint64_t>(value.size()));
+    for(char c : value)
+    {
+        mHash ^= static_cast<uint8_t>(c);
+        mHash *= FNV_PRIME;
+    }
+}
+
+StateChecksum::StateChecksum()
+{
+    mHashes.fill(0);
+}
+
+void StateChecksum::update(Subsystem subsystem, uint64_t stateHash)
+{
+    uint32_t index = static_cast<uint32_t>(subsystem);
+    if(index >= mHashes.size())
+        return;
+
+    StateHasher hasher;
+    hasher.add(mHashes[index]);
+    hasher.add(stateHash);
+    mHashes[index] = hasher.getHash();
+}
+
+uint64_t StateChecksum::getHash(Subsystem subsystem) const
+{
+    uint32_t index = static_cast<uint32_t>(subsystem);
+    if(index >= mHashes.size())
+        return 0;
+
+    return mHashes[index];
+}
+
+uint64_t StateChecksum::getGlobalHash() const
+{
+    StateHasher hasher;
+    for(uint64_t hash : mHashes)
+        hasher.add(hash);
+
+    return hasher.getHash();
+}
+
+StateChecksum::Subsystem StateChecksum::firstDivergingSubsystem(const StateChecksum& other) const
+{
+    for(uint32_t i = 0; i < mHashes.size(); ++i)
+    {
+        if(mHashes[i] != other.mHashes[i])
+            return static_cast<Subsystem>(i);
+    }
+
+    return Subsystem::nb;
+}
+
+std::string StateChecksum::toString(Subsystem subsystem)
+{
+    switch(subsystem)
+    {
+        case Subsystem::tiles:
+            return "tiles";
+        case Subsystem::creatures:
+            return "creatures";
+        case Subsystem::seats:
+            return "seats";
+        case Subsystem::rooms:
+            return "rooms";
+        case Subsystem::nb:
+            return "none";
+        default:
+            return "unknown";
+    }
+}
+
+ODPacket& operator<<(ODPacket& os, const StateChecksum& checksum)
+{
+    for(uint64_t hash : checksum.mHashes)
+        os << hash;
+
+    return os;
+}
+
+ODPacket& operator>>(ODPacket& is, StateChecksum& checksum)
+{
+    for(uint64_t& hash : checksum.mHashes)
+        is >> hash;
+
+    return is;
+}
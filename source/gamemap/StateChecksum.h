@@ -0,0 +1,97 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATECHECKSUM_H
+#define STATECHECKSUM_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+class ODPacket;
+
+//! \brief FNV-1a hash of values. Values are hashed byte by byte in little endian order so that
+//! the hash does not depend on the platform
+class StateHasher
+{
+public:
+    StateHasher() :
+        mHash(0xcbf29ce484222325ULL)
+    {}
+
+    void add(uint64_t value);
+    void add(int64_t value)
+    { add(static_cast<uint64_t>(value)); }
+    void add(uint32_t value)
+    { add(static_cast<uint64_t>(value)); }
+    void add(int32_t value)
+    { add(static_cast<uint64_t>(static_cast<int64_t>(value))); }
+    void add(bool value)
+    { add(static_cast<uint64_t>(value ? 1 : 0)); }
+    //! \brief Doubles are hashed by bit pattern. Results computed the same way on IEEE 754 platforms are identical
+    void add(double value);
+    void add(const std::string& value);
+
+    inline uint64_t getHash() const
+    { return mHash; }
+
+private:
+    uint64_t mHash;
+};
+
+/*! \brief Rolling hash of the game state, one for each subsystem.
+ *
+ * At the end of each turn, the state of each subsystem is hashed and combined with the previous
+ * value. Two simulations with the same seed and the same inputs should have the same checksums.
+ * If they diverge, comparing the checksums tells from which turn and in which subsystem.
+ */
+class StateChecksum
+{
+public:
+    enum class Subsystem
+    {
+        tiles,
+        creatures,
+        seats,
+        rooms,
+        nb
+    };
+
+    StateChecksum();
+
+    //! \brief Combines the previous value of the given subsystem with the hash of its current state
+    void update(Subsystem subsystem, uint64_t stateHash);
+
+    uint64_t getHash(Subsystem subsystem) const;
+
+    //! \brief Hash of all the subsystems
+    uint64_t getGlobalHash() const;
+
+    //! \brief Returns the first subsystem (in Subsystem order) whose hash differs from other. Subsystem::nb
+    //! if every hash is the same
+    Subsystem firstDivergingSubsystem(const StateChecksum& other) const;
+
+    static std::string toString(Subsystem subsystem);
+
+    friend ODPacket& operator<<(ODPacket& os, const StateChecksum& checksum);
+    friend ODPacket& operator>>(ODPacket& is, StateChecksum& checksum);
+
+private:
+    std::array<uint64_t, static_cast<uint32_t>(Subsystem::nb)> mHashes;
+};
+
+#endif // STATECHECKSUM_H
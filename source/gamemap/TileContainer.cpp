@@ -18,11 +18,15 @@
 #include "gamemap/TileContainer.h"
 
 #include "entities/Tile.h"
+#include "gamemap/SightTemplate.h"
 
 #include "network/ODPacket.h"
+#include "network/TileSetCodec.h"
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 
+#include <algorithm>
+
 const std::vector<Tile*> EMPTY_TILES;
 
 class TileDistance
@@ -55,272 +59,11 @@ public:
     inline int getDistSquared() const
     { return mDistSquared; }
 
-    void computeTileDistances(double coefNorth, double coefSouth, const TileDistance& tileDistance,
-        uint32_t indexTileDistance)
-    {
-        // A tile can only hide tiles behind (x > tile.x and y > tile.y)
-        if(tileDistance.getDiffX() < getDiffX())
-            return;
-        if(tileDistance.getDiffY() < getDiffY())
-            return;
-
-        // We don't want a tile to hide itself
-        if((tileDistance.getDiffX() == getDiffX()) &&
-           (tileDistance.getDiffY() == getDiffY()))
-        {
-            return;
-        }
-
-        if(getType() == TileDistance::TileDistanceType::Horizontal)
-        {
-            // For horizontal tiles, we hide following tiles (x > tile.x). But we process
-            // north tiles normally
-            if(tileDistance.getType() == TileDistance::TileDistanceType::Horizontal)
-            {
-                addHiddenTileSouth(indexTileDistance, 1.0);
-                return;
-            }
-
-            double xTileDeb = static_cast<double>(tileDistance.getDiffX()) - 0.5;
-            double xTileEnd = xTileDeb + 1.0;
-            double yTileDeb = static_cast<double>(tileDistance.getDiffY()) - 0.5;
-            double yTileEnd = yTileDeb + 1.0;
-            double yHideDebNorth = coefNorth * xTileDeb;
-            double yHideEndNorth = coefNorth * xTileEnd;
-
-            // If the tile is over the North ray, it is not hidden
-            if(yHideEndNorth <= yTileDeb)
-                return;
-
-            // We check which part of the tile is hidden
-            if((yHideDebNorth >= yTileDeb) &&
-               (yHideEndNorth <= yTileEnd))
-            {
-                // The ray hits the left side of the tile and the right side.
-                // The south part is partially hidden
-                double hiddenArea = (yHideEndNorth - yHideDebNorth) / 2.0;
-                hiddenArea += yHideDebNorth - yTileDeb;
-                addHiddenTileSouth(indexTileDistance, hiddenArea);
-            }
-            else if((yHideDebNorth < yTileDeb) &&
-                    (yHideEndNorth > yTileDeb))
-            {
-                // The ray hits the bottom side of the tile but hits the right side. We compute
-                // the south visible part
-                double xHit = yTileDeb / coefNorth;
-                double hiddenArea = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
-                addHiddenTileSouth(indexTileDistance, hiddenArea);
-            }
-            else if((yHideDebNorth < yTileEnd) &&
-                    (yHideEndNorth > yTileEnd))
-            {
-                // The ray hits the left side of the tile but is over the right side. We compute
-                // the hidden part on north.
-                double xHit = yTileEnd / coefNorth;
-                double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
-                addHiddenTileSouth(indexTileDistance, 1.0 - visibleArea);
-            }
-            else
-            {
-                // The entire tile is hidden
-                addHiddenTileSouth(indexTileDistance, 1.0);
-            }
-
-            return;
-        }
-
-        double xTileDeb = static_cast<double>(tileDistance.getDiffX()) - 0.5;
-        double xTileEnd = xTileDeb + 1.0;
-        double yTileDeb = static_cast<double>(tileDistance.getDiffY()) - 0.5;
-        double yTileEnd = yTileDeb + 1.0;
-
-        // We check if the current tile is hidden by the tile. To consider that the
-        // tile is hidden by the south, as we know the angle will be between 0 and 45 degrees,
-        // we consider that the tile has to be hit by the ray passing through the hiding tile
-        // on the left side of the tile (otherwise, the hidden part will be too small).
-        double yHideDebSouth = coefSouth * xTileDeb;
-        double yHideEndSouth = coefSouth * xTileEnd;
-        double yHideDebNorth = coefNorth * xTileDeb;
-        double yHideEndNorth = coefNorth * xTileEnd;
-        // We check if at least a part of the tile is hidden
-        if((yHideDebSouth < yTileEnd) &&
-           (yHideEndNorth > yTileDeb))
-        {
-            // At least a part of this tile is hidden
-            if((yHideDebSouth >= yTileDeb) &&
-               (yHideEndSouth <= yTileEnd))
-            {
-                // The ray hits the left side of the tile and the right side.
-                // The south part is partially hidden
-                // The visible part is composed from a square between the tile inferior part and
-                // the triangle made by the ray
-                double visibleArea = (yHideEndSouth - yHideDebSouth) / 2.0;
-                visibleArea += yHideDebSouth - yTileDeb;
-                addHiddenTileNorth(indexTileDistance, 1.0 - visibleArea);
-            }
-            else if((yHideDebSouth < yTileDeb) &&
-                    (yHideEndSouth > yTileDeb))
-            {
-                // The ray hits the bottom side of the tile but hits the right side. We compute
-                // the south visible part
-                double xHit = yTileDeb / coefSouth;
-                double visibleArea = (yHideEndSouth - yTileDeb) * (xTileEnd - xHit) / 2.0;
-                addHiddenTileNorth(indexTileDistance, 1.0 - visibleArea);
-            }
-            else if((yHideDebSouth < yTileEnd) &&
-                    (yHideEndSouth > yTileEnd))
-            {
-                // The ray hits the left side of the tile but is over the right side. We compute
-                // the hidden part on north.
-                double xHit = yTileEnd / coefSouth;
-                double hiddenArea = (yTileEnd - yHideDebSouth) * (xHit - xTileDeb) / 2.0;
-                addHiddenTileNorth(indexTileDistance, hiddenArea);
-
-            }
-            else if((yHideDebNorth >= yTileDeb) &&
-               (yHideEndNorth <= yTileEnd))
-            {
-                double hiddenArea = (yHideEndNorth - yHideDebNorth) / 2.0;
-                hiddenArea += yHideDebNorth - yTileDeb;
-                addHiddenTileSouth(indexTileDistance, hiddenArea);
-            }
-            else if((yHideDebNorth < yTileDeb) &&
-                    (yHideEndNorth > yTileDeb))
-            {
-                // The ray hits the bottom side of the tile but hits the right side. We compute
-                // the south visible part
-                double xHit = yTileDeb / coefNorth;
-                double hiddenArea = (yHideEndNorth - yTileDeb) * (xTileEnd - xHit) / 2.0;
-                addHiddenTileSouth(indexTileDistance, hiddenArea);
-            }
-            else if((yHideDebNorth < yTileEnd) &&
-                    (yHideEndNorth > yTileEnd))
-            {
-                // The ray hits the left side of the tile but is over the right side. We compute
-                // the hidden part on north.
-                double xHit = yTileEnd / coefNorth;
-                double visibleArea = (yTileEnd - yHideDebNorth) * (xHit - xTileDeb) / 2.0;
-                addHiddenTileSouth(indexTileDistance, 1.0 - visibleArea);
-            }
-            else
-            {
-                // The entire tile is hidden
-                addHiddenTileSouth(indexTileDistance, 1.0);
-            }
-        }
-    }
-
-    void print(const std::vector<TileDistance>& tileDistance)
-    {
-        std::string log = "TileDistance x=" + Helper::toString(getDiffX())
-            + ", y=" + Helper::toString(getDiffY())
-            + ", squared=" + Helper::toString(getDistSquared());
-        for(const std::pair<uint32_t, double>& p : mHiddenTilesNorth)
-        {
-            const TileDistance& tile = tileDistance[p.first];
-            log += ", TileDistanceNorth x=" + Helper::toString(tile.getDiffX())
-                + ", y=" + Helper::toString(tile.getDiffY())
-                + ", val=" + Helper::toString(p.second);
-        }
-        for(const std::pair<uint32_t, double>& p : mHiddenTilesSouth)
-        {
-            const TileDistance& tile = tileDistance[p.first];
-            log += ", TileDistanceSouth x=" + Helper::toString(tile.getDiffX())
-                + ", y=" + Helper::toString(tile.getDiffY())
-                + ", val=" + Helper::toString(p.second);
-        }
-
-        OD_LOG_INF(log);
-    }
-
-    const std::vector<std::pair<uint32_t, double>>& getHiddenTilesNorth() const
-    {
-        return mHiddenTilesNorth;
-    }
-
-    const std::vector<std::pair<uint32_t, double>>& getHiddenTilesSouth() const
-    {
-        return mHiddenTilesSouth;
-    }
-
 private:
-    void addHiddenTileNorth(uint32_t indexTile, double hiddenPercent)
-    {
-        mHiddenTilesNorth.push_back(std::pair<uint32_t, double>(indexTile, hiddenPercent));
-    }
-
-    void addHiddenTileSouth(uint32_t indexTile, double hiddenPercent)
-    {
-        mHiddenTilesSouth.push_back(std::pair<uint32_t, double>(indexTile, hiddenPercent));
-    }
-
     int mDiffX;
     int mDiffY;
     TileDistanceType mType;
     int mDistSquared;
-    std::vector<std::pair<uint32_t, double>> mHiddenTilesNorth;
-    std::vector<std::pair<uint32_t, double>> mHiddenTilesSouth;
-};
-
-class TileDistanceProcess
-{
-public:
-    TileDistanceProcess(const TileDistance& tileDistance, Tile* tile):
-        mTileDistance(tileDistance),
-        mTile(tile),
-        mHiddenValueNorth(0.0),
-        mHiddenValueSouth(0.0)
-    {
-    }
-
-    inline const TileDistance& getTileDistance() const
-    {
-        return mTileDistance;
-    }
-
-    void addHiddenValueNorth(double val)
-    {
-        // We only add the highest value
-        if(val <= mHiddenValueNorth)
-            return;
-
-        mHiddenValueNorth = val;
-    }
-
-    void addHiddenValueSouth(double val)
-    {
-        // We only add the highest value
-        if(val <= mHiddenValueSouth)
-            return;
-
-        mHiddenValueSouth = val;
-    }
-
-    inline bool isTileVisible() const
-    {
-        return (mHiddenValueNorth + mHiddenValueSouth) <= 0.5;
-    }
-
-    inline double getHiddenValueNorth() const
-    {
-        return mHiddenValueNorth;
-    }
-
-    inline double getHiddenValueSouth() const
-    {
-        return mHiddenValueSouth;
-    }
-
-    inline Tile* getTile() const
-    {
-        return mTile;
-    }
-
-private:
-    const TileDistance& mTileDistance;
-    Tile* mTile;
-    double mHiddenValueNorth;
-    double mHiddenValueSouth;
 };
 
 bool sortByDistSquared(const TileDistance& tileDist1, const TileDistance& tileDist2)
@@ -432,6 +175,49 @@ Tile* TileContainer::tileFromPacket(ODPacket& packet) const
     return tile;
 }
 
+void TileContainer::tilesToPacket(ODPacket& packet, std::vector<Tile*>& tiles) const
+{
+    std::sort(tiles.begin(), tiles.end(), [](Tile* a, Tile* b)
+    {
+        if(a->getY() != b->getY())
+            return a->getY() < b->getY();
+
+        return a->getX() < b->getX();
+    });
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+    std::vector<std::pair<int32_t, int32_t>> coords;
+    coords.reserve(tiles.size());
+    for(Tile* tile : tiles)
+        coords.push_back(std::make_pair(tile->getX(), tile->getY()));
+
+    TileSetCodec::write(packet, coords);
+}
+
+bool TileContainer::tilesFromPacket(ODPacket& packet, std::vector<Tile*>& tiles) const
+{
+    tiles.clear();
+    std::vector<std::pair<int32_t, int32_t>> coords;
+    if(!TileSetCodec::read(packet, coords))
+    {
+        OD_LOG_ERR("Invalid tile set");
+        return false;
+    }
+
+    tiles.reserve(coords.size());
+    for(const std::pair<int32_t, int32_t>& coord : coords)
+    {
+        Tile* tile = getTile(coord.first, coord.second);
+        if(tile == nullptr)
+        {
+            OD_LOG_ERR("tile=" + Helper::toString(coord.first) + "," + Helper::toString(coord.second));
+            return false;
+        }
+        tiles.push_back(tile);
+    }
+    return true;
+}
+
 bool TileContainer::allocateMapMemory(int xSize, int ySize)
 {
     if (xSize <= 0 || ySize <= 0)
@@ -693,28 +479,6 @@ void TileContainer::buildTileDistance(int distance)
     }
 
     std::sort(mTileDistance.begin(), mTileDistance.end(), sortByDistSquared);
-
-    // We have filled the tile distance vector. Now, we fill how each tile hides the
-    // other ones when they mask vision to help calculate visible tiles
-    for(TileDistance& tileDistance : mTileDistance)
-    {
-        // We don't process the first tile
-        if(tileDistance.getDiffX() == 0 && tileDistance.getDiffY() == 0)
-            continue;
-
-        // Other tiles can hide with their down side and their up side other tiles
-        // or diagonal tiles (but not Horizontal tiles)
-        // We compute the tiles hidden from the south. In this case, only tiles with
-        // x > tile.x can be hidden
-        double coefNorth = (static_cast<double>(tileDistance.getDiffY()) + 0.5) / (static_cast<double>(tileDistance.getDiffX()) - 0.5);
-        double coefSouth = (static_cast<double>(tileDistance.getDiffY()) - 0.5) / (static_cast<double>(tileDistance.getDiffX()) + 0.5);
-        for(uint32_t index = 0; index < mTileDistance.size(); ++index)
-        {
-            const TileDistance& tileDistance2 = mTileDistance[index];
-            tileDistance.computeTileDistances(coefNorth, coefSouth, tileDistance2, index);
-        }
-    }
-
     mTileDistanceComputed = distance;
 }
 
@@ -808,164 +572,68 @@ std::list<Tile*> TileContainer::tilesBetween(int x1, int y1, int x2, int y2) con
     return path;
 }
 
-std::vector<Tile*> TileContainer::visibleTiles(int x, int y, int radius)
+void TileContainer::buildSightData(int radius)
 {
-    // To compute the tiles within this region, we use the symmetry of the square. That's why we mix tile x/y coordinate
-    // with tileDist diffX/diffY. More explanation can be found in the buildTileDistance function
-    std::vector<Tile*> returnList;
+    if(radius < 0)
+        radius = -radius;
 
-    if(radius > mTileDistanceComputed)
-        buildTileDistance(radius);
+    buildTileDistance(radius);
 
-    int radiusSquared = radius * radius;
+    // Everything that only depends on the radius is precomputed in the sight template
+    if(static_cast<uint32_t>(radius) >= mSightTemplates.size())
+        mSightTemplates.resize(radius + 1);
+    if(mSightTemplates[radius] == nullptr)
+        mSightTemplates[radius].reset(new SightTemplate(radius));
+}
 
-    // To have all the tiles around, we process mTileDistance 8 times.
-    // We will process in, this order (c being the starting tile):
-    // 514
-    // 2c0
-    // 637
-    // Then, we will have to merge diagonal/horizontal tiles
-    // Because we want the index to be correct, we will add tiles even when null in tilesProcess
-    std::vector<TileDistanceProcess> tilesProcess[8];
-    for(uint32_t k = 0; k < 8; ++k)
-    {
-        for(const TileDistance& tileDist : mTileDistance)
-        {
-            if(tileDist.getDistSquared() > radiusSquared)
-                break;
+void TileContainer::visibleTiles(int x, int y, int radius, std::vector<Tile*>& tiles)
+{
+    buildSightData(radius);
+    visibleTiles(x, y, radius, tiles, mSightWorkspace);
+}
 
-            switch(k)
-            {
-                case 0:
-                {
-                    Tile* tile = getTile(x + tileDist.getDiffX(), y + tileDist.getDiffY());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 1:
-                {
-                    Tile* tile = getTile(x + tileDist.getDiffY(), y - tileDist.getDiffX());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 2:
-                {
-                    Tile* tile = getTile(x - tileDist.getDiffX(), y - tileDist.getDiffY());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 3:
-                {
-                    Tile* tile = getTile(x - tileDist.getDiffY(), y + tileDist.getDiffX());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 4:
-                {
-                    Tile* tile = getTile(x + tileDist.getDiffY(), y + tileDist.getDiffX());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 5:
-                {
-                    Tile* tile = getTile(x + tileDist.getDiffX(), y - tileDist.getDiffY());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 6:
-                {
-                    Tile* tile = getTile(x - tileDist.getDiffY(), y - tileDist.getDiffX());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                case 7:
-                {
-                    Tile* tile = getTile(x - tileDist.getDiffX(), y + tileDist.getDiffY());
-                    tilesProcess[k].push_back(TileDistanceProcess(tileDist, tile));
-                    break;
-                }
-                default:
-                    break;
-            }
-        }
-    }
+void TileContainer::visibleTiles(int x, int y, int radius, std::vector<Tile*>& tiles, SightWorkspace& workspace)
+{
+    tiles.clear();
+    if(radius < 0)
+        radius = -radius;
 
-    // The array of tiles is filled. Now, we apply the visibility.
-    for(uint32_t k = 0; k < 8; ++k)
+    if((static_cast<uint32_t>(radius) >= mSightTemplates.size()) || (mSightTemplates[radius] == nullptr))
     {
-        for(TileDistanceProcess& tileDistanceProcess : tilesProcess[k])
-        {
-            if(tileDistanceProcess.getTile() == nullptr)
-                continue;
-
-            if(tileDistanceProcess.getTile()->permitsVision())
-                continue;
-
-            // The tile hides vision. We process tiles it hides
-            for(const std::pair<uint32_t, double>& p : tileDistanceProcess.getTileDistance().getHiddenTilesNorth())
-            {
-                // mTileDistance might be bigger than the actual vector because it can include tiles
-                // farther than the ones currently computed (for example if sight < computedSight)
-                if(p.first >= tilesProcess[k].size())
-                    continue;
-
-                tilesProcess[k][p.first].addHiddenValueNorth(p.second);
-            }
-            for(const std::pair<uint32_t, double>& p : tileDistanceProcess.getTileDistance().getHiddenTilesSouth())
-            {
-                // mTileDistance might be bigger than the actual vector because it can include tiles
-                // farther than the ones currently computed (for example if sight < computedSight)
-                if(p.first >= tilesProcess[k].size())
-                    continue;
-
-                tilesProcess[k][p.first].addHiddenValueSouth(p.second);
-            }
-        }
+        OD_LOG_ERR("sight data not built for radius=" + Helper::toString(radius));
+        return;
     }
 
-    // Now, we process all the tiles. Note that horizontal tiles are common for 2 consecutive
-    // vectors in tilesProcess and that diagonal tiles should be merged.
-    // The 8 vectors have the same size
-    for(uint32_t i = 0; i < tilesProcess[0].size(); ++i)
+    const SightTemplate& sightTemplate = *mSightTemplates[radius];
+    uint32_t stride = sightTemplate.getStride();
+    uint32_t nbEntries = sightTemplate.getNbEntries();
+    std::vector<Tile*>& sightTiles = workspace.mTiles;
+    std::vector<uint64_t>& sightBlocking = workspace.mBlocking;
+    sightTiles.assign(SightTemplate::NB_OCTANTS * stride, nullptr);
+    sightBlocking.assign(SightTemplate::NB_OCTANTS * sightTemplate.getNbWords(), 0);
+    for(uint32_t k = 0; k < SightTemplate::NB_OCTANTS; ++k)
     {
-        for(uint32_t k = 0; k < 8; ++k)
+        for(uint32_t i = 0; i < nbEntries; ++i)
         {
-            TileDistanceProcess& tileDistanceProcess = tilesProcess[k][i];
-            if(tileDistanceProcess.getTile() == nullptr)
-                continue;
-
-            // We avoid adding several times the center tile
-            if((k > 0) && (tileDistanceProcess.getTileDistance().getDistSquared() == 0))
-                continue;
+            uint32_t slot = k * stride + i;
+            Tile* tile = getTile(x + sightTemplate.getSlotX(slot), y + sightTemplate.getSlotY(slot));
+            sightTiles[slot] = tile;
+            if((tile != nullptr) && !tile->permitsVision())
+                sightBlocking[slot / 64] |= (static_cast<uint64_t>(1) << (slot % 64));
+        }
+    }
 
-            // Because horizontal tiles are common, we don't process them for the 4 last vectors
-            if((tileDistanceProcess.getTileDistance().getType() == TileDistance::TileDistanceType::Horizontal) &&
-               (k > 3))
-            {
-                continue;
-            }
+    sightTemplate.computeHidden(sightBlocking, workspace.mBuffers);
 
-            // Diagonal tiles need to be merged (because south hiding and north hiding are not
-            // computed within the same array). They will be processed for k < 4
-            if((tileDistanceProcess.getTileDistance().getType() == TileDistance::TileDistanceType::Diagonal) &&
-               (k > 3))
-            {
-                continue;
-            }
-
-            if(tileDistanceProcess.getTileDistance().getType() == TileDistance::TileDistanceType::Diagonal)
-            {
-                // We merge diagonal tiles. Because they are inverted, south hidden value becomes north and vice-versa
-                TileDistanceProcess& tileDistanceProcess2 = tilesProcess[k + 4][i];
-                tileDistanceProcess.addHiddenValueNorth(tileDistanceProcess2.getHiddenValueSouth());
-                tileDistanceProcess.addHiddenValueSouth(tileDistanceProcess2.getHiddenValueNorth());
-            }
+    for(uint32_t slot : sightTemplate.getOutputSlots())
+    {
+        Tile* tile = sightTiles[slot];
+        if(tile == nullptr)
+            continue;
 
-            if(!tileDistanceProcess.isTileVisible())
-                continue;
+        if(SightTemplate::isHidden(workspace.mBuffers, slot))
+            continue;
 
-            returnList.push_back(tileDistanceProcess.getTile());
-        }
+        tiles.push_back(tile);
     }
-    return returnList;
 }
@@ -18,8 +18,12 @@
 #ifndef TILECONTAINER_H
 #define TILECONTAINER_H
 
+#include "gamemap/SightTemplate.h"
+
 #include <cassert>
+#include <cstdint>
 #include <list>
+#include <memory>
 #include <vector>
 
 class ODPacket;
@@ -62,6 +66,13 @@ public:
     void tileToPacket(ODPacket& packet, Tile* tile) const;
     Tile* tileFromPacket(ODPacket& packet) const;
 
+    //! \brief Exports a set of tiles with TileSetCodec. The given vector is sorted in the order the
+    //! tiles will be read back (and duplicates are removed) so that per tile data can be written after
+    //! in the same order.
+    void tilesToPacket(ODPacket& packet, std::vector<Tile*>& tiles) const;
+    //! \brief Returns false if the packet is invalid or if it references tiles out of the map
+    bool tilesFromPacket(ODPacket& packet, std::vector<Tile*>& tiles) const;
+
     //! \brief Returns all the valid tiles in the rectangular region specified by the two corner points given.
     std::vector<Tile*> rectangularRegion(int x1, int y1, int x2, int y2);
 
@@ -93,9 +104,25 @@ public:
      */
     std::list<Tile*> tilesBetween(int x1, int y1, int x2, int y2) const;
 
-    //! \brief Returns the tiles visible from the given start tile within radius. The tiles are ordered from the closest to
+    //! \brief Working buffers used by visibleTiles
+    struct SightWorkspace
+    {
+        std::vector<Tile*> mTiles;
+        std::vector<uint64_t> mBlocking;
+        SightTemplate::Buffers mBuffers;
+    };
+
+    //! \brief Fills tiles with the tiles visible from the given start tile within radius. The tiles are ordered from the closest to
     //! the furthest
-    std::vector<Tile*> visibleTiles(int x, int y, int radius);
+    void visibleTiles(int x, int y, int radius, std::vector<Tile*>& tiles);
+
+    //! \brief Same as visibleTiles with the given working buffers. Threads calling it at the same time should each use
+    //! their own workspace and buildSightData should have been called for radius before
+    void visibleTiles(int x, int y, int radius, std::vector<Tile*>& tiles, SightWorkspace& workspace);
+
+    //! \brief Builds what circularRegion and visibleTiles need for the given radius. After that, they only read the
+    //! container so they can be called from several threads while the tiles do not change
+    void buildSightData(int radius);
 
 protected:
     //! \brief The map size
@@ -118,6 +145,11 @@ private:
     //! \brief Stores the highest distance computed. If a bigger distance is asked, mTileDistance will have to be updated by
     //! calling buildTileDistance with the higher distance
     int mTileDistanceComputed;
+
+    //! \brief Line of sight precomputed for each radius (built when first needed)
+    std::vector<std::unique_ptr<SightTemplate>> mSightTemplates;
+
+    SightWorkspace mSightWorkspace;
 };
 
 #endif //TILECONTAINER_H
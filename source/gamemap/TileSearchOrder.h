@@ -0,0 +1,102 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILESEARCHORDER_H
+#define TILESEARCHORDER_H
+
+#include "gamemap/Pathfinding.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*! \brief Order in which the tiles around a creature should be checked when searching the closest one
+ * matching some criteria.
+ *
+ * Each candidate is a tile and the tile the distance is computed to: the tile itself or one of its
+ * neighbors (when the creature works from a neighbor tile). The candidates are sorted by distance from
+ * the center. Candidates at the same distance keep the order of the full search (tiles in the given
+ * order, then neighbors in getAllNeighbors order), so the first candidate matching the criteria is the
+ * one a full search keeping the first closest match would find.
+ * The order only depends on the tile positions, so it can be computed in parallel before the upkeep
+ * (see CreatureAction::prepareSearchOrder). It stays valid as long as the center and the tiles are the same.
+ */
+template<typename TileT>
+class TileSearchOrder
+{
+public:
+    struct Candidate
+    {
+        TileT* mTile;
+        TileT* mTarget;
+        //! \brief Index of mTarget in the mTile neighbors. -1 if mTarget is mTile
+        int32_t mNeighborIndex;
+        int mDist;
+    };
+
+    TileSearchOrder() :
+        mCenter(nullptr),
+        mTilesVersion(0)
+    {}
+
+    /*! \brief Computes the order of the given tiles seen from center. tilesVersion should change when the
+     * content of tiles changes. If withNeighbors is true, there is one candidate for each neighbor of each
+     * tile instead of one for each tile.
+     */
+    void compute(const TileT* center, const std::vector<TileT*>& tiles, uint32_t tilesVersion, bool withNeighbors)
+    {
+        mCenter = center;
+        mTilesVersion = tilesVersion;
+        mCandidates.clear();
+        for(TileT* tile : tiles)
+        {
+            if(tile == nullptr)
+                continue;
+
+            if(!withNeighbors)
+            {
+                mCandidates.push_back({ tile, tile, -1, Pathfinding::squaredDistanceTile(*center, *tile) });
+                continue;
+            }
+
+            const std::vector<TileT*>& neighbors = tile->getAllNeighbors();
+            for(uint32_t i = 0; i < neighbors.size(); ++i)
+            {
+                TileT* neigh = neighbors[i];
+                mCandidates.push_back({ tile, neigh, static_cast<int32_t>(i), Pathfinding::squaredDistanceTile(*center, *neigh) });
+            }
+        }
+
+        std::stable_sort(mCandidates.begin(), mCandidates.end(), [](const Candidate& a, const Candidate& b)
+        {
+            return a.mDist < b.mDist;
+        });
+    }
+
+    inline bool isValid(const TileT* center, uint32_t tilesVersion) const
+    { return (mCenter != nullptr) && (mCenter == center) && (mTilesVersion == tilesVersion); }
+
+    inline const std::vector<Candidate>& getCandidates() const
+    { return mCandidates; }
+
+private:
+    const TileT* mCenter;
+    uint32_t mTilesVersion;
+    std::vector<Candidate> mCandidates;
+};
+
+#endif // TILESEARCHORDER_H
@@ -0,0 +1,267 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gamemap/VisionMap.h"
+
+#include "entities/Tile.h"
+#include "game/Seat.h"
+#include "gamemap/GameMap.h"
+#include "utils/Helper.h"
+#include "utils/LogManager.h"
+
+#include <cstdlib>
+
+VisionMap::VisionMap(GameMap& gameMap) :
+    mGameMap(gameMap),
+    mMapSizeX(0),
+    mMapSizeY(0),
+    mEpoch(0),
+    mAllTilesVisible(false)
+{
+}
+
+void VisionMap::reset()
+{
+    ++mEpoch;
+    mMapSizeX = mGameMap.getMapSizeX();
+    mMapSizeY = mGameMap.getMapSizeY();
+    mAllTilesVisible = false;
+
+    mTeamSeats.clear();
+    for(Seat* seat : mGameMap.getSeats())
+    {
+        if(seat->getTeamIndex() >= mTeamSeats.size())
+            mTeamSeats.resize(seat->getTeamIndex() + 1);
+
+        mTeamSeats[seat->getTeamIndex()].push_back(seat);
+    }
+
+    uint32_t nbTiles = static_cast<uint32_t>(mMapSizeX * mMapSizeY);
+    mCounts.assign(nbTiles * static_cast<uint32_t>(mTeamSeats.size()), 0);
+    mClaimedSeats.assign(nbTiles, nullptr);
+    mIsTileClaimChanged.assign(nbTiles, false);
+    mTilesClaimChanged.clear();
+    mTilesVisionChanged.clear();
+
+    // Claimed tiles will be processed at the next update
+    for(int yy = 0; yy < mMapSizeY; ++yy)
+    {
+        for(int xx = 0; xx < mMapSizeX; ++xx)
+        {
+            Tile* tile = mGameMap.getTile(xx, yy);
+            tile->clearVision();
+            tileClaimChanged(*tile);
+        }
+    }
+
+    if(!mGameMap.getIsFOWActivated())
+        setAllTilesVisible(true);
+}
+
+void VisionMap::update()
+{
+    for(Tile* tile : mTilesClaimChanged)
+    {
+        mIsTileClaimChanged[toIndex(tile->getX(), tile->getY())] = false;
+        setClaimedVision(*tile, tile->isClaimed() ? tile->getSeat() : nullptr);
+    }
+    mTilesClaimChanged.clear();
+}
+
+void VisionMap::endTurn()
+{
+    mTilesVisionChanged.clear();
+}
+
+bool VisionMap::needsUpdate(const Contribution& contribution, Seat* seat, Tile* center, int radius) const
+{
+    if((contribution.mEpoch != mEpoch) ||
+       (contribution.mSeat != seat) ||
+       (contribution.mCenter != center) ||
+       (contribution.mRadius != radius))
+    {
+        return true;
+    }
+
+    for(Tile* tile : mTilesVisionChanged)
+    {
+        if((std::abs(tile->getX() - center->getX()) <= radius) &&
+           (std::abs(tile->getY() - center->getY()) <= radius))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void VisionMap::setVision(Contribution& contribution, Seat* seat, Tile* center, int radius, const std::vector<Tile*>& tiles)
+{
+    if(mCounts.empty())
+        return;
+
+    // We add the new tiles before removing the old ones so that the tiles in both do not
+    // lose vision in between
+    for(Tile* tile : tiles)
+        addVision(*tile, seat);
+
+    clearVision(contribution);
+
+    contribution.mEpoch = mEpoch;
+    contribution.mSeat = seat;
+    contribution.mCenter = center;
+    contribution.mRadius = radius;
+    contribution.mTiles = tiles;
+}
+
+void VisionMap::clearVision(Contribution& contribution)
+{
+    if(contribution.mEpoch == mEpoch)
+    {
+        for(Tile* tile : contribution.mTiles)
+            removeVision(*tile, contribution.mSeat);
+    }
+
+    contribution.mEpoch = 0;
+    contribution.mSeat = nullptr;
+    contribution.mCenter = nullptr;
+    contribution.mRadius = 0;
+    contribution.mTiles.clear();
+}
+
+void VisionMap::tileVisionChanged(Tile& tile)
+{
+    if(mCounts.empty())
+        return;
+
+    mTilesVisionChanged.push_back(&tile);
+}
+
+void VisionMap::tileClaimChanged(Tile& tile)
+{
+    if(mIsTileClaimChanged.empty())
+        return;
+
+    int index = toIndex(tile.getX(), tile.getY());
+    if(mIsTileClaimChanged[index])
+        return;
+
+    mIsTileClaimChanged[index] = true;
+    mTilesClaimChanged.push_back(&tile);
+}
+
+void VisionMap::setAllTilesVisible(bool visible)
+{
+    if(mAllTilesVisible == visible)
+        return;
+
+    mAllTilesVisible = visible;
+    for(int yy = 0; yy < mMapSizeY; ++yy)
+    {
+        for(int xx = 0; xx < mMapSizeX; ++xx)
+        {
+            Tile* tile = mGameMap.getTile(xx, yy);
+            for(uint32_t teamIndex = 0; teamIndex < mTeamSeats.size(); ++teamIndex)
+            {
+                if(visible)
+                    addVisionTeam(*tile, teamIndex);
+                else
+                    removeVisionTeam(*tile, teamIndex);
+            }
+        }
+    }
+}
+
+void VisionMap::addVision(Tile& tile, Seat* seat)
+{
+    if(seat->getTeamIndex() >= mTeamSeats.size())
+    {
+        OD_LOG_ERR("seatId=" + Helper::toString(seat->getId()) + ", teamIndex=" + Helper::toString(seat->getTeamIndex()));
+        return;
+    }
+
+    addVisionTeam(tile, seat->getTeamIndex());
+}
+
+void VisionMap::removeVision(Tile& tile, Seat* seat)
+{
+    if(seat->getTeamIndex() >= mTeamSeats.size())
+    {
+        OD_LOG_ERR("seatId=" + Helper::toString(seat->getId()) + ", teamIndex=" + Helper::toString(seat->getTeamIndex()));
+        return;
+    }
+
+    removeVisionTeam(tile, seat->getTeamIndex());
+}
+
+void VisionMap::addVisionTeam(Tile& tile, uint32_t teamIndex)
+{
+    uint32_t& count = mCounts[static_cast<uint32_t>(toIndex(tile.getX(), tile.getY())) * mTeamSeats.size() + teamIndex];
+    ++count;
+    if(count > 1)
+        return;
+
+    for(Seat* seat : mTeamSeats[teamIndex])
+    {
+        tile.setVisionForSeat(seat, true);
+        seat->setVisionOnTile(&tile, true);
+    }
+}
+
+void VisionMap::removeVisionTeam(Tile& tile, uint32_t teamIndex)
+{
+    uint32_t& count = mCounts[static_cast<uint32_t>(toIndex(tile.getX(), tile.getY())) * mTeamSeats.size() + teamIndex];
+    if(count == 0)
+    {
+        OD_LOG_ERR("tile=" + Tile::displayAsString(&tile) + ", teamIndex=" + Helper::toString(teamIndex));
+        return;
+    }
+
+    --count;
+    if(count > 0)
+        return;
+
+    for(Seat* seat : mTeamSeats[teamIndex])
+    {
+        tile.setVisionForSeat(seat, false);
+        seat->setVisionOnTile(&tile, false);
+    }
+}
+
+void VisionMap::setClaimedVision(Tile& tile, Seat* seat)
+{
+    Seat*& claimedSeat = mClaimedSeats[toIndex(tile.getX(), tile.getY())];
+    if(claimedSeat == seat)
+        return;
+
+    // A claimed tile can see itself and its neighbors
+    if(seat != nullptr)
+    {
+        addVision(tile, seat);
+        for(Tile* neigh : tile.getAllNeighbors())
+            addVision(*neigh, seat);
+    }
+
+    if(claimedSeat != nullptr)
+    {
+        removeVision(tile, claimedSeat);
+        for(Tile* neigh : tile.getAllNeighbors())
+            removeVision(*neigh, claimedSeat);
+    }
+
+    claimedSeat = seat;
+}
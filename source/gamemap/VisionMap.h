@@ -0,0 +1,120 @@
+/*!
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VISIONMAP_H
+#define VISIONMAP_H
+
+#include <cstdint>
+#include <vector>
+
+class GameMap;
+class Seat;
+class Tile;
+
+/*! \brief Server side fog of war.
+ *
+ * For each tile and each team, we count how many sources (creatures, claimed tiles, spells, ...)
+ * give vision on it. Allied seats share the same team so they share vision for free. Seats are
+ * only notified when a count goes from 0 to 1 or from 1 to 0. That way, the vision does not have
+ * to be recomputed from scratch at each turn: a source only updates its contribution when something
+ * it depends on has changed (see needsUpdate).
+ */
+class VisionMap
+{
+public:
+    //! \brief Tiles some source gives vision on. It is owned by the source and should be
+    //! cleared with clearVision when the source stops giving vision.
+    struct Contribution
+    {
+        Contribution() :
+            mEpoch(0),
+            mSeat(nullptr),
+            mCenter(nullptr),
+            mRadius(0)
+        {}
+
+        uint64_t mEpoch;
+        Seat* mSeat;
+        //! \brief Tile the tiles have been computed from and radius used
+        Tile* mCenter;
+        int mRadius;
+        std::vector<Tile*> mTiles;
+    };
+
+    VisionMap(GameMap& gameMap);
+
+    //! \brief Drops every contribution and resizes to fit the current map size and teams. Contributions
+    //! made before this call are ignored. Claimed tiles will be taken into account at the next update
+    void reset();
+
+    //! \brief Processes the tiles whose claimed state changed since the last call
+    void update();
+
+    //! \brief To be called once every source has updated its contribution. Forgets the tiles whose
+    //! vision blocking state changed
+    void endTurn();
+
+    //! \brief Returns true if the given contribution is outdated: it was not computed for the given
+    //! seat, center or radius or a tile within radius has started or stopped blocking vision since
+    bool needsUpdate(const Contribution& contribution, Seat* seat, Tile* center, int radius) const;
+
+    //! \brief Replaces the tiles given by contribution. Tiles both in the old and the new contribution
+    //! are not notified
+    void setVision(Contribution& contribution, Seat* seat, Tile* center, int radius, const std::vector<Tile*>& tiles);
+    void clearVision(Contribution& contribution);
+
+    //! \brief To be called when the given tile may have started or stopped blocking vision
+    void tileVisionChanged(Tile& tile);
+
+    //! \brief To be called when the given tile may have been claimed or unclaimed
+    void tileClaimChanged(Tile& tile);
+
+    //! \brief Gives vision on every tile to every seat (used when the FOW is deactivated and in the editor)
+    void setAllTilesVisible(bool visible);
+
+private:
+    GameMap& mGameMap;
+    int mMapSizeX;
+    int mMapSizeY;
+    uint64_t mEpoch;
+    bool mAllTilesVisible;
+
+    //! \brief Seats of each team index
+    std::vector<std::vector<Seat*>> mTeamSeats;
+
+    //! \brief Number of sources giving vision. Indexed by tile index * nbTeams + team index
+    std::vector<uint32_t> mCounts;
+
+    //! \brief For each tile, seat the claimed tile gives vision to (nullptr if none)
+    std::vector<Seat*> mClaimedSeats;
+    std::vector<Tile*> mTilesClaimChanged;
+    std::vector<bool> mIsTileClaimChanged;
+
+    //! \brief Tiles that started or stopped blocking vision since the last endTurn
+    std::vector<Tile*> mTilesVisionChanged;
+
+    inline int toIndex(int x, int y) const
+    { return x + y * mMapSizeX; }
+
+    void addVision(Tile& tile, Seat* seat);
+    void removeVision(Tile& tile, Seat* seat);
+    void addVisionTeam(Tile& tile, uint32_t teamIndex);
+    void removeVisionTeam(Tile& tile, uint32_t teamIndex);
+    void setClaimedVision(Tile& tile, Seat* seat);
+};
+
+#endif // VISIONMAP_H
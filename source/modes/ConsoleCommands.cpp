@@ -37,6 +37,8 @@ const std::string HELPMESSAGE =
         "\n\thelp keys - Shows the keyboard controls."
         "\n\tlist/ls - Prints out lists of creatures, classes, etc..."
         "\n\tmaxtime - Sets or displays the max time for event messages to be displayed."
+        "\n\treplayspeed - Sets or displays the replay playback speed."
+        "\n\treplayseek - Fast-forwards the replay to the given turn."
         "\n\ttermwidth - Sets the terminal width."
         "\n\n==Cheats=="
         "\n\taddcreature - Adds a creature."
@@ -527,6 +529,64 @@ Command::Result cTriggerCompositor(const Command::ArgumentList_t& args, ConsoleI
     return Command::Result::SUCCESS;
 }
 
+Command::Result cReplaySpeed(const Command::ArgumentList_t& args, ConsoleInterface& c, AbstractModeManager&)
+{
+    ODClient& client = ODClient::getSingleton();
+    if(!client.isReplaying())
+    {
+        c.print("\nNo replay is being played\n");
+        return Command::Result::FAILED;
+    }
+
+    if(args.size() < 2)
+    {
+        if(client.getReplaySpeed() == ODSocketClient::REPLAY_SPEED_MAX)
+            c.print("\nReplay is played as fast as possible\n");
+        else
+            c.print("\nCurrent replay speed is " + Helper::toString(client.getReplaySpeed()) + "\n");
+        return Command::Result::SUCCESS;
+    }
+
+    if(args[1] == "max")
+    {
+        client.setReplaySpeed(ODSocketClient::REPLAY_SPEED_MAX);
+        c.print("\nReplay will be played as fast as possible");
+        return Command::Result::SUCCESS;
+    }
+
+    float speed = Helper::toFloat(args[1]);
+    if(speed <= 0.0f)
+    {
+        c.print("\nInvalid replay speed: " + args[1]);
+        return Command::Result::INVALID_ARGUMENT;
+    }
+
+    client.setReplaySpeed(speed);
+    c.print("\nReplay speed set to: " + Helper::toString(speed));
+    return Command::Result::SUCCESS;
+}
+
+Command::Result cReplaySeek(const Command::ArgumentList_t& args, ConsoleInterface& c, AbstractModeManager&)
+{
+    if(args.size() < 2)
+    {
+        c.print("\nThe turn to go to is needed\n");
+        return Command::Result::INVALID_ARGUMENT;
+    }
+
+    ODClient& client = ODClient::getSingleton();
+    int64_t turn = Helper::toInt(args[1]);
+    if(!client.seekReplay(turn))
+    {
+        c.print("\nCannot go to turn " + args[1] + ", current turn is " + Helper::toString(client.getReplayTurn())
+            + ". A replay cannot go back");
+        return Command::Result::FAILED;
+    }
+
+    c.print("\nGoing to turn " + args[1]);
+    return Command::Result::SUCCESS;
+}
+
 } // namespace <none>
 
 namespace ConsoleCommands
@@ -725,6 +785,20 @@ void addConsoleCommands(ConsoleInterface& cl)
                    cSendCmdToServer,
                    cSrvUnlockSkills,
                    {AbstractModeManager::ModeType::GAME});
+    cl.addCommand("replayspeed",
+                   "'replayspeed' displays or sets the playback speed of the replay being played. "
+                   "'max' plays the replay as fast as possible.\n\nExample:\n"
+                   "replayspeed 8\n\nThe above command will play the replay 8 times faster than the real game.",
+                   cReplaySpeed,
+                   Command::cStubServer,
+                   {AbstractModeManager::ModeType::GAME});
+    cl.addCommand("replayseek",
+                   "'replayseek' plays the replay as fast as possible until the given turn. The turn must be "
+                   "after the current one.\n\nExample:\n"
+                   "replayseek 1500",
+                   cReplaySeek,
+                   Command::cStubServer,
+                   {AbstractModeManager::ModeType::GAME});
 
 }
 
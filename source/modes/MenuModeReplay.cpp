@@ -25,6 +25,7 @@
 #include "render/ODFrameListener.h"
 #include "network/ODServer.h"
 #include "network/ODClient.h"
+#include "network/ReplayFile.h"
 #include "network/ServerNotification.h"
 #include "ODApplication.h"
 #include "utils/LogManager.h"
@@ -218,18 +219,24 @@ bool MenuModeReplay::listReplaysClicked(const CEGUI::EventArgs&)
 bool MenuModeReplay::checkReplayValid(const std::string& replayFileName, std::string& mapDescription, std::string& errorMsg)
 {
     // We open the replay to get the level file name
-    std::ifstream is(replayFileName, std::ios::in | std::ios::binary);
+    ReplayReader reader;
     ODPacket packet;
     ServerNotificationType type;
-    do
+    bool isValid = reader.open(replayFileName);
+    while(isValid)
     {
-        packet.readPacket(is);
+        if(reader.readPacket(packet) < 0)
+        {
+            isValid = false;
+            break;
+        }
+
         OD_ASSERT_TRUE(packet >> type);
-        if(is.eof())
+        if(type == ServerNotificationType::loadLevel)
             break;
-    } while(type != ServerNotificationType::loadLevel);
+    }
 
-    if(is.eof())
+    if(!isValid)
     {
         errorMsg = "Invalid replay file";
         return false;
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/NetworkStringTable.h"
+
+const uint32_t NetworkStringTable::INVALID_ID = 0xFFFFFFFF;
+
+uint32_t NetworkStringTable::addString(const std::string& str, bool& isNew)
+{
+    std::unordered_map<std::string, uint32_t>::const_iterator it = mIds.find(str);
+    if(it != mIds.end())
+    {
+        isNew = false;
+        return it->second;
+    }
+
+    isNew = true;
+    uint32_t id;
+    if(mFreeIds.empty())
+    {
+        id = static_cast<uint32_t>(mStrings.size());
+        mStrings.push_back(str);
+    }
+    else
+    {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+        mStrings[id] = str;
+    }
+    mIds.emplace(str, id);
+    return id;
+}
+
+void NetworkStringTable::removeString(const std::string& str)
+{
+    std::unordered_map<std::string, uint32_t>::const_iterator it = mIds.find(str);
+    if(it == mIds.end())
+        return;
+
+    // The string is kept until the id is given again in case it has not been sent yet
+    mRemovedIds.push_back(it->second);
+    mIds.erase(it);
+}
+
+void NetworkStringTable::recycleRemovedIds()
+{
+    mFreeIds.insert(mFreeIds.end(), mRemovedIds.begin(), mRemovedIds.end());
+    mRemovedIds.clear();
+}
+
+bool NetworkStringTable::setString(uint32_t id, const std::string& str)
+{
+    if(id == INVALID_ID)
+        return false;
+
+    // Ids are reused so the vector should not grow more than the number of strings used at the same time
+    if(id >= mStrings.size())
+        mStrings.resize(id + 1);
+
+    mStrings[id] = str;
+    return true;
+}
+
+const std::string* NetworkStringTable::getString(uint32_t id) const
+{
+    if(id >= mStrings.size())
+        return nullptr;
+
+    return &mStrings[id];
+}
+
+void NetworkStringTable::clear()
+{
+    mStrings.clear();
+    mIds.clear();
+    mRemovedIds.clear();
+    mFreeIds.clear();
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NETWORKSTRINGTABLE_H
+#define NETWORKSTRINGTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*! \brief Dictionary of the strings often sent by the server (entity names, animations, sounds, ...).
+ *
+ * Each string is sent once to the clients with its id (see ServerNotificationType::internStrings). Then,
+ * only the id is sent. The server uses addString to get the id of a string and the clients use setString
+ * when they receive a new string and getString to get it back from its id.
+ * When an entity is removed, the server removes its name so that the id can be given to another string.
+ * The clients just replace the string when they receive the new one for that id.
+ */
+class NetworkStringTable
+{
+public:
+    static const uint32_t INVALID_ID;
+
+    /*! \brief Returns the id of the given string. If the string was not in the table, it is added
+     * and isNew is set to true.
+     */
+    uint32_t addString(const std::string& str, bool& isNew);
+
+    /*! \brief Removes the given string. Its id will only be given to another string once recycleRemovedIds
+     * is called. That way, the messages using the id queued before can still be sent.
+     */
+    void removeString(const std::string& str);
+
+    //! \brief Allows the ids of the strings removed so far to be given to new strings
+    void recycleRemovedIds();
+
+    //! \brief Sets the string for the given id. Returns false if the id is invalid
+    bool setString(uint32_t id, const std::string& str);
+
+    //! \brief Returns the string with the given id or nullptr if there is none
+    const std::string* getString(uint32_t id) const;
+
+    inline uint32_t size() const
+    { return static_cast<uint32_t>(mStrings.size()); }
+
+    void clear();
+
+private:
+    std::vector<std::string> mStrings;
+    //! \brief Only used on the server side
+    std::unordered_map<std::string, uint32_t> mIds;
+    //! \brief Ids of the strings removed since the last call to recycleRemovedIds
+    std::vector<uint32_t> mRemovedIds;
+    //! \brief Ids that can be given to new strings
+    std::vector<uint32_t> mFreeIds;
+};
+
+#endif // NETWORKSTRINGTABLE_H
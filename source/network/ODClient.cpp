@@ -35,6 +35,7 @@
 #include "modes/ModeManager.h"
 #include "network/ChatEventMessage.h"
 #include "network/ODPacket.h"
+#include "network/ODServer.h"
 #include "network/ServerMode.h"
 #include "network/ServerNotification.h"
 #include "render/ODFrameListener.h"
@@ -45,6 +46,7 @@
 #include "utils/ConfigManager.h"
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
+#include "utils/Random.h"
 #include "ODApplication.h"
 
 #include <boost/lexical_cast.hpp>
@@ -55,7 +57,8 @@ template<> ODClient* Ogre::Singleton<ODClient>::msSingleton = nullptr;
 
 ODClient::ODClient() :
     ODSocketClient(),
-    mIsPlayerConfig(false)
+    mIsPlayerConfig(false),
+    mStateChecksumTurn(-1)
 {
 }
 
@@ -82,6 +85,12 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
     OD_LOG_DBG("processMessage type=" + ServerNotification::typeString(cmd));
     switch(cmd)
     {
+        case ServerNotificationType::enableCompression:
+        {
+            enableDecompression();
+            break;
+        }
+
         case ServerNotificationType::loadLevel:
         {
             std::string odVersion;
@@ -337,6 +346,13 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             ServerMode serverMode;
             OD_ASSERT_TRUE(packetReceived >> serverMode);
 
+            // When we host the game, the server already uses the session seed. Otherwise, client side
+            // streams are derived from it
+            uint64_t sessionSeed;
+            OD_ASSERT_TRUE(packetReceived >> sessionSeed);
+            if((ODServer::getSingletonPtr() == nullptr) || !ODServer::getSingleton().isConnected())
+                Random::initialize(sessionSeed);
+
             // Now that the we have received all needed information, we can launch the requested mode
             OD_LOG_INF("Starting game map");
             gameMap->setGamePaused(false);
@@ -435,7 +451,8 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
         {
             GameEntityType entityType;
             std::string entityName;
-            OD_ASSERT_TRUE(packetReceived >> entityType >> entityName);
+            OD_ASSERT_TRUE(packetReceived >> entityType);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, entityName));
             GameEntity* entity = gameMap->getEntityFromTypeAndName(entityType, entityName);
             if(entity == nullptr)
             {
@@ -480,7 +497,10 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             bool loopEndAnim;
             bool playIdleWhenAnimationEnds;
             uint32_t nbDest;
-            OD_ASSERT_TRUE(packetReceived >> walkDistortion >> objName >> walkAnim >> endAnim);
+            OD_ASSERT_TRUE(packetReceived >> walkDistortion);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, objName));
+            OD_ASSERT_TRUE(readInternedString(packetReceived, walkAnim));
+            OD_ASSERT_TRUE(readInternedString(packetReceived, endAnim));
             OD_ASSERT_TRUE(packetReceived >> loopEndAnim >> playIdleWhenAnimationEnds >> nbDest);
 
             MovableGameEntity *tempAnimatedObject = gameMap->getAnimatedObject(objName);
@@ -491,12 +511,13 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             }
 
             std::vector<Ogre::Vector3> path;
-                        
+            Ogre::Vector3 previous = Ogre::Vector3::ZERO;
             while(nbDest > 0)
             {
                 --nbDest;
                 Ogre::Vector3 dest;
-                OD_ASSERT_TRUE(packetReceived >> dest);
+                OD_ASSERT_TRUE(packetReceived.readPositionDelta(dest, previous));
+                previous = dest;
                 if(walkDistortion)
                     tempAnimatedObject->correctEntityMovePosition(dest);
                 path.push_back(dest);
@@ -561,8 +582,9 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             bool loop;
             bool playIdleWhenAnimationEnds;
             bool shouldSetWalkDirection;
-            OD_ASSERT_TRUE(packetReceived >> objName >> animState
-                >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, objName));
+            OD_ASSERT_TRUE(readInternedString(packetReceived, animState));
+            OD_ASSERT_TRUE(packetReceived >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
             MovableGameEntity *obj = gameMap->getAnimatedObject(objName);
             if (obj == nullptr)
             {
@@ -601,7 +623,7 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             {
                 --nbEntities;
                 OD_ASSERT_TRUE(packetReceived >> entityType);
-                OD_ASSERT_TRUE(packetReceived >> entityName);
+                OD_ASSERT_TRUE(readInternedString(packetReceived, entityName));
                 GameEntity* entity = gameMap->getEntityFromTypeAndName(entityType, entityName);
                 if(entity == nullptr)
                 {
@@ -620,7 +642,7 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             Ogre::Vector3 vv;
 
             
-            OD_ASSERT_TRUE(packetReceived >> entityName);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, entityName));
             OD_ASSERT_TRUE(packetReceived >> vv);            
 
             MovableGameEntity* entity = gameMap->getRenderedMovableEntity(entityName);
@@ -660,7 +682,8 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
         {
             std::string entityName;
             float opacity;
-            OD_ASSERT_TRUE(packetReceived >> entityName >> opacity);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, entityName));
+            OD_ASSERT_TRUE(packetReceived >> opacity);
 
             RenderedMovableEntity* entity = gameMap->getRenderedMovableEntity(entityName);
             if(entity == nullptr)
@@ -678,7 +701,8 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             std::string family;
             int xPos;
             int yPos;
-            OD_ASSERT_TRUE(packetReceived >> family >> xPos >> yPos);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, family));
+            OD_ASSERT_TRUE(packetReceived >> xPos >> yPos);
             SoundEffectsManager::getSingleton().playSpatialSound(family, xPos, yPos);
             break;
         }
@@ -777,49 +801,37 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
 
         case ServerNotificationType::refreshVisibleTiles:
         {
-            uint32_t nbTiles;
-            // Tiles we gained vision
-            OD_ASSERT_TRUE(packetReceived >> nbTiles);
-            while(nbTiles > 0)
+            // Tiles we gained vision then tiles we lost vision. We update the vision of
+            // every tile before refreshing the meshes
+            std::vector<Tile*> tilesVisionGained;
+            std::vector<Tile*> tilesVisionLost;
+            if(!gameMap->tilesFromPacket(packetReceived, tilesVisionGained) ||
+               !gameMap->tilesFromPacket(packetReceived, tilesVisionLost))
             {
-                --nbTiles;
-                Tile* tile = gameMap->tileFromPacket(packetReceived);
-                if(tile == nullptr)
-                    continue;
-
-                tile->setLocalPlayerHasVision(true);
-                tile->refreshMesh();
+                break;
             }
-            // Tiles we lost vision
-            OD_ASSERT_TRUE(packetReceived >> nbTiles);
-            while(nbTiles > 0)
-            {
-                --nbTiles;
-                Tile* tile = gameMap->tileFromPacket(packetReceived);
-                if(tile == nullptr)
-                    continue;
 
+            for(Tile* tile : tilesVisionGained)
+                tile->setLocalPlayerHasVision(true);
+            for(Tile* tile : tilesVisionLost)
                 tile->setLocalPlayerHasVision(false);
+
+            for(Tile* tile : tilesVisionGained)
+                tile->refreshMesh();
+            for(Tile* tile : tilesVisionLost)
                 tile->refreshMesh();
-            }
             break;
         }
 
         case ServerNotificationType::refreshTiles:
         {
-            uint32_t nbTiles;
-            OD_ASSERT_TRUE(packetReceived >> nbTiles);
             std::vector<Tile*> tiles;
-            while(nbTiles > 0)
-            {
-                --nbTiles;
-                Tile* gameTile = gameMap->tileFromPacket(packetReceived);
-                if(gameTile == nullptr)
-                    continue;
+            if(!gameMap->tilesFromPacket(packetReceived, tiles))
+                break;
+
+            for(Tile* tile : tiles)
+                tile->updateFromPacket(packetReceived);
 
-                gameTile->updateFromPacket(packetReceived);
-                tiles.push_back(gameTile);
-            }
             gameMap->refreshBorderingTilesOf(tiles);
             break;
         }
@@ -851,7 +863,9 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             std::string carrierName;
             GameEntityType entityType;
             std::string carriedName;
-            OD_ASSERT_TRUE(packetReceived >> carrierName >> entityType >> carriedName);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, carrierName));
+            OD_ASSERT_TRUE(packetReceived >> entityType);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, carriedName));
             Creature* carrier = gameMap->getCreature(carrierName);
             if(carrier == nullptr)
             {
@@ -878,7 +892,10 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             GameEntityType entityType;
             std::string carriedName;
             Ogre::Vector3 pos;
-            OD_ASSERT_TRUE(packetReceived >> carrierName >> entityType >> carriedName >> pos);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, carrierName));
+            OD_ASSERT_TRUE(packetReceived >> entityType);
+            OD_ASSERT_TRUE(readInternedString(packetReceived, carriedName));
+            OD_ASSERT_TRUE(packetReceived >> pos);
             Creature* carrier = gameMap->getCreature(carrierName);
             if(carrier == nullptr)
             {
@@ -968,6 +985,17 @@ bool ODClient::processMessage(ServerNotificationType cmd, ODPacket& packetReceiv
             break;
         }
 
+        case ServerNotificationType::stateChecksum:
+        {
+            // The client does not simulate the game so there is nothing to compare with. We keep the
+            // checksum so that runs with the same seed and inputs can be compared (it is also saved in
+            // the replays)
+            OD_ASSERT_TRUE(packetReceived >> mStateChecksumTurn >> mStateChecksum);
+            OD_LOG_DBG("turn=" + Helper::toString(mStateChecksumTurn)
+                + ", stateChecksum=" + Helper::toString(mStateChecksum.getGlobalHash()));
+            break;
+        }
+
         default:
         {
             OD_LOG_ERR("Unknown server command:"
@@ -1050,10 +1078,11 @@ bool ODClient::connect(const std::string& host, const int port, uint32_t timeout
     if(!ODSocketClient::connect(host, port, timeout, outputReplayFilename))
         return false;
 
-    // Send a hello request to start the conversation with the server
+    // Send a hello request to start the conversation with the server. We can read compressed packets
+    bool isCompressionSupported = true;
     ODPacket packSend;
     packSend << ClientNotificationType::hello
-        << std::string("OpenDungeons V ") + ODApplication::VERSION;
+        << std::string("OpenDungeons V ") + ODApplication::VERSION << isCompressionSupported;
     send(packSend);
 
     return true;
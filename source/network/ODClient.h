@@ -18,6 +18,7 @@
 #ifndef ODCLIENT_H
 #define ODCLIENT_H
 
+#include "gamemap/StateChecksum.h"
 #include "network/ODSocketClient.h"
 #include "network/ClientNotification.h"
 
@@ -85,6 +86,13 @@ class ODClient: public Ogre::Singleton<ODClient>,
     inline bool getIsPlayerConfig() const
     { return mIsPlayerConfig; }
 
+    //! \brief Last state checksum received from a server in lockstep mode and the turn it was computed at
+    inline const StateChecksum& getStateChecksum() const
+    { return mStateChecksum; }
+
+    inline int64_t getStateChecksumTurn() const
+    { return mStateChecksumTurn; }
+
  protected:
     bool processMessage(ServerNotificationType cmd, ODPacket& packetReceived) override;
     void playerDisconnected() override;
@@ -104,6 +112,9 @@ class ODClient: public Ogre::Singleton<ODClient>,
     // true if the server told us we are allowed to configure the game. False otherwise
     bool mIsPlayerConfig;
 
+    StateChecksum mStateChecksum;
+    int64_t mStateChecksumTurn;
+
 };
 
 template<typename ...Args>
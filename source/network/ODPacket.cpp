@@ -17,52 +17,71 @@
 
 #include "network/ODPacket.h"
 
+#include <cmath>
+#include <cstring>
+
 #define OD_INT64TOINT32H(valInt64)              (static_cast<int32_t>(valInt64 >> 32))
 #define OD_INT64TOINT32L(valInt64)              (static_cast<int32_t>(valInt64))
 #define OD_INT32TOINT64(valInt32h,valInt32l)    ((((static_cast<int64_t>(valInt32h)) << 32) & static_cast<int64_t>(0xFFFFFFFF00000000)) + ((static_cast<int64_t>(valInt32l)) & static_cast<int64_t>(0x00000000FFFFFFFF)))
 
-// The max buffer size when reading packets.
-const int32_t BUFFER_SIZE = 1024;
+const Ogre::Real ODPacket::POSITION_SCALE = 256.0;
+
+static int32_t toFixedPoint(Ogre::Real v)
+{
+    return static_cast<int32_t>(std::round(v * ODPacket::POSITION_SCALE));
+}
 
 ODPacket& ODPacket::operator >>(bool& data)
 {
-    mPacket>>data;
+    uint8_t value;
+    if(*this >> value)
+        data = (value != 0);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(int8_t& data)
 {
-    mPacket>>data;
+    uint32_t value;
+    if(readBigEndian(sizeof(data), value))
+        data = static_cast<int8_t>(value);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(uint8_t& data)
 {
-    mPacket>>data;
+    uint32_t value;
+    if(readBigEndian(sizeof(data), value))
+        data = static_cast<uint8_t>(value);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(int16_t& data)
 {
-    mPacket>>data;
+    uint32_t value;
+    if(readBigEndian(sizeof(data), value))
+        data = static_cast<int16_t>(value);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(uint16_t& data)
 {
-    mPacket>>data;
+    uint32_t value;
+    if(readBigEndian(sizeof(data), value))
+        data = static_cast<uint16_t>(value);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(int32_t& data)
 {
-    mPacket>>data;
+    uint32_t value;
+    if(readBigEndian(sizeof(data), value))
+        data = static_cast<int32_t>(value);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(uint32_t& data)
 {
-    mPacket>>data;
+    readBigEndian(sizeof(data), data);
     return *this;
 }
 
@@ -71,9 +90,8 @@ ODPacket& ODPacket::operator >>(int64_t& data)
     // Note: currently, SFML 2.1 do not handle int64. We do it ourselves
     int32_t dataH;
     int32_t dataL;
-    mPacket>>dataH;
-    mPacket>>dataL;
-    data = OD_INT32TOINT64(dataH,dataL);
+    if(*this >> dataH >> dataL)
+        data = OD_INT32TOINT64(dataH,dataL);
     return *this;
 }
 
@@ -82,92 +100,136 @@ ODPacket& ODPacket::operator >>(uint64_t& data)
     // Note: currently, SFML 2.1 do not handle int64. We do it ourselves
     uint32_t dataH;
     uint32_t dataL;
-    mPacket>>dataH;
-    mPacket>>dataL;
-    data = OD_INT32TOINT64(dataH,dataL);
+    if(*this >> dataH >> dataL)
+        data = OD_INT32TOINT64(dataH,dataL);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(float& data)
 {
-    mPacket>>data;
+    readRaw(data);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(double& data)
 {
-    mPacket>>data;
+    readRaw(data);
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(char* data)
 {
-    mPacket>>data;
+    uint32_t length;
+    if(!(*this >> length))
+        return *this;
+
+    if((length > 0) && checkSize(length))
+    {
+        std::memcpy(data, getData() + mReadPos, length);
+        data[length] = '\0';
+        mReadPos += length;
+    }
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(std::string& data)
 {
-    mPacket>>data;
+    uint32_t length;
+    if(!(*this >> length))
+        return *this;
+
+    data.clear();
+    if((length > 0) && checkSize(length))
+    {
+        data.assign(getData() + mReadPos, length);
+        mReadPos += length;
+    }
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(wchar_t* data)
 {
-    mPacket>>data;
+    uint32_t length;
+    if(!(*this >> length))
+        return *this;
+
+    if((length == 0) || !checkSize(static_cast<uint64_t>(length) * sizeof(uint32_t)))
+        return *this;
+
+    for(uint32_t i = 0; i < length; ++i)
+    {
+        uint32_t character;
+        *this >> character;
+        data[i] = static_cast<wchar_t>(character);
+    }
+    data[length] = L'\0';
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(std::wstring& data)
 {
-    mPacket>>data;
+    uint32_t length;
+    if(!(*this >> length))
+        return *this;
+
+    data.clear();
+    if((length == 0) || !checkSize(static_cast<uint64_t>(length) * sizeof(uint32_t)))
+        return *this;
+
+    for(uint32_t i = 0; i < length; ++i)
+    {
+        uint32_t character;
+        *this >> character;
+        data += static_cast<wchar_t>(character);
+    }
     return *this;
 }
 
 ODPacket& ODPacket::operator >>(Ogre::Vector3& data)
 {
-    mPacket >> data.x >> data.y >> data.z;
+    *this >> data.x >> data.y >> data.z;
     return *this;
 }
+
 ODPacket& ODPacket::operator <<(bool data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(int8_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(uint8_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(int16_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(uint16_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(int32_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(uint32_t data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
@@ -176,8 +238,8 @@ ODPacket& ODPacket::operator <<(int64_t data)
     // Note: currently, SFML 2.1 do not handle int64. We do it ourselves
     int32_t dataH = OD_INT64TOINT32H(data);
     int32_t dataL = OD_INT64TOINT32L(data);
-    mPacket<<dataH;
-    mPacket<<dataL;
+    makeOwned() << dataH;
+    makeOwned() << dataL;
     return *this;
 }
 
@@ -186,94 +248,233 @@ ODPacket& ODPacket::operator <<(uint64_t data)
     // Note: currently, SFML 2.1 do not handle int64. We do it ourselves
     int32_t dataH = OD_INT64TOINT32H(data);
     int32_t dataL = OD_INT64TOINT32L(data);
-    mPacket<<dataH;
-    mPacket<<dataL;
+    makeOwned() << dataH;
+    makeOwned() << dataL;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(float data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(double data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(const char* data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(const std::string& data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(const wchar_t* data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(const std::wstring& data)
 {
-    mPacket<<data;
+    makeOwned() << data;
     return *this;
 }
 
 ODPacket& ODPacket::operator <<(const Ogre::Vector3&   data)
 {
-    mPacket << data.x << data.y << data.z;
+    makeOwned() << data.x << data.y << data.z;
     return *this;
 }
 
 ODPacket::operator bool() const
 {
-    return mPacket;
+    return mIsValid;
 }
 
 void ODPacket::clear()
 {
     mPacket.clear();
+    mViewData = nullptr;
+    mViewSize = 0;
+    mReadPos = 0;
+    mIsValid = true;
 }
 
-void ODPacket::writePacket(int32_t timestamp, std::ofstream& os)
+void ODPacket::writeVarUInt(uint32_t data)
 {
-    int32_t bufferSize = mPacket.getDataSize();
-    const char* buffer = static_cast<const char*>(mPacket.getData());
-    os.write(reinterpret_cast<const char*>(&timestamp), sizeof(int32_t));
-    os.write(reinterpret_cast<const char*>(&bufferSize), sizeof(int32_t));
-    os.write(buffer, bufferSize);
+    while(data >= 0x80)
+    {
+        uint8_t byte = static_cast<uint8_t>(data | 0x80);
+        makeOwned() << byte;
+        data >>= 7;
+    }
+    uint8_t byte = static_cast<uint8_t>(data);
+    makeOwned() << byte;
 }
 
-int32_t ODPacket::readPacket(std::ifstream& is)
+bool ODPacket::readVarUInt(uint32_t& data)
 {
-    int32_t timestamp;
-    int32_t packetSize;
+    data = 0;
+    // A 32 bits value takes at most 5 bytes
+    for(uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte;
+        if(!(*this >> byte))
+            return false;
 
-    is.read(reinterpret_cast<char*>(&timestamp), sizeof(int32_t));
-    if(is.eof())
-        return -1;
+        data |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+            return true;
+    }
 
-    is.read(reinterpret_cast<char*>(&packetSize), sizeof(int32_t));
-    if(is.eof())
-        return -1;
+    return false;
+}
 
-    mPacket.clear();
-    char buffer[BUFFER_SIZE];
-    while(packetSize > 0)
-    {
-        int32_t sizeToRead = std::min(packetSize, BUFFER_SIZE);
-        is.read(buffer, sizeToRead);
-        mPacket.append(buffer, sizeToRead);
-        packetSize -= sizeToRead;
-    }
+void ODPacket::writeVarInt(int32_t data)
+{
+    // Zigzag encoding: 0, -1, 1, -2, ... are written as 0, 1, 2, 3, ...
+    uint32_t zigzag = (static_cast<uint32_t>(data) << 1) ^ static_cast<uint32_t>(data >> 31);
+    writeVarUInt(zigzag);
+}
+
+bool ODPacket::readVarInt(int32_t& data)
+{
+    uint32_t zigzag;
+    if(!readVarUInt(zigzag))
+        return false;
+
+    data = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+    return true;
+}
+
+void ODPacket::writePositionDelta(const Ogre::Vector3& pos, const Ogre::Vector3& ref)
+{
+    writeVarInt(toFixedPoint(pos.x) - toFixedPoint(ref.x));
+    writeVarInt(toFixedPoint(pos.y) - toFixedPoint(ref.y));
+    writeVarInt(toFixedPoint(pos.z) - toFixedPoint(ref.z));
+}
+
+bool ODPacket::readPositionDelta(Ogre::Vector3& pos, const Ogre::Vector3& ref)
+{
+    int32_t dx;
+    int32_t dy;
+    int32_t dz;
+    if(!readVarInt(dx) || !readVarInt(dy) || !readVarInt(dz))
+        return false;
+
+    pos.x = static_cast<Ogre::Real>(toFixedPoint(ref.x) + dx) / POSITION_SCALE;
+    pos.y = static_cast<Ogre::Real>(toFixedPoint(ref.y) + dy) / POSITION_SCALE;
+    pos.z = static_cast<Ogre::Real>(toFixedPoint(ref.z) + dz) / POSITION_SCALE;
+    return true;
+}
 
-    return timestamp;
+uint32_t ODPacket::getDataSize() const
+{
+    if(mViewData != nullptr)
+        return mViewSize;
+
+    return static_cast<uint32_t>(mPacket.getDataSize());
+}
+
+const char* ODPacket::getData() const
+{
+    if(mViewData != nullptr)
+        return mViewData;
+
+    return static_cast<const char*>(mPacket.getData());
+}
+
+bool ODPacket::endOfPacket() const
+{
+    return mReadPos >= getDataSize();
+}
+
+void ODPacket::writeSubPacket(const ODPacket& packet)
+{
+    // Same format as a std::string: the size then the data
+    uint32_t size = packet.getDataSize();
+    sf::Packet& data = makeOwned();
+    data << size;
+    data.append(packet.getData(), size);
+}
+
+bool ODPacket::readSubPacket(ODPacket& packet)
+{
+    if(endOfPacket())
+        return false;
+
+    uint32_t size;
+    if(!(*this >> size) || !checkSize(size))
+        return false;
+
+    packet.setView(getData() + mReadPos, size);
+    mReadPos += size;
+    return true;
+}
+
+void ODPacket::setData(const char* data, uint32_t size)
+{
+    clear();
+    mPacket.append(data, size);
+}
+
+void ODPacket::setView(const char* data, uint32_t size)
+{
+    clear();
+    mViewData = data;
+    mViewSize = size;
+}
+
+bool ODPacket::checkSize(uint64_t size)
+{
+    mIsValid = mIsValid && (static_cast<uint64_t>(mReadPos) + size <= getDataSize());
+    return mIsValid;
+}
+
+bool ODPacket::readBigEndian(uint32_t nbBytes, uint32_t& data)
+{
+    if(!checkSize(nbBytes))
+        return false;
+
+    const char* bytes = getData() + mReadPos;
+    data = 0;
+    for(uint32_t i = 0; i < nbBytes; ++i)
+        data = (data << 8) | static_cast<uint8_t>(bytes[i]);
+
+    mReadPos += nbBytes;
+    return true;
+}
+
+template<typename T>
+bool ODPacket::readRaw(T& data)
+{
+    if(!checkSize(sizeof(data)))
+        return false;
+
+    std::memcpy(&data, getData() + mReadPos, sizeof(data));
+    mReadPos += sizeof(data);
+    return true;
+}
+
+sf::Packet& ODPacket::makeOwned()
+{
+    if(mViewData == nullptr)
+        return mPacket;
+
+    // The read position is kept
+    const char* data = mViewData;
+    mViewData = nullptr;
+    mPacket.clear();
+    mPacket.append(data, mViewSize);
+    mViewSize = 0;
+    return mPacket;
 }
@@ -62,13 +62,23 @@
  * Emission : packet << creature->mHp;
  * Reception : packet >> creature->mHp;
  * This way, if mHp changes (from float to double for example), it will still work.
+ *
+ * A packet can also be a read only view on data it does not own (see setView). Received packets are
+ * read that way without copying them. Copying a view copies the view, not the data.
  */
 class ODPacket
 {
     friend class ODSocketClient;
 
     public:
-        ODPacket()
+        //! \brief Positions written by writePositionDelta are rounded to 1/POSITION_SCALE
+        static const Ogre::Real POSITION_SCALE;
+
+        ODPacket() :
+            mViewData(nullptr),
+            mViewSize(0),
+            mReadPos(0),
+            mIsValid(true)
         {}
         ~ODPacket()
         {}
@@ -125,15 +135,49 @@ class ODPacket
          */
         void clear();
 
-        /*! \brief Writes the packet content to the given ofstream.
+        //! \brief Size in bytes of the data in the packet
+        uint32_t getDataSize() const;
+
+        //! \brief Raw data of the packet (getDataSize bytes)
+        const char* getData() const;
+
+        //! \brief Returns true if every data in the packet has been exported
+        bool endOfPacket() const;
+
+        /*! \brief Appends the whole content of the given packet. It can then be read on reception
+         * with readSubPacket. That allows to send many packets at once.
+         */
+        void writeSubPacket(const ODPacket& packet);
+
+        /*! \brief Reads a packet written with writeSubPacket. Returns false if there is no more
+         * packet to read. packet is a view on the data of this packet (see setView).
+         */
+        bool readSubPacket(ODPacket& packet);
+
+        /*! \brief Writes an unsigned integer with as few bytes as possible (7 bits per byte). Small values
+         * like counters or flags only take 1 byte.
          */
-        void writePacket(int32_t timestamp, std::ofstream& os);
+        void writeVarUInt(uint32_t data);
+        bool readVarUInt(uint32_t& data);
 
-        /*! \brief Reads the packet content from the given ifstream.
-         *         Returns the timestamp at which the packet has been sent.
-         *         If EOF has been reached, returns -1
+        //! \brief Same as writeVarUInt for signed values (small negative values also take few bytes)
+        void writeVarInt(int32_t data);
+        bool readVarInt(int32_t& data);
+
+        /*! \brief Writes pos in fixed point relative to ref. If positions are chained (the previous one being
+         * the ref of the next one), a position usually takes a few bytes instead of the 12 bytes of a Vector3.
+         * When reading, ref should be the same as when writing (for example, the previous position read)
+         */
+        void writePositionDelta(const Ogre::Vector3& pos, const Ogre::Vector3& ref);
+        bool readPositionDelta(Ogre::Vector3& pos, const Ogre::Vector3& ref);
+
+        //! \brief Replaces the content of the packet by a copy of the given data
+        void setData(const char* data, uint32_t size);
+
+        /*! \brief Makes the packet a read only view on the given data, which is not copied. It has to stay
+         * valid while the packet (or a copy of it) is read. Writing to the packet copies the data first.
          */
-        int32_t readPacket(std::ifstream& is);
+        void setView(const char* data, uint32_t size);
 
         /*! \brief Template function to put arguments in a packet, used for in-place construction.
          */
@@ -151,7 +195,27 @@ class ODPacket
         }
 
     private:
+        //! \brief Checks that size bytes can be read and invalidates the packet if not (like sf::Packet)
+        bool checkSize(uint64_t size);
+
+        //! \brief Reads an unsigned integer written by sf::Packet (network byte order)
+        bool readBigEndian(uint32_t nbBytes, uint32_t& data);
+
+        //! \brief Reads a value copied as is by sf::Packet (floating points)
+        template<typename T>
+        bool readRaw(T& data);
+
+        //! \brief If the packet is a view, copies the data so that the packet owns it. Returns the data
+        sf::Packet& makeOwned();
+
+        //! \brief Data written. Unused if the packet is a view
         sf::Packet mPacket;
+        //! \brief The data if the packet is a view. nullptr otherwise
+        const char* mViewData;
+        uint32_t mViewSize;
+        //! \brief Data are read by ODPacket (and not sf::Packet) so that views can be read
+        uint32_t mReadPos;
+        bool mIsValid;
 
 };
 
@@ -46,6 +46,7 @@
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 #include "utils/MasterServer.h"
+#include "utils/Random.h"
 #include "utils/ResourceManager.h"
 #include "ODApplication.h"
 
@@ -57,6 +58,8 @@
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <tuple>
+
 
 const std::string SAVEGAME_SKIRMISH_PREFIX = "SK-";
 const std::string SAVEGAME_MULTIPLAYER_PREFIX = "MP-";
@@ -64,6 +67,8 @@ static const double MASTER_SERVER_UPDATE_PERIOD_MS = 30000.0;
 static const int32_t MASTER_SERVER_STATUS_PENDING = 0;
 static const int32_t MASTER_SERVER_STATUS_STARTED = 1;
 static const int32_t MASTER_SERVER_STATUS_FINISHED = 2;
+//! \brief In lockstep mode, the state checksum is sent to the clients every STATE_CHECKSUM_PERIOD turns
+static const int64_t STATE_CHECKSUM_PERIOD = 10;
 
 template<> ODServer* Ogre::Singleton<ODServer>::msSingleton = nullptr;
 
@@ -94,6 +99,16 @@ bool ODServer::startServer(const std::string& creator, const std::string& levelF
     mMasterServerGameId.clear();
     mMasterServerGameStatusUpdateTime = 0.0;
     mPlayerConfig = nullptr;
+    mStringTable.clear();
+    mStringIdsToSend.clear();
+
+    // Every game restarts the random streams so that a forced seed always gives the same game
+    uint64_t seed = ResourceManager::getSingleton().getForcedRandomSeed();
+    if(seed == 0)
+        Random::initialize();
+    else
+        Random::initialize(seed);
+    mGameMap->setLockstep(ResourceManager::getSingleton().isLockstepMode());
 
     // Start the server socket listener as well as the server socket thread
     if (isConnected())
@@ -247,13 +262,81 @@ void ODServer::sendAsyncMsg(ServerNotification& notif)
     sendMsg(notif.mConcernedPlayer, notif.mPacket);
 }
 
-void ODServer::sendMsg(Player* player, ODPacket& packet)
+uint32_t ODServer::internString(const std::string& str)
+{
+    bool isNew;
+    uint32_t id = mStringTable.addString(str, isNew);
+    if(isNew)
+        mStringIdsToSend.push_back(id);
+
+    return id;
+}
+
+void ODServer::releaseString(const std::string& str)
+{
+    mStringTable.removeString(str);
+}
+
+void ODServer::sendInternedStrings()
+{
+    if(mStringIdsToSend.empty())
+        return;
+
+    ODPacket packet;
+    uint32_t nbStrings = mStringIdsToSend.size();
+    packet << ServerNotificationType::internStrings << nbStrings;
+    for(uint32_t id : mStringIdsToSend)
+    {
+        const std::string* str = mStringTable.getString(id);
+        packet << id << *str;
+    }
+    mStringIdsToSend.clear();
+
+    // The strings are sent right away (and not in the current batch) so that they are known before
+    // any message using them. It does not matter if some clients do not need them
+    for (ODSocketClient* client : mSockClients)
+        client->send(packet);
+}
+
+void ODServer::sendNotificationInBatch(ServerNotification* notification)
 {
+    // If a client is late, sounds are not worth sending and only the last of the notifications
+    // overriding each other (like walk paths) is needed
+    ODSocketClient::BacklogPolicy policy = ODSocketClient::BacklogPolicy::keep;
+    std::string coalescingKey;
+    switch(notification->mType)
+    {
+        case ServerNotificationType::playSpatialSound:
+        case ServerNotificationType::playRelativeSound:
+            policy = ODSocketClient::BacklogPolicy::drop;
+            break;
+        default:
+            if(notification->mCoalescingKey.empty())
+                break;
+
+            policy = ODSocketClient::BacklogPolicy::collapse;
+            coalescingKey = ServerNotification::typeString(notification->mType) + ":" + notification->mCoalescingKey;
+            break;
+    }
+
+    sendMsg(notification->mConcernedPlayer, notification->mPacket, true, policy, coalescingKey);
+}
+
+void ODServer::sendMsg(Player* player, ODPacket& packet, bool inBatch,
+    ODSocketClient::BacklogPolicy policy, const std::string& coalescingKey)
+{
+    sendInternedStrings();
+
     if(player == nullptr)
     {
         // If player is nullptr, we send the message to every connected player
         for (ODSocketClient* client : mSockClients)
-            client->send(packet);
+        {
+            if(inBatch)
+                client->sendInBatch(packet, policy, coalescingKey);
+            else
+                client->send(packet);
+        }
 
         return;
     }
@@ -269,7 +352,12 @@ void ODServer::sendMsg(Player* player, ODPacket& packet)
         return;
     }
 
-    if(client != nullptr)
+    if(client == nullptr)
+        return;
+
+    if(inBatch)
+        client->sendInBatch(packet, policy, coalescingKey);
+    else
         client->send(packet);
 }
 
@@ -386,6 +474,14 @@ void ODServer::startNewTurn(double timeSinceLastTurn)
             break;
     }
 
+    if(gameMap->isLockstep() && ((turn % STATE_CHECKSUM_PERIOD) == 0))
+    {
+        ServerNotification* serverNotification = new ServerNotification(
+            ServerNotificationType::stateChecksum, nullptr);
+        serverNotification->mPacket << turn << gameMap->getStateChecksum();
+        queueServerNotification(serverNotification);
+    }
+
     gameMap->fireRefreshEntities();
     gameMap->processDeletionQueues();
 }
@@ -460,18 +556,9 @@ void ODServer::serverThread()
                 // In editor mode, we give vision on all the gamemap tiles
                 if(mServerMode == ServerMode::ModeEditor)
                 {
+                    gameMap->getVisionMap().setAllTilesVisible(true);
                     for (Seat* seat : gameMap->getSeats())
-                    {
-                        for (int jj = 0; jj < gameMap->getMapSizeY(); ++jj)
-                        {
-                            for (int ii = 0; ii < gameMap->getMapSizeX(); ++ii)
-                            {
-                                gameMap->getTile(ii,jj)->notifyVision(seat);
-                            }
-                        }
-
                         seat->sendVisibleTiles();
-                    }
                 }
 
                 gameMap->createAllEntities();
@@ -510,7 +597,12 @@ void ODServer::serverThread()
         // to wait for server. If server is in advance, he might send commands before the
         // creatures arrive at their destination. That could result in weird issues like
         // creatures going through walls.
-        startNewTurn(static_cast<double>(clock.restart().asSeconds()) * 0.95);
+        double timeSinceLastTurn = static_cast<double>(clock.restart().asSeconds()) * 0.95;
+        // In lockstep mode, the turns should not depend on the server load
+        if(gameMap->isLockstep())
+            timeSinceLastTurn = 1.0 / ODApplication::turnsPerSecond;
+
+        startNewTurn(timeSinceLastTurn);
 
         processServerNotifications();
     }
@@ -526,6 +618,18 @@ void ODServer::processServerNotifications()
 {
     GameMap* gameMap = mGameMap;
 
+    // Notifications that override the previous ones with the same key (like walk paths) are only
+    // sent once per turn: we only keep the last one for each key
+    std::map<std::tuple<ServerNotificationType, Player*, std::string>, ServerNotification*> lastNotifications;
+    for(ServerNotification* event : mServerNotificationQueue)
+    {
+        if((event == nullptr) || event->mCoalescingKey.empty())
+            continue;
+
+        lastNotifications[std::make_tuple(event->mType, event->mConcernedPlayer, event->mCoalescingKey)] = event;
+    }
+
+    uint32_t nbCoalesced = 0;
     bool running = true;
 
     while (running)
@@ -544,46 +648,90 @@ void ODServer::processServerNotifications()
             continue;
         }
 
+        if(!event->mCoalescingKey.empty())
+        {
+            auto it = lastNotifications.find(std::make_tuple(event->mType, event->mConcernedPlayer, event->mCoalescingKey));
+            if((it != lastNotifications.end()) && (it->second != event))
+            {
+                ++nbCoalesced;
+                delete event;
+                continue;
+            }
+        }
+
         OD_LOG_DBG("processServerNotifications type=" + ServerNotification::typeString(event->mType));
         switch (event->mType)
         {
             case ServerNotificationType::turnStarted:
                 OD_LOG_INF("Server sends newturn="
                     + boost::lexical_cast<std::string>(gameMap->getTurnNumber()));
-                sendMsg(event->mConcernedPlayer, event->mPacket);
+                sendNotificationInBatch(event);
                 break;
 
             case ServerNotificationType::entityPickedUp:
                 // This message should not be sent by human players (they are notified asynchronously)
                 OD_ASSERT_TRUE_MSG(event->mConcernedPlayer->getIsHuman(), "nick=" + event->mConcernedPlayer->getNick());
-                sendMsg(event->mConcernedPlayer, event->mPacket);
+                sendNotificationInBatch(event);
                 break;
 
             case ServerNotificationType::entityDropped:
                 // This message should not be sent by human players (they are notified asynchronously)
                 OD_ASSERT_TRUE_MSG(event->mConcernedPlayer->getIsHuman(), "nick=" + event->mConcernedPlayer->getNick());
-                sendMsg(event->mConcernedPlayer, event->mPacket);
+                sendNotificationInBatch(event);
                 break;
 
             case ServerNotificationType::entitySlapped:
                 // This message should not be sent by human players (they are notified asynchronously)
                 OD_ASSERT_TRUE_MSG(!event->mConcernedPlayer->getIsHuman(), "nick=" + event->mConcernedPlayer->getNick());
-                sendMsg(event->mConcernedPlayer, event->mPacket);
+                sendNotificationInBatch(event);
                 break;
 
             case ServerNotificationType::exit:
+                // We send what was queued before stopping, even to late clients
+                for (ODSocketClient* client : mSockClients)
+                    client->flushBatch(true);
+
                 running = false;
                 stopServer();
                 break;
 
             default:
-                sendMsg(event->mConcernedPlayer, event->mPacket);
+                sendNotificationInBatch(event);
                 break;
         }
 
         delete event;
         event = nullptr;
     }
+
+    uint64_t nbBytes = 0;
+    uint64_t nbPackets = 0;
+    // Packets are written to the sockets by the network thread. The backlog is what the
+    // slowest client did not receive yet
+    uint64_t maxBacklogBytes = 0;
+    uint32_t nbLateClients = 0;
+    for (ODSocketClient* client : mSockClients)
+    {
+        if(client->isLate())
+            ++nbLateClients;
+
+        uint64_t nbBytesBefore = client->getNbBytesQueued();
+        uint64_t nbPacketsBefore = client->getNbPacketsQueued();
+        client->flushBatch();
+        nbBytes += client->getNbBytesQueued() - nbBytesBefore;
+        nbPackets += client->getNbPacketsQueued() - nbPacketsBefore;
+        maxBacklogBytes = std::max(maxBacklogBytes, client->getNbBytesBacklog());
+    }
+
+    // Every message using the released strings is now in the clients batches (sent or held in order)
+    // so their ids can be given to the new strings
+    mStringTable.recycleRemovedIds();
+
+    OD_LOG_DBG("Sent turn=" + Helper::toString(gameMap->getTurnNumber())
+        + ", packets=" + Helper::toString(nbPackets) + ", bytes=" + Helper::toString(nbBytes)
+        + ", coalesced=" + Helper::toString(nbCoalesced)
+        + ", maxBacklogBytes=" + Helper::toString(maxBacklogBytes)
+        + ", lateClients=" + Helper::toString(nbLateClients));
 }
 
 bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
@@ -667,6 +815,18 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
                 return false;
             }
 
+            // We compress what we send from now on (the level included) if the client can read it and
+            // if it is worth it (local games do not need it)
+            bool isCompressionSupported;
+            OD_ASSERT_TRUE(packetReceived >> isCompressionSupported);
+            if(isCompressionSupported && (mServerMode == ServerMode::ModeGameMultiPlayer))
+            {
+                ODPacket packetCompression;
+                packetCompression << ServerNotificationType::enableCompression;
+                clientSocket->send(packetCompression);
+                clientSocket->enableCompression();
+            }
+
             // Tell the client to load the given map
             OD_LOG_INF("Level sent to client: " + gameMap->getLevelName());
             clientSocket->setState("loadLevel");
@@ -834,7 +994,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
             clientSocket->send(packetSend);
 
             packetSend.clear();
-            packetSend << ServerNotificationType::startGameMode << seatId << mServerMode;
+            packetSend << ServerNotificationType::startGameMode << seatId << mServerMode << Random::getSessionSeed();
             clientSocket->send(packetSend);
             mSeatsConfigured = true;
             break;
@@ -1108,7 +1268,7 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
 
                 ODPacket packetSend;
                 int seatId = client->getPlayer()->getSeat()->getId();
-                packetSend << ServerNotificationType::startGameMode << seatId << mServerMode;
+                packetSend << ServerNotificationType::startGameMode << seatId << mServerMode << Random::getSessionSeed();
                 client->send(packetSend);
             }
 
@@ -1824,45 +1984,33 @@ bool ODServer::processClientNotifications(ODSocketClient* clientSocket)
     return true;
 }
 
-ODSocketClient* ODServer::notifyNewConnection(sf::TcpListener& sockListener)
+bool ODServer::notifyNewConnection(ODSocketClient* client)
 {
-    ODSocketClient* newClient = new ODSocketClient;
-    sf::Socket::Status status = sockListener.accept(newClient->getSockClient());
-    if (status != sf::Socket::Done)
-    {
-        OD_LOG_ERR("Error while listening to socket status=" + Helper::toString(static_cast<uint32_t>(status)));
-        delete newClient;
-        return nullptr;
-    }
-
     switch(mServerState)
     {
         case ServerState::StateNone:
         {
             // It is not normal to receive new connexions while not connected. We are in an unexpected state
             OD_LOG_ERR("Unexpected none server mode");
-            delete newClient;
-            return nullptr;
+            return false;
         }
         case ServerState::StateConfiguration:
         {
-            newClient->setState("connected");
-            return newClient;
+            client->setState("connected");
+            return true;
         }
         case ServerState::StateGame:
         {
             // TODO : handle re-connexion if a client was disconnected and tries to reconnect
             OD_LOG_WRN("Received a reconnexion from a client while in game state");
-            delete newClient;
-            return nullptr;
+            return false;
         }
         default:
             OD_LOG_ERR("Unexpected server state=" + Helper::toString(static_cast<uint32_t>(mServerState)));
             break;
     }
 
-    delete newClient;
-    return nullptr;
+    return false;
 }
 
 bool ODServer::notifyClientMessage(ODSocketClient *clientSocket)
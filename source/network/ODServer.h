@@ -20,6 +20,7 @@
 
 #include "ODSocketServer.h"
 #include "modes/ConsoleInterface.h"
+#include "network/NetworkStringTable.h"
 
 #include <OgreSingleton.h>
 
@@ -86,6 +87,15 @@ class ODServer: public Ogre::Singleton<ODServer>,
     //! for messages that need to show reactivity (after a player does something like building a room or tried to pickup a creature).
     void sendAsyncMsg(ServerNotification& notif);
 
+    //! \brief Returns the id of the given string in the dictionary shared with the clients. Often sent strings
+    //! (like entity or animation names) should be sent that way. If the string is new, it will be sent to the
+    //! clients before any other message. They can then get it back with ODSocketClient::readInternedString.
+    uint32_t internString(const std::string& str);
+
+    //! \brief To be called when an entity is deleted so that the id of its name can be given to another
+    //! string once the messages queued this turn have been sent
+    void releaseString(const std::string& str);
+
     void notifyExit();
 
     //! This function will block the calling thread until the game is launched and
@@ -96,7 +106,7 @@ class ODServer: public Ogre::Singleton<ODServer>,
     int32_t getNetworkPort() const;
 
 protected:
-    ODSocketClient* notifyNewConnection(sf::TcpListener& sockListener) override;
+    bool notifyNewConnection(ODSocketClient* client) override;
     bool notifyClientMessage(ODSocketClient *sock) override;
     void serverThread() override;
 
@@ -116,6 +126,10 @@ private:
 
     ConsoleInterface mConsoleInterface;
 
+    NetworkStringTable mStringTable;
+    //! \brief Ids of the strings added to mStringTable not sent yet to the clients
+    std::vector<uint32_t> mStringIdsToSend;
+
     std::string mMasterServerGameId;
     double mMasterServerGameStatusUpdateTime;
 
@@ -133,6 +147,8 @@ private:
      * mServerNotificationQueue.  It takes an event out of the queue, determines
      * which clients need to be informed about that particular event, and
      * dispacthes TCP packets to inform the clients about the new information.
+     * The notifications superseded by a later one (see ServerNotification::setCoalescingKey) are
+     * not sent and the others are sent in one batch per client.
      */
     void processServerNotifications();
 
@@ -145,8 +161,18 @@ private:
      */
     bool processClientNotifications(ODSocketClient* clientSocket);
 
-    //! \brief Sends the packet to the given player. If player is nullptr, the packet is sent to every connected player
-    void sendMsg(Player* player, ODPacket& packet);
+    //! \brief Sends the packet to the given player. If player is nullptr, the packet is sent to every connected player.
+    //! If inBatch is true, the packet will be sent with the next ODSocketClient::flushBatch (policy and
+    //! coalescingKey tell how to handle it if the client is late)
+    void sendMsg(Player* player, ODPacket& packet, bool inBatch = false,
+        ODSocketClient::BacklogPolicy policy = ODSocketClient::BacklogPolicy::keep,
+        const std::string& coalescingKey = std::string());
+
+    //! \brief Sends the notification in batch with the backlog policy matching its type
+    void sendNotificationInBatch(ServerNotification* notification);
+
+    //! \brief Sends the strings added by internString since the last call to every client
+    void sendInternedStrings();
 
     void fireSeatConfigurationRefresh();
 
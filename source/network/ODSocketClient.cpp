@@ -25,6 +25,13 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
 
+const uint32_t ODSocketClient::NETWORK_QUEUE_SIZE = 256;
+const uint32_t ODSocketClient::NETWORK_SEND_BUFFER_SIZE = 64 * 1024;
+const uint64_t ODSocketClient::BACKLOG_LATE_BYTES = 128 * 1024;
+const uint64_t ODSocketClient::BACKLOG_MAX_BYTES = 16 * 1024 * 1024;
+const float ODSocketClient::REPLAY_SPEED_MAX = 0.0f;
+const uint32_t ODSocketClient::REPLAY_MAX_TURNS_PER_FRAME = 20;
+
 bool ODSocketClient::connect(const std::string& host, const int port, uint32_t timeout, const std::string& outputReplayFilename)
 {
     mSource = ODSource::none;
@@ -43,7 +50,9 @@ bool ODSocketClient::connect(const std::string& host, const int port, uint32_t t
 
     mOutputReplayFilename = outputReplayFilename;
 
-    mReplayOutputStream.open(mOutputReplayFilename, std::ios::out | std::ios::binary);
+    if(!mReplayWriter.open(mOutputReplayFilename))
+        OD_LOG_WRN("Cannot write replay file " + mOutputReplayFilename);
+
     mGameClock.restart();
     mSource = ODSource::network;
     return true;
@@ -52,7 +61,16 @@ bool ODSocketClient::connect(const std::string& host, const int port, uint32_t t
 bool ODSocketClient::replay(const std::string& filename)
 {
     OD_LOG_INF("Reading replay from file " + filename);
-    mReplayInputStream.open(filename, std::ios::in | std::ios::binary);
+    if(!mReplayReader.open(filename))
+    {
+        OD_LOG_ERR("Cannot read replay file " + filename);
+        return false;
+    }
+
+    mReplaySpeed = 1.0f;
+    mReplayTimeOffset = 0;
+    mReplayTurn = -1;
+    mReplaySeekTurn = -1;
     mGameClock.restart();
     mSource = ODSource::file;
     return true;
@@ -60,7 +78,17 @@ bool ODSocketClient::replay(const std::string& filename)
 
 void ODSocketClient::disconnect(bool keepReplay)
 {
-    mPendingTimestamp = -1;
+    mBatchedPackets.clear();
+    mBatchedKeys.clear();
+    mNbBatchedBytes = 0;
+    mIsBatchHeld = false;
+    mReceivedPacket.clear();
+    mReceivedBatchPackets.clear();
+    mStringTable.clear();
+    mReplayNewStringIds.clear();
+    mIsCompressionEnabled = false;
+    mIsDecompressionEnabled = false;
+    mStreamDecompressor.reset();
     ODSource src = mSource;
     mSource = ODSource::none;
     switch(src)
@@ -80,7 +108,20 @@ void ODSocketClient::disconnect(bool keepReplay)
         }
         case ODSource::file:
         {
-            mReplayInputStream.close();
+            mReplayReader.close();
+            return;
+        }
+        case ODSource::serverNetwork:
+        {
+            // The network thread should not use this client anymore
+            mOutboundOverflow.clear();
+            std::unique_ptr<ODPacket> packet;
+            while(mInboundQueue.pop(packet))
+                packet.reset();
+
+            mStreamCompressor.reset();
+
+            mSockClient.disconnect();
             return;
         }
         default:
@@ -88,7 +129,7 @@ void ODSocketClient::disconnect(bool keepReplay)
             break;
     }
 
-    mReplayOutputStream.close();
+    mReplayWriter.close();
     // Delete the replay newly created if asked to.
     if (!keepReplay)
         boost::filesystem::remove(mOutputReplayFilename);
@@ -113,20 +154,24 @@ bool ODSocketClient::isDataAvailable()
         }
         case ODSource::file:
         {
-            if(mReplayInputStream.eof())
+            // The record is only read by recv
+            int32_t timestamp = mReplayReader.peekTimestamp();
+            if(timestamp < 0)
                 return false;
 
-            if(mPendingTimestamp == -1)
-                mPendingTimestamp = mPendingPacket.readPacket(mReplayInputStream);
+            if(isReplayFastForward())
+                return mNbReplayTurnsInFrame < REPLAY_MAX_TURNS_PER_FRAME;
 
-            if(mPendingTimestamp < 0)
-                return false;
-
-            if(mPendingTimestamp < mGameClock.getElapsedTime().asMilliseconds())
+            if(timestamp < getGameTimeMillis())
                 return true;
 
             return false;
         }
+        case ODSource::serverNetwork:
+        {
+            // If the socket is closed, recv will report the error
+            return !mInboundQueue.empty() || mIsSocketClosed.load() || mIsDisconnectRequested;
+        }
         default:
             assert(false);
             break;
@@ -137,12 +182,47 @@ bool ODSocketClient::isDataAvailable()
 
 ODSocketClient::ODComStatus ODSocketClient::send(ODPacket& s)
 {
+    if(mSource == ODSource::serverNetwork)
+    {
+        if(!checkBacklog(s.getDataSize()))
+            return ODComStatus::Error;
+
+        // The held batch contains older messages. The packet is sent after them
+        if(mIsBatchHeld)
+        {
+            sendInBatch(s);
+            return ODComStatus::OK;
+        }
+
+        ++mNbPacketsQueued;
+        mNbBytesQueued += s.getDataSize();
+        OutboundPacket packet;
+        packet.mPacket.reset(new ODPacket(s));
+        packet.mPacket->makeOwned();
+        packet.mIsCompressed = mIsCompressionEnabled;
+        // We keep the order if some packets are already waiting
+        flushOutboundOverflow();
+        if(!mOutboundOverflow.empty() || !mOutboundQueue.push(packet))
+            mOutboundOverflow.push_back(std::move(packet));
+
+        if(mIsSocketClosed.load())
+            return ODComStatus::Error;
+
+        return ODComStatus::OK;
+    }
+
     if(mSource != ODSource::network)
         return ODComStatus::OK;
 
-    sf::Socket::Status status = mSockClient.send(s.mPacket);
+    ++mNbPacketsQueued;
+    mNbBytesQueued += s.getDataSize();
+    sf::Socket::Status status = mSockClient.send(s.makeOwned());
     if (status == sf::Socket::Done)
+    {
+        mNbPacketsSent.fetch_add(1, std::memory_order_relaxed);
+        mNbBytesSent.fetch_add(s.getDataSize(), std::memory_order_relaxed);
         return ODComStatus::OK;
+    }
 
     OD_LOG_ERR("Could not send data from client status="
         + Helper::toString(status));
@@ -161,11 +241,29 @@ ODSocketClient::ODComStatus ODSocketClient::recv(ODPacket& s)
         }
         case ODSource::network:
         {
+            s.clear();
             sf::Socket::Status status = mSockClient.receive(s.mPacket);
             if (status == sf::Socket::Done)
             {
-                s.writePacket(mGameClock.getElapsedTime().asMilliseconds(),
-                    mReplayOutputStream);
+                ++mNbPacketsReceived;
+                mNbBytesReceived += s.getDataSize();
+                if(mIsDecompressionEnabled)
+                {
+                    const char* data;
+                    uint32_t size;
+                    if(!mStreamDecompressor.decompress(s.getData(), s.getDataSize(), data, size))
+                    {
+                        OD_LOG_ERR("Could not decompress packet size=" + Helper::toString(s.getDataSize()));
+                        return ODComStatus::Error;
+                    }
+                    // The decompressed data stay in the decompressor until the next packet
+                    s.setView(data, size);
+                }
+                int32_t timestamp = mGameClock.getElapsedTime().asMilliseconds();
+                if(mReplayWriter.isKeyframePending())
+                    writeReplayKeyframe(timestamp);
+
+                mReplayWriter.writePacket(timestamp, s);
                 return ODComStatus::OK;
             }
 
@@ -185,17 +283,251 @@ ODSocketClient::ODComStatus ODSocketClient::recv(ODPacket& s)
         }
         case ODSource::file:
         {
-            OD_ASSERT_TRUE(mPendingPacket != 0);
-            s = mPendingPacket;
-            mPendingTimestamp = -1;
+            const char* data;
+            uint32_t size;
+            int32_t timestamp = mReplayReader.readRecord(data, size);
+            if(timestamp < 0)
+            {
+                OD_LOG_ERR("Could not read replay record");
+                return ODComStatus::Error;
+            }
+            s.setView(data, size);
+
+            // When going fast, the replay time follows the packets so that it is right when the
+            // normal speed is restored
+            if(isReplayFastForward())
+            {
+                mReplayTimeOffset = timestamp;
+                mGameClock.restart();
+            }
             return ODComStatus::OK;
         }
+        case ODSource::serverNetwork:
+        {
+            if(mIsDisconnectRequested)
+                return ODComStatus::Error;
+
+            std::unique_ptr<ODPacket> packet;
+            if(mInboundQueue.pop(packet))
+            {
+                ++mNbPacketsReceived;
+                mNbBytesReceived += packet->getDataSize();
+                s = *packet;
+                return ODComStatus::OK;
+            }
+
+            if(mIsSocketClosed.load())
+                return ODComStatus::Error;
+
+            return ODComStatus::NotReady;
+        }
         default:
             break;
     }
     return ODComStatus::Error;
 }
 
+void ODSocketClient::flushOutboundOverflow()
+{
+    while(!mOutboundOverflow.empty() && mOutboundQueue.push(mOutboundOverflow.front()))
+        mOutboundOverflow.pop_front();
+}
+
+bool ODSocketClient::checkBacklog(uint64_t extraBytes)
+{
+    if(mIsDisconnectRequested)
+        return false;
+
+    if(getNbBytesBacklog() + mNbBatchedBytes + extraBytes <= BACKLOG_MAX_BYTES)
+        return true;
+
+    OD_LOG_WRN("Disconnecting client too slow, backlog=" + Helper::toString(getNbBytesBacklog())
+        + ", held=" + Helper::toString(mNbBatchedBytes));
+    mIsDisconnectRequested = true;
+    return false;
+}
+
+bool ODSocketClient::isLate() const
+{
+    if(mSource != ODSource::serverNetwork)
+        return false;
+
+    return getNbBytesBacklog() > BACKLOG_LATE_BYTES;
+}
+
+bool ODSocketClient::networkThreadSend()
+{
+    // We fill the buffer with the queued packets while there is room
+    OutboundPacket packet;
+    std::vector<char> compressed;
+    while((mSendBuffer.size() - mSendBufferPos < NETWORK_SEND_BUFFER_SIZE) && mOutboundQueue.pop(packet))
+    {
+        uint32_t packetSize = packet.mPacket->getDataSize();
+        const char* data = packet.mPacket->getData();
+        uint32_t size = packetSize;
+        if(packet.mIsCompressed)
+        {
+            compressed.clear();
+            mStreamCompressor.compress(data, packetSize, compressed);
+            data = compressed.data();
+            size = static_cast<uint32_t>(compressed.size());
+        }
+
+        // Same format as sf::TcpSocket::send(sf::Packet&): size in network byte order, then the data
+        mSendBuffer.push_back(static_cast<char>((size >> 24) & 0xFF));
+        mSendBuffer.push_back(static_cast<char>((size >> 16) & 0xFF));
+        mSendBuffer.push_back(static_cast<char>((size >> 8) & 0xFF));
+        mSendBuffer.push_back(static_cast<char>(size & 0xFF));
+        mSendBuffer.insert(mSendBuffer.end(), data, data + size);
+
+        // The backlog is counted in uncompressed bytes like mNbBytesQueued
+        mNbPacketsSent.fetch_add(1, std::memory_order_relaxed);
+        mNbBytesSent.fetch_add(packetSize, std::memory_order_relaxed);
+    }
+
+    if(mSendBufferPos >= mSendBuffer.size())
+        return true;
+
+    // The socket is not blocking. We write what it accepts and keep the rest for later
+    std::size_t sent = 0;
+    sf::Socket::Status status = mSockClient.send(mSendBuffer.data() + mSendBufferPos,
+        mSendBuffer.size() - mSendBufferPos, sent);
+    mSendBufferPos += sent;
+    if(mSendBufferPos >= mSendBuffer.size())
+    {
+        mSendBuffer.clear();
+        mSendBufferPos = 0;
+    }
+    else if(mSendBufferPos >= NETWORK_SEND_BUFFER_SIZE)
+    {
+        mSendBuffer.erase(mSendBuffer.begin(), mSendBuffer.begin() + mSendBufferPos);
+        mSendBufferPos = 0;
+    }
+
+    switch(status)
+    {
+        case sf::Socket::Done:
+        case sf::Socket::Partial:
+        case sf::Socket::NotReady:
+            return true;
+        case sf::Socket::Disconnected:
+            OD_LOG_WRN("Socket disconnected");
+            return false;
+        default:
+            OD_LOG_ERR("Could not send data to client status=" + Helper::toString(status));
+            return false;
+    }
+}
+
+bool ODSocketClient::networkThreadReceive()
+{
+    std::unique_ptr<ODPacket> packet(new ODPacket);
+    sf::Socket::Status status = mSockClient.receive(packet->mPacket);
+    if(status == sf::Socket::Done)
+    {
+        // The network thread only reads the socket when there is room in the queue
+        OD_ASSERT_TRUE(mInboundQueue.push(packet));
+        return true;
+    }
+
+    // The socket is not blocking and sf::TcpSocket keeps what has been received of an incomplete packet
+    if((status == sf::Socket::NotReady) || (status == sf::Socket::Partial))
+        return true;
+
+    if(status == sf::Socket::Disconnected)
+    {
+        OD_LOG_WRN("Socket disconnected");
+        return false;
+    }
+
+    OD_LOG_ERR("Could not receive data from client status=" + Helper::toString(status));
+    return false;
+}
+
+void ODSocketClient::sendInBatch(const ODPacket& s, BacklogPolicy policy, const std::string& coalescingKey)
+{
+    bool isLateClient = isLate();
+    if(isLateClient && (policy == BacklogPolicy::drop))
+    {
+        ++mNbPacketsDropped;
+        return;
+    }
+
+    if((policy == BacklogPolicy::collapse) && !coalescingKey.empty())
+    {
+        std::map<std::string, uint32_t>::iterator it = mBatchedKeys.find(coalescingKey);
+        if(it != mBatchedKeys.end())
+        {
+            // The previous packet is superseded. We keep the order of the messages by sending the new one last
+            BatchedPacket& previous = mBatchedPackets[it->second];
+            mNbBatchedBytes -= previous.mPacket.getDataSize();
+            previous.mPacket.clear();
+            previous.mIsCollapsed = true;
+            ++mNbPacketsCollapsed;
+        }
+        mBatchedKeys[coalescingKey] = static_cast<uint32_t>(mBatchedPackets.size());
+    }
+
+    mBatchedPackets.emplace_back();
+    BatchedPacket& batched = mBatchedPackets.back();
+    batched.mPacket = s;
+    batched.mPacket.makeOwned();
+    batched.mIsCollapsed = false;
+    mNbBatchedBytes += s.getDataSize();
+}
+
+ODSocketClient::ODComStatus ODSocketClient::flushBatch(bool force)
+{
+    if(mBatchedPackets.empty())
+        return ODComStatus::OK;
+
+    if(mSource == ODSource::serverNetwork)
+    {
+        if(!checkBacklog(0))
+            return ODComStatus::Error;
+
+        // We hold the batch until the client has read enough. Messages that can be collapsed will
+        // be replaced by the newer ones in the meantime
+        if(!force && isLate())
+        {
+            mIsBatchHeld = true;
+            return ODComStatus::OK;
+        }
+    }
+
+    ODPacket batchPacket;
+    batchPacket << ServerNotificationType::turnBatch;
+    for(const BatchedPacket& batched : mBatchedPackets)
+    {
+        if(batched.mIsCollapsed)
+            continue;
+
+        batchPacket.writeSubPacket(batched.mPacket);
+    }
+    mBatchedPackets.clear();
+    mBatchedKeys.clear();
+    mNbBatchedBytes = 0;
+    mIsBatchHeld = false;
+    return send(batchPacket);
+}
+
+bool ODSocketClient::readInternedString(ODPacket& packet, std::string& str) const
+{
+    uint32_t id;
+    if(!(packet >> id))
+        return false;
+
+    const std::string* internedStr = mStringTable.getString(id);
+    if(internedStr == nullptr)
+    {
+        OD_LOG_ERR("Unknown string id=" + Helper::toString(id));
+        return false;
+    }
+
+    str = *internedStr;
+    return true;
+}
+
 bool ODSocketClient::isConnected()
 {
     return mSource != ODSource::none;
@@ -206,26 +538,156 @@ void ODSocketClient::processClientSocketMessages()
     // If we receive message for a new turn, after processing every message,
     // we will refresh what is needed
     // We loop until no more data is available
+    mNbReplayTurnsInFrame = 0;
     while(isConnected() && processOneClientSocketMessage());
 }
 
 bool ODSocketClient::processOneClientSocketMessage()
 {
-    if(!isDataAvailable())
-        return false;
-
     ODPacket packetReceived;
-
-    // Check if data available
-    ODComStatus comStatus = recv(packetReceived);
-    if(comStatus != ODComStatus::OK)
+    if(!mReceivedBatchPackets.empty())
     {
-        playerDisconnected();
-        return false;
+        packetReceived = mReceivedBatchPackets.front();
+        mReceivedBatchPackets.pop_front();
+    }
+    else
+    {
+        if(!isDataAvailable())
+            return false;
+
+        // Check if data available
+        ODComStatus comStatus = recv(mReceivedPacket);
+        if(comStatus != ODComStatus::OK)
+        {
+            playerDisconnected();
+            return false;
+        }
+
+        // mReceivedPacket is kept until the next packet is received so that the packets of a
+        // batch can be read without copying them
+        packetReceived.setView(mReceivedPacket.getData(), mReceivedPacket.getDataSize());
     }
 
     ServerNotificationType serverCommand;
     OD_ASSERT_TRUE(packetReceived >> serverCommand);
 
+    if(serverCommand == ServerNotificationType::turnBatch)
+    {
+        // We process the batched packets one by one as if they had been received separately. That
+        // way, processMessage can still stop the processing after any of them
+        uint32_t nbBatchBytes = packetReceived.getDataSize();
+        mReceivedBatchPackets.emplace_back();
+        while(packetReceived.readSubPacket(mReceivedBatchPackets.back()))
+        {
+            nbBatchBytes -= mReceivedBatchPackets.back().getDataSize();
+            mReceivedBatchPackets.emplace_back();
+        }
+
+        mReceivedBatchPackets.pop_back();
+        messageReceived(serverCommand, nbBatchBytes);
+        return true;
+    }
+
+    messageReceived(serverCommand, packetReceived.getDataSize());
+
+    if(serverCommand == ServerNotificationType::turnStarted)
+    {
+        // The view is copied so that processMessage can read the turn as well
+        ODPacket turnPacket(packetReceived);
+        int64_t turnNum;
+        if(turnPacket >> turnNum)
+            replayTurnStarted(turnNum);
+    }
+
+    if(serverCommand == ServerNotificationType::internStrings)
+    {
+        uint32_t nbStrings;
+        OD_ASSERT_TRUE(packetReceived >> nbStrings);
+        while(nbStrings > 0)
+        {
+            --nbStrings;
+            uint32_t id;
+            std::string str;
+            OD_ASSERT_TRUE(packetReceived >> id >> str);
+            OD_ASSERT_TRUE_MSG(mStringTable.setString(id, str), "id=" + Helper::toString(id) + ", str=" + str);
+            if(mReplayWriter.isOpen())
+                mReplayNewStringIds.push_back(id);
+        }
+        return true;
+    }
+
     return processMessage(serverCommand, packetReceived);
 }
+
+int32_t ODSocketClient::getGameTimeMillis() const
+{
+    if(mSource != ODSource::file)
+        return mGameClock.getElapsedTime().asMilliseconds();
+
+    if(isReplayFastForward())
+        return mReplayTimeOffset;
+
+    return mReplayTimeOffset + static_cast<int32_t>(mGameClock.getElapsedTime().asMilliseconds() * mReplaySpeed);
+}
+
+void ODSocketClient::setReplaySpeed(float speed)
+{
+    if(speed < 0.0f)
+        return;
+
+    mReplayTimeOffset = getGameTimeMillis();
+    mGameClock.restart();
+    mReplaySpeed = speed;
+}
+
+bool ODSocketClient::seekReplay(int64_t turn)
+{
+    if(mSource != ODSource::file)
+        return false;
+
+    // The keyframes do not contain the game state so it cannot be restored as it was before
+    if(turn <= mReplayTurn)
+        return false;
+
+    mReplaySeekTurn = turn;
+    return true;
+}
+
+void ODSocketClient::replayTurnStarted(int64_t turn)
+{
+    switch(mSource)
+    {
+        case ODSource::network:
+        {
+            mReplayWriter.turnStarted(turn);
+            break;
+        }
+        case ODSource::file:
+        {
+            mReplayTurn = turn;
+            ++mNbReplayTurnsInFrame;
+            if((mReplaySeekTurn >= 0) && (turn >= mReplaySeekTurn))
+            {
+                mReplaySeekTurn = -1;
+                mGameClock.restart();
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void ODSocketClient::writeReplayKeyframe(int32_t timestamp)
+{
+    // The strings are also in the internStrings messages recorded since the previous keyframe. They
+    // are written again so that the keyframe tells which strings were added during the last turns
+    ODPacket packet;
+    uint32_t nbStrings = mReplayNewStringIds.size();
+    packet << ServerNotificationType::internStrings << nbStrings;
+    for(uint32_t id : mReplayNewStringIds)
+        packet << id << *mStringTable.getString(id);
+
+    mReplayNewStringIds.clear();
+    mReplayWriter.writeKeyframe(timestamp, packet);
+}
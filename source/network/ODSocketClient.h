@@ -18,13 +18,22 @@
 #ifndef ODSOCKETCLIENT_H
 #define ODSOCKETCLIENT_H
 
+#include "network/NetworkStringTable.h"
 #include "network/ODPacket.h"
+#include "network/ReplayFile.h"
+#include "network/StreamCompression.h"
+#include "utils/SpscQueue.h"
 
 #include <SFML/Network.hpp>
 
+#include <atomic>
 #include <string>
 #include <cstdint>
+#include <deque>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
 
 class Player;
 
@@ -32,6 +41,8 @@ enum class ServerNotificationType;
 
 class ODSocketClient
 {
+    friend class ODSocketServer;
+
     public:
         enum ODComStatus
         {
@@ -42,14 +53,68 @@ class ODSocketClient
         {
             none,
             network,
-            file
+            file,
+            //! Client connected to the server. The socket is read and written by the server
+            //! network thread (see ODSocketServer) through lock free queues
+            serverNetwork
         };
 
+        //! \brief How a message sent in batch is handled when the client does not read fast enough
+        enum class BacklogPolicy
+        {
+            keep,       //!< Always sent
+            collapse,   //!< While the batch is held, only the last message with the same key is sent
+            drop        //!< Cosmetic message (like sounds) not sent while the client is late
+        };
+
+        //! \brief Size of the queues between the server network thread and the simulation
+        static const uint32_t NETWORK_QUEUE_SIZE;
+
+        //! \brief Maximum number of bytes buffered by the network thread for 1 client. Packets
+        //! stay in the queues while the buffer is full
+        static const uint32_t NETWORK_SEND_BUFFER_SIZE;
+
+        //! \brief When more bytes than that are waiting to be written to the socket, the client is
+        //! late: batches are held instead of being sent and cosmetic messages are dropped
+        static const uint64_t BACKLOG_LATE_BYTES;
+
+        //! \brief When more bytes than that are waiting (including the held batch), the client is
+        //! disconnected
+        static const uint64_t BACKLOG_MAX_BYTES;
+
+        //! \brief Replay speed to play the replay as fast as possible
+        static const float REPLAY_SPEED_MAX;
+
+        //! \brief When playing a replay as fast as possible (or seeking), maximum number of turns
+        //! processed at each call to processClientSocketMessages
+        static const uint32_t REPLAY_MAX_TURNS_PER_FRAME;
+
         ODSocketClient():
             mSource(ODSource::none),
             mPlayer(nullptr),
             mLastTurnAck(-1),
-            mPendingTimestamp(-1)
+            mReplaySpeed(1.0f),
+            mReplayTimeOffset(0),
+            mReplayTurn(-1),
+            mReplaySeekTurn(-1),
+            mNbReplayTurnsInFrame(0),
+            mNbBatchedBytes(0),
+            mIsBatchHeld(false),
+            mOutboundQueue(NETWORK_QUEUE_SIZE),
+            mInboundQueue(NETWORK_QUEUE_SIZE),
+            mIsSocketClosed(false),
+            mIsDisconnectRequested(false),
+            mSendBufferPos(0),
+            mIsCompressionEnabled(false),
+            mIsDecompressionEnabled(false),
+            mNbPacketsDropped(0),
+            mNbPacketsCollapsed(0),
+            mNbPacketsQueued(0),
+            mNbBytesQueued(0),
+            mNbPacketsSent(0),
+            mNbBytesSent(0),
+            mNbPacketsReceived(0),
+            mNbBytesReceived(0)
         {}
 
         virtual ~ODSocketClient()
@@ -71,8 +136,33 @@ class ODSocketClient
         void setLastTurnAck(int64_t lastTurnAck) { mLastTurnAck = lastTurnAck; }
         const std::string& getState() {return mState;}
         bool isDataAvailable();
-        int32_t getGameTimeMillis()
-        { return mGameClock.getElapsedTime().asMilliseconds(); }
+
+        //! \brief Time since the connection. When playing a replay, time in the replay
+        int32_t getGameTimeMillis() const;
+
+        inline bool isReplaying() const
+        { return mSource == ODSource::file; }
+
+        //! \brief Sets the replay playback speed (2 plays twice as fast). REPLAY_SPEED_MAX plays
+        //! the replay as fast as possible
+        void setReplaySpeed(float speed);
+
+        inline float getReplaySpeed() const
+        { return mReplaySpeed; }
+
+        //! \brief Last turn started in the replay
+        inline int64_t getReplayTurn() const
+        { return mReplayTurn; }
+
+        //! \brief True when every message of the replay has been processed
+        inline bool isReplayEnded() const
+        { return isReplaying() && mReceivedBatchPackets.empty() && (mReplayReader.peekTimestamp() < 0); }
+
+        /*! \brief Plays the replay as fast as possible until the given turn is reached. Keyframes do not
+         * contain the game state so the replay cannot go back: returns false if not playing a replay or
+         * if the turn is not after the current one.
+         */
+        bool seekReplay(int64_t turn);
 
         void setState(const std::string& state) {mState = state;}
 
@@ -87,6 +177,9 @@ class ODSocketClient
          * ODPacket should preserve integrity. That means that if an ODSocketClient
          * sends an ODPacket, the server should receive exactly 1 similar ODPacket (same data,
          * nothing less, nothing more). It is up to ODSocketClient to do so.
+         * For serverNetwork clients, the packet is only queued for the network thread so this
+         * never blocks. If a batch is held because the client is late, the packet is added to it
+         * so that it is not received before the messages sent previously.
          */
         ODComStatus send(ODPacket& s);
 
@@ -94,9 +187,70 @@ class ODSocketClient
          * ODPacket should preserve integrity. That means that if an ODSocketClient
          * sends an ODPacket, the server should receive exactly 1 similar ODPacket (same data,
          * nothing less, nothing more). It is up to ODSocketClient to do so.
+         * Replay records and decompressed packets are not copied: the packet is a view (see
+         * ODPacket::setView) that stays valid until the next call to recv.
          */
         ODComStatus recv(ODPacket& s);
 
+        /*! \brief Adds the packet to the batch that will be sent by flushBatch. On reception, the
+         * packets in the batch are processed one by one in the same order as if they had been sent
+         * separately. That allows to send all the messages of a turn at once.
+         * If the client is late, the packet may be dropped or replace a packet with the same
+         * coalescingKey depending on policy.
+         */
+        void sendInBatch(const ODPacket& s, BacklogPolicy policy = BacklogPolicy::keep,
+            const std::string& coalescingKey = std::string());
+
+        /*! \brief Sends the packets added by sendInBatch since the last call, if any. For serverNetwork
+         * clients, if the client is late, the batch is held and will be sent by a next call unless
+         * force is true (when nothing will be sent after). If the backlog is too big, the client will
+         * be disconnected and Error is returned.
+         */
+        ODComStatus flushBatch(bool force = false);
+
+        //! \brief Returns true if the client does not read fast enough what is sent
+        bool isLate() const;
+
+        //! \brief The packets sent after this call are compressed (serverNetwork clients only). The
+        //! client should call enableDecompression when it receives the last uncompressed packet
+        inline void enableCompression()
+        { mIsCompressionEnabled = true; }
+
+        //! \brief Statistics about the packets sent/received through the network. Batches count as 1 packet.
+        //! Packets queued by send are counted as sent once the network thread has moved them to its
+        //! send buffer (which is bounded by NETWORK_SEND_BUFFER_SIZE)
+        inline uint64_t getNbPacketsQueued() const
+        { return mNbPacketsQueued; }
+
+        inline uint64_t getNbBytesQueued() const
+        { return mNbBytesQueued; }
+
+        inline uint64_t getNbPacketsSent() const
+        { return mNbPacketsSent.load(std::memory_order_relaxed); }
+
+        inline uint64_t getNbBytesSent() const
+        { return mNbBytesSent.load(std::memory_order_relaxed); }
+
+        //! \brief Packets/bytes queued by send but not written to the socket yet
+        inline uint64_t getNbPacketsBacklog() const
+        { return mNbPacketsQueued - getNbPacketsSent(); }
+
+        inline uint64_t getNbBytesBacklog() const
+        { return mNbBytesQueued - getNbBytesSent(); }
+
+        //! \brief Messages not sent because the client was late
+        inline uint64_t getNbPacketsDropped() const
+        { return mNbPacketsDropped; }
+
+        inline uint64_t getNbPacketsCollapsed() const
+        { return mNbPacketsCollapsed; }
+
+        inline uint64_t getNbPacketsReceived() const
+        { return mNbPacketsReceived; }
+
+        inline uint64_t getNbBytesReceived() const
+        { return mNbBytesReceived; }
+
     protected:
         virtual bool connect(const std::string& host, const int port, uint32_t timeout, const std::string& outputReplayFilename);
         virtual bool replay(const std::string& filename);
@@ -105,12 +259,51 @@ class ODSocketClient
 
         virtual bool processMessage(ServerNotificationType cmd, ODPacket& packetReceived)
         { return false; }
+
+        /*! \brief Called for each message read, before it is handled. That includes the messages handled
+         * by ODSocketClient itself (turnBatch and internStrings). For a turnBatch, nbBytes only counts
+         * the bytes that are not part of the batched messages as they are given afterwards, one by one.
+         */
+        virtual void messageReceived(ServerNotificationType cmd, uint32_t nbBytes)
+        {}
+
+        /*! \brief Reads a string id sent by the server (see ODServer::internString) and sets str to
+         * the matching string. Returns false if the id cannot be read or is unknown.
+         */
+        bool readInternedString(ODPacket& packet, std::string& str) const;
+
+        //! \brief The packets received from the network after this call will be decompressed
+        inline void enableDecompression()
+        { mIsDecompressionEnabled = true; }
         virtual void playerDisconnected()
         {}
 
     private :
         bool processOneClientSocketMessage();
 
+        //! \brief Moves the packets waiting in mOutboundOverflow to mOutboundQueue while there is room
+        void flushOutboundOverflow();
+
+        //! \brief Disconnects the client if the backlog (plus extraBytes) is too big. Returns false in this case
+        bool checkBacklog(uint64_t extraBytes);
+
+        //! \brief Called from the server network thread. Writes as much as the socket accepts without
+        //! blocking from the queued packets. Returns false if the socket is in error
+        bool networkThreadSend();
+
+        //! \brief Called from the server network thread when the socket is ready. Returns false if the
+        //! socket is in error
+        bool networkThreadReceive();
+
+        //! \brief Called for each turnStarted received to record or seek the replay
+        void replayTurnStarted(int64_t turn);
+
+        //! \brief Writes a keyframe with the strings received since the previous one in the replay being recorded
+        void writeReplayKeyframe(int32_t timestamp);
+
+        inline bool isReplayFastForward() const
+        { return (mReplaySpeed == REPLAY_SPEED_MAX) || (mReplaySeekTurn >= 0); }
+
         ODSource mSource;
         sf::SocketSelector mSockSelector;
         sf::TcpSocket mSockClient;
@@ -119,10 +312,90 @@ class ODSocketClient
         std::string mState;
 
         sf::Clock mGameClock;
-        std::ifstream mReplayInputStream;
-        std::ofstream mReplayOutputStream;
-        ODPacket mPendingPacket;
-        int32_t mPendingTimestamp;
+        ReplayReader mReplayReader;
+        ReplayWriter mReplayWriter;
+
+        float mReplaySpeed;
+        //! \brief Replay time when mGameClock was restarted
+        int32_t mReplayTimeOffset;
+        int64_t mReplayTurn;
+        //! \brief Turn to reach when seeking. -1 if not seeking
+        int64_t mReplaySeekTurn;
+        uint32_t mNbReplayTurnsInFrame;
+
+        struct BatchedPacket
+        {
+            ODPacket mPacket;
+            //! \brief True if the packet has been replaced by a newer one with the same key
+            bool mIsCollapsed;
+        };
+
+        //! \brief Batch being filled by sendInBatch (and held while the client is late)
+        std::vector<BatchedPacket> mBatchedPackets;
+        //! \brief Index in mBatchedPackets of the last packet with a given key
+        std::map<std::string, uint32_t> mBatchedKeys;
+        uint64_t mNbBatchedBytes;
+        //! \brief True if flushBatch did not send the batch because the client is late
+        bool mIsBatchHeld;
+
+        //! \brief Last packet received. The packets of a batch are views on it
+        ODPacket mReceivedPacket;
+
+        //! \brief Packets from a received batch not processed yet
+        std::deque<ODPacket> mReceivedBatchPackets;
+
+        struct OutboundPacket
+        {
+            OutboundPacket() :
+                mIsCompressed(false)
+            {}
+
+            std::unique_ptr<ODPacket> mPacket;
+            //! \brief If true, the network thread compresses the packet before writing it
+            bool mIsCompressed;
+        };
+
+        //! \brief serverNetwork clients only. Packets sent by the simulation to be written by the network
+        //! thread. When the queue is full, packets wait in mOutboundOverflow (simulation side)
+        SpscQueue<OutboundPacket> mOutboundQueue;
+        std::deque<OutboundPacket> mOutboundOverflow;
+
+        //! \brief serverNetwork clients only. Packets read by the network thread to be processed by the simulation
+        SpscQueue<std::unique_ptr<ODPacket>> mInboundQueue;
+
+        //! \brief Set by the network thread when the socket is disconnected or in error
+        std::atomic<bool> mIsSocketClosed;
+
+        //! \brief Set by the server thread when the client is too late
+        bool mIsDisconnectRequested;
+
+        //! \brief Network thread only. Packets to write to the socket (with the size prefix sf::Packet
+        //! uses) and how much of it has already been written
+        std::vector<char> mSendBuffer;
+        std::size_t mSendBufferPos;
+
+        bool mIsCompressionEnabled;
+        bool mIsDecompressionEnabled;
+        //! \brief Used by the network thread for the packets sent to the client
+        StreamCompressor mStreamCompressor;
+        //! \brief Used for the packets received from the server
+        StreamDecompressor mStreamDecompressor;
+
+        uint64_t mNbPacketsDropped;
+        uint64_t mNbPacketsCollapsed;
+
+        //! \brief Strings received from the server
+        NetworkStringTable mStringTable;
+        //! \brief Ids of the strings received since the last keyframe of the replay being recorded
+        std::vector<uint32_t> mReplayNewStringIds;
+
+        uint64_t mNbPacketsQueued;
+        uint64_t mNbBytesQueued;
+        //! \brief Written by the network thread for serverNetwork clients
+        std::atomic<uint64_t> mNbPacketsSent;
+        std::atomic<uint64_t> mNbBytesSent;
+        uint64_t mNbPacketsReceived;
+        uint64_t mNbBytesReceived;
 
         //! \brief the replay filename being written. Used to later optionally delete it
         //! if asked to.
@@ -24,8 +24,19 @@
 
 #include <SFML/System.hpp>
 
+#include <algorithm>
+
+//! \brief Maximum time the network thread waits for incoming data before writing the queued packets
+const int32_t NETWORK_THREAD_WAIT_MS = 1;
+//! \brief Size of the queues used to add/remove clients
+const uint32_t NETWORK_MESSAGES_QUEUE_SIZE = 64;
+
 ODSocketServer::ODSocketServer():
     mThread(nullptr),
+    mNetworkCommands(NETWORK_MESSAGES_QUEUE_SIZE),
+    mNetworkEvents(NETWORK_MESSAGES_QUEUE_SIZE),
+    mNetworkThread(nullptr),
+    mIsNetworkThreadRunning(false),
     mIsConnected(false)
 {
 }
@@ -52,6 +63,9 @@ bool ODSocketServer::createServer(int listeningPort)
     mSockSelector.add(mSockListener);
     mIsConnected = true;
     OD_LOG_INF("Server connected and listening");
+    mIsNetworkThreadRunning = true;
+    mNetworkThread = new sf::Thread(&ODSocketServer::networkThread, this);
+    mNetworkThread->launch();
     mThread = new sf::Thread(&ODSocketServer::serverThread, this);
     mThread->launch();
 
@@ -63,64 +77,232 @@ bool ODSocketServer::isConnected()
     return mIsConnected;
 }
 
+void ODSocketServer::pushNetworkCommand(NetworkMessageType type, ODSocketClient* client)
+{
+    mPendingNetworkCommands.push_back(NetworkMessage(type, client));
+    while(!mPendingNetworkCommands.empty() && mNetworkCommands.push(mPendingNetworkCommands.front()))
+        mPendingNetworkCommands.pop_front();
+}
+
+void ODSocketServer::pushNetworkEvent(NetworkMessageType type, ODSocketClient* client)
+{
+    mPendingNetworkEvents.push_back(NetworkMessage(type, client));
+    while(!mPendingNetworkEvents.empty() && mNetworkEvents.push(mPendingNetworkEvents.front()))
+        mPendingNetworkEvents.pop_front();
+}
+
 void ODSocketServer::doTask(int timeoutMs)
 {
     mClockMainTask.restart();
     while((timeoutMs == 0) ||
           (timeoutMs > mClockMainTask.getElapsedTime().asMilliseconds()))
     {
-        bool isSockReady;
-        if(timeoutMs != 0)
+        bool hasWorked = false;
+
+        // Commands that could not be sent to the network thread
+        while(!mPendingNetworkCommands.empty() && mNetworkCommands.push(mPendingNetworkCommands.front()))
+            mPendingNetworkCommands.pop_front();
+
+        NetworkMessage event;
+        while(mNetworkEvents.pop(event))
         {
-            // We adapt the timeout so that the function returns after timeoutMs
-            // even if events occurred
-            int timeoutMsAdjusted = std::max(1, timeoutMs - mClockMainTask.getElapsedTime().asMilliseconds());
-            isSockReady = mSockSelector.wait(sf::milliseconds(timeoutMsAdjusted));
+            hasWorked = true;
+            ODSocketClient* client = event.mClient;
+            switch(event.mType)
+            {
+                case NetworkMessageType::newClient:
+                {
+                    if(!notifyNewConnection(client))
+                    {
+                        // The network thread will release it
+                        pushNetworkCommand(NetworkMessageType::removeClient, client);
+                        break;
+                    }
+
+                    OD_LOG_INF("New client connected.");
+                    mSockClients.push_back(client);
+                    pushNetworkCommand(NetworkMessageType::addClient, client);
+                    break;
+                }
+                case NetworkMessageType::clientReleased:
+                {
+                    client->disconnect();
+                    delete client;
+                    break;
+                }
+                default:
+                    OD_LOG_ERR("Unexpected network event=" + Helper::toString(static_cast<uint32_t>(event.mType)));
+                    break;
+            }
         }
-        else
+
+        for(std::vector<ODSocketClient*>::iterator it = mSockClients.begin(); it != mSockClients.end();)
         {
-            isSockReady = mSockSelector.wait(sf::Time::Zero);
-        }
+            ODSocketClient* client = *it;
+            client->flushOutboundOverflow();
+            bool isRemoved = false;
+            while(client->isDataAvailable())
+            {
+                hasWorked = true;
+                if(notifyClientMessage(client))
+                    continue;
 
-        // Check if a client tries to connect or to communicate
-        if(!isSockReady)
-            continue;
+                // The server wants to remove the client. It will be deleted once released by the network thread
+                isRemoved = true;
+                break;
+            }
 
-        if(mSockSelector.isReady(mSockListener))
-        {
-            // New connection
-            ODSocketClient* newClient = notifyNewConnection(mSockListener);
-            if (newClient != nullptr)
+            if(!isRemoved)
             {
-                // New connection
-                OD_LOG_INF("New client connected.");
-                // The server wants to keep the client
-                newClient->setSource(ODSocketClient::ODSource::network);
-                mSockSelector.add(newClient->getSockClient());
-                mSockClients.push_back(newClient);
+                ++it;
+                continue;
             }
+
+            it = mSockClients.erase(it);
+            pushNetworkCommand(NetworkMessageType::removeClient, client);
         }
-        else
-        {
 
-            for(std::vector<ODSocketClient*>::iterator it = mSockClients.begin(); it != mSockClients.end();)
+        // Nothing to do. We wait for the network thread
+        if(!hasWorked)
+            sf::sleep(sf::milliseconds(NETWORK_THREAD_WAIT_MS));
+    }
+}
+
+void ODSocketServer::networkThread()
+{
+    while(mIsNetworkThreadRunning.load())
+    {
+        // Events that could not be sent to the server thread
+        while(!mPendingNetworkEvents.empty() && mNetworkEvents.push(mPendingNetworkEvents.front()))
+            mPendingNetworkEvents.pop_front();
+
+        NetworkMessage command;
+        while(mNetworkCommands.pop(command))
+        {
+            ODSocketClient* client = command.mClient;
+            switch(command.mType)
             {
-                ODSocketClient* client = *it;
-                if((mSockSelector.isReady(client->getSockClient())) &&
-                    (!notifyClientMessage(client)))
+                case NetworkMessageType::addClient:
                 {
-                    // The server wants to remove the client
-                    it = mSockClients.erase(it);
-                    mSockSelector.remove(client->getSockClient());
-                    client->disconnect();
-                    delete client;
+                    // Sends and receives should never block the network thread (see networkThreadSend)
+                    client->getSockClient().setBlocking(false);
+                    mNetworkClients.push_back(client);
+                    if(!client->mIsSocketClosed.load())
+                        mSockSelector.add(client->getSockClient());
+                    break;
                 }
-                else
+                case NetworkMessageType::removeClient:
                 {
-                    ++it;
+                    std::vector<ODSocketClient*>::iterator it = std::find(mNetworkClients.begin(), mNetworkClients.end(), client);
+                    if(it != mNetworkClients.end())
+                    {
+                        mNetworkClients.erase(it);
+                        if(!client->mIsSocketClosed.load())
+                            mSockSelector.remove(client->getSockClient());
+                    }
+                    client->getSockClient().disconnect();
+                    client->mIsSocketClosed = true;
+                    pushNetworkEvent(NetworkMessageType::clientReleased, client);
+                    break;
                 }
+                default:
+                    OD_LOG_ERR("Unexpected network command=" + Helper::toString(static_cast<uint32_t>(command.mType)));
+                    break;
             }
         }
+
+        for(ODSocketClient* client : mNetworkClients)
+        {
+            if(client->mIsSocketClosed.load())
+                continue;
+
+            if(client->networkThreadSend())
+                continue;
+
+            mSockSelector.remove(client->getSockClient());
+            client->mIsSocketClosed = true;
+        }
+
+        if(!mSockSelector.wait(sf::milliseconds(NETWORK_THREAD_WAIT_MS)))
+            continue;
+
+        // We only accept new connections if the server thread can be notified
+        if(mPendingNetworkEvents.empty() && mSockSelector.isReady(mSockListener))
+        {
+            ODSocketClient* newClient = new ODSocketClient;
+            sf::Socket::Status status = mSockListener.accept(newClient->getSockClient());
+            if(status == sf::Socket::Done)
+            {
+                newClient->setSource(ODSocketClient::ODSource::serverNetwork);
+                pushNetworkEvent(NetworkMessageType::newClient, newClient);
+            }
+            else
+            {
+                OD_LOG_ERR("Error while listening to socket status=" + Helper::toString(static_cast<uint32_t>(status)));
+                delete newClient;
+            }
+        }
+
+        bool isInboundFull = false;
+        for(ODSocketClient* client : mNetworkClients)
+        {
+            if(client->mIsSocketClosed.load())
+                continue;
+
+            if(!mSockSelector.isReady(client->getSockClient()))
+                continue;
+
+            // If the server thread is late processing the messages of this client, we leave the data
+            // in the socket
+            if(client->mInboundQueue.size() >= client->mInboundQueue.capacity())
+            {
+                isInboundFull = true;
+                continue;
+            }
+
+            if(client->networkThreadReceive())
+                continue;
+
+            mSockSelector.remove(client->getSockClient());
+            client->mIsSocketClosed = true;
+        }
+
+        // The selector would return immediately while the data is not read
+        if(isInboundFull)
+            sf::sleep(sf::milliseconds(NETWORK_THREAD_WAIT_MS));
+    }
+}
+
+void ODSocketServer::deleteNetworkQueuedClients()
+{
+    // Clients removed by the server but not released by the network thread yet. Added clients
+    // are still in mSockClients
+    NetworkMessage command;
+    while(mNetworkCommands.pop(command))
+        mPendingNetworkCommands.push_back(command);
+
+    for(const NetworkMessage& pendingCommand : mPendingNetworkCommands)
+    {
+        if(pendingCommand.mType != NetworkMessageType::removeClient)
+            continue;
+
+        pendingCommand.mClient->disconnect();
+        delete pendingCommand.mClient;
+    }
+    mPendingNetworkCommands.clear();
+
+    // Clients accepted or released by the network thread but not handled by the server yet
+    for(const NetworkMessage& event : mPendingNetworkEvents)
+    {
+        event.mClient->disconnect();
+        delete event.mClient;
+    }
+    mPendingNetworkEvents.clear();
+    NetworkMessage event;
+    while(mNetworkEvents.pop(event))
+    {
+        event.mClient->disconnect();
+        delete event.mClient;
     }
 }
 
@@ -130,8 +312,17 @@ void ODSocketServer::stopServer()
     if(mThread != nullptr)
         delete mThread; // Delete waits for the thread to finish
     mThread = nullptr;
+
+    // Now that the server thread is stopped, we can stop the network thread
+    mIsNetworkThreadRunning = false;
+    if(mNetworkThread != nullptr)
+        delete mNetworkThread;
+    mNetworkThread = nullptr;
+
     mSockSelector.clear();
     mSockListener.close();
+    mNetworkClients.clear();
+    deleteNetworkQueuedClients();
     for (std::vector<ODSocketClient*>::iterator it = mSockClients.begin(); it != mSockClients.end(); ++it)
     {
         ODSocketClient* client = *it;
@@ -19,11 +19,24 @@
 #define ODSOCKETSERVER_H
 
 #include "ODSocketClient.h"
+#include "utils/SpscQueue.h"
 
 #include <SFML/Network.hpp>
 
+#include <atomic>
+#include <deque>
+
 class ODPacket;
 
+/*! \brief Server side of the network.
+ *
+ * The sockets are only used by a dedicated network thread. It accepts the connections, reads the
+ * packets sent by the clients and writes the packets sent by the server. The server thread (that
+ * computes the turns) and the network thread only communicate through single producer/single consumer
+ * lock free queues: each client has an inbound and an outbound queue (see ODSocketClient) and the
+ * creation/removal of clients goes through mNetworkCommands and mNetworkEvents. That way, a slow
+ * client cannot stall the turn computation.
+ */
 class ODSocketServer
 {
     public:
@@ -37,10 +50,11 @@ class ODSocketServer
         virtual void stopServer();
 
     protected:
-        /*! \brief Function called when a new client connects. If the server returns an ODSocketClient,
-         *! it will be added to the client list
+        /*! \brief Function called when a new client connects. The connection has already been accepted
+         * by the network thread. If the server returns true, the client is added to the client list.
+         * Otherwise, it is disconnected and deleted.
          */
-        virtual ODSocketClient* notifyNewConnection(sf::TcpListener& sockListener) = 0;
+        virtual bool notifyNewConnection(ODSocketClient* client) = 0;
 
         /*! \brief Function called when a client sends a message. As this function is called
          * from the doTask context, it shall return as soon as possible (we should not send
@@ -54,7 +68,7 @@ class ODSocketServer
          */
         virtual bool notifyClientMessage(ODSocketClient *sock) = 0;
 
-        /*! \brief Main function task. Checks if a new client connects. If so, notifyNewConnection
+        /*! \brief Main function task. Checks if a new client connected. If so, notifyNewConnection
          * will be called with the client socket. If it returns true, the client is saved in the
          * client list. If not, the client is discarded. doTask also checks if a connected client sent
          * a message. If so, calls notifyClientMessage with the client socket.
@@ -67,10 +81,60 @@ class ODSocketServer
         sf::Thread* mThread;
 
     private:
+        enum class NetworkMessageType
+        {
+            addClient,      //!< Server -> network thread: the client should be read/written
+            removeClient,   //!< Server -> network thread: the client should not be used anymore
+            newClient,      //!< Network thread -> server: a client connected
+            clientReleased  //!< Network thread -> server: the client is not used anymore and can be deleted
+        };
+
+        struct NetworkMessage
+        {
+            NetworkMessage() :
+                mType(NetworkMessageType::addClient),
+                mClient(nullptr)
+            {}
+
+            NetworkMessage(NetworkMessageType type, ODSocketClient* client) :
+                mType(type),
+                mClient(client)
+            {}
+
+            NetworkMessageType mType;
+            ODSocketClient* mClient;
+        };
+
+        //! \brief Network thread main loop
+        void networkThread();
+
+        //! \brief Sends a command to the network thread (server thread only)
+        void pushNetworkCommand(NetworkMessageType type, ODSocketClient* client);
+        //! \brief Sends an event to the server thread (network thread only)
+        void pushNetworkEvent(NetworkMessageType type, ODSocketClient* client);
+
+        //! \brief Only used by the network thread while it is running
         sf::TcpListener mSockListener;
         sf::SocketSelector mSockSelector;
+        std::vector<ODSocketClient*> mNetworkClients;
+        //! \brief Events that could not be pushed because mNetworkEvents was full
+        std::deque<NetworkMessage> mPendingNetworkEvents;
+
+        //! \brief Only used by the server thread. Commands that could not be pushed because
+        //! mNetworkCommands was full
+        std::deque<NetworkMessage> mPendingNetworkCommands;
+
+        SpscQueue<NetworkMessage> mNetworkCommands;
+        SpscQueue<NetworkMessage> mNetworkEvents;
+
+        sf::Thread* mNetworkThread;
+        std::atomic<bool> mIsNetworkThreadRunning;
+
         sf::Clock mClockMainTask;
         bool mIsConnected;
+
+        //! \brief Deletes the clients still referenced by the network queues. The network thread should be stopped
+        void deleteNetworkQueuedClients();
 };
 
 #endif // ODSOCKETSERVER_H
@@ -0,0 +1,282 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/ReplayFile.h"
+
+#include "network/ODPacket.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+// File layout:
+// - header: HEADER_MAGIC, FORMAT_VERSION
+// - records: timestamp (int32), size (uint32, with COMPRESSED_RECORD_FLAG if the data is compressed)
+//   and data
+// - index: for each keyframe turn (int64), timestamp (int32) and offset (uint64). Then the index offset
+//   (uint64), the number of keyframes (uint32) and INDEX_MAGIC
+// Values are written with the native byte order
+static const uint32_t HEADER_MAGIC = 0x5052444F; // "ODRP"
+static const uint32_t INDEX_MAGIC = 0x4952444F; // "ODRI"
+static const uint32_t FORMAT_VERSION = 1;
+static const uint32_t HEADER_SIZE = 2 * sizeof(uint32_t);
+static const uint32_t RECORD_HEADER_SIZE = sizeof(int32_t) + sizeof(uint32_t);
+static const uint32_t COMPRESSED_RECORD_FLAG = 0x80000000;
+static const uint32_t INDEX_ENTRY_SIZE = sizeof(int64_t) + sizeof(int32_t) + sizeof(uint64_t);
+static const uint32_t INDEX_FOOTER_SIZE = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+const int64_t ReplayWriter::KEYFRAME_INTERVAL = 50;
+
+template<typename T>
+static void writeValue(std::ofstream& os, T value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//! \brief Reads a value from the mapped file and moves offset after it
+template<typename T>
+static T readValue(const char* data, uint64_t& offset)
+{
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+ReplayWriter::ReplayWriter() :
+    mPendingKeyframeTurn(-1)
+{
+}
+
+bool ReplayWriter::open(const std::string& filename)
+{
+    close();
+    mOutputStream.open(filename, std::ios::out | std::ios::binary);
+    if(!mOutputStream.is_open())
+        return false;
+
+    mCompressor.reset();
+    writeValue(mOutputStream, HEADER_MAGIC);
+    writeValue(mOutputStream, FORMAT_VERSION);
+    return true;
+}
+
+void ReplayWriter::close()
+{
+    if(mOutputStream.is_open())
+    {
+        uint64_t indexOffset = static_cast<uint64_t>(mOutputStream.tellp());
+        for(const ReplayKeyframe& keyframe : mKeyframes)
+        {
+            writeValue(mOutputStream, keyframe.mTurn);
+            writeValue(mOutputStream, keyframe.mTimestamp);
+            writeValue(mOutputStream, keyframe.mOffset);
+        }
+        writeValue(mOutputStream, indexOffset);
+        writeValue(mOutputStream, static_cast<uint32_t>(mKeyframes.size()));
+        writeValue(mOutputStream, INDEX_MAGIC);
+        mOutputStream.close();
+    }
+
+    mKeyframes.clear();
+    mPendingKeyframeTurn = -1;
+}
+
+void ReplayWriter::turnStarted(int64_t turn)
+{
+    if((turn % KEYFRAME_INTERVAL) != 0)
+        return;
+
+    mPendingKeyframeTurn = turn;
+}
+
+void ReplayWriter::writeKeyframe(int32_t timestamp, const ODPacket& stringsPacket)
+{
+    if(!mOutputStream.is_open())
+        return;
+
+    ReplayKeyframe keyframe;
+    keyframe.mTurn = mPendingKeyframeTurn;
+    keyframe.mTimestamp = timestamp;
+    keyframe.mOffset = static_cast<uint64_t>(mOutputStream.tellp());
+    mKeyframes.push_back(keyframe);
+    mPendingKeyframeTurn = -1;
+
+    mCompressor.reset();
+    writePacket(timestamp, stringsPacket);
+}
+
+void ReplayWriter::writePacket(int32_t timestamp, const ODPacket& packet)
+{
+    if(!mOutputStream.is_open())
+        return;
+
+    mCompressedBuffer.clear();
+    mCompressor.compress(packet.getData(), packet.getDataSize(), mCompressedBuffer);
+    uint32_t size = static_cast<uint32_t>(mCompressedBuffer.size());
+    writeValue(mOutputStream, timestamp);
+    writeValue(mOutputStream, size | COMPRESSED_RECORD_FLAG);
+    mOutputStream.write(mCompressedBuffer.data(), size);
+}
+
+ReplayReader::ReplayReader() :
+    mData(nullptr),
+    mPosition(0),
+    mRecordsEnd(0)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+}
+
+bool ReplayReader::open(const std::string& filename)
+{
+    close();
+    try
+    {
+        mFile.reset(new boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only));
+        mRegion.reset(new boost::interprocess::mapped_region(*mFile, boost::interprocess::read_only));
+    }
+    catch(const boost::interprocess::interprocess_exception&)
+    {
+        // The file does not exist or is empty
+        close();
+        return false;
+    }
+
+    mData = static_cast<const char*>(mRegion->get_address());
+    uint64_t fileSize = static_cast<uint64_t>(mRegion->get_size());
+    mPosition = 0;
+    mRecordsEnd = fileSize;
+
+    uint64_t offset = 0;
+    if((fileSize < HEADER_SIZE) || (readValue<uint32_t>(mData, offset) != HEADER_MAGIC))
+    {
+        // Replay written before the header existed. There is no index
+        return true;
+    }
+
+    // Replay written by a newer version
+    if(readValue<uint32_t>(mData, offset) > FORMAT_VERSION)
+    {
+        close();
+        return false;
+    }
+
+    mPosition = HEADER_SIZE;
+    if(fileSize < HEADER_SIZE + INDEX_FOOTER_SIZE)
+        return true;
+
+    offset = fileSize - INDEX_FOOTER_SIZE;
+    uint64_t indexOffset = readValue<uint64_t>(mData, offset);
+    uint32_t nbKeyframes = readValue<uint32_t>(mData, offset);
+    uint32_t magic = readValue<uint32_t>(mData, offset);
+    if((magic != INDEX_MAGIC) || (indexOffset < HEADER_SIZE) ||
+       (indexOffset + static_cast<uint64_t>(nbKeyframes) * INDEX_ENTRY_SIZE + INDEX_FOOTER_SIZE != fileSize))
+    {
+        // The index is missing (for example if the game crashed while recording)
+        return true;
+    }
+
+    offset = indexOffset;
+    mKeyframes.resize(nbKeyframes);
+    for(ReplayKeyframe& keyframe : mKeyframes)
+    {
+        keyframe.mTurn = readValue<int64_t>(mData, offset);
+        keyframe.mTimestamp = readValue<int32_t>(mData, offset);
+        keyframe.mOffset = readValue<uint64_t>(mData, offset);
+    }
+    mRecordsEnd = indexOffset;
+    return true;
+}
+
+void ReplayReader::close()
+{
+    mRegion.reset();
+    mFile.reset();
+    mData = nullptr;
+    mPosition = 0;
+    mRecordsEnd = 0;
+    mDecompressor.reset();
+    mKeyframes.clear();
+}
+
+int32_t ReplayReader::peekTimestamp() const
+{
+    if(mPosition + RECORD_HEADER_SIZE > mRecordsEnd)
+        return -1;
+
+    uint64_t offset = mPosition;
+    return readValue<int32_t>(mData, offset);
+}
+
+int32_t ReplayReader::readRecord(const char*& data, uint32_t& size)
+{
+    if(mPosition + RECORD_HEADER_SIZE > mRecordsEnd)
+        return -1;
+
+    uint64_t offset = mPosition;
+    int32_t timestamp = readValue<int32_t>(mData, offset);
+    uint32_t recordSize = readValue<uint32_t>(mData, offset);
+    uint32_t dataSize = recordSize & ~COMPRESSED_RECORD_FLAG;
+    if(offset + dataSize > mRecordsEnd)
+        return -1;
+
+    const char* recordData = mData + offset;
+    if((recordSize & COMPRESSED_RECORD_FLAG) == 0)
+    {
+        data = recordData;
+        size = dataSize;
+    }
+    else if(!mDecompressor.decompress(recordData, dataSize, data, size))
+        return -1;
+
+    mPosition = offset + dataSize;
+    return timestamp;
+}
+
+int32_t ReplayReader::readPacket(ODPacket& packet)
+{
+    const char* data;
+    uint32_t size;
+    int32_t timestamp = readRecord(data, size);
+    if(timestamp < 0)
+        return -1;
+
+    packet.setData(data, size);
+    return timestamp;
+}
+
+const ReplayKeyframe* ReplayReader::seekKeyframe(int64_t turn)
+{
+    // We look for the first keyframe after the turn
+    std::vector<ReplayKeyframe>::const_iterator it = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), turn,
+        [](int64_t t, const ReplayKeyframe& keyframe)
+        {
+            return t < keyframe.mTurn;
+        });
+    if(it == mKeyframes.begin())
+        return nullptr;
+
+    --it;
+    mPosition = it->mOffset;
+    mDecompressor.reset();
+    return &(*it);
+}
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAYFILE_H
+#define REPLAYFILE_H
+
+#include "network/StreamCompression.h"
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ODPacket;
+
+namespace boost
+{
+namespace interprocess
+{
+class file_mapping;
+class mapped_region;
+}
+}
+
+//! \brief Position of a keyframe in a replay file
+struct ReplayKeyframe
+{
+    //! \brief The keyframe is written after the turnStarted of this turn
+    int64_t mTurn;
+    int32_t mTimestamp;
+    //! \brief Offset of the first record of the keyframe in the file
+    uint64_t mOffset;
+};
+
+/*! \brief Writes the packets received by a client to a replay file (.odr).
+ *
+ * The file is made of a header, the records (timestamp, size and compressed packet) and an
+ * index of the keyframes written when the file is closed. Every KEYFRAME_INTERVAL turns, the
+ * compressor is reset and a packet with the strings interned since the previous keyframe is written.
+ * That way, the records can be decompressed from any keyframe. Keyframes do not contain the game
+ * state: a replay can only be played from the beginning.
+ */
+class ReplayWriter
+{
+public:
+    //! \brief Number of turns between 2 keyframes
+    static const int64_t KEYFRAME_INTERVAL;
+
+    ReplayWriter();
+
+    bool open(const std::string& filename);
+
+    //! \brief Writes the index and closes the file
+    void close();
+
+    inline bool isOpen() const
+    { return mOutputStream.is_open(); }
+
+    //! \brief To be called when a turn starts. If a keyframe is needed, isKeyframePending
+    //! will return true until writeKeyframe is called
+    void turnStarted(int64_t turn);
+
+    inline bool isKeyframePending() const
+    { return mPendingKeyframeTurn >= 0; }
+
+    //! \brief Writes a keyframe. stringsPacket should be an internStrings notification with
+    //! the strings received since the previous keyframe
+    void writeKeyframe(int32_t timestamp, const ODPacket& stringsPacket);
+
+    void writePacket(int32_t timestamp, const ODPacket& packet);
+
+private:
+    std::ofstream mOutputStream;
+    StreamCompressor mCompressor;
+    //! \brief Kept to avoid allocating a buffer for each packet
+    std::vector<char> mCompressedBuffer;
+    std::vector<ReplayKeyframe> mKeyframes;
+    int64_t mPendingKeyframeTurn;
+};
+
+/*! \brief Reads the replay files written by ReplayWriter. Files without index (if the game
+ * crashed while recording) or without header (older versions) can only be read from the beginning.
+ *
+ * The whole file is mapped in memory so records are not copied when read: readRecord gives a view
+ * on the mapped file (or on the decompressor buffer for compressed records).
+ */
+class ReplayReader
+{
+public:
+    ReplayReader();
+    ~ReplayReader();
+
+    //! \brief Opens the file and reads its index. Returns false if the file cannot be read
+    bool open(const std::string& filename);
+
+    void close();
+
+    inline bool isOpen() const
+    { return mData != nullptr; }
+
+    //! \brief Timestamp of the next record without reading it. -1 if the end of the replay is reached
+    int32_t peekTimestamp() const;
+
+    /*! \brief Reads the next record. data is set to the packet content, which is not copied: it stays
+     * valid until the next record is read (or the file closed). Returns the timestamp of the record
+     * or -1 if the end of the replay is reached or if the record cannot be read.
+     */
+    int32_t readRecord(const char*& data, uint32_t& size);
+
+    //! \brief Same as readRecord but the content is copied to the packet
+    int32_t readPacket(ODPacket& packet);
+
+    //! \brief Keyframes from the index, ordered by turn. Empty if the file has no index
+    inline const std::vector<ReplayKeyframe>& getKeyframes() const
+    { return mKeyframes; }
+
+    /*! \brief Moves to the last keyframe at or before the given turn so that the next packet read
+     * is the first of the keyframe. Returns nullptr if there is no such keyframe (then, the position
+     * is unchanged). Only the records can be read from there, not the game state.
+     */
+    const ReplayKeyframe* seekKeyframe(int64_t turn);
+
+private:
+    std::unique_ptr<boost::interprocess::file_mapping> mFile;
+    std::unique_ptr<boost::interprocess::mapped_region> mRegion;
+    //! \brief The mapped file. nullptr if not open
+    const char* mData;
+    //! \brief Offset of the next record
+    uint64_t mPosition;
+    //! \brief Offset of the end of the records (where the index starts if any)
+    uint64_t mRecordsEnd;
+    StreamDecompressor mDecompressor;
+    std::vector<ReplayKeyframe> mKeyframes;
+};
+
+#endif // REPLAYFILE_H
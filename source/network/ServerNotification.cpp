@@ -32,6 +32,8 @@ std::string ServerNotification::typeString(ServerNotificationType type)
 {
     switch(type)
     {
+        case ServerNotificationType::enableCompression:
+            return "enableCompression";
         case ServerNotificationType::loadLevel:
             return "loadLevel";
         case ServerNotificationType::pickNick:
@@ -60,6 +62,10 @@ std::string ServerNotification::typeString(ServerNotificationType type)
             return "chatServer";
         case ServerNotificationType::turnStarted:
             return "turnStarted";
+        case ServerNotificationType::turnBatch:
+            return "turnBatch";
+        case ServerNotificationType::internStrings:
+            return "internStrings";
         case ServerNotificationType::animatedObjectSetWalkPath:
             return "animatedObjectSetWalkPath";
         case ServerNotificationType::setObjectAnimationState:
@@ -116,6 +122,8 @@ std::string ServerNotification::typeString(ServerNotificationType type)
             return "setSpellCooldown";
         case ServerNotificationType::playerEvents:
             return "playerEvents";
+        case ServerNotificationType::stateChecksum:
+            return "stateChecksum";
         case ServerNotificationType::exit:
             return "exit";
         default:
@@ -31,6 +31,7 @@ class Player;
 enum class ServerNotificationType
 {
     // Negotiation for multiplayer
+    enableCompression, // Every packet following this one is compressed (see StreamCompression)
     loadLevel, // Tells the client to load the level: + string LevelFilename
     pickNick,
     addPlayers,
@@ -48,6 +49,8 @@ enum class ServerNotificationType
     chatServer,
 
     turnStarted,
+    turnBatch, // Every notification sent to a player during a turn: + sub packets (see ODPacket::writeSubPacket)
+    internStrings, // Adds strings to the dictionary (see NetworkStringTable): + nb + (uint32 id + string) for each
 
     animatedObjectSetWalkPath,
     setObjectAnimationState,
@@ -87,6 +90,8 @@ enum class ServerNotificationType
 
     playerEvents,
 
+    stateChecksum, // State checksum in lockstep mode: + int64 turn + StateChecksum
+
     exit
 };
 
@@ -110,9 +115,17 @@ class ServerNotification
 
         static std::string typeString(ServerNotificationType type);
 
+        /*! \brief If another notification with the same type, concerned player and key is queued after this
+         *         one before the notifications are sent, this one will not be sent. That should only be used for
+         *         notifications overriding everything the previous ones did (like the walk path of a given entity).
+         */
+        void setCoalescingKey(const std::string& key)
+        { mCoalescingKey = key; }
+
     private:
         ServerNotificationType mType;
         Player *mConcernedPlayer;
+        std::string mCoalescingKey;
 };
 
 #endif // SERVERNOTIFICATION_H
@@ -0,0 +1,307 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/StreamCompression.h"
+
+#include <cstring>
+
+const uint32_t StreamCompressor::WINDOW_SIZE = 65535;
+
+//! \brief Every block starts with its mode (1 byte) and its decompressed size (4 bytes)
+enum BlockMode : uint8_t
+{
+    blockRaw = 0,
+    blockCompressed = 1
+};
+
+static const uint32_t BLOCK_HEADER_SIZE = 5;
+static const uint32_t MIN_MATCH = 4;
+static const uint32_t HASH_BITS = 14;
+//! \brief Blocks bigger than that are considered invalid when decompressing
+static const uint32_t MAX_BLOCK_SIZE = 256 * 1024 * 1024;
+
+static inline uint32_t read32(const char* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+//! \brief Lengths bigger than 15 do not fit in the token and continue with bytes of 255 until the last one
+static void writeLength(std::vector<char>& out, uint32_t length)
+{
+    length -= 15;
+    while(length >= 255)
+    {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static bool readLength(const uint8_t*& data, const uint8_t* end, uint32_t& length)
+{
+    uint8_t value;
+    do
+    {
+        if(data >= end)
+            return false;
+
+        value = *data;
+        ++data;
+        length += value;
+        if(length > MAX_BLOCK_SIZE)
+            return false;
+    } while(value == 255);
+    return true;
+}
+
+static void writeSequence(std::vector<char>& out, const char* literals, uint32_t nbLiterals, uint32_t offset, uint32_t matchLength)
+{
+    uint32_t matchCode = (matchLength >= MIN_MATCH) ? matchLength - MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>(((nbLiterals < 15 ? nbLiterals : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+    out.push_back(static_cast<char>(token));
+    if(nbLiterals >= 15)
+        writeLength(out, nbLiterals);
+
+    out.insert(out.end(), literals, literals + nbLiterals);
+
+    // The last sequence of a block only has literals
+    if(matchLength == 0)
+        return;
+
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>((offset >> 8) & 0xFF));
+    if(matchCode >= 15)
+        writeLength(out, matchCode);
+}
+
+static void writeHeader(std::vector<char>& out, BlockMode mode, uint32_t size)
+{
+    out.push_back(static_cast<char>(mode));
+    for(uint32_t i = 0; i < 4; ++i)
+        out.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+}
+
+StreamCompressor::StreamCompressor() :
+    mHashTable(1 << HASH_BITS, -1)
+{
+}
+
+void StreamCompressor::reset()
+{
+    mHistory.clear();
+    std::fill(mHashTable.begin(), mHashTable.end(), -1);
+}
+
+void StreamCompressor::trimHistory()
+{
+    if(mHistory.size() <= 2 * WINDOW_SIZE)
+        return;
+
+    int32_t shift = static_cast<int32_t>(mHistory.size() - WINDOW_SIZE);
+    mHistory.erase(mHistory.begin(), mHistory.begin() + shift);
+    for(int32_t& pos : mHashTable)
+    {
+        pos -= shift;
+        if(pos < 0)
+            pos = -1;
+    }
+}
+
+void StreamCompressor::compress(const char* data, uint32_t size, std::vector<char>& out)
+{
+    trimHistory();
+    uint32_t start = static_cast<uint32_t>(mHistory.size());
+    mHistory.insert(mHistory.end(), data, data + size);
+    const char* base = mHistory.data();
+    uint32_t end = static_cast<uint32_t>(mHistory.size());
+
+    std::vector<char> compressed;
+    compressed.reserve(size / 2 + 16);
+    uint32_t anchor = start;
+    uint32_t pos = start;
+    while(pos + MIN_MATCH <= end)
+    {
+        uint32_t sequence = read32(base + pos);
+        int32_t& entry = mHashTable[hashSequence(sequence)];
+        int32_t candidate = entry;
+        entry = static_cast<int32_t>(pos);
+        if((candidate < 0) ||
+           (pos - static_cast<uint32_t>(candidate) > WINDOW_SIZE) ||
+           (read32(base + candidate) != sequence))
+        {
+            ++pos;
+            continue;
+        }
+
+        uint32_t matchLength = MIN_MATCH;
+        while((pos + matchLength < end) && (base[candidate + matchLength] == base[pos + matchLength]))
+            ++matchLength;
+
+        writeSequence(compressed, base + anchor, pos - anchor, pos - static_cast<uint32_t>(candidate), matchLength);
+        pos += matchLength;
+        anchor = pos;
+
+        // We also remember a position near the end of the match so that the next matches are more likely found
+        if((pos >= start + 2) && (pos - 2 + MIN_MATCH <= end))
+            mHashTable[hashSequence(read32(base + pos - 2))] = static_cast<int32_t>(pos - 2);
+    }
+
+    if(anchor < end)
+        writeSequence(compressed, base + anchor, end - anchor, 0, 0);
+
+    if(compressed.size() >= size)
+    {
+        writeHeader(out, blockRaw, size);
+        out.insert(out.end(), data, data + size);
+        return;
+    }
+
+    writeHeader(out, blockCompressed, size);
+    out.insert(out.end(), compressed.begin(), compressed.end());
+}
+
+void StreamDecompressor::reset()
+{
+    mHistory.clear();
+}
+
+void StreamDecompressor::trimHistory()
+{
+    if(mHistory.size() <= 2 * StreamCompressor::WINDOW_SIZE)
+        return;
+
+    mHistory.erase(mHistory.begin(), mHistory.end() - StreamCompressor::WINDOW_SIZE);
+}
+
+bool StreamDecompressor::decompress(const char* data, uint32_t size, std::vector<char>& out)
+{
+    out.clear();
+    const char* outData;
+    uint32_t outSize;
+    if(!decompress(data, size, outData, outSize))
+        return false;
+
+    out.assign(outData, outData + outSize);
+    return true;
+}
+
+bool StreamDecompressor::decompress(const char* data, uint32_t size, const char*& outData, uint32_t& outSize)
+{
+    if(size < BLOCK_HEADER_SIZE)
+        return false;
+
+    const uint8_t* cur = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = cur + size;
+    uint8_t mode = cur[0];
+    uint32_t blockSize = 0;
+    for(uint32_t i = 0; i < 4; ++i)
+        blockSize |= static_cast<uint32_t>(cur[1 + i]) << (8 * i);
+    cur += BLOCK_HEADER_SIZE;
+    if(blockSize > MAX_BLOCK_SIZE)
+        return false;
+
+    trimHistory();
+    std::size_t start = mHistory.size();
+    std::size_t blockEnd = start + blockSize;
+    switch(mode)
+    {
+        case blockRaw:
+        {
+            if(static_cast<uint32_t>(end - cur) != blockSize)
+                return false;
+
+            mHistory.insert(mHistory.end(), cur, end);
+            break;
+        }
+        case blockCompressed:
+        {
+            bool isValid = true;
+            while(isValid && (mHistory.size() < blockEnd))
+            {
+                if(cur >= end)
+                {
+                    isValid = false;
+                    break;
+                }
+
+                uint8_t token = *cur;
+                ++cur;
+                uint32_t nbLiterals = token >> 4;
+                if((nbLiterals == 15) && !readLength(cur, end, nbLiterals))
+                {
+                    isValid = false;
+                    break;
+                }
+                if((static_cast<uint32_t>(end - cur) < nbLiterals) || (mHistory.size() + nbLiterals > blockEnd))
+                {
+                    isValid = false;
+                    break;
+                }
+                mHistory.insert(mHistory.end(), cur, cur + nbLiterals);
+                cur += nbLiterals;
+
+                if(mHistory.size() == blockEnd)
+                    break;
+
+                if(end - cur < 2)
+                {
+                    isValid = false;
+                    break;
+                }
+                uint32_t offset = static_cast<uint32_t>(cur[0]) | (static_cast<uint32_t>(cur[1]) << 8);
+                cur += 2;
+                uint32_t matchLength = token & 0x0F;
+                if((matchLength == 15) && !readLength(cur, end, matchLength))
+                {
+                    isValid = false;
+                    break;
+                }
+                matchLength += MIN_MATCH;
+                if((offset == 0) || (offset > mHistory.size()) || (mHistory.size() + matchLength > blockEnd))
+                {
+                    isValid = false;
+                    break;
+                }
+
+                // The match can overlap the data being written so we copy byte per byte
+                std::size_t from = mHistory.size() - offset;
+                for(uint32_t i = 0; i < matchLength; ++i)
+                    mHistory.push_back(mHistory[from + i]);
+            }
+
+            if(!isValid || (cur != end))
+            {
+                mHistory.resize(start);
+                return false;
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+
+    outData = mHistory.data() + start;
+    outSize = static_cast<uint32_t>(mHistory.size() - start);
+    return true;
+}
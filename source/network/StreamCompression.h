@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STREAMCOMPRESSION_H
+#define STREAMCOMPRESSION_H
+
+#include <cstdint>
+#include <vector>
+
+/*! \brief Compresses a stream of blocks (like the packets sent to a client or the records of a replay).
+ *
+ * The format is a LZ77 variant close to LZ4: each block is a sequence of literals and matches
+ * (offset, length) that can refer to data from the same block or from the previous ones (up to
+ * WINDOW_SIZE bytes back). Because the previous blocks are used as dictionary, repeated names,
+ * tile states or animations compress well even when they come in small packets. The counterpart is
+ * that blocks have to be decompressed in the same order by a StreamDecompressor.
+ * Blocks that do not compress are stored as they are.
+ */
+class StreamCompressor
+{
+public:
+    //! \brief Maximum distance of a match
+    static const uint32_t WINDOW_SIZE;
+
+    StreamCompressor();
+
+    //! \brief Compresses the given block and appends it to out
+    void compress(const char* data, uint32_t size, std::vector<char>& out);
+
+    //! \brief Forgets the previous blocks. The next block can be decompressed by a new StreamDecompressor
+    void reset();
+
+private:
+    //! \brief The last blocks compressed (at least WINDOW_SIZE bytes if available)
+    std::vector<char> mHistory;
+    //! \brief Last position in mHistory of each hashed 4 bytes sequence (-1 if none)
+    std::vector<int32_t> mHashTable;
+
+    void trimHistory();
+};
+
+//! \brief Decompresses the blocks written by StreamCompressor
+class StreamDecompressor
+{
+public:
+    //! \brief Decompresses the given block and sets out to its content. Returns false if the block is invalid
+    bool decompress(const char* data, uint32_t size, std::vector<char>& out);
+
+    /*! \brief Same as above without copying the decompressed block: outData points to the internal
+     * buffer and stays valid until the next call to decompress or reset.
+     */
+    bool decompress(const char* data, uint32_t size, const char*& outData, uint32_t& outSize);
+
+    void reset();
+
+private:
+    std::vector<char> mHistory;
+
+    void trimHistory();
+};
+
+#endif // STREAMCOMPRESSION_H
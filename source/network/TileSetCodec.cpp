@@ -0,0 +1,249 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/TileSetCodec.h"
+
+#include "network/ODPacket.h"
+
+#include <algorithm>
+
+namespace
+{
+//! \brief Run of consecutive tiles on a row
+struct TileRun
+{
+    int32_t mY;
+    int32_t mXStart;
+    int32_t mXEnd;
+};
+}
+
+//! \brief Number of bytes taken by ODPacket::writeVarUInt
+static uint32_t varUIntSize(uint32_t value)
+{
+    uint32_t size = 1;
+    while(value >= 0x80)
+    {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+//! \brief Splits the coordinates in runs. If maxLength is 1, each tile is a run
+static void computeRuns(const std::vector<std::pair<int32_t, int32_t>>& coords, int32_t maxLength, std::vector<TileRun>& runs)
+{
+    for(const std::pair<int32_t, int32_t>& coord : coords)
+    {
+        if(!runs.empty() && (runs.back().mY == coord.second) && (runs.back().mXEnd + 1 == coord.first)
+            && (runs.back().mXEnd - runs.back().mXStart + 1 < maxLength))
+        {
+            runs.back().mXEnd = coord.first;
+            continue;
+        }
+
+        TileRun run;
+        run.mY = coord.second;
+        run.mXStart = coord.first;
+        run.mXEnd = coord.first;
+        runs.push_back(run);
+    }
+}
+
+/*! \brief Each run is written relative to the previous one: the row difference, then the x start
+ * (relative to the end of the previous run if on the same row) and, if withLength is true, the length.
+ * If packet is nullptr, nothing is written. Returns the number of bytes written.
+ */
+static uint32_t writeRuns(ODPacket* packet, const std::vector<TileRun>& runs, bool withLength)
+{
+    std::vector<uint32_t> values;
+    values.reserve(runs.size() * 3 + 1);
+    values.push_back(static_cast<uint32_t>(runs.size()));
+    int32_t previousY = 0;
+    // So that the first run written on row 0 has an absolute x
+    int32_t previousXEnd = -1;
+    for(const TileRun& run : runs)
+    {
+        values.push_back(static_cast<uint32_t>(run.mY - previousY));
+        if(run.mY == previousY)
+            values.push_back(static_cast<uint32_t>(run.mXStart - previousXEnd - 1));
+        else
+            values.push_back(static_cast<uint32_t>(run.mXStart));
+
+        if(withLength)
+            values.push_back(static_cast<uint32_t>(run.mXEnd - run.mXStart));
+
+        previousY = run.mY;
+        previousXEnd = run.mXEnd;
+    }
+
+    uint32_t size = 1;
+    for(uint32_t value : values)
+    {
+        size += varUIntSize(value);
+        if(packet != nullptr)
+            packet->writeVarUInt(value);
+    }
+    return size;
+}
+
+TileSetCodec::Encoding TileSetCodec::write(ODPacket& packet, const std::vector<std::pair<int32_t, int32_t>>& coords)
+{
+    std::vector<TileRun> tiles;
+    computeRuns(coords, 1, tiles);
+    std::vector<TileRun> runs;
+    computeRuns(coords, 0x7FFFFFFF, runs);
+
+    uint32_t sizeList = writeRuns(nullptr, tiles, false);
+    uint32_t sizeRows = writeRuns(nullptr, runs, true);
+
+    uint32_t sizeBitmap = 0xFFFFFFFF;
+    int32_t xMin = 0;
+    int32_t yMin = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if(!runs.empty())
+    {
+        xMin = runs.front().mXStart;
+        int32_t xMax = runs.front().mXEnd;
+        for(const TileRun& run : runs)
+        {
+            xMin = std::min(xMin, run.mXStart);
+            xMax = std::max(xMax, run.mXEnd);
+        }
+        yMin = runs.front().mY;
+        width = static_cast<uint32_t>(xMax - xMin + 1);
+        height = static_cast<uint32_t>(runs.back().mY - yMin + 1);
+        sizeBitmap = 1 + varUIntSize(static_cast<uint32_t>(xMin)) + varUIntSize(static_cast<uint32_t>(yMin))
+            + varUIntSize(width - 1) + varUIntSize(height - 1) + (width * height + 7) / 8;
+    }
+
+    Encoding encoding = Encoding::list;
+    if((sizeRows < sizeList) && (sizeRows <= sizeBitmap))
+        encoding = Encoding::rows;
+    else if(sizeBitmap < sizeList)
+        encoding = Encoding::bitmap;
+
+    uint8_t encodingValue = static_cast<uint8_t>(encoding);
+    packet << encodingValue;
+    switch(encoding)
+    {
+        case Encoding::list:
+            writeRuns(&packet, tiles, false);
+            break;
+        case Encoding::rows:
+            writeRuns(&packet, runs, true);
+            break;
+        case Encoding::bitmap:
+        {
+            packet.writeVarUInt(static_cast<uint32_t>(xMin));
+            packet.writeVarUInt(static_cast<uint32_t>(yMin));
+            packet.writeVarUInt(width - 1);
+            packet.writeVarUInt(height - 1);
+            std::vector<uint8_t> bitmap((width * height + 7) / 8, 0);
+            for(const std::pair<int32_t, int32_t>& coord : coords)
+            {
+                uint32_t index = static_cast<uint32_t>(coord.second - yMin) * width + static_cast<uint32_t>(coord.first - xMin);
+                bitmap[index / 8] |= static_cast<uint8_t>(1 << (index % 8));
+            }
+            for(uint8_t byte : bitmap)
+                packet << byte;
+            break;
+        }
+        default:
+            break;
+    }
+
+    return encoding;
+}
+
+bool TileSetCodec::read(ODPacket& packet, std::vector<std::pair<int32_t, int32_t>>& coords)
+{
+    coords.clear();
+    uint8_t encodingValue;
+    if(!(packet >> encodingValue))
+        return false;
+
+    Encoding encoding = static_cast<Encoding>(encodingValue);
+    switch(encoding)
+    {
+        case Encoding::list:
+        case Encoding::rows:
+        {
+            uint32_t nbRuns;
+            if(!packet.readVarUInt(nbRuns))
+                return false;
+
+            int32_t y = 0;
+            int32_t xEnd = -1;
+            for(uint32_t i = 0; i < nbRuns; ++i)
+            {
+                uint32_t dy;
+                uint32_t offsetX;
+                uint32_t length = 0;
+                if(!packet.readVarUInt(dy) || !packet.readVarUInt(offsetX))
+                    return false;
+                if((encoding == Encoding::rows) && !packet.readVarUInt(length))
+                    return false;
+
+                int32_t xStart = static_cast<int32_t>(offsetX);
+                if(dy == 0)
+                    xStart += xEnd + 1;
+
+                y += static_cast<int32_t>(dy);
+                xEnd = xStart + static_cast<int32_t>(length);
+                for(int32_t x = xStart; x <= xEnd; ++x)
+                    coords.push_back(std::make_pair(x, y));
+            }
+            return true;
+        }
+        case Encoding::bitmap:
+        {
+            uint32_t xMin;
+            uint32_t yMin;
+            uint32_t width;
+            uint32_t height;
+            if(!packet.readVarUInt(xMin) || !packet.readVarUInt(yMin) ||
+               !packet.readVarUInt(width) || !packet.readVarUInt(height))
+            {
+                return false;
+            }
+            ++width;
+            ++height;
+            uint32_t nbBytes = (width * height + 7) / 8;
+            for(uint32_t i = 0; i < nbBytes; ++i)
+            {
+                uint8_t byte;
+                if(!(packet >> byte))
+                    return false;
+
+                for(uint32_t bit = 0; bit < 8; ++bit)
+                {
+                    if((byte & (1 << bit)) == 0)
+                        continue;
+
+                    uint32_t index = i * 8 + bit;
+                    coords.push_back(std::make_pair(static_cast<int32_t>(xMin + index % width),
+                        static_cast<int32_t>(yMin + index / width)));
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
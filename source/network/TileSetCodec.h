@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILESETCODEC_H
+#define TILESETCODEC_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class ODPacket;
+
+/*! \brief Writes sets of tile coordinates to packets with as few bytes as possible.
+ *
+ * Depending on how the tiles are spread, the set is written as a list of tiles, as runs of
+ * consecutive tiles on the rows or as a bitmap over the bounding box of the tiles. The smallest
+ * encoding is chosen for each set.
+ * Coordinates are (x, y) pairs. They should be sorted by y then x (see lessRowMajor) without
+ * duplicates. That is also the order they are read back.
+ */
+class TileSetCodec
+{
+public:
+    enum class Encoding : uint8_t
+    {
+        list,
+        rows,
+        bitmap
+    };
+
+    //! \brief Order the coordinates should be sorted in before being written
+    static inline bool lessRowMajor(const std::pair<int32_t, int32_t>& a, const std::pair<int32_t, int32_t>& b)
+    {
+        if(a.second != b.second)
+            return a.second < b.second;
+
+        return a.first < b.first;
+    }
+
+    //! \brief Writes the given coordinates and returns the encoding used. coords should be sorted
+    //! and should not contain negative values
+    static Encoding write(ODPacket& packet, const std::vector<std::pair<int32_t, int32_t>>& coords);
+
+    //! \brief Reads coordinates written by write. Returns false if the packet is invalid
+    static bool read(ODPacket& packet, std::vector<std::pair<int32_t, int32_t>>& coords);
+};
+
+#endif // TILESETCODEC_H
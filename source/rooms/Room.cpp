@@ -703,7 +703,8 @@ void Room::fireRoomSound(Tile& tile, const std::string& soundFamily)
 
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::playSpatialSound, seat->getPlayer());
-        serverNotification->mPacket << sound << tile.getX() << tile.getY();
+        uint32_t soundId = ODServer::getSingleton().internString(sound);
+        serverNotification->mPacket << soundId << tile.getX() << tile.getY();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -279,7 +279,7 @@ void RoomBridge::setupRoom(const std::string& name, Seat* seat, const std::vecto
 
     mClaimedValue = static_cast<double>(tiles.size()) * CLAIMED_VALUE_PER_TILE;
 
-    for(Seat* s : getGameMap()->getSeats())
+    for(Seat* s : getGameMap()->getFloodFillSeats())
         updateFloodFillPathCreated(s, tiles);
 }
 
@@ -287,7 +287,7 @@ void RoomBridge::restoreInitialEntityState()
 {
     Room::restoreInitialEntityState();
 
-    for(Seat* s : getGameMap()->getSeats())
+    for(Seat* s : getGameMap()->getFloodFillSeats())
         updateFloodFillPathCreated(s, getCoveredTiles());
 }
 
@@ -330,7 +330,7 @@ bool RoomBridge::removeCoveredTile(Tile* t)
     if(mClaimedValue > CLAIMED_VALUE_PER_TILE)
         mClaimedValue -= CLAIMED_VALUE_PER_TILE;
 
-    for(Seat* seat : getGameMap()->getSeats())
+    for(Seat* seat : getGameMap()->getFloodFillSeats())
         updateFloodFillTileRemoved(seat, t);
 
     return true;
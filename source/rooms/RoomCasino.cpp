@@ -131,7 +131,7 @@ BuildingObject* RoomCasino::notifyActiveSpotCreated(ActiveSpotPlace place, Tile*
             Ogre::Real y = static_cast<Ogre::Real>(tile->getY());
             Ogre::Real z = 0;
             mCreaturesSpots.emplace(std::make_pair(tile, RoomCasinoGame()));
-            if(Random::Uint(0,9) < 5)
+            if(Random::getStream(Random::Subsystem::room).Uint(0,9) < 5)
                 return new BuildingObject(getGameMap(), *this, "CasinoPokerTable", tile, x, y, z, 0.0, false);
             else
                 return new BuildingObject(getGameMap(), *this, "Roulette", tile, x, y, z, 0.0, false);
@@ -375,7 +375,7 @@ void RoomCasino::doUpkeep()
         // TODO: we could use the wall active spots to change feePercent/bets
 
         // We set anim for both creatures
-        uint32_t cooldown = Random::Uint(ConfigManager::getSingleton().getRoomConfigUInt32("CasinoCooldownWorkMin"),
+        uint32_t cooldown = Random::getStream(Random::Subsystem::room).Uint(ConfigManager::getSingleton().getRoomConfigUInt32("CasinoCooldownWorkMin"),
             ConfigManager::getSingleton().getRoomConfigUInt32("CasinoCooldownWorkMax"));
         double feePercent = std::min(ConfigManager::getSingleton().getRoomConfigDouble("CasinoFee"), 1.0);
         double wakefullness = ConfigManager::getSingleton().getRoomConfigDouble("CasinoWakefulnessPerWork");
@@ -409,7 +409,7 @@ void RoomCasino::doUpkeep()
         // We give the total amount to the winning creature
         double totalWinPercent = creature1RoomAffinity.getEfficiency()
                 + creature2RoomAffinity.getEfficiency();
-        if(Random::Double(0, totalWinPercent) <= creature1RoomAffinity.getEfficiency())
+        if(Random::getStream(Random::Subsystem::room).Double(0, totalWinPercent) <= creature1RoomAffinity.getEfficiency())
         {
             setCreatureWinning(*p.second.mCreature1.mCreature, ro->getPosition());
             setCreatureLoosing(*p.second.mCreature2.mCreature, ro->getPosition());
@@ -479,7 +479,7 @@ bool RoomCasino::useRoom(Creature& creature, bool forced)
         Creature* opponent = opponentInfo->mCreature;
         creature.popAction();
         // We randomly engage the creature we are playing with if any
-        if((opponent != nullptr) && (Random::Uint(0,100) <= 50))
+        if((opponent != nullptr) && (Random::getStream(Random::Subsystem::room).Uint(0,100) <= 50))
         {
             // We fight for KO
             // We notify the player that his own creatures are fighting
@@ -509,7 +509,7 @@ bool RoomCasino::useRoom(Creature& creature, bool forced)
     if(Pathfinding::squaredDistance(creature.getPosition().x, wantedX, creature.getPosition().y, wantedY) > 0.4)
     {
         // We go there
-        std::list<Tile*> pathToSpot = getGameMap()->path(&creature, tileSpot);
+        std::vector<Tile*> pathToSpot = getGameMap()->path(&creature, tileSpot);
         std::vector<Ogre::Vector3> path;
         Creature::tileToVector3(pathToSpot, path, true, 0.0);
         // We add the last step to take account of the offset
@@ -529,7 +529,7 @@ bool RoomCasino::useRoom(Creature& creature, bool forced)
             return false;
         }
 
-        uint32_t index = Random::Uint(0, tiles.size() - 1);
+        uint32_t index = Random::getStream(Random::Subsystem::room).Uint(0, tiles.size() - 1);
         Tile* tile = tiles[index];
         creature.setDestination(tile);
         creatureInfo->mIsReady = false;
@@ -74,7 +74,7 @@ protected:
 private:
     void setCreatureWinning(Creature& creature, const Ogre::Vector3& gamePosition);
     void setCreatureLoosing(Creature& creature, const Ogre::Vector3& gamePosition);
-    std::map<Tile*,RoomCasinoGame> mCreaturesSpots;
+    std::map<Tile*,RoomCasinoGame,TilePositionLess> mCreaturesSpots;
 };
 
 #endif // ROOMCASINO_H
@@ -126,7 +126,7 @@ BuildingObject* RoomCrypt::notifyActiveSpotCreated(ActiveSpotPlace place, Tile*
         case ActiveSpotPlace::activeSpotCenter:
         {
             mRottingCreatures[tile] = std::pair<Creature*,int32_t>(nullptr, -1);
-            int rnd = Random::Int(0, 100);
+            int rnd = Random::getStream(Random::Subsystem::room).Int(0, 100);
             if (rnd < 33)
                 return new BuildingObject(getGameMap(), *this, "KnightCoffin", *tile, 0.0, false);
             else if (rnd < 66)
@@ -200,7 +200,7 @@ void RoomCrypt::doUpkeep()
     // Each central active spot has a probability to spawn a spider
     for(Tile* tile : mCentralActiveSpotTiles)
     {
-        if(Random::Int(1, 10) > 1)
+        if(Random::getStream(Random::Subsystem::room).Int(1, 10) > 1)
             continue;
 
         SmallSpiderEntity* spider = new SmallSpiderEntity(getGameMap(), getName(), 10);
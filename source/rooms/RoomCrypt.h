@@ -49,7 +49,7 @@ protected:
     virtual BuildingObject* notifyActiveSpotCreated(ActiveSpotPlace place, Tile* tile) override;
     virtual void notifyActiveSpotRemoved(ActiveSpotPlace place, Tile* tile) override;
 private:
-    std::map<Tile*,std::pair<Creature*, int32_t> > mRottingCreatures;
+    std::map<Tile*,std::pair<Creature*, int32_t>,TilePositionLess> mRottingCreatures;
     int32_t mRottenPoints;
 };
 
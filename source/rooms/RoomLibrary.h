@@ -78,7 +78,7 @@ private:
     void getCreatureWantedPos(Creature* creature, Tile* tileSpot,
         Ogre::Real& wantedX, Ogre::Real& wantedY);
     std::vector<Tile*> mUnusedSpots;
-    std::map<Creature*,Tile*> mCreaturesSpots;
+    std::map<Creature*,Tile*,CreatureNameLess> mCreaturesSpots;
     int32_t mSkillPoints;
 };
 
@@ -34,6 +34,8 @@
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 
+#include <algorithm>
+
 static const std::string EMPTY_STRING;
 
 
@@ -552,7 +554,9 @@ void RoomManager::sellRoomTiles(GameMap* gameMap, Player* player, ODPacket& pack
     uint32_t nbTiles;
     OD_ASSERT_TRUE(packet >> nbTiles);
     int32_t price = 0;
-    std::set<Room*> rooms;
+    // The rooms are kept in the order of the tiles so that they are updated the same way whatever
+    // their address
+    std::vector<Room*> rooms;
     std::vector<Tile*> tiles;
     while(nbTiles > 0)
     {
@@ -578,7 +582,8 @@ void RoomManager::sellRoomTiles(GameMap* gameMap, Player* player, ODPacket& pack
 
         price += costPerTile(room->getType()) / 2;
         tiles.push_back(tile);
-        rooms.insert(room);
+        if(std::find(rooms.begin(), rooms.end(), room) == rooms.end())
+            rooms.push_back(room);
     }
 
     gameMap->addGoldToSeat(price, player->getSeat()->getId());
@@ -684,7 +689,9 @@ void RoomManager::sellRoomTilesEditor(GameMap* gameMap, ODPacket& packet)
 {
     uint32_t nbTiles;
     OD_ASSERT_TRUE(packet >> nbTiles);
-    std::set<Room*> rooms;
+    // The rooms are kept in the order of the tiles so that they are updated the same way whatever
+    // their address
+    std::vector<Room*> rooms;
     std::vector<Tile*> tiles;
     while(nbTiles > 0)
     {
@@ -706,7 +713,8 @@ void RoomManager::sellRoomTilesEditor(GameMap* gameMap, ODPacket& packet)
         }
 
         tiles.push_back(tile);
-        rooms.insert(room);
+        if(std::find(rooms.begin(), rooms.end(), room) == rooms.end())
+            rooms.push_back(room);
     }
 
     // We notify the clients with vision of the changed tiles. Note that we need
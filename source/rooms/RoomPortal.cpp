@@ -216,7 +216,7 @@ void RoomPortal::doUpkeep()
         --mSpawnCreatureCountdown;
         return;
     }
-    mSpawnCreatureCountdown = Random::Uint(ConfigManager::getSingleton().getRoomConfigUInt32("PortalCooldownSpawnMin"),
+    mSpawnCreatureCountdown = Random::getStream(Random::Subsystem::room).Uint(ConfigManager::getSingleton().getRoomConfigUInt32("PortalCooldownSpawnMin"),
         ConfigManager::getSingleton().getRoomConfigUInt32("PortalCooldownSpawnMax"));
 
     if (mCoveredTiles.empty())
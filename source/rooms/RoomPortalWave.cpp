@@ -274,7 +274,7 @@ void RoomPortalWave::doUpkeep()
         --mSearchFoeCountdown;
     else
     {
-        mSearchFoeCountdown = Random::Uint(10, 20);
+        mSearchFoeCountdown = Random::getStream(Random::Subsystem::room).Uint(10, 20);
 
         handleAttack();
     }
@@ -304,7 +304,7 @@ void RoomPortalWave::handleChooseTarget()
         {
             case RoomPortalWaveStrategy::randomPlayer:
             {
-                uint32_t kk = Random::Uint(0, mAttackableSeats.size() - 1);
+                uint32_t kk = Random::getStream(Random::Subsystem::room).Uint(0, mAttackableSeats.size() - 1);
                 mTargetSeats.clear();
                 Seat* attackedSeat = mAttackableSeats[kk];
                 OD_LOG_INF("PortalWave=" + getName() + ", attacking seatId=" + Helper::toString(attackedSeat->getId()));
@@ -477,7 +477,7 @@ void RoomPortalWave::handleSpawnWave()
         return;
 
     // Randomly choose a wave to spawn
-    uint32_t index = Random::Uint(0, mRoomPortalWaveDataSpawnable.size() - 1);
+    uint32_t index = Random::getStream(Random::Subsystem::room).Uint(0, mRoomPortalWaveDataSpawnable.size() - 1);
     spawnWave(mRoomPortalWaveDataSpawnable[index], maxCreatures - numCreatures);
 }
 
@@ -720,7 +720,7 @@ bool RoomPortalWave::handleSearchFoe()
         return false;
 
     // We randomly pick a creature to test for path
-    uint32_t index = Random::Uint(0, creatures.size() - 1);
+    uint32_t index = Random::getStream(Random::Subsystem::room).Uint(0, creatures.size() - 1);
     Creature* creature = creatures[index];
 
     std::vector<Room*> dungeonTemples = getGameMap()->getRoomsByType(RoomType::dungeonTemple);
@@ -437,7 +437,7 @@ bool RoomPrison::isInContainment(Creature& creature)
 
 bool RoomPrison::useRoom(Creature& creature, bool forced)
 {
-    if(Random::Uint(1, 4) > 1)
+    if(Random::getStream(Random::Subsystem::room).Uint(1, 4) > 1)
         return false;
 
     Tile* creatureTile = creature.getPositionTile();
@@ -459,14 +459,14 @@ bool RoomPrison::useRoom(Creature& creature, bool forced)
     if(availableTiles.empty())
         return false;
 
-    uint32_t index = Random::Uint(0, availableTiles.size() - 1);
+    uint32_t index = Random::getStream(Random::Subsystem::room).Uint(0, availableTiles.size() - 1);
     Tile* tileDest = availableTiles[index];
     Ogre::Vector3 v (static_cast<Ogre::Real>(tileDest->getX()), static_cast<Ogre::Real>(tileDest->getY()), 0.0);
     std::vector<Ogre::Vector3> path;
     path.push_back(v);
     creature.setWalkPath(EntityAnimation::flee_anim, EntityAnimation::idle_anim, true, true, path,true);
 
-    uint32_t nbTurns = Random::Uint(3, 6);
+    uint32_t nbTurns = Random::getStream(Random::Subsystem::room).Uint(3, 6);
     creature.setJobCooldown(nbTurns);
 
     return false;
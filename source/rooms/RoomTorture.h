@@ -73,7 +73,7 @@ protected:
     bool importFromStream(std::istream& is) override;
 
 private:
-    std::map<Tile*,RoomTortureCreatureInfo> mCreaturesSpots;
+    std::map<Tile*,RoomTortureCreatureInfo,TilePositionLess> mCreaturesSpots;
     std::vector<std::string> mPrisonersLoad;
 };
 
@@ -50,7 +50,7 @@ private:
     int32_t nbTurnsNoChangeDummies;
     void refreshCreaturesDummies();
     std::vector<Tile*> mUnusedDummies;
-    std::map<Creature*,Tile*> mCreaturesDummies;
+    std::map<Creature*,Tile*,CreatureNameLess> mCreaturesDummies;
 };
 
 #endif // ROOMTRAININGHALL_H
@@ -412,9 +412,9 @@ void RoomTreasury::updateMeshesForTile(Tile* tile, RoomTreasuryTileData* roomTre
         double posX = static_cast<double>(tile->getX());
         double posY = static_cast<double>(tile->getY());
         double posZ = 0;
-        posX += Random::Double(-offset, offset);
-        posY += Random::Double(-offset, offset);
-        double angle = Random::Double(0.0, 360);
+        posX += Random::getStream(Random::Subsystem::room).Double(-offset, offset);
+        posY += Random::getStream(Random::Subsystem::room).Double(-offset, offset);
+        double angle = Random::getStream(Random::Subsystem::room).Double(0.0, 360);
         BuildingObject* ro = new BuildingObject(getGameMap(), *this, newMeshName, tile, posX, posY, posZ, angle, false);
         addBuildingObject(tile, ro);
     }
@@ -137,7 +137,7 @@ BuildingObject* RoomWorkshop::notifyActiveSpotCreated(ActiveSpotPlace place, Til
             Ogre::Real y = static_cast<Ogre::Real>(tile->getY()) + Y_OFFSET_SPOT;
             Ogre::Real z = 0;
             mUnusedSpots.push_back(tile);
-            int result = Random::Int(0, 3);
+            int result = Random::getStream(Random::Subsystem::room).Int(0, 3);
             if(result < 2)
                 return new BuildingObject(getGameMap(), *this, "WorkshopMachine1", tile, x, y, z, 30.0, false);
             else
@@ -236,7 +236,7 @@ bool RoomWorkshop::addCreatureUsingRoom(Creature* creature)
     if(!Room::addCreatureUsingRoom(creature))
         return false;
 
-    int index = Random::Int(0, mUnusedSpots.size() - 1);
+    int index = Random::getStream(Random::Subsystem::room).Int(0, mUnusedSpots.size() - 1);
     Tile* tileSpot = mUnusedSpots[index];
     mUnusedSpots.erase(mUnusedSpots.begin() + index);
     mCreaturesSpots[creature] = tileSpot;
@@ -248,7 +248,7 @@ bool RoomWorkshop::addCreatureUsingRoom(Creature* creature)
        creaturePosition.y != wantedY)
     {
         // We move to the good tile
-        std::list<Tile*> pathToSpot = getGameMap()->path(creature, tileSpot);
+        std::vector<Tile*> pathToSpot = getGameMap()->path(creature, tileSpot);
         if(pathToSpot.empty())
         {
             OD_LOG_ERR("unexpected empty pathToSpot");
@@ -357,7 +357,7 @@ void RoomWorkshop::doUpkeep()
             // We randomly pickup the trap to craft if any
             if(!trapsToCraft.empty())
             {
-                uint32_t index = Random::Uint(0, trapsToCraft.size() - 1);
+                uint32_t index = Random::getStream(Random::Subsystem::room).Uint(0, trapsToCraft.size() - 1);
                 mTrapType = trapsToCraft[index];
             }
         }
@@ -473,7 +473,7 @@ bool RoomWorkshop::useRoom(Creature& creature, bool forced)
 
     mPoints += static_cast<int32_t>(creatureRoomAffinity.getEfficiency() * ConfigManager::getSingleton().getRoomConfigDouble("WorkshopPointsPerWork"));
     creature.jobDone(ConfigManager::getSingleton().getRoomConfigDouble("WorkshopWakefulnessPerWork"));
-    creature.setJobCooldown(Random::Uint(ConfigManager::getSingleton().getRoomConfigUInt32("WorkshopCooldownWorkMin"),
+    creature.setJobCooldown(Random::getStream(Random::Subsystem::room).Uint(ConfigManager::getSingleton().getRoomConfigUInt32("WorkshopCooldownWorkMin"),
         ConfigManager::getSingleton().getRoomConfigUInt32("WorkshopCooldownWorkMax")));
 
     return false;
@@ -215,7 +215,7 @@ void SoundEffectsManager::playSpatialSound(const std::string& family,
         return;
     }
 
-    unsigned int soundId = Random::Uint(0, sounds.size() - 1);
+    unsigned int soundId = Random::getStream(Random::Subsystem::client).Uint(0, sounds.size() - 1);
     sounds[soundId]->play(XPos, YPos, height);
 }
 
@@ -240,7 +240,7 @@ void SoundEffectsManager::playRelativeSound(const std::string& family)
     if(sounds.empty())
         return;
 
-    unsigned int soundId = Random::Uint(0, sounds.size() - 1);
+    unsigned int soundId = Random::getStream(Random::Subsystem::client).Uint(0, sounds.size() - 1);
     GameSound* sound = sounds[soundId];
     if(mRelativeSoundQueue.empty())
         sound->play();
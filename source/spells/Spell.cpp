@@ -86,6 +86,7 @@ void Spell::removeFromGameMap()
         return;
 
     fireRemoveEntityToSeatsWithVision();
+    getGameMap()->getVisionMap().clearVision(mVisionContribution);
 
     getGameMap()->removeActiveObject(this);
 }
@@ -195,7 +196,8 @@ void Spell::fireSpellSound(Tile& tile, const std::string& soundFamily)
 
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::playSpatialSound, seat->getPlayer());
-        serverNotification->mPacket << sound << tile.getX() << tile.getY();
+        uint32_t soundId = ODServer::getSingleton().internString(sound);
+        serverNotification->mPacket << soundId << tile.getX() << tile.getY();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -19,6 +19,7 @@
 #define SPELL_H
 
 #include "entities/RenderedMovableEntity.h"
+#include "gamemap/VisionMap.h"
 
 class GameMap;
 class ODPacket;
@@ -55,7 +56,7 @@ public:
 
     virtual void doUpkeep() override;
 
-    //! \brief Computes the visible tiles and tags them to know which are visible
+    //! \brief Updates the tiles this spell gives vision on (in mVisionContribution)
     virtual void computeVisibleTiles()
     {}
 
@@ -72,6 +73,9 @@ protected:
 
     static std::string formatCastSpell(SpellType type, uint32_t price);
 
+    //! \brief Tiles this spell gives vision on. Cleared when the spell is removed from the gamemap
+    VisionMap::Contribution mVisionContribution;
+
 private:
     //! \brief Number of turns the spell should be displayed before automatic deletion.
     //! If < 0, the Spell will not be removed automatically
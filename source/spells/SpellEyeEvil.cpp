@@ -90,9 +90,14 @@ void SpellEyeEvil::computeVisibleTiles()
         return;
     }
 
-    std::vector<Tile*> tiles = getGameMap()->circularRegion(posTile->getX(), posTile->getY(), radius);
-    for(Tile* tile : tiles)
-        tile->notifyVision(getSeat());
+    // The spell does not move. The region is only computed again if the contribution is outdated
+    VisionMap& visionMap = getGameMap()->getVisionMap();
+    int radiusTiles = static_cast<int>(radius);
+    if(!visionMap.needsUpdate(mVisionContribution, getSeat(), posTile, radiusTiles))
+        return;
+
+    std::vector<Tile*> tiles = getGameMap()->circularRegion(posTile->getX(), posTile->getY(), radiusTiles);
+    visionMap.setVision(mVisionContribution, getSeat(), posTile, radiusTiles, tiles);
 }
 
 void SpellEyeEvil::checkSpellCast(GameMap* gameMap, const InputManager& inputManager, InputCommand& inputCommand)
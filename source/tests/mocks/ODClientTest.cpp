@@ -35,11 +35,15 @@ static const std::string OD_VERSION_STR = "undefined";
 
 ODClientTest::ODClientTest(const std::vector<PlayerInfo>& players, uint32_t indexLocalPlayer) :
     mTurnNum(0),
+    mNbPacketsLastTurn(0),
+    mNbBytesLastTurn(0),
     mContinueLoop(true),
     mIsActivated(false),
     mIsGameModeStarted(false),
     mPlayers(players),
-    mLocalPlayerIndex(indexLocalPlayer)
+    mLocalPlayerIndex(indexLocalPlayer),
+    mNbPacketsReceivedTurnStart(0),
+    mNbBytesReceivedTurnStart(0)
 {
     BOOST_CHECK(!players.empty());
     BOOST_CHECK(indexLocalPlayer < mPlayers.size());
@@ -66,10 +70,11 @@ bool ODClientTest::connect(const std::string& host, const int port, uint32_t tim
             return false;
     }
 
-    // Send a hello request to start the conversation with the server
+    // Send a hello request to start the conversation with the server. We can read compressed packets
+    bool isCompressionSupported = true;
     ODPacket packSend;
     packSend << ClientNotificationType::hello
-        << std::string("OpenDungeons V ") + OD_VERSION_STR;
+        << std::string("OpenDungeons V ") + OD_VERSION_STR << isCompressionSupported;
     send(packSend);
 
     return true;
@@ -88,6 +93,12 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
     OD_LOG_INF("ServerNotificationType=" + ServerNotification::typeString(cmd));
     switch(cmd)
     {
+        case ServerNotificationType::enableCompression:
+        {
+            enableDecompression();
+            return true;
+        }
+
         case ServerNotificationType::loadLevel:
         {
             std::string odVersion;
@@ -381,6 +392,12 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
             BOOST_CHECK(mIsGameModeStarted);
             BOOST_CHECK(packetReceived >> mTurnNum);
             OD_LOG_INF("turnNum=" + Helper::toString(mTurnNum));
+            mNbPacketsLastTurn = getNbPacketsReceived() - mNbPacketsReceivedTurnStart;
+            mNbBytesLastTurn = getNbBytesReceived() - mNbBytesReceivedTurnStart;
+            mNbPacketsReceivedTurnStart = getNbPacketsReceived();
+            mNbBytesReceivedTurnStart = getNbBytesReceived();
+            OD_LOG_INF("Received during last turn packets=" + Helper::toString(mNbPacketsLastTurn)
+                + ", bytes=" + Helper::toString(mNbBytesLastTurn));
             handleTurnStarted(mTurnNum);
 
             ODPacket packSend;
@@ -402,8 +419,9 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
             bool playIdleWhenAnimationEnds;
             bool shouldSetWalkDirection;
             Ogre::Vector3 walkDirection(0, 0, 0);
-            BOOST_CHECK(packetReceived >> entityName >> animState
-                >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
+            BOOST_CHECK(readInternedString(packetReceived, entityName));
+            BOOST_CHECK(readInternedString(packetReceived, animState));
+            BOOST_CHECK(packetReceived >> loop >> playIdleWhenAnimationEnds >> shouldSetWalkDirection);
 
             if(shouldSetWalkDirection)
             {
@@ -418,17 +436,23 @@ bool ODClientTest::processMessage(ServerNotificationType cmd, ODPacket& packetRe
             std::string entityName;
             std::string walkAnim;
             std::string endAnim;
+            bool walkDistortion;
             bool loopEndAnim;
             bool playIdleWhenAnimationEnds;
             uint32_t nbDest;
-            BOOST_CHECK(packetReceived >> entityName >> walkAnim >> endAnim);
+            BOOST_CHECK(packetReceived >> walkDistortion);
+            BOOST_CHECK(readInternedString(packetReceived, entityName));
+            BOOST_CHECK(readInternedString(packetReceived, walkAnim));
+            BOOST_CHECK(readInternedString(packetReceived, endAnim));
             BOOST_CHECK(packetReceived >> loopEndAnim >> playIdleWhenAnimationEnds >> nbDest);
             std::vector<Ogre::Vector3> path;
+            Ogre::Vector3 previous = Ogre::Vector3::ZERO;
             while(nbDest)
             {
                 --nbDest;
                 Ogre::Vector3 dest;
-                BOOST_CHECK(packetReceived >> dest);
+                BOOST_CHECK(packetReceived.readPositionDelta(dest, previous));
+                previous = dest;
                 path.push_back(dest);
             }
 
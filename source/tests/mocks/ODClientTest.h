@@ -69,6 +69,10 @@ public:
     // Allows to check that the server correctly launched and sent new turns
     int64_t mTurnNum;
 
+    //! \brief Packets (that is socket reads) and bytes received between the 2 last turns
+    uint64_t mNbPacketsLastTurn;
+    uint64_t mNbBytesLastTurn;
+
 protected:
     bool processMessage(ServerNotificationType cmd, ODPacket& packetReceived) override;
     virtual void handleTurnStarted(int64_t turnNum)
@@ -90,6 +94,8 @@ private:
     std::vector<PlayerInfo> mPlayers;
     std::vector<SeatData*> mSeats;
     uint32_t mLocalPlayerIndex;
+    uint64_t mNbPacketsReceivedTurnStart;
+    uint64_t mNbBytesReceivedTurnStart;
 };
 
 #endif // ODCLIENTTEST_H
@@ -21,6 +21,8 @@
 #include "utils/LogManager.h"
 #include "utils/LogSinkConsole.h"
 
+#include <algorithm>
+
 #define BOOST_TEST_MODULE TestCreatures
 #include <BoostTestTargetConfig.h>
 
@@ -29,13 +31,36 @@ class ODClientTestCreatures : public ODClientTest
 public:
     ODClientTestCreatures(const std::vector<PlayerInfo>& players, uint32_t indexLocalPlayer) :
         ODClientTest(players, indexLocalPlayer),
-        mResultTest(false)
+        mResultTest(false),
+        mIsRecordingTurns(false),
+        mNbRecordedTurns(0),
+        mNbRecordedPackets(0),
+        mNbRecordedBytes(0),
+        mMaxBytesPerTurn(0)
     {}
 
     std::string mAwaitedEntityName;
     std::string mAwaitedEntityAnimation;
     bool mResultTest;
 
+    //! \brief Packets (socket reads) and bytes received during the turns started while mIsRecordingTurns is set
+    bool mIsRecordingTurns;
+    uint64_t mNbRecordedTurns;
+    uint64_t mNbRecordedPackets;
+    uint64_t mNbRecordedBytes;
+    uint64_t mMaxBytesPerTurn;
+
+    virtual void handleTurnStarted(int64_t turnNum) override
+    {
+        if(!mIsRecordingTurns)
+            return;
+
+        ++mNbRecordedTurns;
+        mNbRecordedPackets += mNbPacketsLastTurn;
+        mNbRecordedBytes += mNbBytesLastTurn;
+        mMaxBytesPerTurn = std::max(mMaxBytesPerTurn, mNbBytesLastTurn);
+    }
+
     virtual void animationPlayed(const std::string& entityName, const std::string& animState, bool loop,
         bool playIdleWhenAnimationEnds, bool shouldSetWalkDirection, const Ogre::Vector3& walkDirection) override
     {
@@ -145,10 +170,23 @@ BOOST_AUTO_TEST_CASE(test_Creatures)
     client.mResultTest = false;
     client.mAwaitedEntityName = "Wyvern3";
     client.mAwaitedEntityAnimation = "Attack1";
+    client.mIsRecordingTurns = true;
     client.runFor(5000);
+    client.mIsRecordingTurns = false;
 
     BOOST_CHECK(client.mResultTest);
 
+    // The notifications of a turn are sent in 1 batch. Only some asynchronous messages (like the
+    // console command answers) are sent on their own
+    BOOST_REQUIRE(client.mNbRecordedTurns > 0);
+    double packetsPerTurn = static_cast<double>(client.mNbRecordedPackets) / static_cast<double>(client.mNbRecordedTurns);
+    double bytesPerTurn = static_cast<double>(client.mNbRecordedBytes) / static_cast<double>(client.mNbRecordedTurns);
+    OD_LOG_INF("While fighting, turns=" + Helper::toString(client.mNbRecordedTurns)
+        + ", packets/turn=" + Helper::toString(packetsPerTurn)
+        + ", bytes/turn=" + Helper::toString(bytesPerTurn)
+        + ", max bytes/turn=" + Helper::toString(client.mMaxBytesPerTurn));
+    BOOST_CHECK(packetsPerTurn <= 2.0);
+
     // We expect to have reached at least turn 10
     OD_LOG_INF("turnNum=" + Helper::toString(client.mTurnNum));
     BOOST_CHECK(client.mTurnNum > 0);
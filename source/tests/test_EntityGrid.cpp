@@ -0,0 +1,96 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE EntityGrid
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/EntityGrid.h"
+
+// EntityGrid only stores pointers so we do not need the real GameEntity
+class GameEntity
+{
+public:
+    GameEntity(int team) :
+        mTeam(team)
+    {}
+
+    int mTeam;
+};
+
+static bool hasTeamInArea(const EntityGrid& grid, int team, int xMin, int yMin, int xMax, int yMax, bool withBuildings)
+{
+    return grid.anyInArea(xMin, yMin, xMax, yMax, withBuildings, [team](GameEntity* entity)
+        {
+            return entity->mTeam == team;
+        });
+}
+
+BOOST_AUTO_TEST_CASE(test_EntityGridCreatures)
+{
+    EntityGrid grid;
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 0, 0, 10, 10, true));
+
+    grid.reset(50, 30);
+    GameEntity creature1(1);
+    GameEntity creature2(2);
+    grid.addCreature(&creature1, 5, 5);
+    grid.addCreature(&creature2, 40, 25);
+
+    BOOST_CHECK(hasTeamInArea(grid, 1, 0, 0, 7, 7, false));
+    BOOST_CHECK(!hasTeamInArea(grid, 2, 0, 0, 7, 7, false));
+    BOOST_CHECK(hasTeamInArea(grid, 2, 30, 20, 60, 40, false));
+    // Areas out of the map are clamped
+    BOOST_CHECK(hasTeamInArea(grid, 1, -10, -10, 100, 100, false));
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 20, 0, 60, 40, false));
+
+    // Moving a creature
+    grid.removeCreature(&creature1, 5, 5);
+    grid.addCreature(&creature1, 30, 5);
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 0, 0, 7, 7, false));
+    BOOST_CHECK(hasTeamInArea(grid, 1, 28, 0, 35, 10, false));
+
+    // The team is checked when querying so changing it is taken into account
+    creature1.mTeam = 2;
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 28, 0, 35, 10, false));
+    BOOST_CHECK(hasTeamInArea(grid, 2, 28, 0, 35, 10, false));
+
+    grid.removeCreature(&creature1, 30, 5);
+    grid.removeCreature(&creature2, 40, 25);
+    BOOST_CHECK(!hasTeamInArea(grid, 2, 0, 0, 50, 30, true));
+}
+
+BOOST_AUTO_TEST_CASE(test_EntityGridBuildings)
+{
+    EntityGrid grid;
+    grid.reset(32, 32);
+    GameEntity building(1);
+
+    // A building covering 2 tiles in the same bucket is still there while one tile is covered
+    grid.addBuildingTile(&building, 10, 10);
+    grid.addBuildingTile(&building, 11, 10);
+    BOOST_CHECK(hasTeamInArea(grid, 1, 8, 8, 12, 12, true));
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 8, 8, 12, 12, false));
+
+    grid.removeBuildingTile(&building, 10, 10);
+    BOOST_CHECK(hasTeamInArea(grid, 1, 8, 8, 12, 12, true));
+    grid.removeBuildingTile(&building, 11, 10);
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 0, 0, 31, 31, true));
+
+    // Tiles out of the map are ignored
+    grid.addBuildingTile(&building, 40, 10);
+    BOOST_CHECK(!hasTeamInArea(grid, 1, 0, 0, 31, 31, true));
+}
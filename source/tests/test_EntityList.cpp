@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE EntityList
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/EntityList.h"
+
+#include <algorithm>
+
+//! \brief Minimal entity storing its list positions like GameEntity does
+class TestEntity
+{
+public:
+    TestEntity(int id = 0) :
+        mId(id)
+    {
+        for(uint32_t& position : mPositions)
+            position = EntityList<TestEntity>::INVALID_POSITION;
+    }
+
+    inline uint32_t getEntityListPosition(EntityListType type) const
+    { return mPositions[static_cast<uint32_t>(type)]; }
+
+    inline void setEntityListPosition(EntityListType type, uint32_t position)
+    { mPositions[static_cast<uint32_t>(type)] = position; }
+
+    int mId;
+
+private:
+    uint32_t mPositions[static_cast<uint32_t>(EntityListType::nbTypes)];
+};
+
+static std::vector<int> getIds(const EntityList<TestEntity>& list)
+{
+    std::vector<int> ids;
+    for(TestEntity* entity : list)
+        ids.push_back(entity->mId);
+    return ids;
+}
+
+BOOST_AUTO_TEST_CASE(test_EntityListAddRemove)
+{
+    TestEntity entities[5] = { 0, 1, 2, 3, 4 };
+    EntityList<TestEntity> list(EntityListType::active);
+    EntityList<TestEntity> otherList(EntityListType::animated);
+
+    for(TestEntity& entity : entities)
+    {
+        BOOST_CHECK(list.add(&entity));
+        BOOST_CHECK(otherList.add(&entity));
+    }
+    BOOST_CHECK(!list.add(&entities[2]));
+    BOOST_CHECK(list.size() == 5);
+
+    // The removed entity is replaced by the last one
+    BOOST_CHECK(list.remove(&entities[1]));
+    BOOST_CHECK(!list.remove(&entities[1]));
+    BOOST_CHECK(!list.contains(&entities[1]));
+    BOOST_CHECK(getIds(list) == std::vector<int>({ 0, 4, 2, 3 }));
+
+    BOOST_CHECK(list.remove(&entities[3]));
+    BOOST_CHECK(getIds(list) == std::vector<int>({ 0, 4, 2 }));
+    BOOST_CHECK(list.size() == 3);
+    for(TestEntity* entity : list)
+        BOOST_CHECK(list.contains(entity));
+
+    // Lists of different types do not interfere
+    BOOST_CHECK(getIds(otherList) == std::vector<int>({ 0, 1, 2, 3, 4 }));
+    BOOST_CHECK(otherList.contains(&entities[1]));
+
+    list.clear();
+    BOOST_CHECK(list.empty());
+    BOOST_CHECK(!list.contains(&entities[0]));
+    BOOST_CHECK(list.add(&entities[0]));
+}
+
+BOOST_AUTO_TEST_CASE(test_EntityListForEach)
+{
+    TestEntity entities[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    TestEntity added(8);
+    EntityList<TestEntity> list(EntityListType::active);
+    for(uint32_t i = 0; i < 6; ++i)
+        list.add(&entities[i]);
+
+    // Entity 1 removes itself, entity 2 removes entity 5 (not iterated yet) and entity 0 (already
+    // iterated), entity 3 adds a new entity (not iterated) and entity 4 removes it and adds another one
+    std::vector<int> iterated;
+    list.forEach([&](TestEntity* entity)
+    {
+        iterated.push_back(entity->mId);
+        switch(entity->mId)
+        {
+            case 1:
+                list.remove(entity);
+                break;
+            case 2:
+                list.remove(&entities[5]);
+                list.remove(&entities[0]);
+                break;
+            case 3:
+                list.add(&added);
+                break;
+            case 4:
+                list.remove(&added);
+                list.add(&entities[6]);
+                break;
+            default:
+                break;
+        }
+    });
+
+    BOOST_CHECK(iterated == std::vector<int>({ 0, 1, 2, 3, 4 }));
+    BOOST_CHECK(list.size() == 4);
+    // The holes left during the iteration have been filled
+    BOOST_CHECK(list.getEntities().size() == 4);
+    std::vector<int> ids = getIds(list);
+    std::sort(ids.begin(), ids.end());
+    BOOST_CHECK(ids == std::vector<int>({ 2, 3, 4, 6 }));
+    for(TestEntity* entity : list)
+        BOOST_CHECK(list.contains(entity));
+
+    // Same sequence, same order
+    EntityList<TestEntity> list2(EntityListType::animated);
+    for(uint32_t i = 0; i < 6; ++i)
+        list2.add(&entities[i]);
+    list2.forEach([&](TestEntity* entity)
+    {
+        if(entity->mId == 1)
+            list2.remove(entity);
+        else if(entity->mId == 2)
+        {
+            list2.remove(&entities[5]);
+            list2.remove(&entities[0]);
+        }
+        else if(entity->mId == 3)
+            list2.add(&added);
+        else if(entity->mId == 4)
+        {
+            list2.remove(&added);
+            list2.add(&entities[6]);
+        }
+    });
+    BOOST_CHECK(getIds(list2) == getIds(list));
+
+    // Nested iterations only compact at the end of the outer one
+    uint32_t nbInner = 0;
+    list.forEach([&](TestEntity* entity)
+    {
+        list.remove(entity);
+        list.forEach([&](TestEntity*)
+        {
+            ++nbInner;
+        });
+    });
+    BOOST_CHECK(nbInner == 3 + 2 + 1);
+    BOOST_CHECK(list.empty());
+    BOOST_CHECK(getIds(list).empty());
+}
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE EntityRegistry
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/EntityRegistry.h"
+
+// EntityRegistry only stores pointers so we do not need the real GameEntity
+class GameEntity
+{
+public:
+    int mDummy;
+};
+
+BOOST_AUTO_TEST_CASE(test_EntityRegistryHandles)
+{
+    EntityRegistry registry;
+    GameEntity entities[3];
+
+    BOOST_CHECK(registry.getEntity(EntityRegistry::INVALID_HANDLE) == nullptr);
+
+    uint32_t handle0 = registry.addHandle(&entities[0]);
+    uint32_t handle1 = registry.addHandle(&entities[1]);
+    BOOST_CHECK(handle0 != EntityRegistry::INVALID_HANDLE);
+    BOOST_CHECK(handle1 != EntityRegistry::INVALID_HANDLE);
+    BOOST_CHECK(handle0 != handle1);
+    BOOST_CHECK(registry.getEntity(handle0) == &entities[0]);
+    BOOST_CHECK(registry.getEntity(handle1) == &entities[1]);
+    BOOST_CHECK(registry.getNbHandles() == 2);
+
+    // The slot of a removed entity is reused but its old handle should not resolve anymore
+    BOOST_CHECK(registry.removeHandle(handle0));
+    BOOST_CHECK(registry.getEntity(handle0) == nullptr);
+    BOOST_CHECK(!registry.removeHandle(handle0));
+    uint32_t handle2 = registry.addHandle(&entities[2]);
+    BOOST_CHECK(handle2 != handle0);
+    BOOST_CHECK(registry.getEntity(handle0) == nullptr);
+    BOOST_CHECK(registry.getEntity(handle2) == &entities[2]);
+    BOOST_CHECK(registry.getEntity(handle1) == &entities[1]);
+    BOOST_CHECK(registry.getNbHandles() == 2);
+
+    // Many reuses of the same slot
+    for(uint32_t i = 0; i < 10000; ++i)
+    {
+        BOOST_CHECK(registry.removeHandle(handle2));
+        uint32_t handle = registry.addHandle(&entities[2]);
+        BOOST_CHECK(handle != EntityRegistry::INVALID_HANDLE);
+        BOOST_CHECK(handle != handle2);
+        BOOST_CHECK(registry.getEntity(handle2) == nullptr);
+        handle2 = handle;
+    }
+    BOOST_CHECK(registry.getEntity(handle2) == &entities[2]);
+}
+
+BOOST_AUTO_TEST_CASE(test_EntityRegistryNames)
+{
+    EntityRegistry registry;
+    GameEntity entities[3];
+
+    BOOST_CHECK(registry.addName(EntityIndex::creature, "Kobold1", &entities[0]));
+    BOOST_CHECK(registry.addName(EntityIndex::animatedObject, "Kobold1", &entities[0]));
+    BOOST_CHECK(registry.addName(EntityIndex::room, "Kobold1", &entities[1]));
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::creature, "Kobold1") == &entities[0]);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::animatedObject, "Kobold1") == &entities[0]);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::room, "Kobold1") == &entities[1]);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::trap, "Kobold1") == nullptr);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::creature, "Kobold2") == nullptr);
+
+    // Like the former linear search, the first entity added with a name is kept
+    BOOST_CHECK(!registry.addName(EntityIndex::creature, "Kobold1", &entities[2]));
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::creature, "Kobold1") == &entities[0]);
+    registry.removeName(EntityIndex::creature, "Kobold1", &entities[2]);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::creature, "Kobold1") == &entities[0]);
+
+    registry.removeName(EntityIndex::creature, "Kobold1", &entities[0]);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::creature, "Kobold1") == nullptr);
+    BOOST_CHECK(registry.getEntityByName(EntityIndex::animatedObject, "Kobold1") == &entities[0]);
+}
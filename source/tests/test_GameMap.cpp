@@ -0,0 +1,380 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ODApplication.h"
+#include "ai/KeeperAIType.h"
+#include "entities/Tile.h"
+#include "game/Player.h"
+#include "game/Seat.h"
+#include "gamemap/GameMap.h"
+#include "gamemap/StateChecksum.h"
+#include "gamemap/VisionMap.h"
+#include "network/ODServer.h"
+#include "utils/ConfigManager.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+#include "utils/Random.h"
+#include "utils/ResourceManager.h"
+#include "utils/ThreadPool.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE GameMap
+#include <BoostTestTargetConfig.h>
+
+//! \brief Creates what the server game map needs, like ODApplication::startServer does. As the
+//! server is not started, the notifications queued by the game code are dropped
+struct ServerFixture
+{
+    ServerFixture() :
+        mResourceManager(mOptions)
+    {
+        mLogManager.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+        Random::initialize(1);
+        mConfigManager.reset(new ConfigManager(mResourceManager.getConfigPath(), "", mResourceManager.getSoundPath()));
+        mServer.reset(new ODServer);
+    }
+
+    boost::program_options::variables_map mOptions;
+    ResourceManager mResourceManager;
+    LogManager mLogManager;
+    std::unique_ptr<ConfigManager> mConfigManager;
+    std::unique_ptr<ODServer> mServer;
+};
+
+BOOST_GLOBAL_FIXTURE(ServerFixture);
+
+/*! \brief Creates a map of full dirt tiles where the given tiles are dug, with the rogue seat and
+ * one seat for each given team id (seat ids start at 1). The seats are configured like when the
+ * game starts so that floodfill and vision are computed
+ */
+static void createMap(GameMap& gameMap, int sizeX, int sizeY, const std::vector<std::pair<int, int>>& dugTiles,
+    const std::vector<int>& teamIds)
+{
+    BOOST_REQUIRE(gameMap.createNewMap(sizeX, sizeY));
+    gameMap.disableFloodFill();
+    gameMap.setProperPositions();
+    gameMap.setAllFullnessAndNeighbors();
+    // The tiles are dug before the seats are added so that no floodfill is computed yet
+    for(const std::pair<int, int>& dugTile : dugTiles)
+        gameMap.getTile(dugTile.first, dugTile.second)->setFullness(0.0);
+
+    Seat* rogueSeat = Seat::createRogueSeat(&gameMap);
+    BOOST_REQUIRE(gameMap.addSeat(rogueSeat));
+    for(uint32_t i = 0; i < teamIds.size(); ++i)
+    {
+        Seat* seat = new Seat(&gameMap);
+        seat->setId(static_cast<int>(i) + 1);
+        seat->setTeamId(teamIds[i]);
+        BOOST_REQUIRE(gameMap.addSeat(seat));
+    }
+
+    gameMap.notifySeatsConfigured();
+    for(int yy = 0; yy < sizeY; ++yy)
+    {
+        for(int xx = 0; xx < sizeX; ++xx)
+            gameMap.getTile(xx, yy)->setSeats(gameMap.getSeats());
+    }
+}
+
+//! \brief Floodfill values of every tile for the given seat
+static std::vector<uint32_t> getFloodFillValues(GameMap& gameMap, Seat* seat)
+{
+    std::vector<uint32_t> values;
+    for(int yy = 0; yy < gameMap.getMapSizeY(); ++yy)
+    {
+        for(int xx = 0; xx < gameMap.getMapSizeX(); ++xx)
+        {
+            for(uint32_t i = 0; i < static_cast<uint32_t>(FloodFillType::nbValues); ++i)
+                values.push_back(gameMap.getTile(xx, yy)->getFloodFillValue(seat, static_cast<FloodFillType>(i)));
+        }
+    }
+    return values;
+}
+
+BOOST_AUTO_TEST_CASE(test_FloodFillPlanes)
+{
+    GameMap gameMap(true);
+    // A corridor from (1, 3) to (10, 3) with a door in the middle. Seats 2 and 4 are allied
+    std::vector<std::pair<int, int>> dugTiles;
+    for(int xx = 1; xx <= 10; ++xx)
+        dugTiles.push_back(std::make_pair(xx, 3));
+    createMap(gameMap, 12, 8, dugTiles, { 1, 2, 3, 2 });
+    Seat* seat1 = gameMap.getSeatById(1);
+    Seat* seat2 = gameMap.getSeatById(2);
+    Seat* seat3 = gameMap.getSeatById(3);
+    Seat* seat4 = gameMap.getSeatById(4);
+    Tile* door = gameMap.getTile(5, 3);
+    Tile* left = gameMap.getTile(1, 3);
+    Tile* right = gameMap.getTile(10, 3);
+
+    // Every team shares the same plane until a door is locked
+    BOOST_CHECK_EQUAL(gameMap.getFloodFillSeats().size(), 1);
+    for(Seat* seat : gameMap.getSeats())
+        BOOST_CHECK(left->isSameFloodFill(seat, FloodFillType::ground, right));
+
+    std::vector<uint32_t> valuesSeat2 = getFloodFillValues(gameMap, seat2);
+    std::vector<uint32_t> valuesSeat3 = getFloodFillValues(gameMap, seat3);
+
+    // Only the door team gets its own plane. The other teams keep sharing theirs, unchanged
+    gameMap.doorLock(door, seat1, true);
+    std::vector<Seat*> floodFillSeats = gameMap.getFloodFillSeats();
+    BOOST_CHECK_EQUAL(floodFillSeats.size(), 2);
+    BOOST_CHECK(std::find(floodFillSeats.begin(), floodFillSeats.end(), seat1) != floodFillSeats.end());
+    BOOST_CHECK(!left->isSameFloodFill(seat1, FloodFillType::ground, right));
+    BOOST_CHECK(left->isSameFloodFill(seat2, FloodFillType::ground, right));
+    BOOST_CHECK(left->isSameFloodFill(seat3, FloodFillType::ground, right));
+    BOOST_CHECK(left->isSameFloodFill(gameMap.getSeatRogue(), FloodFillType::ground, right));
+    BOOST_CHECK(getFloodFillValues(gameMap, seat2) == valuesSeat2);
+    BOOST_CHECK(getFloodFillValues(gameMap, seat3) == valuesSeat3);
+    BOOST_CHECK(getFloodFillValues(gameMap, seat4) == valuesSeat2);
+
+    // Digging updates both planes
+    gameMap.getTile(10, 4)->setFullness(0.0);
+    BOOST_CHECK(right->isSameFloodFill(seat1, FloodFillType::ground, gameMap.getTile(10, 4)));
+    BOOST_CHECK(right->isSameFloodFill(seat3, FloodFillType::ground, gameMap.getTile(10, 4)));
+    BOOST_CHECK(!left->isSameFloodFill(seat1, FloodFillType::ground, gameMap.getTile(10, 4)));
+    BOOST_CHECK(left->isSameFloodFill(seat3, FloodFillType::ground, gameMap.getTile(10, 4)));
+    valuesSeat3 = getFloodFillValues(gameMap, seat3);
+
+    // A door locked by allied seats blocks the whole team but not the other ones
+    gameMap.doorLock(door, seat2, true);
+    BOOST_CHECK_EQUAL(gameMap.getFloodFillSeats().size(), 3);
+    BOOST_CHECK(!left->isSameFloodFill(seat2, FloodFillType::ground, right));
+    BOOST_CHECK(!left->isSameFloodFill(seat4, FloodFillType::ground, right));
+    BOOST_CHECK(left->isSameFloodFill(seat3, FloodFillType::ground, right));
+    BOOST_CHECK(getFloodFillValues(gameMap, seat3) == valuesSeat3);
+    BOOST_CHECK(getFloodFillValues(gameMap, seat4) == getFloodFillValues(gameMap, seat2));
+
+    // Unlocking gives the connectivity back
+    gameMap.doorLock(door, seat1, false);
+    BOOST_CHECK(left->isSameFloodFill(seat1, FloodFillType::ground, right));
+    BOOST_CHECK(!left->isSameFloodFill(seat2, FloodFillType::ground, right));
+    BOOST_CHECK(getFloodFillValues(gameMap, seat3) == valuesSeat3);
+    gameMap.doorLock(door, seat2, false);
+    BOOST_CHECK(left->isSameFloodFill(seat2, FloodFillType::ground, right));
+    BOOST_CHECK(left->isSameFloodFill(seat4, FloodFillType::ground, right));
+    BOOST_CHECK(getFloodFillValues(gameMap, seat3) == valuesSeat3);
+}
+
+static bool hasVision(GameMap& gameMap, int x, int y, Seat* seat)
+{
+    const std::vector<Seat*>& seats = gameMap.getTile(x, y)->getSeatsWithVision();
+    return std::find(seats.begin(), seats.end(), seat) != seats.end();
+}
+
+BOOST_AUTO_TEST_CASE(test_VisionMap)
+{
+    GameMap gameMap(true);
+    // Seats 1 and 3 are allied
+    std::vector<std::pair<int, int>> dugTiles;
+    for(int yy = 1; yy <= 6; ++yy)
+    {
+        for(int xx = 1; xx <= 10; ++xx)
+            dugTiles.push_back(std::make_pair(xx, yy));
+    }
+    createMap(gameMap, 12, 8, dugTiles, { 1, 2, 1 });
+    Seat* seat1 = gameMap.getSeatById(1);
+    Seat* seat2 = gameMap.getSeatById(2);
+    Seat* seat3 = gameMap.getSeatById(3);
+    VisionMap& visionMap = gameMap.getVisionMap();
+    visionMap.update();
+    BOOST_CHECK(!hasVision(gameMap, 5, 5, seat1));
+
+    // Setting a contribution gives vision to the seat and its allies
+    VisionMap::Contribution contribution1;
+    Tile* center = gameMap.getTile(5, 5);
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat1, center, 1));
+    visionMap.setVision(contribution1, seat1, center, 1, { center, gameMap.getTile(5, 6), gameMap.getTile(6, 5) });
+    BOOST_CHECK(!visionMap.needsUpdate(contribution1, seat1, center, 1));
+    BOOST_CHECK(hasVision(gameMap, 5, 5, seat1));
+    BOOST_CHECK(hasVision(gameMap, 5, 6, seat1));
+    BOOST_CHECK(hasVision(gameMap, 6, 5, seat3));
+    BOOST_CHECK(!hasVision(gameMap, 5, 5, seat2));
+    BOOST_CHECK(!hasVision(gameMap, 7, 5, seat1));
+
+    // Moving it only keeps vision on the new tiles
+    center = gameMap.getTile(6, 5);
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat1, center, 1));
+    visionMap.setVision(contribution1, seat1, center, 1, { center, gameMap.getTile(7, 5) });
+    BOOST_CHECK(!hasVision(gameMap, 5, 5, seat1));
+    BOOST_CHECK(!hasVision(gameMap, 5, 6, seat3));
+    BOOST_CHECK(hasVision(gameMap, 6, 5, seat1));
+    BOOST_CHECK(hasVision(gameMap, 7, 5, seat1));
+
+    // Overlapping contributions from allied seats: a tile stays visible until every contribution is cleared
+    VisionMap::Contribution contribution2;
+    visionMap.setVision(contribution2, seat3, gameMap.getTile(8, 5), 1, { gameMap.getTile(7, 5), gameMap.getTile(8, 5) });
+    visionMap.clearVision(contribution1);
+    BOOST_CHECK(!hasVision(gameMap, 6, 5, seat1));
+    BOOST_CHECK(hasVision(gameMap, 7, 5, seat1));
+    BOOST_CHECK(hasVision(gameMap, 8, 5, seat1));
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat1, center, 1));
+    visionMap.clearVision(contribution2);
+    BOOST_CHECK(!hasVision(gameMap, 7, 5, seat1));
+    BOOST_CHECK(!hasVision(gameMap, 8, 5, seat3));
+
+    // Changing the seat of a contribution (for example when a creature is converted) moves the vision
+    center = gameMap.getTile(3, 3);
+    visionMap.setVision(contribution1, seat1, center, 1, { center, gameMap.getTile(3, 4) });
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat2, center, 1));
+    visionMap.setVision(contribution1, seat2, center, 1, { center, gameMap.getTile(3, 4) });
+    BOOST_CHECK(hasVision(gameMap, 3, 3, seat2));
+    BOOST_CHECK(hasVision(gameMap, 3, 4, seat2));
+    BOOST_CHECK(!hasVision(gameMap, 3, 3, seat1));
+    BOOST_CHECK(!hasVision(gameMap, 3, 4, seat3));
+    visionMap.clearVision(contribution1);
+    BOOST_CHECK(!hasVision(gameMap, 3, 3, seat2));
+
+    // A tile blocking vision within the radius forces the contribution to be cast again until the end of the turn
+    center = gameMap.getTile(4, 3);
+    Tile* farCenter = gameMap.getTile(9, 2);
+    visionMap.setVision(contribution1, seat1, center, 2, { center });
+    visionMap.setVision(contribution2, seat2, farCenter, 1, { farCenter });
+    visionMap.tileVisionChanged(*gameMap.getTile(6, 4));
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat1, center, 2));
+    BOOST_CHECK(!visionMap.needsUpdate(contribution2, seat2, farCenter, 1));
+    visionMap.endTurn();
+    BOOST_CHECK(!visionMap.needsUpdate(contribution1, seat1, center, 2));
+
+    // Digging a tile changes its vision too
+    gameMap.getTile(4, 0)->setFullness(0.0);
+    BOOST_CHECK(visionMap.needsUpdate(contribution1, seat1, center, 2));
+    BOOST_CHECK(!visionMap.needsUpdate(contribution2, seat2, farCenter, 1));
+    visionMap.endTurn();
+
+    visionMap.clearVision(contribution1);
+    visionMap.clearVision(contribution2);
+    BOOST_CHECK(!hasVision(gameMap, 4, 3, seat1));
+    BOOST_CHECK(!hasVision(gameMap, 9, 2, seat2));
+}
+
+/*! \brief Loads the given level and computes the given number of turns with the given number of upkeep
+ * threads, like od-simbench does: every seat is played by a normal keeper AI and the turns have a fixed
+ * length. Returns the state checksums of the last turn
+ */
+static StateChecksum computeTurns(const std::string& levelFilename, uint32_t nbThreads, uint32_t nbTurns)
+{
+    // Every run starts from the same random state
+    Random::initialize(1);
+
+    GameMap gameMap(true);
+    gameMap.setNbThreads(nbThreads);
+    BOOST_REQUIRE_EQUAL(gameMap.getThreadPool()->getNbThreads(), nbThreads);
+    gameMap.setLockstep(true);
+    BOOST_REQUIRE(gameMap.loadLevel(levelFilename));
+
+    const std::vector<std::string>& factions = ConfigManager::getSingleton().getFactions();
+    const std::vector<Seat*>& seats = gameMap.getSeats();
+    for(Seat* seat : seats)
+    {
+        if(seat->isRogueSeat())
+            continue;
+
+        if(std::find(factions.begin(), factions.end(), seat->getFaction()) == factions.end())
+            seat->setFaction(factions.front());
+
+        const std::vector<int>& availableTeamIds = seat->getAvailableTeamIds();
+        if(!availableTeamIds.empty())
+            seat->setTeamId(availableTeamIds.front());
+
+        Player* aiPlayer = new Player(&gameMap, 0);
+        gameMap.addPlayer(aiPlayer);
+        seat->setPlayer(aiPlayer);
+        gameMap.assignAI(*aiPlayer, KeeperAIType::normal);
+        seat->setMapSize(gameMap.getMapSizeX(), gameMap.getMapSizeY());
+    }
+
+    for(Seat* seat : seats)
+        seat->initSeat();
+
+    gameMap.notifySeatsConfigured();
+    for(int yy = 0; yy < gameMap.getMapSizeY(); ++yy)
+    {
+        for(int xx = 0; xx < gameMap.getMapSizeX(); ++xx)
+            gameMap.getTile(xx, yy)->setSeats(seats);
+    }
+
+    for(Seat* seat : seats)
+    {
+        for(Seat* alliedSeat : seats)
+        {
+            if((alliedSeat != seat) && seat->isAlliedSeat(alliedSeat))
+                seat->addAlliedSeat(alliedSeat);
+        }
+    }
+
+    gameMap.setTurnNumber(0);
+    gameMap.setGamePaused(false);
+    gameMap.createAllEntities();
+    for(Seat* seat : seats)
+    {
+        if((seat->getPlayer() != nullptr) && (seat->getGold() > 0))
+            gameMap.addGoldToSeat(seat->getGold(), seat->getId());
+    }
+
+    double timeSinceLastTurn = 1.0 / ODApplication::turnsPerSecond;
+    for(uint32_t turn = 0; turn < nbTurns; ++turn)
+    {
+        gameMap.setTurnNumber(gameMap.getTurnNumber() + 1);
+        gameMap.updateAnimations(timeSinceLastTurn);
+        gameMap.updateVisibleEntities();
+        gameMap.doTurn(timeSinceLastTurn);
+        gameMap.doPlayerAITurn(timeSinceLastTurn);
+        gameMap.fireRefreshEntities();
+        gameMap.processDeletionQueues();
+    }
+
+    return gameMap.getStateChecksum();
+}
+
+BOOST_AUTO_TEST_CASE(test_TurnsDoNotDependOnThreads)
+{
+    // The 4 keepers of this level dig, claim and fight from the first turns
+    std::string levelFilename = ResourceManager::getSingleton().getGameLevelPathSkirmish() + "TestSingleplayerSmall.level";
+    const uint32_t nbTurns = 300;
+    uint64_t checksum = computeTurns(levelFilename, 1, nbTurns).getGlobalHash();
+    BOOST_CHECK_EQUAL(computeTurns(levelFilename, 1, nbTurns).getGlobalHash(), checksum);
+    for(uint32_t nbThreads : { 2, 3, 8 })
+        BOOST_CHECK_EQUAL(computeTurns(levelFilename, nbThreads, nbTurns).getGlobalHash(), checksum);
+}
+
+BOOST_AUTO_TEST_CASE(test_TurnsAreReproducible)
+{
+    // With the same seed and the same inputs (only the keeper AIs play), two runs should give the same
+    // state. The AIs have the time to build rooms used by the creatures (like libraries or training halls)
+    std::string levelFilename = ResourceManager::getSingleton().getGameLevelPathSkirmish() + "TestSingleplayerSmall.level";
+    const uint32_t nbTurns = 1000;
+    StateChecksum checksum = computeTurns(levelFilename, 1, nbTurns);
+
+    // Memory is allocated between the runs so that the entities of the second one are not at the same
+    // addresses. That way, the containers ordered by address would be iterated in another order
+    std::vector<std::unique_ptr<char[]>> padding;
+    for(uint32_t i = 1; i <= 256; ++i)
+        padding.emplace_back(new char[i * 24]);
+
+    StateChecksum otherChecksum = computeTurns(levelFilename, 1, nbTurns);
+    StateChecksum::Subsystem subsystem = checksum.firstDivergingSubsystem(otherChecksum);
+    BOOST_CHECK_MESSAGE(subsystem == StateChecksum::Subsystem::nb,
+        "The runs diverge in " + StateChecksum::toString(subsystem));
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE NetworkStringTable
+#include "BoostTestTargetConfig.h"
+
+#include "network/NetworkStringTable.h"
+
+BOOST_AUTO_TEST_CASE(test_NetworkStringTable)
+{
+    // Server side
+    NetworkStringTable serverTable;
+    bool isNew = false;
+    uint32_t idGoblin = serverTable.addString("Goblin12", isNew);
+    BOOST_CHECK(isNew);
+    uint32_t idWalk = serverTable.addString("Walk", isNew);
+    BOOST_CHECK(isNew);
+    BOOST_CHECK(idGoblin != idWalk);
+    BOOST_CHECK(serverTable.addString("Goblin12", isNew) == idGoblin);
+    BOOST_CHECK(!isNew);
+    BOOST_CHECK(serverTable.size() == 2);
+
+    // Client side
+    NetworkStringTable clientTable;
+    BOOST_CHECK(clientTable.getString(idGoblin) == nullptr);
+    BOOST_CHECK(clientTable.setString(idWalk, "Walk"));
+    BOOST_CHECK(clientTable.setString(idGoblin, "Goblin12"));
+    BOOST_CHECK(!clientTable.setString(NetworkStringTable::INVALID_ID, "Invalid"));
+    BOOST_CHECK(*clientTable.getString(idGoblin) == *serverTable.getString(idGoblin));
+    BOOST_CHECK(*clientTable.getString(idWalk) == "Walk");
+    BOOST_CHECK(clientTable.getString(NetworkStringTable::INVALID_ID) == nullptr);
+
+    serverTable.clear();
+    BOOST_CHECK(serverTable.size() == 0);
+    BOOST_CHECK(serverTable.addString("Walk", isNew) == 0);
+    BOOST_CHECK(isNew);
+}
+
+BOOST_AUTO_TEST_CASE(test_NetworkStringTableRecycle)
+{
+    NetworkStringTable serverTable;
+    bool isNew = false;
+    uint32_t idGoblin = serverTable.addString("Goblin12", isNew);
+    uint32_t idWalk = serverTable.addString("Walk", isNew);
+
+    // A removed string keeps its id until the ids are recycled
+    serverTable.removeString("Goblin12");
+    serverTable.removeString("Unknown");
+    BOOST_CHECK(*serverTable.getString(idGoblin) == "Goblin12");
+    uint32_t idMissile = serverTable.addString("Missile3", isNew);
+    BOOST_CHECK(isNew);
+    BOOST_CHECK(idMissile != idGoblin);
+    BOOST_CHECK(serverTable.size() == 3);
+
+    // Then, it is given to the next new string and the table does not grow
+    serverTable.recycleRemovedIds();
+    BOOST_CHECK(serverTable.addString("Goblin12", isNew) == idGoblin);
+    BOOST_CHECK(isNew);
+    serverTable.removeString("Goblin12");
+    serverTable.recycleRemovedIds();
+    BOOST_CHECK(serverTable.addString("Goblin13", isNew) == idGoblin);
+    BOOST_CHECK(*serverTable.getString(idGoblin) == "Goblin13");
+    BOOST_CHECK(serverTable.addString("Walk", isNew) == idWalk);
+    BOOST_CHECK(!isNew);
+    BOOST_CHECK(serverTable.size() == 3);
+
+    // The client replaces the string when it receives the new one
+    NetworkStringTable clientTable;
+    BOOST_CHECK(clientTable.setString(idGoblin, "Goblin12"));
+    BOOST_CHECK(clientTable.setString(idGoblin, "Goblin13"));
+    BOOST_CHECK(*clientTable.getString(idGoblin) == "Goblin13");
+}
@@ -54,3 +54,163 @@ BOOST_AUTO_TEST_CASE(test_ODPacket)
 
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_ODPacketSubPackets)
+{
+    ODPacket packet1;
+    const int32_t inInt = 42;
+    packet1 << inInt;
+    ODPacket packet2;
+    const std::string inString("TEST");
+    packet2 << inString << inInt;
+
+    ODPacket batch;
+    batch.writeSubPacket(packet1);
+    batch.writeSubPacket(packet2);
+
+    ODPacket subPacket;
+    int32_t outInt = 0;
+    std::string outString;
+    BOOST_CHECK(batch.readSubPacket(subPacket));
+    BOOST_CHECK(subPacket.getDataSize() == packet1.getDataSize());
+    subPacket >> outInt;
+    BOOST_CHECK(outInt == inInt);
+    BOOST_CHECK(subPacket.endOfPacket());
+
+    outInt = 0;
+    BOOST_CHECK(batch.readSubPacket(subPacket));
+    subPacket >> outString >> outInt;
+    BOOST_CHECK(inString.compare(outString) == 0);
+    BOOST_CHECK(outInt == inInt);
+
+    BOOST_CHECK(!batch.readSubPacket(subPacket));
+}
+
+BOOST_AUTO_TEST_CASE(test_ODPacketView)
+{
+    ODPacket packet;
+    const bool inBool = true;
+    const int8_t inInt8 = -12;
+    const uint16_t inUInt16 = 54321;
+    const int32_t inInt32 = -123456789;
+    const uint32_t inUInt32 = 0xDEADBEEF;
+    const int64_t inInt64 = -1234567890123;
+    const uint64_t inUInt64 = 0xFEDCBA9876543210;
+    const float inFloat = 3.5f;
+    const double inDouble = -0.125;
+    const std::string inString("TEST");
+    const std::wstring inWString(L"WTEST");
+    packet << inBool << inInt8 << inUInt16 << inInt32 << inUInt32 << inInt64 << inUInt64
+        << inFloat << inDouble << inString << inWString;
+
+    // The view reads the data written without copying it
+    ODPacket view;
+    view.setView(packet.getData(), packet.getDataSize());
+    BOOST_CHECK(view.getData() == packet.getData());
+    BOOST_CHECK(view.getDataSize() == packet.getDataSize());
+
+    bool outBool = false;
+    int8_t outInt8 = 0;
+    uint16_t outUInt16 = 0;
+    int32_t outInt32 = 0;
+    uint32_t outUInt32 = 0;
+    int64_t outInt64 = 0;
+    uint64_t outUInt64 = 0;
+    float outFloat = 0;
+    double outDouble = 0;
+    std::string outString;
+    std::wstring outWString;
+    BOOST_CHECK(view >> outBool >> outInt8 >> outUInt16 >> outInt32 >> outUInt32 >> outInt64 >> outUInt64
+        >> outFloat >> outDouble >> outString >> outWString);
+    BOOST_CHECK(outBool == inBool);
+    BOOST_CHECK(outInt8 == inInt8);
+    BOOST_CHECK(outUInt16 == inUInt16);
+    BOOST_CHECK(outInt32 == inInt32);
+    BOOST_CHECK(outUInt32 == inUInt32);
+    BOOST_CHECK(outInt64 == inInt64);
+    BOOST_CHECK(outUInt64 == inUInt64);
+    BOOST_CHECK(outFloat == inFloat);
+    BOOST_CHECK(outDouble == inDouble);
+    BOOST_CHECK(outString == inString);
+    BOOST_CHECK(outWString == inWString);
+    BOOST_CHECK(view.endOfPacket());
+
+    // Reading past the end invalidates the packet
+    BOOST_CHECK(!(view >> outInt32));
+    BOOST_CHECK(outInt32 == inInt32);
+
+    // Writing to a view copies the data first
+    ODPacket copy;
+    copy.setView(packet.getData(), packet.getDataSize());
+    copy << inInt32;
+    BOOST_CHECK(copy.getData() != packet.getData());
+    BOOST_CHECK(copy.getDataSize() == packet.getDataSize() + sizeof(inInt32));
+    BOOST_CHECK(copy >> outBool);
+    BOOST_CHECK(outBool == inBool);
+
+    // Sub packets are views on the batch
+    ODPacket batch;
+    batch.writeSubPacket(packet);
+    ODPacket subPacket;
+    BOOST_CHECK(batch.readSubPacket(subPacket));
+    BOOST_CHECK(subPacket.getDataSize() == packet.getDataSize());
+    BOOST_CHECK(subPacket.getData() >= batch.getData());
+    BOOST_CHECK(subPacket.getData() + subPacket.getDataSize() <= batch.getData() + batch.getDataSize());
+    BOOST_CHECK(subPacket >> outBool >> outInt8);
+    BOOST_CHECK(outInt8 == inInt8);
+}
+
+BOOST_AUTO_TEST_CASE(test_ODPacketVarInts)
+{
+    ODPacket packet;
+    const std::vector<uint32_t> inUInts = { 0, 1, 127, 128, 300, 0xFFFFFFFF };
+    for(uint32_t v : inUInts)
+        packet.writeVarUInt(v);
+    const std::vector<int32_t> inInts = { 0, -1, 1, -64, 64, 0x7FFFFFFF, -0x7FFFFFFF - 1 };
+    for(int32_t v : inInts)
+        packet.writeVarInt(v);
+
+    for(uint32_t v : inUInts)
+    {
+        uint32_t out = 0;
+        BOOST_CHECK(packet.readVarUInt(out));
+        BOOST_CHECK(out == v);
+    }
+    for(int32_t v : inInts)
+    {
+        int32_t out = 0;
+        BOOST_CHECK(packet.readVarInt(out));
+        BOOST_CHECK(out == v);
+    }
+    BOOST_CHECK(packet.endOfPacket());
+
+    // Small values take 1 byte
+    ODPacket small;
+    small.writeVarUInt(127);
+    small.writeVarInt(-64);
+    BOOST_CHECK(small.getDataSize() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_ODPacketPositions)
+{
+    const std::vector<Ogre::Vector3> path = { Ogre::Vector3(10.5, 3.25, 0), Ogre::Vector3(11.5, 3.25, 0),
+        Ogre::Vector3(12.1, 4.7, 0.3) };
+    ODPacket packet;
+    Ogre::Vector3 ref = Ogre::Vector3::ZERO;
+    for(const Ogre::Vector3& pos : path)
+    {
+        packet.writePositionDelta(pos, ref);
+        ref = pos;
+    }
+    // Chained positions take less space than full vectors
+    BOOST_CHECK(packet.getDataSize() < path.size() * 3 * sizeof(float));
+
+    ref = Ogre::Vector3::ZERO;
+    for(const Ogre::Vector3& pos : path)
+    {
+        Ogre::Vector3 out;
+        BOOST_CHECK(packet.readPositionDelta(out, ref));
+        BOOST_CHECK(out.distance(pos) <= 1.0 / ODPacket::POSITION_SCALE);
+        ref = out;
+    }
+}
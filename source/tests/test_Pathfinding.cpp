@@ -18,7 +18,17 @@
 #define BOOST_TEST_MODULE Random
 #include "BoostTestTargetConfig.h"
 
+#include "gamemap/AstarSearch.h"
+#include "gamemap/DisjointSet.h"
+#include "gamemap/FlowFieldCache.h"
+#include "gamemap/HierarchicalPathfinding.h"
 #include "gamemap/Pathfinding.h"
+#include "gamemap/PathfindingGrid.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 struct Point
 {
@@ -39,3 +49,639 @@ BOOST_AUTO_TEST_CASE(test_Pathfinding)
     BOOST_CHECK((Pathfinding::distanceTile(a, b) - std::sqrt(128.0f)) < 0.0001f);
     BOOST_CHECK(Pathfinding::squaredDistance(9,1,1,9) == 128);
 }
+
+BOOST_AUTO_TEST_CASE(test_AstarSearch)
+{
+    AstarSearch search;
+    search.resize(10, 10);
+    search.newSearch();
+
+    // Nodes with the same cost are returned in the order they have been opened
+    search.open(search.toIndex(1, 1), 3.0, 1.0, -1);
+    search.open(search.toIndex(2, 1), 1.0, 2.0, -1);
+    search.open(search.toIndex(3, 1), 0.0, 1.0, -1);
+    search.open(search.toIndex(4, 1), 1.0, 2.0, -1);
+    BOOST_CHECK(search.popLowest() == search.toIndex(3, 1));
+    BOOST_CHECK(search.isClosed(search.toIndex(3, 1)));
+
+    // Lowering the cost of a node moves it after the nodes with the same cost
+    search.decreaseG(search.toIndex(1, 1), 2.0, search.toIndex(3, 1));
+    BOOST_CHECK(search.popLowest() == search.toIndex(2, 1));
+    BOOST_CHECK(search.popLowest() == search.toIndex(4, 1));
+    BOOST_CHECK(search.popLowest() == search.toIndex(1, 1));
+    BOOST_CHECK(search.getParent(search.toIndex(1, 1)) == search.toIndex(3, 1));
+    BOOST_CHECK(search.isOpenListEmpty());
+
+    // A new search forgets the previous nodes
+    search.newSearch();
+    BOOST_CHECK(!search.isVisited(search.toIndex(1, 1)));
+    BOOST_CHECK(!search.isClosed(search.toIndex(3, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(test_DisjointSet)
+{
+    DisjointSet set;
+    // Values never merged are their own representative
+    BOOST_CHECK(set.find(0) == 0);
+    BOOST_CHECK(set.find(42) == 42);
+
+    // The representative given when merging is kept
+    set.merge(5, 3);
+    set.merge(8, 5);
+    BOOST_CHECK(set.find(5) == 3);
+    BOOST_CHECK(set.find(8) == 3);
+
+    set.merge(3, 12);
+    BOOST_CHECK(set.find(8) == 12);
+    BOOST_CHECK(set.find(4) == 4);
+
+    // Merging values already in the same set changes nothing
+    set.merge(8, 5);
+    BOOST_CHECK(set.find(3) == 12);
+
+    // Merging a big set into a small one keeps the representative of the small one
+    set.merge(20, 21);
+    set.merge(12, 20);
+    BOOST_CHECK(set.find(8) == 21);
+    BOOST_CHECK(set.find(20) == 21);
+    set.merge(21, 30);
+    const DisjointSet& constSet = set;
+    for(uint32_t value : { 3u, 5u, 8u, 12u, 20u, 21u, 30u })
+        BOOST_CHECK(constSet.find(value) == 30);
+
+    // Each value merged into the next one
+    DisjointSet chain;
+    for(uint32_t value = 100; value < 200; ++value)
+        chain.merge(value, value + 1);
+    BOOST_CHECK(chain.find(100) == 200);
+    BOOST_CHECK(chain.find(150) == 200);
+    BOOST_CHECK(chain.find(99) == 99);
+
+    set.clear();
+    BOOST_CHECK(set.find(8) == 8);
+}
+
+//! \brief Map given as text lines: '#' is a full tile, '.' ground, '~' water and '=' lava
+class TestGrid : public PathfindingGrid
+{
+public:
+    TestGrid(int sizeX, int sizeY) :
+        mLines(static_cast<uint32_t>(sizeY), std::string(static_cast<uint32_t>(sizeX), '.'))
+    {}
+
+    inline int getMapSizeX() const
+    { return static_cast<int>(mLines.front().size()); }
+
+    inline int getMapSizeY() const
+    { return static_cast<int>(mLines.size()); }
+
+    inline int32_t toIndex(int x, int y) const
+    { return x + y * getMapSizeX(); }
+
+    inline void setTile(int x, int y, char tile)
+    { mLines[static_cast<uint32_t>(y)][static_cast<uint32_t>(x)] = tile; }
+
+    //! \brief Fills the tiles of column x from yMin to yMax (included)
+    void setColumn(int x, int yMin, int yMax, char tile)
+    {
+        for(int y = yMin; y <= yMax; ++y)
+            setTile(x, y, tile);
+    }
+
+    PathfindingGround getPathfindingGround(int x, int y) const override
+    {
+        switch(mLines[static_cast<uint32_t>(y)][static_cast<uint32_t>(x)])
+        {
+            case '.':
+                return PathfindingGround::ground;
+            case '~':
+                return PathfindingGround::water;
+            case '=':
+                return PathfindingGround::lava;
+            default:
+                return PathfindingGround::none;
+        }
+    }
+
+private:
+    std::vector<std::string> mLines;
+};
+
+static bool isGridPassable(const TestGrid& grid, int x, int y, FloodFillType type, int32_t blockedTile)
+{
+    if((x < 0) || (y < 0) || (x >= grid.getMapSizeX()) || (y >= grid.getMapSizeY()))
+        return false;
+
+    if(grid.toIndex(x, y) == blockedTile)
+        return false;
+
+    return PathfindingGrid::isPassable(grid.getPathfindingGround(x, y), type);
+}
+
+//! \brief A* with the same rules as GameMap::computePath for a creature with the same speed everywhere.
+//! blockedTile is a tile the creature cannot go through even if the grid allows it (-1 if none)
+static std::vector<int32_t> searchPath(const TestGrid& grid, int x1, int y1, int x2, int y2, FloodFillType type,
+    int32_t blockedTile)
+{
+    static const int dirX[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+    static const int dirY[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+    // Diagonals are only allowed if both adjacent tiles are passable
+    static const int diagSides[4][2] = { { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 } };
+
+    std::vector<int32_t> path;
+    AstarSearch search;
+    search.resize(grid.getMapSizeX(), grid.getMapSizeY());
+    search.newSearch();
+    search.open(search.toIndex(x1, y1), 0.0, std::abs(x2 - x1) + std::abs(y2 - y1), -1);
+    int destIndex = search.toIndex(x2, y2);
+    while(!search.isOpenListEmpty())
+    {
+        int current = search.popLowest();
+        if(current == destIndex)
+            break;
+
+        int currentX = search.indexToX(current);
+        int currentY = search.indexToY(current);
+        bool areTilesPassable[4] = { false, false, false, false };
+        for(int i = 0; i < 8; ++i)
+        {
+            if((i >= 4) && (!areTilesPassable[diagSides[i - 4][0]] || !areTilesPassable[diagSides[i - 4][1]]))
+                continue;
+
+            int neighX = currentX + dirX[i];
+            int neighY = currentY + dirY[i];
+            if(!isGridPassable(grid, neighX, neighY, type, blockedTile))
+                continue;
+
+            if(i < 4)
+                areTilesPassable[i] = true;
+
+            int neighIndex = search.toIndex(neighX, neighY);
+            if(search.isClosed(neighIndex))
+                continue;
+
+            double g = search.getG(current) + std::abs(dirX[i]) + std::abs(dirY[i]);
+            if(!search.isVisited(neighIndex))
+                search.open(neighIndex, g, std::abs(x2 - neighX) + std::abs(y2 - neighY), current);
+            else if(g < search.getG(neighIndex))
+                search.decreaseG(neighIndex, g, current);
+        }
+    }
+
+    if(!search.isClosed(destIndex))
+        return path;
+
+    for(int index = destIndex; index >= 0; index = search.getParent(index))
+        path.push_back(index);
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+//! \brief Searches a path like GameMap::path: the waypoints given by the abstraction are refined and,
+//! if the abstraction fails or if a segment cannot be walked, the whole path is searched with A*
+static std::vector<int32_t> findPath(const TestGrid& grid, HierarchicalPathfinding& hpa, int x1, int y1, int x2, int y2,
+    FloodFillType type, int32_t blockedTile, bool& usedWaypoints)
+{
+    usedWaypoints = false;
+    std::vector<int32_t> waypoints;
+    if(hpa.findWaypoints(x1, y1, x2, y2, type, HierarchicalPathfinding::NO_TEAM, waypoints))
+    {
+        std::vector<int32_t> path;
+        for(uint32_t i = 1; i < waypoints.size(); ++i)
+        {
+            int sizeX = grid.getMapSizeX();
+            std::vector<int32_t> segment = searchPath(grid, waypoints[i - 1] % sizeX, waypoints[i - 1] / sizeX,
+                waypoints[i] % sizeX, waypoints[i] / sizeX, type, blockedTile);
+            if(segment.empty())
+            {
+                path.clear();
+                break;
+            }
+
+            path.insert(path.end(), path.empty() ? segment.begin() : segment.begin() + 1, segment.end());
+        }
+
+        if(!path.empty())
+        {
+            usedWaypoints = true;
+            return path;
+        }
+    }
+
+    return searchPath(grid, x1, y1, x2, y2, type, blockedTile);
+}
+
+//! \brief Checks that path goes from start to dest through adjacent passable tiles
+static bool isPathValid(const TestGrid& grid, const std::vector<int32_t>& path, int x1, int y1, int x2, int y2,
+    FloodFillType type)
+{
+    if(path.empty() || (path.front() != grid.toIndex(x1, y1)) || (path.back() != grid.toIndex(x2, y2)))
+        return false;
+
+    int sizeX = grid.getMapSizeX();
+    for(uint32_t i = 0; i < path.size(); ++i)
+    {
+        int x = path[i] % sizeX;
+        int y = path[i] / sizeX;
+        if(!isGridPassable(grid, x, y, type, -1))
+            return false;
+
+        if(i == 0)
+            continue;
+
+        int prevX = path[i - 1] % sizeX;
+        int prevY = path[i - 1] / sizeX;
+        if((std::abs(x - prevX) > 1) || (std::abs(y - prevY) > 1) || ((x == prevX) && (y == prevY)))
+            return false;
+    }
+    return true;
+}
+
+//! \brief Length of the given path with the weights used by GameMap::path (diagonals count as 2 moves)
+static int pathLength(const TestGrid& grid, const std::vector<int32_t>& path)
+{
+    int length = 0;
+    int sizeX = grid.getMapSizeX();
+    for(uint32_t i = 1; i < path.size(); ++i)
+        length += std::abs(path[i] % sizeX - path[i - 1] % sizeX) + std::abs(path[i] / sizeX - path[i - 1] / sizeX);
+
+    return length;
+}
+
+BOOST_AUTO_TEST_CASE(test_HierarchicalPathfindingWaypoints)
+{
+    const int clusterSize = HierarchicalPathfinding::CLUSTER_SIZE;
+    TestGrid grid(4 * clusterSize, 3 * clusterSize);
+    // Some walls with gaps to go around
+    grid.setColumn(12, 0, 20, '#');
+    grid.setColumn(25, 8, 29, '#');
+    grid.setColumn(33, 0, 12, '~');
+    HierarchicalPathfinding hpa(grid);
+    hpa.reset(grid.getMapSizeX(), grid.getMapSizeY());
+
+    std::vector<int32_t> waypoints;
+    BOOST_REQUIRE(hpa.findWaypoints(1, 1, 38, 2, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_CHECK(waypoints.front() == grid.toIndex(1, 1));
+    BOOST_CHECK(waypoints.back() == grid.toIndex(38, 2));
+    int sizeX = grid.getMapSizeX();
+    for(uint32_t i = 0; i < waypoints.size(); ++i)
+    {
+        int x = waypoints[i] % sizeX;
+        int y = waypoints[i] / sizeX;
+        BOOST_CHECK(isGridPassable(grid, x, y, FloodFillType::ground, -1));
+        if(i == 0)
+            continue;
+
+        // Consecutive waypoints are in the same or in adjacent clusters
+        int prevX = waypoints[i - 1] % sizeX;
+        int prevY = waypoints[i - 1] / sizeX;
+        BOOST_CHECK(std::abs(x / clusterSize - prevX / clusterSize) <= 1);
+        BOOST_CHECK(std::abs(y / clusterSize - prevY / clusterSize) <= 1);
+    }
+
+    // The refined path is valid and cannot be shorter than the best one
+    bool usedWaypoints;
+    std::vector<int32_t> path = findPath(grid, hpa, 1, 1, 38, 2, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 1, 1, 38, 2, FloodFillType::ground));
+    BOOST_CHECK(pathLength(grid, path) == pathLength(grid, searchPath(grid, 1, 1, 38, 2, FloodFillType::ground, -1)));
+
+    // Unlike the plain A* search, the refined path is not always the shortest one because it has to go
+    // through the entrances of the clusters. It is never shorter and, here, only a bit longer
+    path = findPath(grid, hpa, 1, 21, 30, 25, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 1, 21, 30, 25, FloodFillType::ground));
+    BOOST_CHECK(pathLength(grid, path) == 63);
+    BOOST_CHECK(pathLength(grid, searchPath(grid, 1, 21, 30, 25, FloodFillType::ground, -1)) == 61);
+
+    // Creatures going through water can cross the water wall
+    path = findPath(grid, hpa, 30, 2, 38, 25, FloodFillType::groundWater, -1, usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 30, 2, 38, 25, FloodFillType::groundWater));
+
+    // No waypoints within the same cluster or when the destination is not passable
+    BOOST_CHECK(!hpa.findWaypoints(1, 1, 5, 5, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_CHECK(!hpa.findWaypoints(1, 1, 12, 5, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_CHECK(!hpa.findWaypoints(1, 1, 33, 5, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_CHECK(hpa.findWaypoints(1, 1, 33, 5, FloodFillType::groundWater, HierarchicalPathfinding::NO_TEAM, waypoints));
+}
+
+BOOST_AUTO_TEST_CASE(test_HierarchicalPathfindingDig)
+{
+    const int clusterSize = HierarchicalPathfinding::CLUSTER_SIZE;
+    TestGrid grid(4 * clusterSize, 3 * clusterSize);
+    // A wall splits the map in 2
+    grid.setColumn(15, 0, grid.getMapSizeY() - 1, '#');
+    HierarchicalPathfinding hpa(grid);
+    hpa.reset(grid.getMapSizeX(), grid.getMapSizeY());
+
+    std::vector<int32_t> waypoints;
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+
+    // The clusters are only rebuilt once notified
+    grid.setTile(15, 21, '.');
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    hpa.tilePassabilityChanged(15, 21);
+    BOOST_REQUIRE(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+
+    bool usedWaypoints;
+    std::vector<int32_t> path = findPath(grid, hpa, 2, 2, 35, 25, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 25, FloodFillType::ground));
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(15, 21)) != path.end());
+
+    // A tile on a cluster border also changes the entrances of the neighbour cluster
+    grid.setTile(15, 21, '#');
+    grid.setColumn(19, 0, grid.getMapSizeY() - 1, '#');
+    grid.setColumn(15, 0, grid.getMapSizeY() - 1, '.');
+    for(int y = 0; y < grid.getMapSizeY(); ++y)
+    {
+        hpa.tilePassabilityChanged(15, y);
+        hpa.tilePassabilityChanged(19, y);
+    }
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    grid.setTile(19, 8, '.');
+    hpa.tilePassabilityChanged(19, 8);
+    path = findPath(grid, hpa, 2, 2, 35, 25, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 25, FloodFillType::ground));
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(19, 8)) != path.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_HierarchicalPathfindingDoor)
+{
+    const int clusterSize = HierarchicalPathfinding::CLUSTER_SIZE;
+    TestGrid grid(4 * clusterSize, 3 * clusterSize);
+    // 2 areas linked by a single tile
+    grid.setColumn(20, 0, grid.getMapSizeY() - 1, '#');
+    grid.setTile(20, 14, '.');
+    HierarchicalPathfinding hpa(grid);
+    hpa.reset(grid.getMapSizeX(), grid.getMapSizeY());
+
+    std::vector<int32_t> waypoints;
+    BOOST_CHECK(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, 1, waypoints));
+
+    // Locked doors block every flood fill type for the creatures of the door team
+    hpa.setDoorLocked(20, 14, 1, true);
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, 1, waypoints));
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::groundWaterLava, 1, waypoints));
+    // Waypoints cannot start or end on the door either
+    BOOST_CHECK(!hpa.findWaypoints(20, 14, 35, 25, FloodFillType::ground, 1, waypoints));
+
+    // The other teams can go through. Workers are blocked by any locked door
+    BOOST_CHECK(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, 2, waypoints));
+    BOOST_CHECK(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_CHECK(!hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::ALL_TEAMS, waypoints));
+
+    hpa.setDoorLocked(20, 14, 1, false);
+    BOOST_CHECK(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, HierarchicalPathfinding::ALL_TEAMS, waypoints));
+    BOOST_REQUIRE(hpa.findWaypoints(2, 2, 35, 25, FloodFillType::ground, 1, waypoints));
+    bool usedWaypoints;
+    std::vector<int32_t> path = findPath(grid, hpa, 2, 2, 35, 25, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(20, 14)) != path.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_HierarchicalPathfindingFallback)
+{
+    const int clusterSize = HierarchicalPathfinding::CLUSTER_SIZE;
+    TestGrid grid(4 * clusterSize, 3 * clusterSize);
+    // A wall with 2 gaps. The abstraction goes through the closest one
+    grid.setColumn(20, 0, grid.getMapSizeY() - 1, '#');
+    grid.setTile(20, 3, '.');
+    grid.setTile(20, 26, '.');
+    HierarchicalPathfinding hpa(grid);
+    hpa.reset(grid.getMapSizeX(), grid.getMapSizeY());
+
+    std::vector<int32_t> waypoints;
+    BOOST_REQUIRE(hpa.findWaypoints(2, 2, 35, 2, FloodFillType::ground, HierarchicalPathfinding::NO_TEAM, waypoints));
+    BOOST_REQUIRE(waypoints.size() > 2);
+
+    // If the creature cannot go through a waypoint (for example a tile where its speed is null),
+    // the refinement fails and the whole path is searched
+    int32_t blockedTile = grid.toIndex(20, 3);
+    bool usedWaypoints;
+    std::vector<int32_t> path = findPath(grid, hpa, 2, 2, 35, 2, FloodFillType::ground, blockedTile, usedWaypoints);
+    BOOST_CHECK(!usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 2, FloodFillType::ground));
+    BOOST_CHECK(std::find(path.begin(), path.end(), blockedTile) == path.end());
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(20, 26)) != path.end());
+
+    // Paths within a cluster do not use the abstraction
+    path = findPath(grid, hpa, 2, 2, 7, 8, FloodFillType::ground, -1, usedWaypoints);
+    BOOST_CHECK(!usedWaypoints);
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 7, 8, FloodFillType::ground));
+}
+
+static FlowFieldCache::Walker makeWalker(int teamId, bool isWorker, double speedGround, double speedWater, double speedLava)
+{
+    FlowFieldCache::Walker walker;
+    walker.mTeamId = teamId;
+    walker.mIsBlockedByAllDoors = isWorker;
+    walker.mSpeedGround = speedGround;
+    walker.mSpeedWater = speedWater;
+    walker.mSpeedLava = speedLava;
+    return walker;
+}
+
+//! \brief Cost of the given path with the weights used by GameMap::path
+static double pathCost(const TestGrid& grid, const std::vector<int32_t>& path, const FlowFieldCache::Walker& walker)
+{
+    double cost = 0.0;
+    int sizeX = grid.getMapSizeX();
+    for(uint32_t i = 1; i < path.size(); ++i)
+    {
+        int x = path[i - 1] % sizeX;
+        int y = path[i - 1] / sizeX;
+        double speed = walker.mSpeedGround;
+        if(grid.getPathfindingGround(x, y) == PathfindingGround::water)
+            speed = walker.mSpeedWater;
+        else if(grid.getPathfindingGround(x, y) == PathfindingGround::lava)
+            speed = walker.mSpeedLava;
+
+        cost += (std::abs(path[i] % sizeX - x) + std::abs(path[i] / sizeX - y)) / speed;
+    }
+    return cost;
+}
+
+BOOST_AUTO_TEST_CASE(test_FlowFieldCacheMultiDestination)
+{
+    TestGrid grid(40, 30);
+    grid.setColumn(12, 0, 20, '#');
+    grid.setColumn(25, 8, 29, '#');
+    FlowFieldCache cache(grid);
+    cache.reset(grid.getMapSizeX(), grid.getMapSizeY());
+    FlowFieldCache::Walker walker = makeWalker(1, false, 1.0, 0.0, 0.0);
+
+    const int destX[3] = { 5, 35, 30 };
+    const int destY[3] = { 25, 25, 3 };
+    std::vector<int32_t> destinations;
+    for(int i = 0; i < 3; ++i)
+        destinations.push_back(grid.toIndex(destX[i], destY[i]));
+
+    const int startX[4] = { 1, 20, 38, 13 };
+    const int startY[4] = { 1, 20, 12, 2 };
+    for(int i = 0; i < 4; ++i)
+    {
+        // The path leads to the closest destination with the same cost as an A* search
+        double bestCost = -1.0;
+        for(int j = 0; j < 3; ++j)
+        {
+            std::vector<int32_t> path = searchPath(grid, startX[i], startY[i], destX[j], destY[j], FloodFillType::ground, -1);
+            double cost = pathCost(grid, path, walker);
+            if(!path.empty() && ((bestCost < 0.0) || (cost < bestCost)))
+                bestCost = cost;
+        }
+
+        std::vector<int32_t> path;
+        BOOST_REQUIRE(cache.findPath(destinations, walker, startX[i], startY[i], path));
+        int sizeX = grid.getMapSizeX();
+        int endX = path.back() % sizeX;
+        int endY = path.back() / sizeX;
+        BOOST_CHECK(std::find(destinations.begin(), destinations.end(), path.back()) != destinations.end());
+        BOOST_CHECK(isPathValid(grid, path, startX[i], startY[i], endX, endY, FloodFillType::ground));
+        BOOST_CHECK_CLOSE(pathCost(grid, path, walker), bestCost, 0.001);
+    }
+
+    // The same destinations in another order and the same walker share the flow field
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 1);
+    std::reverse(destinations.begin(), destinations.end());
+    std::vector<int32_t> path;
+    BOOST_CHECK(cache.findPath(destinations, walker, 1, 1, path));
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 1);
+    BOOST_CHECK_EQUAL(cache.getNbHits(), 4);
+
+    // Starting on a destination gives a path with only this tile
+    BOOST_REQUIRE(cache.findPath(destinations, walker, 30, 3, path));
+    BOOST_CHECK(path.size() == 1);
+
+    // Unreachable start
+    grid.setColumn(2, 0, 3, '#');
+    grid.setTile(0, 3, '#');
+    grid.setTile(1, 3, '#');
+    for(int y = 0; y <= 3; ++y)
+        cache.tilePassabilityChanged(2, y);
+    cache.tilePassabilityChanged(0, 3);
+    cache.tilePassabilityChanged(1, 3);
+    BOOST_CHECK(!cache.findPath(destinations, walker, 1, 1, path));
+    BOOST_CHECK(path.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_FlowFieldCacheDoor)
+{
+    TestGrid grid(40, 30);
+    // 2 areas linked by a door
+    grid.setColumn(20, 0, grid.getMapSizeY() - 1, '#');
+    grid.setTile(20, 14, '.');
+    FlowFieldCache cache(grid);
+    cache.reset(grid.getMapSizeX(), grid.getMapSizeY());
+    FlowFieldCache::Walker fighterTeam1 = makeWalker(1, false, 1.0, 0.0, 0.0);
+    FlowFieldCache::Walker fighterTeam2 = makeWalker(2, false, 1.0, 0.0, 0.0);
+    FlowFieldCache::Walker worker = makeWalker(FlowFieldCache::NO_TEAM, true, 1.0, 0.0, 0.0);
+    std::vector<int32_t> destinations(1, grid.toIndex(35, 25));
+
+    std::vector<int32_t> path;
+    BOOST_CHECK(cache.findPath(destinations, worker, 2, 2, path));
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(20, 14)) != path.end());
+    BOOST_CHECK(cache.findPath(destinations, fighterTeam1, 2, 2, path));
+
+    // The door team cannot go through. Enemy fighters can (they attack the door) but not workers
+    cache.setDoorLocked(20, 14, 1, true);
+    BOOST_CHECK(!cache.findPath(destinations, fighterTeam1, 2, 2, path));
+    BOOST_CHECK(!cache.findPath(destinations, worker, 2, 2, path));
+    BOOST_REQUIRE(cache.findPath(destinations, fighterTeam2, 2, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 25, FloodFillType::ground));
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(20, 14)) != path.end());
+
+    // Creatures on the closed door cannot use the flow field
+    BOOST_CHECK(!cache.findPath(destinations, fighterTeam1, 20, 14, path));
+
+    cache.setDoorLocked(20, 14, 1, false);
+    BOOST_REQUIRE(cache.findPath(destinations, worker, 2, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 25, FloodFillType::ground));
+    BOOST_CHECK(cache.findPath(destinations, fighterTeam1, 2, 2, path));
+}
+
+BOOST_AUTO_TEST_CASE(test_FlowFieldCacheBridge)
+{
+    TestGrid grid(40, 30);
+    // A wide river with a bridge. The grid gives ground for the bridge tiles
+    for(int x = 15; x < 25; ++x)
+    {
+        grid.setColumn(x, 0, grid.getMapSizeY() - 1, '~');
+        grid.setTile(x, 15, '.');
+    }
+    FlowFieldCache cache(grid);
+    cache.reset(grid.getMapSizeX(), grid.getMapSizeY());
+    std::vector<int32_t> destinations(1, grid.toIndex(35, 2));
+    auto isOnBridge = [&grid](const std::vector<int32_t>& path)
+    {
+        return std::find(path.begin(), path.end(), grid.toIndex(20, 15)) != path.end();
+    };
+
+    // Ground creatures use the bridge
+    FlowFieldCache::Walker groundWalker = makeWalker(1, false, 1.0, 0.0, 0.0);
+    std::vector<int32_t> path;
+    BOOST_REQUIRE(cache.findPath(destinations, groundWalker, 2, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 2, FloodFillType::ground));
+    BOOST_CHECK(isOnBridge(path));
+
+    // Creatures swimming as fast as they walk go straight
+    FlowFieldCache::Walker fastSwimmer = makeWalker(1, false, 1.0, 1.0, 0.0);
+    BOOST_REQUIRE(cache.findPath(destinations, fastSwimmer, 2, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 2, FloodFillType::groundWater));
+    BOOST_CHECK(!isOnBridge(path));
+    BOOST_CHECK_CLOSE(pathCost(grid, path, fastSwimmer), 33.0, 0.001);
+
+    // Slow swimmers prefer the bridge like GameMap::path would
+    FlowFieldCache::Walker slowSwimmer = makeWalker(1, false, 1.0, 0.2, 0.0);
+    BOOST_REQUIRE(cache.findPath(destinations, slowSwimmer, 2, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 2, 2, 35, 2, FloodFillType::groundWater));
+    BOOST_CHECK(isOnBridge(path));
+    BOOST_CHECK_CLOSE(pathCost(grid, path, slowSwimmer), 59.0, 0.001);
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 3);
+
+    // Swimmers can start in the water
+    BOOST_REQUIRE(cache.findPath(destinations, slowSwimmer, 16, 2, path));
+    BOOST_CHECK(isPathValid(grid, path, 16, 2, 35, 2, FloodFillType::groundWater));
+    BOOST_CHECK(!cache.findPath(destinations, groundWalker, 16, 2, path));
+}
+
+BOOST_AUTO_TEST_CASE(test_FlowFieldCacheInvalidation)
+{
+    TestGrid grid(40, 30);
+    // The destination is in the left area. The right one cannot be reached
+    grid.setColumn(20, 0, grid.getMapSizeY() - 1, '#');
+    grid.setColumn(21, 0, grid.getMapSizeY() - 1, '#');
+    grid.setColumn(30, 0, grid.getMapSizeY() - 1, '#');
+    FlowFieldCache cache(grid);
+    cache.reset(grid.getMapSizeX(), grid.getMapSizeY());
+    FlowFieldCache::Walker walker = makeWalker(1, false, 1.0, 0.0, 0.0);
+    std::vector<int32_t> destinations(1, grid.toIndex(2, 2));
+
+    std::vector<int32_t> path;
+    BOOST_CHECK(!cache.findPath(destinations, walker, 25, 2, path));
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 1);
+
+    // Digging far from the reachable tiles keeps the flow field
+    grid.setTile(30, 10, '.');
+    cache.tilePassabilityChanged(30, 10);
+    grid.setTile(21, 10, '.');
+    cache.tilePassabilityChanged(21, 10);
+    BOOST_CHECK(!cache.findPath(destinations, walker, 25, 2, path));
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 1);
+    BOOST_CHECK_EQUAL(cache.getNbHits(), 1);
+
+    // Digging next to a reachable tile updates it
+    grid.setTile(20, 10, '.');
+    cache.tilePassabilityChanged(20, 10);
+    BOOST_REQUIRE(cache.findPath(destinations, walker, 25, 2, path));
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 2);
+    BOOST_CHECK(isPathValid(grid, path, 25, 2, 2, 2, FloodFillType::ground));
+    BOOST_CHECK(std::find(path.begin(), path.end(), grid.toIndex(21, 10)) != path.end());
+
+    // Filling a reachable tile updates it too
+    grid.setTile(21, 10, '#');
+    cache.tilePassabilityChanged(21, 10);
+    BOOST_CHECK(!cache.findPath(destinations, walker, 25, 2, path));
+    BOOST_CHECK_EQUAL(cache.getNbMisses(), 3);
+}
@@ -20,8 +20,114 @@
 #define BOOST_TEST_MODULE Random
 #include "BoostTestTargetConfig.h"
 
+#include <vector>
+
 BOOST_AUTO_TEST_CASE(test_Random)
 {
     Random::initialize();
     BOOST_CHECK (Random::Int(1, 2 ) <= 2);
 }
+
+BOOST_AUTO_TEST_CASE(test_RandomSessionSeed)
+{
+    // The same session seed gives the same values
+    Random::initialize(42);
+    int values[16];
+    for(int& value : values)
+        value = Random::Int(0, 1000);
+
+    Random::initialize(42);
+    for(int value : values)
+        BOOST_CHECK_EQUAL(Random::Int(0, 1000), value);
+}
+
+BOOST_AUTO_TEST_CASE(test_RandomStreams)
+{
+    Random::initialize(1234);
+    RandomStream creature1 = Random::createStream(Random::Subsystem::creature, "Troll1");
+    RandomStream creature1Bis = Random::createStream(Random::Subsystem::creature, "Troll1");
+    RandomStream creature2 = Random::createStream(Random::Subsystem::creature, "Troll2");
+    RandomStream seat1 = Random::createStream(Random::Subsystem::keeperAI, 1);
+
+    // Streams do not depend on each other: using one does not change the others
+    uint32_t nbDiff2 = 0;
+    uint32_t nbDiffSeat = 0;
+    for(uint32_t i = 0; i < 64; ++i)
+    {
+        uint32_t value = creature1.next();
+        BOOST_CHECK_EQUAL(creature1Bis.next(), value);
+        if(creature2.next() != value)
+            ++nbDiff2;
+        if(seat1.next() != value)
+            ++nbDiffSeat;
+    }
+    BOOST_CHECK(nbDiff2 > 60);
+    BOOST_CHECK(nbDiffSeat > 60);
+
+    // Another session seed gives other values
+    Random::initialize(1235);
+    RandomStream otherSession = Random::createStream(Random::Subsystem::creature, "Troll1");
+    Random::initialize(1234);
+    RandomStream sameSession = Random::createStream(Random::Subsystem::creature, "Troll1");
+    BOOST_CHECK(otherSession.next() != sameSession.next());
+}
+
+BOOST_AUTO_TEST_CASE(test_RandomSubsystemStreams)
+{
+    // The values the server gets do not depend on what the client draws
+    Random::initialize(99);
+    std::vector<int> values;
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        values.push_back(Random::getStream(Random::Subsystem::room).Int(0, 1000));
+        values.push_back(Random::getStream(Random::Subsystem::trap).Int(0, 1000));
+        values.push_back(Random::Int(0, 1000));
+    }
+
+    Random::initialize(99);
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        Random::getStream(Random::Subsystem::client).Int(0, 1000);
+        BOOST_CHECK_EQUAL(Random::getStream(Random::Subsystem::room).Int(0, 1000), values[i * 3]);
+        Random::getStream(Random::Subsystem::client).Int(0, 1000);
+        BOOST_CHECK_EQUAL(Random::getStream(Random::Subsystem::trap).Int(0, 1000), values[i * 3 + 1]);
+        BOOST_CHECK_EQUAL(Random::Int(0, 1000), values[i * 3 + 2]);
+    }
+    BOOST_CHECK_EQUAL(Random::getStream(Random::Subsystem::client).getCounter(), 32);
+}
+
+BOOST_AUTO_TEST_CASE(test_RandomStreamBulk)
+{
+    RandomStream stream(7, 3);
+    RandomStream streamBulk(7, 3);
+
+    // Bulk generation gives the same values as the single value functions
+    std::vector<uint32_t> values(100);
+    streamBulk.fillUint(values.data(), static_cast<uint32_t>(values.size()));
+    for(uint32_t value : values)
+        BOOST_CHECK_EQUAL(stream.next(), value);
+    BOOST_CHECK_EQUAL(stream.getCounter(), streamBulk.getCounter());
+
+    std::vector<double> doubles(100);
+    streamBulk.fillDouble(doubles.data(), static_cast<uint32_t>(doubles.size()), 5.0, -5.0);
+    for(double value : doubles)
+    {
+        BOOST_CHECK_EQUAL(stream.Double(-5.0, 5.0), value);
+        BOOST_CHECK(value >= -5.0);
+        BOOST_CHECK(value < 5.0);
+    }
+
+    // Bounds are included for integers
+    bool hasMin = false;
+    bool hasMax = false;
+    for(uint32_t i = 0; i < 1000; ++i)
+    {
+        int value = stream.Int(3, -2);
+        BOOST_CHECK(value >= -2);
+        BOOST_CHECK(value <= 3);
+        hasMin |= (value == -2);
+        hasMax |= (value == 3);
+    }
+    BOOST_CHECK(hasMin);
+    BOOST_CHECK(hasMax);
+}
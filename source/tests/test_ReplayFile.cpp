@@ -0,0 +1,180 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE ReplayFile
+#include "BoostTestTargetConfig.h"
+
+#include "network/ODPacket.h"
+#include "network/ReplayFile.h"
+
+#include <cstdio>
+#include <fstream>
+
+static const char* REPLAY_FILENAME = "test_ReplayFile.odr";
+static const int64_t NB_TURNS = 120;
+static const int32_t NB_PACKETS_PER_TURN = 3;
+
+//! \brief Writes NB_TURNS turns of NB_PACKETS_PER_TURN packets. Each packet contains its turn
+//! and its index. Keyframes contain -1 and the turn
+static void writeReplay(ReplayWriter& writer)
+{
+    BOOST_REQUIRE(writer.open(REPLAY_FILENAME));
+    int32_t timestamp = 0;
+    for(int64_t turn = 0; turn < NB_TURNS; ++turn)
+    {
+        writer.turnStarted(turn);
+        for(int32_t i = 0; i < NB_PACKETS_PER_TURN; ++i)
+        {
+            timestamp += 10;
+            if(writer.isKeyframePending())
+            {
+                ODPacket keyframe;
+                keyframe << static_cast<int32_t>(-1) << turn;
+                writer.writeKeyframe(timestamp, keyframe);
+            }
+
+            ODPacket packet;
+            packet << i << turn << std::string("some data repeated in every packet");
+            writer.writePacket(timestamp, packet);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ReplayFileIndex)
+{
+    {
+        ReplayWriter writer;
+        writeReplay(writer);
+        writer.close();
+    }
+
+    ReplayReader reader;
+    BOOST_REQUIRE(reader.open(REPLAY_FILENAME));
+    const std::vector<ReplayKeyframe>& keyframes = reader.getKeyframes();
+    BOOST_REQUIRE(keyframes.size() == 3);
+    BOOST_CHECK(keyframes[0].mTurn == 0);
+    BOOST_CHECK(keyframes[1].mTurn == ReplayWriter::KEYFRAME_INTERVAL);
+    BOOST_CHECK(keyframes[2].mTurn == 2 * ReplayWriter::KEYFRAME_INTERVAL);
+
+    // The records can be read without copying them to a packet
+    const char* data;
+    uint32_t size;
+    BOOST_REQUIRE(reader.peekTimestamp() == 10);
+    BOOST_REQUIRE(reader.readRecord(data, size) == 10);
+    ODPacket packet;
+    packet.setData(data, size);
+    int32_t index;
+    int64_t turn;
+    BOOST_REQUIRE(packet >> index >> turn);
+    BOOST_CHECK(index == -1);
+    BOOST_CHECK(turn == 0);
+    BOOST_REQUIRE(reader.seekKeyframe(0) != nullptr);
+
+    // Every packet can be read in order. The index is not read as a packet
+    int32_t nbPackets = 0;
+    int32_t nbKeyframes = 0;
+    int32_t lastTimestamp = 0;
+    int32_t timestamp;
+    while((timestamp = reader.readPacket(packet)) >= 0)
+    {
+        BOOST_CHECK(timestamp >= lastTimestamp);
+        lastTimestamp = timestamp;
+        BOOST_REQUIRE(packet >> index);
+        if(index < 0)
+            ++nbKeyframes;
+        else
+            ++nbPackets;
+    }
+    BOOST_CHECK(nbKeyframes == 3);
+    BOOST_CHECK(nbPackets == NB_TURNS * NB_PACKETS_PER_TURN);
+
+    // Seeking goes to the keyframe and the packets after it can be decoded
+    const ReplayKeyframe* keyframe = reader.seekKeyframe(75);
+    BOOST_REQUIRE(keyframe != nullptr);
+    BOOST_CHECK(keyframe->mTurn == ReplayWriter::KEYFRAME_INTERVAL);
+    BOOST_REQUIRE(reader.readPacket(packet) == keyframe->mTimestamp);
+    BOOST_REQUIRE(packet >> index >> turn);
+    BOOST_CHECK(index == -1);
+    BOOST_CHECK(turn == ReplayWriter::KEYFRAME_INTERVAL);
+    std::string str;
+    BOOST_REQUIRE(reader.readPacket(packet) >= 0);
+    BOOST_REQUIRE(packet >> index >> turn >> str);
+    BOOST_CHECK(index == 0);
+    BOOST_CHECK(turn == ReplayWriter::KEYFRAME_INTERVAL);
+    BOOST_CHECK(str == "some data repeated in every packet");
+
+    // Going back works as well
+    keyframe = reader.seekKeyframe(10);
+    BOOST_REQUIRE(keyframe != nullptr);
+    BOOST_CHECK(keyframe->mTurn == 0);
+    BOOST_CHECK(reader.seekKeyframe(-1) == nullptr);
+
+    reader.close();
+    std::remove(REPLAY_FILENAME);
+}
+
+BOOST_AUTO_TEST_CASE(test_ReplayFileWithoutIndex)
+{
+    // If the game crashes, the writer is not closed and the index is missing
+    {
+        ReplayWriter writer;
+        writeReplay(writer);
+    }
+
+    ReplayReader reader;
+    BOOST_REQUIRE(reader.open(REPLAY_FILENAME));
+    BOOST_CHECK(reader.getKeyframes().empty());
+    BOOST_CHECK(reader.seekKeyframe(75) == nullptr);
+    ODPacket packet;
+    int32_t nbPackets = 0;
+    while(reader.readPacket(packet) >= 0)
+        ++nbPackets;
+    BOOST_CHECK(nbPackets == NB_TURNS * NB_PACKETS_PER_TURN + 3);
+    reader.close();
+
+    // Replays written before the header existed are only uncompressed records
+    {
+        std::ofstream os(REPLAY_FILENAME, std::ios::out | std::ios::binary);
+        for(int32_t i = 0; i < 10; ++i)
+        {
+            ODPacket packet;
+            packet << i;
+            int32_t timestamp = i * 10;
+            uint32_t size = packet.getDataSize();
+            os.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+            os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            os.write(packet.getData(), size);
+        }
+    }
+    BOOST_REQUIRE(reader.open(REPLAY_FILENAME));
+    BOOST_CHECK(reader.getKeyframes().empty());
+    int32_t i = 0;
+    int32_t timestamp;
+    while((timestamp = reader.readPacket(packet)) >= 0)
+    {
+        int32_t value;
+        BOOST_REQUIRE(packet >> value);
+        BOOST_CHECK(value == i);
+        BOOST_CHECK(timestamp == i * 10);
+        ++i;
+    }
+    BOOST_CHECK(i == 10);
+    BOOST_CHECK(reader.peekTimestamp() == -1);
+
+    reader.close();
+    std::remove(REPLAY_FILENAME);
+}
@@ -0,0 +1,307 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE SightTemplate
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/SightTemplate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <utility>
+
+typedef std::pair<int, int> Position;
+
+//! \brief Map where each tile blocks vision or not. Tiles out of the map do not exist
+struct TestMap
+{
+    TestMap(int sizeX, int sizeY, double blockingRatio, uint32_t seed) :
+        mSizeX(sizeX),
+        mSizeY(sizeY),
+        mBlocking(sizeX * sizeY, false)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        for(uint32_t i = 0; i < mBlocking.size(); ++i)
+            mBlocking[i] = (dist(gen) < blockingRatio);
+    }
+
+    inline bool exists(int x, int y) const
+    { return (x >= 0) && (y >= 0) && (x < mSizeX) && (y < mSizeY); }
+
+    inline bool isBlocking(int x, int y) const
+    { return mBlocking[x + y * mSizeX]; }
+
+    int mSizeX;
+    int mSizeY;
+    std::vector<bool> mBlocking;
+};
+
+/*! \brief Line of sight as it was computed before SightTemplate: the hidden tiles lists are computed
+ * once but the 8 octants are built and every blocking tile propagates its lists at each call.
+ */
+class LegacySight
+{
+public:
+    LegacySight(int radius)
+    {
+        int radiusSquared = radius * radius;
+        for(int y = 0; y <= radius; ++y)
+        {
+            for(int x = y; x <= radius; ++x)
+            {
+                if(x * x + y * y > radiusSquared)
+                    continue;
+
+                Entry entry;
+                entry.mX = x;
+                entry.mY = y;
+                entry.mDistSquared = x * x + y * y;
+                mEntries.push_back(entry);
+            }
+        }
+        std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry& e1, const Entry& e2)
+            { return e1.mDistSquared < e2.mDistSquared; });
+
+        for(Entry& entry : mEntries)
+        {
+            for(uint32_t j = 0; j < mEntries.size(); ++j)
+            {
+                bool north;
+                double value;
+                if(!SightTemplate::computeHiding(entry.mX, entry.mY, mEntries[j].mX, mEntries[j].mY, north, value))
+                    continue;
+
+                if(north)
+                    entry.mHiddenNorth.push_back(std::make_pair(j, value));
+                else
+                    entry.mHiddenSouth.push_back(std::make_pair(j, value));
+            }
+        }
+    }
+
+    std::vector<Position> visibleTiles(const TestMap& map, int x, int y) const
+    {
+        std::vector<Position> returnList;
+        std::vector<Process> tilesProcess[8];
+        for(uint32_t k = 0; k < 8; ++k)
+        {
+            for(const Entry& entry : mEntries)
+            {
+                const int slotsX[8] = {  entry.mX,  entry.mY, -entry.mX, -entry.mY,  entry.mY,  entry.mX, -entry.mY, -entry.mX };
+                const int slotsY[8] = {  entry.mY, -entry.mX, -entry.mY,  entry.mX,  entry.mX, -entry.mY, -entry.mX,  entry.mY };
+                Process process;
+                process.mEntry = &entry;
+                process.mX = x + slotsX[k];
+                process.mY = y + slotsY[k];
+                process.mExists = map.exists(process.mX, process.mY);
+                process.mHiddenNorth = 0.0;
+                process.mHiddenSouth = 0.0;
+                tilesProcess[k].push_back(process);
+            }
+        }
+
+        for(uint32_t k = 0; k < 8; ++k)
+        {
+            for(Process& process : tilesProcess[k])
+            {
+                if(!process.mExists || !map.isBlocking(process.mX, process.mY))
+                    continue;
+
+                for(const std::pair<uint32_t, double>& p : process.mEntry->mHiddenNorth)
+                    tilesProcess[k][p.first].mHiddenNorth = std::max(tilesProcess[k][p.first].mHiddenNorth, p.second);
+                for(const std::pair<uint32_t, double>& p : process.mEntry->mHiddenSouth)
+                    tilesProcess[k][p.first].mHiddenSouth = std::max(tilesProcess[k][p.first].mHiddenSouth, p.second);
+            }
+        }
+
+        for(uint32_t i = 0; i < mEntries.size(); ++i)
+        {
+            for(uint32_t k = 0; k < 8; ++k)
+            {
+                Process& process = tilesProcess[k][i];
+                if(!process.mExists)
+                    continue;
+                if((k > 0) && (process.mEntry->mDistSquared == 0))
+                    continue;
+
+                bool isHorizontal = (process.mEntry->mY == 0);
+                bool isDiagonal = !isHorizontal && (process.mEntry->mX == process.mEntry->mY);
+                if((isHorizontal || isDiagonal) && (k > 3))
+                    continue;
+
+                if(isDiagonal)
+                {
+                    process.mHiddenNorth = std::max(process.mHiddenNorth, tilesProcess[k + 4][i].mHiddenSouth);
+                    process.mHiddenSouth = std::max(process.mHiddenSouth, tilesProcess[k + 4][i].mHiddenNorth);
+                }
+
+                if(process.mHiddenNorth + process.mHiddenSouth > 0.5)
+                    continue;
+
+                returnList.push_back(Position(process.mX, process.mY));
+            }
+        }
+        return returnList;
+    }
+
+private:
+    struct Entry
+    {
+        int mX;
+        int mY;
+        int mDistSquared;
+        std::vector<std::pair<uint32_t, double>> mHiddenNorth;
+        std::vector<std::pair<uint32_t, double>> mHiddenSouth;
+    };
+
+    struct Process
+    {
+        const Entry* mEntry;
+        int mX;
+        int mY;
+        bool mExists;
+        double mHiddenNorth;
+        double mHiddenSouth;
+    };
+
+    std::vector<Entry> mEntries;
+};
+
+//! \brief Same as TileContainer::visibleTiles
+static void visibleTiles(const SightTemplate& sightTemplate, const TestMap& map, int x, int y,
+    std::vector<Position>& tiles)
+{
+    static std::vector<uint64_t> blocking;
+    static SightTemplate::Buffers buffers;
+
+    tiles.clear();
+    uint32_t stride = sightTemplate.getStride();
+    blocking.assign(SightTemplate::NB_OCTANTS * sightTemplate.getNbWords(), 0);
+    for(uint32_t k = 0; k < SightTemplate::NB_OCTANTS; ++k)
+    {
+        for(uint32_t i = 0; i < sightTemplate.getNbEntries(); ++i)
+        {
+            uint32_t slot = k * stride + i;
+            int xx = x + sightTemplate.getSlotX(slot);
+            int yy = y + sightTemplate.getSlotY(slot);
+            if(map.exists(xx, yy) && map.isBlocking(xx, yy))
+                blocking[slot / 64] |= (static_cast<uint64_t>(1) << (slot % 64));
+        }
+    }
+
+    sightTemplate.computeHidden(blocking, buffers);
+
+    for(uint32_t slot : sightTemplate.getOutputSlots())
+    {
+        int xx = x + sightTemplate.getSlotX(slot);
+        int yy = y + sightTemplate.getSlotY(slot);
+        if(!map.exists(xx, yy))
+            continue;
+        if(SightTemplate::isHidden(buffers, slot))
+            continue;
+
+        tiles.push_back(Position(xx, yy));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_SightTemplateNoObstacle)
+{
+    // Without obstacle, every tile within radius is visible once
+    TestMap map(21, 21, 0.0, 0);
+    SightTemplate sightTemplate(10);
+    std::vector<Position> tiles;
+    visibleTiles(sightTemplate, map, 10, 10, tiles);
+    BOOST_CHECK(tiles.front() == Position(10, 10));
+
+    uint32_t nbTiles = 0;
+    for(int y = 0; y < 21; ++y)
+    {
+        for(int x = 0; x < 21; ++x)
+        {
+            if((x - 10) * (x - 10) + (y - 10) * (y - 10) <= 100)
+                ++nbTiles;
+        }
+    }
+    BOOST_CHECK(tiles.size() == nbTiles);
+    std::sort(tiles.begin(), tiles.end());
+    BOOST_CHECK(std::unique(tiles.begin(), tiles.end()) == tiles.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_SightTemplateSameAsLegacy)
+{
+    std::vector<Position> tiles;
+    for(int radius = 0; radius <= 16; ++radius)
+    {
+        SightTemplate sightTemplate(radius);
+        LegacySight legacySight(radius);
+        for(uint32_t seed = 0; seed < 5; ++seed)
+        {
+            TestMap map(40, 40, 0.1 * seed, seed);
+            for(int y = 0; y < map.mSizeY; y += 3)
+            {
+                for(int x = 0; x < map.mSizeX; x += 3)
+                {
+                    visibleTiles(sightTemplate, map, x, y, tiles);
+                    BOOST_CHECK(tiles == legacySight.visibleTiles(map, x, y));
+                }
+            }
+        }
+    }
+}
+
+// Disabled by default as it only measures times. It can be run with --run_test=bench_SightTemplate --log_level=message
+BOOST_AUTO_TEST_CASE(bench_SightTemplate, *boost::unit_test::disabled())
+{
+    // Compares the time needed to compute the visible tiles with the legacy algorithm and with
+    // SightTemplate for usual creature sight radius
+    TestMap map(100, 100, 0.2, 42);
+    const int radiuses[3] = { 6, 10, 15 };
+    const int nbCalls = 20000;
+    std::vector<Position> tiles;
+    for(int radius : radiuses)
+    {
+        SightTemplate sightTemplate(radius);
+        LegacySight legacySight(radius);
+        std::mt19937 gen(radius);
+        std::uniform_int_distribution<int> dist(0, 99);
+        std::vector<Position> viewers;
+        for(int i = 0; i < nbCalls; ++i)
+            viewers.push_back(Position(dist(gen), dist(gen)));
+
+        size_t nbLegacyTiles = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(const Position& viewer : viewers)
+            nbLegacyTiles += legacySight.visibleTiles(map, viewer.first, viewer.second).size();
+        auto legacyTime = std::chrono::steady_clock::now() - start;
+
+        size_t nbTemplateTiles = 0;
+        start = std::chrono::steady_clock::now();
+        for(const Position& viewer : viewers)
+        {
+            visibleTiles(sightTemplate, map, viewer.first, viewer.second, tiles);
+            nbTemplateTiles += tiles.size();
+        }
+        auto templateTime = std::chrono::steady_clock::now() - start;
+
+        BOOST_CHECK(nbLegacyTiles == nbTemplateTiles);
+        BOOST_TEST_MESSAGE("radius=" << radius
+            << ", legacy=" << std::chrono::duration_cast<std::chrono::nanoseconds>(legacyTime).count() / nbCalls << "ns/call"
+            << ", template=" << std::chrono::duration_cast<std::chrono::nanoseconds>(templateTime).count() / nbCalls << "ns/call");
+    }
+}
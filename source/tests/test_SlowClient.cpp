@@ -0,0 +1,200 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "network/ODSocketServer.h"
+#include "network/ServerNotification.h"
+#include "utils/Helper.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#define BOOST_TEST_MODULE SlowClient
+#include <BoostTestTargetConfig.h>
+
+#include <SFML/System.hpp>
+
+#include <atomic>
+
+static const int TEST_PORT = 32223;
+static const int32_t TURN_LENGTH_MS = 20;
+static const uint32_t MAX_TURNS = 1000;
+//! \brief Size of the message that cannot be dropped sent each turn
+static const uint32_t TURN_DATA_SIZE = 256 * 1024;
+
+//! \brief Server sending a lot of data each turn to its clients
+class ODServerSlowClient : public ODSocketServer
+{
+public:
+    ODServerSlowClient() :
+        mIsDone(false),
+        mMaxTurnMs(0),
+        mNbDropped(0),
+        mNbCollapsed(0),
+        mNbTurns(0),
+        mHasClientConnected(false)
+    {}
+
+    std::atomic<bool> mIsDone;
+    int32_t mMaxTurnMs;
+    uint64_t mNbDropped;
+    uint64_t mNbCollapsed;
+    uint32_t mNbTurns;
+
+protected:
+    bool notifyNewConnection(ODSocketClient* client) override
+    {
+        mHasClientConnected = true;
+        return true;
+    }
+
+    bool notifyClientMessage(ODSocketClient* client) override
+    {
+        ODPacket packet;
+        return client->recv(packet) == ODSocketClient::ODComStatus::OK;
+    }
+
+    void serverThread() override
+    {
+        std::string turnData(TURN_DATA_SIZE, 'x');
+        sf::Clock clock;
+        while(isConnected() && (mNbTurns < MAX_TURNS))
+        {
+            doTask(TURN_LENGTH_MS);
+            if(!mHasClientConnected)
+                continue;
+
+            // The client has been disconnected
+            if(mSockClients.empty())
+                break;
+
+            clock.restart();
+            for(ODSocketClient* client : mSockClients)
+            {
+                ODPacket packetData;
+                packetData << ServerNotificationType::turnStarted << mNbTurns << turnData;
+                client->sendInBatch(packetData);
+
+                ODPacket packetSound;
+                packetSound << ServerNotificationType::playRelativeSound << mNbTurns;
+                client->sendInBatch(packetSound, ODSocketClient::BacklogPolicy::drop);
+
+                ODPacket packetWalk;
+                packetWalk << ServerNotificationType::animatedObjectSetWalkPath << mNbTurns;
+                client->sendInBatch(packetWalk, ODSocketClient::BacklogPolicy::collapse, "walk");
+
+                client->flushBatch();
+
+                // Sent right away but after the turn data
+                ODPacket packetChat;
+                packetChat << ServerNotificationType::chatServer << mNbTurns;
+                client->send(packetChat);
+
+                mNbDropped = client->getNbPacketsDropped();
+                mNbCollapsed = client->getNbPacketsCollapsed();
+            }
+            mMaxTurnMs = std::max(mMaxTurnMs, clock.getElapsedTime().asMilliseconds());
+            ++mNbTurns;
+        }
+        mIsDone = true;
+    }
+
+private:
+    bool mHasClientConnected;
+};
+
+//! \brief Client reading the messages slower than the server sends them
+class ODClientSlow : public ODSocketClient
+{
+public:
+    bool connectToServer()
+    {
+        return connect("localhost", TEST_PORT, 5000, "test_SlowClient.odr");
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_SlowClient)
+{
+    LogManager logMgr;
+    logMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+
+    ODServerSlowClient server;
+    BOOST_REQUIRE(server.createServer(TEST_PORT));
+
+    ODClientSlow client;
+    BOOST_REQUIRE(client.connectToServer());
+    uint32_t nbBatches = 0;
+    uint32_t nbTurnsReceived = 0;
+    uint32_t nbChatsReceived = 0;
+    bool isOrderOk = true;
+    bool isChatOrderOk = true;
+    while(!server.mIsDone.load())
+    {
+        sf::sleep(sf::milliseconds(200));
+        ODPacket packet;
+        if(client.recv(packet) != ODSocketClient::ODComStatus::OK)
+            break;
+
+        ServerNotificationType type;
+        uint32_t turn;
+        BOOST_CHECK(packet >> type);
+        // The messages sent without batch should never be received before the turn data sent before them
+        if(type == ServerNotificationType::chatServer)
+        {
+            BOOST_CHECK(packet >> turn);
+            if(turn >= nbTurnsReceived)
+                isChatOrderOk = false;
+            ++nbChatsReceived;
+            continue;
+        }
+
+        ++nbBatches;
+        BOOST_CHECK(type == ServerNotificationType::turnBatch);
+        // The turn data messages are never dropped and should be received in order
+        ODPacket subPacket;
+        while(packet.readSubPacket(subPacket))
+        {
+            BOOST_CHECK(subPacket >> type >> turn);
+            if(type == ServerNotificationType::chatServer)
+            {
+                if(turn >= nbTurnsReceived)
+                    isChatOrderOk = false;
+                ++nbChatsReceived;
+                continue;
+            }
+
+            if(type != ServerNotificationType::turnStarted)
+                continue;
+
+            if(turn != nbTurnsReceived)
+                isOrderOk = false;
+            ++nbTurnsReceived;
+        }
+    }
+    client.disconnect();
+    while(!server.mIsDone.load())
+        sf::sleep(sf::milliseconds(10));
+
+    BOOST_CHECK(nbBatches > 0);
+    BOOST_CHECK(isOrderOk);
+    BOOST_CHECK(nbChatsReceived > 0);
+    BOOST_CHECK(isChatOrderOk);
+    // The server kept its turn rate while the client was late and finally disconnected it
+    BOOST_CHECK(server.mMaxTurnMs < 100);
+    BOOST_CHECK(server.mNbTurns < MAX_TURNS);
+    BOOST_CHECK(server.mNbDropped > 0);
+    BOOST_CHECK(server.mNbCollapsed > 0);
+    server.stopServer();
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE SpscQueue
+#include "BoostTestTargetConfig.h"
+
+#include "utils/SpscQueue.h"
+
+#include <memory>
+#include <thread>
+
+BOOST_AUTO_TEST_CASE(test_SpscQueueBounded)
+{
+    SpscQueue<int> queue(3);
+    BOOST_CHECK(queue.capacity() == 4);
+    BOOST_CHECK(queue.empty());
+
+    int value = 0;
+    BOOST_CHECK(!queue.pop(value));
+    BOOST_CHECK(queue.front() == nullptr);
+    for(int i = 1; i <= 4; ++i)
+        BOOST_CHECK(queue.push(i));
+
+    int extra = 5;
+    BOOST_CHECK(!queue.push(extra));
+    BOOST_CHECK(extra == 5);
+    BOOST_CHECK(queue.size() == 4);
+
+    // Values come out in order and the ring wraps around
+    BOOST_CHECK(*queue.front() == 1);
+    BOOST_CHECK(queue.pop(value) && (value == 1));
+    BOOST_CHECK(queue.push(extra));
+    for(int i = 2; i <= 5; ++i)
+        BOOST_CHECK(queue.pop(value) && (value == i));
+    BOOST_CHECK(queue.empty());
+
+    // Move only values
+    SpscQueue<std::unique_ptr<int>> ptrQueue(2);
+    std::unique_ptr<int> ptr(new int(42));
+    BOOST_CHECK(ptrQueue.push(ptr));
+    BOOST_CHECK(ptr == nullptr);
+    BOOST_CHECK(ptrQueue.pop(ptr) && (*ptr == 42));
+}
+
+BOOST_AUTO_TEST_CASE(test_SpscQueueThreads)
+{
+    const uint32_t nbValues = 200000;
+    SpscQueue<uint32_t> queue(64);
+    std::thread producer([&]()
+    {
+        for(uint32_t i = 0; i < nbValues; ++i)
+        {
+            uint32_t value = i;
+            while(!queue.push(value))
+                std::this_thread::yield();
+        }
+    });
+
+    uint32_t nbOk = 0;
+    uint32_t expected = 0;
+    while(expected < nbValues)
+    {
+        uint32_t value;
+        if(!queue.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if(value == expected)
+            ++nbOk;
+        ++expected;
+    }
+    producer.join();
+    BOOST_CHECK(nbOk == nbValues);
+    BOOST_CHECK(queue.empty());
+}
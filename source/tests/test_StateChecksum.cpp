@@ -0,0 +1,89 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE StateChecksum
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/StateChecksum.h"
+#include "network/ODPacket.h"
+
+static uint64_t hashValues(int32_t i, double d, const std::string& s)
+{
+    StateHasher hasher;
+    hasher.add(i);
+    hasher.add(d);
+    hasher.add(s);
+    return hasher.getHash();
+}
+
+BOOST_AUTO_TEST_CASE(test_StateHasher)
+{
+    BOOST_CHECK_EQUAL(hashValues(3, 1.5, "Troll1"), hashValues(3, 1.5, "Troll1"));
+    BOOST_CHECK(hashValues(3, 1.5, "Troll1") != hashValues(4, 1.5, "Troll1"));
+    BOOST_CHECK(hashValues(3, 1.5, "Troll1") != hashValues(3, 1.5000001, "Troll1"));
+    BOOST_CHECK(hashValues(3, 1.5, "Troll1") != hashValues(3, 1.5, "Troll2"));
+
+    // The size of the strings is hashed so that values cannot move from one string to the next
+    StateHasher hasher1;
+    hasher1.add(std::string("ab"));
+    hasher1.add(std::string("c"));
+    StateHasher hasher2;
+    hasher2.add(std::string("a"));
+    hasher2.add(std::string("bc"));
+    BOOST_CHECK(hasher1.getHash() != hasher2.getHash());
+}
+
+BOOST_AUTO_TEST_CASE(test_StateChecksumDivergence)
+{
+    StateChecksum checksum1;
+    StateChecksum checksum2;
+    for(uint64_t turn = 0; turn < 5; ++turn)
+    {
+        checksum1.update(StateChecksum::Subsystem::tiles, turn);
+        checksum2.update(StateChecksum::Subsystem::tiles, turn);
+        checksum1.update(StateChecksum::Subsystem::rooms, turn * 2);
+        checksum2.update(StateChecksum::Subsystem::rooms, turn * 2);
+    }
+    BOOST_CHECK(checksum1.firstDivergingSubsystem(checksum2) == StateChecksum::Subsystem::nb);
+    BOOST_CHECK_EQUAL(checksum1.getGlobalHash(), checksum2.getGlobalHash());
+
+    // Once a subsystem diverged, it stays different even if the states are the same again
+    checksum1.update(StateChecksum::Subsystem::rooms, 100);
+    checksum2.update(StateChecksum::Subsystem::rooms, 101);
+    checksum1.update(StateChecksum::Subsystem::rooms, 102);
+    checksum2.update(StateChecksum::Subsystem::rooms, 102);
+    BOOST_CHECK(checksum1.firstDivergingSubsystem(checksum2) == StateChecksum::Subsystem::rooms);
+    BOOST_CHECK(checksum1.getGlobalHash() != checksum2.getGlobalHash());
+
+    // The first diverging subsystem is reported
+    checksum1.update(StateChecksum::Subsystem::creatures, 1);
+    BOOST_CHECK(checksum1.firstDivergingSubsystem(checksum2) == StateChecksum::Subsystem::creatures);
+    BOOST_CHECK_EQUAL(StateChecksum::toString(StateChecksum::Subsystem::creatures), "creatures");
+}
+
+BOOST_AUTO_TEST_CASE(test_StateChecksumPacket)
+{
+    StateChecksum checksum;
+    checksum.update(StateChecksum::Subsystem::tiles, 1);
+    checksum.update(StateChecksum::Subsystem::seats, 2);
+
+    ODPacket packet;
+    packet << checksum;
+    StateChecksum received;
+    BOOST_CHECK(packet >> received);
+    BOOST_CHECK(received.firstDivergingSubsystem(checksum) == StateChecksum::Subsystem::nb);
+}
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE StreamCompression
+#include "BoostTestTargetConfig.h"
+
+#include "network/StreamCompression.h"
+
+#include <string>
+
+static bool roundTrip(StreamCompressor& compressor, StreamDecompressor& decompressor, const std::string& block, uint32_t& compressedSize)
+{
+    std::vector<char> compressed;
+    compressor.compress(block.data(), static_cast<uint32_t>(block.size()), compressed);
+    compressedSize = static_cast<uint32_t>(compressed.size());
+    std::vector<char> decompressed;
+    if(!decompressor.decompress(compressed.data(), compressedSize, decompressed))
+        return false;
+
+    return std::string(decompressed.begin(), decompressed.end()) == block;
+}
+
+BOOST_AUTO_TEST_CASE(test_StreamCompressionBlocks)
+{
+    StreamCompressor compressor;
+    StreamDecompressor decompressor;
+    uint32_t compressedSize;
+
+    BOOST_CHECK(roundTrip(compressor, decompressor, std::string(), compressedSize));
+    BOOST_CHECK(roundTrip(compressor, decompressor, "abc", compressedSize));
+
+    // Redundant data shrinks
+    std::string tiles;
+    for(uint32_t i = 0; i < 500; ++i)
+        tiles += "Tile_" + std::to_string(i % 7) + "_Claimed;";
+    BOOST_CHECK(roundTrip(compressor, decompressor, tiles, compressedSize));
+    BOOST_CHECK(compressedSize < tiles.size() / 4);
+
+    // Data seen in the previous blocks is used as dictionary
+    std::string entity = "Creature=Goblin12;Animation=Walk;Seat=2;";
+    StreamCompressor compressorAlone;
+    StreamDecompressor decompressorAlone;
+    uint32_t compressedSizeAlone;
+    BOOST_CHECK(roundTrip(compressorAlone, decompressorAlone, entity, compressedSizeAlone));
+    BOOST_CHECK(roundTrip(compressor, decompressor, "Creature=Goblin12;Animation=Walk;Seat=2;", compressedSize));
+    BOOST_CHECK(roundTrip(compressor, decompressor, entity, compressedSize));
+    BOOST_CHECK(compressedSize < compressedSizeAlone / 2);
+
+    // Random like data is stored as is
+    std::string noise;
+    uint32_t seed = 12345;
+    for(uint32_t i = 0; i < 3000; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        noise.push_back(static_cast<char>(seed >> 16));
+    }
+    BOOST_CHECK(roundTrip(compressor, decompressor, noise, compressedSize));
+    BOOST_CHECK(compressedSize <= noise.size() + 5);
+
+    // Many blocks so that the history is trimmed on both sides
+    for(uint32_t i = 0; i < 100; ++i)
+    {
+        std::string block = tiles.substr(i * 7, 1000 + i * 20) + noise.substr(i, 200);
+        BOOST_CHECK(roundTrip(compressor, decompressor, block, compressedSize));
+    }
+
+    // After reset, a new decompressor can read the stream
+    compressor.reset();
+    StreamDecompressor newDecompressor;
+    BOOST_CHECK(roundTrip(compressor, newDecompressor, entity, compressedSize));
+}
+
+BOOST_AUTO_TEST_CASE(test_StreamCompressionInvalid)
+{
+    StreamCompressor compressor;
+    std::string block(2000, 'a');
+    std::vector<char> compressed;
+    compressor.compress(block.data(), static_cast<uint32_t>(block.size()), compressed);
+
+    StreamDecompressor decompressor;
+    std::vector<char> decompressed;
+    BOOST_CHECK(!decompressor.decompress(compressed.data(), static_cast<uint32_t>(compressed.size() - 1), decompressed));
+    BOOST_CHECK(!decompressor.decompress(compressed.data(), 3, decompressed));
+
+    // A match referring to data before the beginning of the stream
+    const char invalid[] = { 1, 8, 0, 0, 0, 0x14, 'a', 10, 0 };
+    BOOST_CHECK(!decompressor.decompress(invalid, sizeof(invalid), decompressed));
+
+    // The failures did not break the stream
+    BOOST_CHECK(decompressor.decompress(compressed.data(), static_cast<uint32_t>(compressed.size()), decompressed));
+    BOOST_CHECK(std::string(decompressed.begin(), decompressed.end()) == block);
+}
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE ThreadPool
+#include "BoostTestTargetConfig.h"
+
+#include "utils/ThreadPool.h"
+
+#include <atomic>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(test_ThreadPoolCoversEveryIndex)
+{
+    ThreadPool pool(4);
+    BOOST_CHECK(pool.getNbThreads() == 4);
+
+    // Every index is processed exactly once whatever the chunk size
+    const uint32_t chunkSizes[] = { 1, 3, 64, 1000 };
+    for(uint32_t chunkSize : chunkSizes)
+    {
+        std::vector<std::atomic<uint32_t>> nbCalls(997);
+        for(std::atomic<uint32_t>& nb : nbCalls)
+            nb = 0;
+
+        std::atomic<bool> isThreadIndexValid(true);
+        pool.parallelFor(static_cast<uint32_t>(nbCalls.size()), chunkSize, [&](uint32_t index, uint32_t threadIndex)
+        {
+            ++nbCalls[index];
+            if(threadIndex >= 4)
+                isThreadIndexValid = false;
+        });
+
+        BOOST_CHECK(isThreadIndexValid);
+        for(const std::atomic<uint32_t>& nb : nbCalls)
+            BOOST_CHECK(nb == 1);
+    }
+
+    // Nothing to do
+    bool isCalled = false;
+    pool.parallelFor(0, 1, [&](uint32_t, uint32_t) { isCalled = true; });
+    BOOST_CHECK(!isCalled);
+}
+
+BOOST_AUTO_TEST_CASE(test_ThreadPoolDeterministicResult)
+{
+    // Results written by index do not depend on the threads
+    std::vector<uint64_t> expected(5000);
+    for(uint32_t i = 0; i < expected.size(); ++i)
+        expected[i] = static_cast<uint64_t>(i) * i + 7;
+
+    ThreadPool pool(8);
+    for(uint32_t run = 0; run < 20; ++run)
+    {
+        std::vector<uint64_t> results(expected.size(), 0);
+        // Per thread sums show the work is shared without depending on how
+        std::vector<uint64_t> threadSums(pool.getNbThreads(), 0);
+        pool.parallelFor(static_cast<uint32_t>(results.size()), 16, [&](uint32_t index, uint32_t threadIndex)
+        {
+            results[index] = static_cast<uint64_t>(index) * index + 7;
+            threadSums[threadIndex] += results[index];
+        });
+        BOOST_CHECK(results == expected);
+
+        uint64_t total = 0;
+        for(uint64_t sum : threadSums)
+            total += sum;
+        uint64_t expectedTotal = 0;
+        for(uint64_t value : expected)
+            expectedTotal += value;
+        BOOST_CHECK(total == expectedTotal);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ThreadPoolSingleThread)
+{
+    // With 1 thread, everything runs in order in the caller
+    ThreadPool pool(1);
+    std::vector<uint32_t> order;
+    pool.parallelFor(10, 3, [&](uint32_t index, uint32_t threadIndex)
+    {
+        BOOST_CHECK(threadIndex == 0);
+        order.push_back(index);
+    });
+    BOOST_CHECK(order == std::vector<uint32_t>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }));
+}
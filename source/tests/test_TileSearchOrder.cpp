@@ -0,0 +1,154 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE TileSearchOrder
+#include "BoostTestTargetConfig.h"
+
+#include "gamemap/TileSearchOrder.h"
+
+#include <random>
+
+//! \brief Minimal tile with what TileSearchOrder uses
+class TestTile
+{
+public:
+    TestTile(int x, int y) :
+        mX(x),
+        mY(y),
+        mIsMatching(false)
+    {}
+
+    int getX() const
+    { return mX; }
+    int getY() const
+    { return mY; }
+    const std::vector<TestTile*>& getAllNeighbors() const
+    { return mNeighbors; }
+
+    int mX;
+    int mY;
+    bool mIsMatching;
+    std::vector<TestTile*> mNeighbors;
+};
+
+static const int MAP_SIZE = 20;
+
+static std::vector<TestTile> buildMap()
+{
+    std::vector<TestTile> map;
+    for(int y = 0; y < MAP_SIZE; ++y)
+    {
+        for(int x = 0; x < MAP_SIZE; ++x)
+            map.push_back(TestTile(x, y));
+    }
+
+    for(TestTile& tile : map)
+    {
+        const int dx[] = { -1, 1, 0, 0 };
+        const int dy[] = { 0, 0, -1, 1 };
+        for(int i = 0; i < 4; ++i)
+        {
+            int x = tile.mX + dx[i];
+            int y = tile.mY + dy[i];
+            if((x >= 0) && (y >= 0) && (x < MAP_SIZE) && (y < MAP_SIZE))
+                tile.mNeighbors.push_back(&map[x + y * MAP_SIZE]);
+        }
+    }
+    return map;
+}
+
+//! \brief Search like the creature actions do: the first closest matching tile is kept
+static TestTile* fullSearch(const TestTile& center, const std::vector<TestTile*>& tiles, bool withNeighbors)
+{
+    int distBest = -1;
+    TestTile* best = nullptr;
+    for(TestTile* tile : tiles)
+    {
+        std::vector<TestTile*> targets;
+        if(withNeighbors)
+            targets = tile->getAllNeighbors();
+        else
+            targets.push_back(tile);
+
+        for(TestTile* target : targets)
+        {
+            if(!target->mIsMatching)
+                continue;
+
+            int dist = Pathfinding::squaredDistanceTile(center, *target);
+            if((distBest != -1) && (distBest <= dist))
+                continue;
+
+            distBest = dist;
+            best = tile;
+        }
+    }
+    return best;
+}
+
+static TestTile* orderedSearch(const TileSearchOrder<TestTile>& order)
+{
+    for(const TileSearchOrder<TestTile>::Candidate& candidate : order.getCandidates())
+    {
+        if(candidate.mTarget->mIsMatching)
+            return candidate.mTile;
+    }
+    return nullptr;
+}
+
+BOOST_AUTO_TEST_CASE(test_TileSearchOrderSameResultAsFullSearch)
+{
+    std::vector<TestTile> map = buildMap();
+    std::mt19937 generator(42);
+    for(int run = 0; run < 200; ++run)
+    {
+        TestTile& center = map[generator() % map.size()];
+        std::vector<TestTile*> tiles;
+        for(TestTile& tile : map)
+        {
+            tile.mIsMatching = (generator() % 10) == 0;
+            if(Pathfinding::squaredDistanceTile(center, tile) <= 36)
+                tiles.push_back(&tile);
+        }
+        // The order of the tiles matters for the tiles at the same distance
+        std::shuffle(tiles.begin(), tiles.end(), generator);
+
+        bool withNeighbors = (run % 2) == 1;
+        TileSearchOrder<TestTile> order;
+        order.compute(&center, tiles, 1, withNeighbors);
+        BOOST_CHECK(orderedSearch(order) == fullSearch(center, tiles, withNeighbors));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_TileSearchOrderValidity)
+{
+    std::vector<TestTile> map = buildMap();
+    TestTile* tile = &map[5 + 5 * MAP_SIZE];
+    TileSearchOrder<TestTile> order;
+    BOOST_CHECK(!order.isValid(tile, 0));
+
+    std::vector<TestTile*> tiles = { tile, tile->mNeighbors[0], nullptr };
+    order.compute(tile, tiles, 3, true);
+    BOOST_CHECK(order.isValid(tile, 3));
+    BOOST_CHECK(!order.isValid(tile, 4));
+    BOOST_CHECK(!order.isValid(tile->mNeighbors[0], 3));
+
+    // One candidate per neighbor, null tiles ignored, closest first
+    BOOST_CHECK(order.getCandidates().size() == tile->mNeighbors.size() + tile->mNeighbors[0]->mNeighbors.size());
+    BOOST_CHECK(order.getCandidates().front().mDist == 0);
+    BOOST_CHECK(order.getCandidates().front().mTarget == tile);
+}
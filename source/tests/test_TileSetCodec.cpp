@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE TileSetCodec
+#include "BoostTestTargetConfig.h"
+
+#include "network/TileSetCodec.h"
+#include "network/ODPacket.h"
+
+#include <algorithm>
+
+typedef std::vector<std::pair<int32_t, int32_t>> Coords;
+
+//! \brief Writes and reads back the given coordinates. Returns the encoding used
+static TileSetCodec::Encoding checkRoundTrip(Coords coords)
+{
+    std::sort(coords.begin(), coords.end(), TileSetCodec::lessRowMajor);
+    ODPacket packet;
+    TileSetCodec::Encoding encoding = TileSetCodec::write(packet, coords);
+    int32_t check = 42;
+    packet << check;
+
+    Coords readCoords;
+    BOOST_CHECK(TileSetCodec::read(packet, readCoords));
+    BOOST_CHECK(readCoords == coords);
+    check = 0;
+    BOOST_CHECK(packet >> check);
+    BOOST_CHECK(check == 42);
+    return encoding;
+}
+
+BOOST_AUTO_TEST_CASE(test_TileSetCodecEncodings)
+{
+    checkRoundTrip(Coords());
+    checkRoundTrip(Coords({ { 0, 0 } }));
+
+    // A few scattered tiles
+    BOOST_CHECK(checkRoundTrip(Coords({ { 3, 0 }, { 150, 2 }, { 0, 200 }, { 90, 200 }, { 91, 200 } }))
+        == TileSetCodec::Encoding::list);
+
+    // A horizontal wall and a vertical one far from each other
+    Coords coords;
+    for(int32_t x = 10; x < 60; ++x)
+        coords.push_back(std::make_pair(x, 5));
+    for(int32_t y = 100; y < 110; ++y)
+        coords.push_back(std::make_pair(150, y));
+    BOOST_CHECK(checkRoundTrip(coords) == TileSetCodec::Encoding::rows);
+
+    // A vision circle with some holes
+    coords.clear();
+    for(int32_t y = 20; y < 40; ++y)
+    {
+        for(int32_t x = 20; x < 40; ++x)
+        {
+            if((x * 7 + y * 3) % 4 == 0)
+                continue;
+            if((x - 30) * (x - 30) + (y - 30) * (y - 30) < 100)
+                coords.push_back(std::make_pair(x, y));
+        }
+    }
+    BOOST_CHECK(checkRoundTrip(coords) == TileSetCodec::Encoding::bitmap);
+}
+
+BOOST_AUTO_TEST_CASE(test_TileSetCodecInvalid)
+{
+    ODPacket packet;
+    uint8_t encoding = 12;
+    packet << encoding;
+    Coords coords;
+    BOOST_CHECK(!TileSetCodec::read(packet, coords));
+
+    // Truncated bitmap
+    ODPacket packet2;
+    encoding = static_cast<uint8_t>(TileSetCodec::Encoding::bitmap);
+    packet2 << encoding;
+    packet2.writeVarUInt(0);
+    packet2.writeVarUInt(0);
+    packet2.writeVarUInt(31);
+    packet2.writeVarUInt(31);
+    BOOST_CHECK(!TileSetCodec::read(packet2, coords));
+}
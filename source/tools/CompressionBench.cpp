@@ -0,0 +1,149 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the compression of recorded sessions. Usage:
+ *   od-compressionbench replay1.odr [replay2.odr ...]
+ * For each replay, the packets are compressed as a stream (like on a network connection or in a
+ * replay file) and one by one (without dictionary reuse). The sizes and the time spent to compress
+ * and decompress are printed.
+ */
+
+#include "network/ReplayFile.h"
+#include "network/StreamCompression.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double toSeconds(Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+static double toMBPerSecond(uint64_t nbBytes, double seconds)
+{
+    if(seconds <= 0.0)
+        return 0.0;
+
+    return static_cast<double>(nbBytes) / (1024.0 * 1024.0) / seconds;
+}
+
+static bool loadReplay(const std::string& filename, std::vector<std::vector<char>>& packets, uint64_t& nbBytes)
+{
+    ReplayReader reader;
+    if(!reader.open(filename))
+        return false;
+
+    const char* data;
+    uint32_t size;
+    while(reader.readRecord(data, size) >= 0)
+    {
+        packets.push_back(std::vector<char>(data, data + size));
+        nbBytes += size;
+    }
+    return true;
+}
+
+static void printResult(const std::string& name, uint64_t rawBytes, uint64_t compressedBytes,
+    double compressSeconds, double decompressSeconds)
+{
+    double ratio = (compressedBytes == 0) ? 0.0 : static_cast<double>(rawBytes) / static_cast<double>(compressedBytes);
+    std::cout << "  " << std::left << std::setw(12) << name << std::right
+        << std::setw(12) << compressedBytes << " bytes"
+        << "  ratio=" << std::fixed << std::setprecision(2) << ratio
+        << "  compress=" << std::setprecision(1) << toMBPerSecond(rawBytes, compressSeconds) << " MB/s"
+        << "  decompress=" << toMBPerSecond(rawBytes, decompressSeconds) << " MB/s"
+        << std::endl;
+}
+
+//! \brief Compresses the packets. If isStream is false, the dictionary is reset for each packet
+static bool benchCompression(const std::vector<std::vector<char>>& packets, uint64_t rawBytes, bool isStream)
+{
+    StreamCompressor compressor;
+    std::vector<std::vector<char>> compressedPackets(packets.size());
+    uint64_t compressedBytes = 0;
+    Clock::time_point start = Clock::now();
+    for(uint32_t i = 0; i < packets.size(); ++i)
+    {
+        if(!isStream)
+            compressor.reset();
+
+        const std::vector<char>& packet = packets[i];
+        compressor.compress(packet.data(), static_cast<uint32_t>(packet.size()), compressedPackets[i]);
+        compressedBytes += compressedPackets[i].size();
+    }
+    double compressSeconds = toSeconds(Clock::now() - start);
+
+    StreamDecompressor decompressor;
+    std::vector<char> decompressed;
+    bool isValid = true;
+    start = Clock::now();
+    for(uint32_t i = 0; i < compressedPackets.size(); ++i)
+    {
+        if(!isStream)
+            decompressor.reset();
+
+        const std::vector<char>& compressed = compressedPackets[i];
+        if(!decompressor.decompress(compressed.data(), static_cast<uint32_t>(compressed.size()), decompressed) ||
+           (decompressed != packets[i]))
+        {
+            isValid = false;
+            break;
+        }
+    }
+    double decompressSeconds = toSeconds(Clock::now() - start);
+
+    printResult(isStream ? "stream" : "per-packet", rawBytes, compressedBytes, compressSeconds, decompressSeconds);
+    if(!isValid)
+        std::cout << "  ERROR: decompressed data do not match" << std::endl;
+
+    return isValid;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " replay.odr [replay.odr ...]" << std::endl;
+        return 1;
+    }
+
+    bool isValid = true;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string filename = argv[i];
+        std::vector<std::vector<char>> packets;
+        uint64_t rawBytes = 0;
+        if(!loadReplay(filename, packets, rawBytes))
+        {
+            std::cout << filename << ": cannot open file" << std::endl;
+            isValid = false;
+            continue;
+        }
+
+        std::cout << filename << ": " << packets.size() << " packets, " << rawBytes << " bytes" << std::endl;
+        isValid = benchCompression(packets, rawBytes, true) && isValid;
+        isValid = benchCompression(packets, rawBytes, false) && isValid;
+    }
+
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Extracts statistics from replays without starting the game. Usage:
+ *   od-replayanalyzer [--json] replay.odr
+ * The replay is played as fast as possible through ODSocketClient (like the game does) but the
+ * messages are only decoded to be counted. For each turn, the number of messages and their size in
+ * bytes (in total and per message type) and the number of entities known by the client are written
+ * to the standard output as CSV (default) or JSON.
+ * Messages received before the first turn are reported with turn -1. The messages handled by
+ * ODSocketClient itself are counted too: internStrings (including the strings written again at each
+ * keyframe of the replay) and turnBatch, for which only the bytes added around the batched messages
+ * are counted since those are counted one by one.
+ */
+
+#include "entities/GameEntityType.h"
+#include "network/ODPacket.h"
+#include "network/ODSocketClient.h"
+#include "network/ServerNotification.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const uint32_t NB_MESSAGE_TYPES = static_cast<uint32_t>(ServerNotificationType::exit) + 1;
+
+struct MessageStats
+{
+    MessageStats() :
+        mNbMessages(0),
+        mNbBytes(0)
+    {}
+
+    void add(const MessageStats& stats)
+    {
+        mNbMessages += stats.mNbMessages;
+        mNbBytes += stats.mNbBytes;
+    }
+
+    uint64_t mNbMessages;
+    uint64_t mNbBytes;
+};
+
+struct TurnStats
+{
+    TurnStats() :
+        mTurn(-1),
+        mTimeMillis(0),
+        mNbEntities(0),
+        mNbCreatures(0),
+        mMessagesByType(NB_MESSAGE_TYPES)
+    {}
+
+    int64_t mTurn;
+    //! \brief Replay time when the turn started
+    int32_t mTimeMillis;
+    //! \brief Entities added and not removed yet at the end of the turn
+    int64_t mNbEntities;
+    int64_t mNbCreatures;
+    MessageStats mMessages;
+    std::vector<MessageStats> mMessagesByType;
+};
+
+static std::string messageTypeName(uint32_t type)
+{
+    return ServerNotification::typeString(static_cast<ServerNotificationType>(type));
+}
+
+//! \brief Writes the statistics in a given format
+class StatsWriter
+{
+public:
+    StatsWriter(std::ostream& os) :
+        mOs(os)
+    {}
+
+    virtual ~StatsWriter()
+    {}
+
+    virtual void writeBegin(const std::string& replayFilename) = 0;
+    virtual void writeTurn(const TurnStats& stats) = 0;
+
+    //! \brief Called once the whole replay is read. totals contains the statistics of every turn
+    virtual void writeEnd(const TurnStats& totals, uint64_t nbTurns) = 0;
+
+protected:
+    std::ostream& mOs;
+};
+
+//! \brief One line per turn with a fixed set of columns (every message type is listed)
+class CsvStatsWriter : public StatsWriter
+{
+public:
+    CsvStatsWriter(std::ostream& os) :
+        StatsWriter(os)
+    {}
+
+    void writeBegin(const std::string& replayFilename) override
+    {
+        mOs << "turn,time_ms,entities,creatures,messages,bytes";
+        for(uint32_t type = 0; type < NB_MESSAGE_TYPES; ++type)
+        {
+            std::string name = messageTypeName(type);
+            mOs << "," << name << "_messages," << name << "_bytes";
+        }
+        mOs << "\n";
+    }
+
+    void writeTurn(const TurnStats& stats) override
+    {
+        mOs << stats.mTurn << "," << stats.mTimeMillis << "," << stats.mNbEntities << "," << stats.mNbCreatures
+            << "," << stats.mMessages.mNbMessages << "," << stats.mMessages.mNbBytes;
+        for(const MessageStats& messages : stats.mMessagesByType)
+            mOs << "," << messages.mNbMessages << "," << messages.mNbBytes;
+        mOs << "\n";
+    }
+
+    void writeEnd(const TurnStats& totals, uint64_t nbTurns) override
+    {
+        mOs.flush();
+    }
+};
+
+//! \brief One object per turn (only the message types received are listed) followed by the totals
+class JsonStatsWriter : public StatsWriter
+{
+public:
+    JsonStatsWriter(std::ostream& os) :
+        StatsWriter(os),
+        mIsFirstTurn(true)
+    {}
+
+    void writeBegin(const std::string& replayFilename) override
+    {
+        mOs << "{\n  \"replay\": " << jsonString(replayFilename) << ",\n  \"turns\": [";
+    }
+
+    void writeTurn(const TurnStats& stats) override
+    {
+        mOs << (mIsFirstTurn ? "\n    " : ",\n    ");
+        mIsFirstTurn = false;
+        mOs << "{\"turn\": " << stats.mTurn << ", \"time_ms\": " << stats.mTimeMillis
+            << ", \"entities\": " << stats.mNbEntities << ", \"creatures\": " << stats.mNbCreatures << ", ";
+        writeMessages(stats);
+        mOs << "}";
+    }
+
+    void writeEnd(const TurnStats& totals, uint64_t nbTurns) override
+    {
+        mOs << "\n  ],\n  \"totals\": {\"turns\": " << nbTurns << ", ";
+        writeMessages(totals);
+        mOs << "}\n}\n";
+        mOs.flush();
+    }
+
+private:
+    bool mIsFirstTurn;
+
+    void writeMessages(const TurnStats& stats)
+    {
+        mOs << "\"messages\": " << stats.mMessages.mNbMessages << ", \"bytes\": " << stats.mMessages.mNbBytes
+            << ", \"types\": {";
+        bool isFirst = true;
+        for(uint32_t type = 0; type < NB_MESSAGE_TYPES; ++type)
+        {
+            const MessageStats& messages = stats.mMessagesByType[type];
+            if(messages.mNbMessages == 0)
+                continue;
+
+            mOs << (isFirst ? "" : ", ") << jsonString(messageTypeName(type)) << ": {\"messages\": "
+                << messages.mNbMessages << ", \"bytes\": " << messages.mNbBytes << "}";
+            isFirst = false;
+        }
+        mOs << "}";
+    }
+
+    static std::string jsonString(const std::string& str)
+    {
+        std::string escaped = "\"";
+        for(char c : str)
+        {
+            if((c == '"') || (c == '\\'))
+                escaped += '\\';
+            escaped += c;
+        }
+        escaped += "\"";
+        return escaped;
+    }
+};
+
+//! \brief Client reading a replay and computing the statistics of the received messages
+class ReplayAnalyzer : public ODSocketClient
+{
+public:
+    ReplayAnalyzer(StatsWriter& writer) :
+        mWriter(writer),
+        mNbTurns(0),
+        mNbPendingBatchBytes(0),
+        mIsReplayValid(true)
+    {}
+
+    //! \brief Reads the whole replay. Returns false if the replay cannot be opened or is corrupted
+    bool analyze(const std::string& filename)
+    {
+        if(!replay(filename))
+            return false;
+
+        mWriter.writeBegin(filename);
+        setReplaySpeed(REPLAY_SPEED_MAX);
+        while(isConnected() && !isReplayEnded())
+            processClientSocketMessages();
+
+        endTurn();
+        mWriter.writeEnd(mTotals, mNbTurns);
+        disconnect();
+        return mIsReplayValid;
+    }
+
+protected:
+    void messageReceived(ServerNotificationType cmd, uint32_t nbBytes) override
+    {
+        // The batch is counted in the turn of its first message (usually turnStarted)
+        if(cmd == ServerNotificationType::turnBatch)
+        {
+            mNbPendingBatchBytes += nbBytes;
+            return;
+        }
+
+        if(cmd == ServerNotificationType::turnStarted)
+        {
+            endTurn();
+            ++mNbTurns;
+        }
+
+        countMessage(cmd, nbBytes);
+        if(mNbPendingBatchBytes > 0)
+        {
+            countMessage(ServerNotificationType::turnBatch, mNbPendingBatchBytes);
+            mNbPendingBatchBytes = 0;
+        }
+    }
+
+    bool processMessage(ServerNotificationType cmd, ODPacket& packetReceived) override
+    {
+        if(cmd == ServerNotificationType::turnStarted)
+        {
+            int64_t turn;
+            OD_ASSERT_TRUE(packetReceived >> turn);
+            mTurn.mTurn = turn;
+            mTurn.mTimeMillis = getGameTimeMillis();
+        }
+
+        switch(cmd)
+        {
+            case ServerNotificationType::addEntity:
+            case ServerNotificationType::removeEntity:
+            {
+                GameEntityType entityType;
+                OD_ASSERT_TRUE(packetReceived >> entityType);
+                int64_t delta = (cmd == ServerNotificationType::addEntity) ? 1 : -1;
+                mTurn.mNbEntities += delta;
+                if(entityType == GameEntityType::creature)
+                    mTurn.mNbCreatures += delta;
+                break;
+            }
+            default:
+                break;
+        }
+
+        // We never stop the processing: the replay is read as fast as possible
+        return true;
+    }
+
+    void playerDisconnected() override
+    {
+        mIsReplayValid = false;
+        disconnect();
+    }
+
+private:
+    StatsWriter& mWriter;
+    //! \brief Turn being read
+    TurnStats mTurn;
+    TurnStats mTotals;
+    uint64_t mNbTurns;
+    //! \brief Bytes of the last batch received not counted yet
+    uint32_t mNbPendingBatchBytes;
+    bool mIsReplayValid;
+
+    void countMessage(ServerNotificationType cmd, uint32_t nbBytes)
+    {
+        uint32_t type = static_cast<uint32_t>(cmd);
+        if(type >= NB_MESSAGE_TYPES)
+            return;
+
+        MessageStats message;
+        message.mNbMessages = 1;
+        message.mNbBytes = nbBytes;
+        mTurn.mMessages.add(message);
+        mTurn.mMessagesByType[type].add(message);
+    }
+
+    //! \brief Writes the statistics of the current turn. The entity counts are kept for the next one
+    void endTurn()
+    {
+        if(mTurn.mMessages.mNbMessages == 0)
+            return;
+
+        mWriter.writeTurn(mTurn);
+        mTotals.mMessages.add(mTurn.mMessages);
+        for(uint32_t type = 0; type < NB_MESSAGE_TYPES; ++type)
+        {
+            mTotals.mMessagesByType[type].add(mTurn.mMessagesByType[type]);
+            mTurn.mMessagesByType[type] = MessageStats();
+        }
+        mTurn.mMessages = MessageStats();
+    }
+};
+
+int main(int argc, char** argv)
+{
+    bool isJson = false;
+    std::string filename;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--json")
+            isJson = true;
+        else if(arg == "--csv")
+            isJson = false;
+        else
+            filename = arg;
+    }
+
+    if(filename.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--csv|--json] replay.odr" << std::endl;
+        return 1;
+    }
+
+    // The output is written to stdout so only warnings and errors are logged (to stderr)
+    LogManager logMgr;
+    logMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+    logMgr.setLevel(LogMessageLevel::WARNING);
+
+    std::unique_ptr<StatsWriter> writer;
+    if(isJson)
+        writer.reset(new JsonStatsWriter(std::cout));
+    else
+        writer.reset(new CsvStatsWriter(std::cout));
+
+    ReplayAnalyzer analyzer(*writer);
+    if(!analyzer.analyze(filename))
+    {
+        std::cerr << filename << ": cannot open replay or replay corrupted" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the cost of the server turns without starting the game. Usage:
+ *   od-simbench [--turns N] [--ai easy|normal] [--threads T] [--seed S] path/to/map.level
+ * The level is loaded like the server does, every seat is given to a keeper AI and the turns are
+ * computed as fast as possible with a fixed length (no socket is created, the server notifications
+ * are dropped). The time spent in each phase of the turns, the number of pathfinding calls with the
+ * time spent in them and the state checksum of the final turn are written to the standard output as
+ * JSON. Two runs with the same level and seed give the same checksum, whatever the number of threads
+ * (test_GameMap checks it on the test levels), so it can be used to check that an optimization did not
+ * change the simulation.
+ * The options of the game (like --appData or --loglevel) are also accepted.
+ */
+
+#include "ODApplication.h"
+#include "ai/KeeperAIType.h"
+#include "entities/Tile.h"
+#include "game/Player.h"
+#include "game/Seat.h"
+#include "gamemap/GameMap.h"
+#include "network/ODServer.h"
+#include "utils/ConfigManager.h"
+#include "utils/Helper.h"
+#include "utils/LogManager.h"
+#include "utils/LogSinkConsole.h"
+#include "utils/Random.h"
+#include "utils/ResourceManager.h"
+#include "utils/ThreadPool.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+//! \brief Seed used when none is given so that the runs can be compared
+static const uint64_t DEFAULT_SEED = 1;
+
+static double toMillis(Clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(duration).count();
+}
+
+static double microsToMillis(uint64_t micros)
+{
+    return static_cast<double>(micros) / 1000.0;
+}
+
+static std::string jsonString(const std::string& str)
+{
+    std::string escaped = "\"";
+    for(char c : str)
+    {
+        if((c == '"') || (c == '\\'))
+            escaped += '\\';
+        escaped += c;
+    }
+    escaped += "\"";
+    return escaped;
+}
+
+//! \brief Configures the seats and starts the game the same way the server does once every
+//! player is ready. Every seat but the rogue one is played by a keeper AI of the given type
+static void startGame(GameMap& gameMap, KeeperAIType aiType)
+{
+    const std::vector<std::string>& factions = ConfigManager::getSingleton().getFactions();
+    for(Seat* seat : gameMap.getSeats())
+    {
+        if(seat->isRogueSeat())
+            continue;
+
+        // Seats where the faction can be chosen (or with an unknown one) use the first faction
+        if(std::find(factions.begin(), factions.end(), seat->getFaction()) == factions.end())
+            seat->setFaction(factions.front());
+
+        const std::vector<int>& availableTeamIds = seat->getAvailableTeamIds();
+        if(!availableTeamIds.empty())
+            seat->setTeamId(availableTeamIds.front());
+
+        Player* aiPlayer = new Player(&gameMap, 0);
+        aiPlayer->setNick("Keeper AI " + KeeperAITypes::toString(aiType) + " " + Helper::toString(seat->getId()));
+        gameMap.addPlayer(aiPlayer);
+        seat->setPlayer(aiPlayer);
+        gameMap.assignAI(*aiPlayer, aiType);
+        seat->setMapSize(gameMap.getMapSizeX(), gameMap.getMapSizeY());
+    }
+
+    const std::vector<Seat*>& seats = gameMap.getSeats();
+    for(Seat* seat : seats)
+        seat->initSeat();
+
+    gameMap.notifySeatsConfigured();
+
+    for (int jj = 0; jj < gameMap.getMapSizeY(); ++jj)
+    {
+        for (int ii = 0; ii < gameMap.getMapSizeX(); ++ii)
+            gameMap.getTile(ii, jj)->setSeats(seats);
+    }
+
+    for(Seat* seat : seats)
+    {
+        for(Seat* alliedSeat : seats)
+        {
+            if(alliedSeat == seat)
+                continue;
+            if(!seat->isAlliedSeat(alliedSeat))
+                continue;
+            seat->addAlliedSeat(alliedSeat);
+        }
+    }
+
+    gameMap.setTurnNumber(0);
+    gameMap.setGamePaused(false);
+    gameMap.createAllEntities();
+
+    for(Seat* seat : seats)
+    {
+        if(seat->getPlayer() == nullptr)
+            continue;
+
+        if(seat->getGold() > 0)
+            gameMap.addGoldToSeat(seat->getGold(), seat->getId());
+    }
+}
+
+//! \brief Computes one turn like ODServer::startNewTurn without the client notifications
+static void computeTurn(GameMap& gameMap, double timeSinceLastTurn)
+{
+    gameMap.setTurnNumber(gameMap.getTurnNumber() + 1);
+    gameMap.updateAnimations(timeSinceLastTurn);
+    gameMap.updateVisibleEntities();
+    gameMap.doTurn(timeSinceLastTurn);
+    gameMap.doPlayerAITurn(timeSinceLastTurn);
+    gameMap.fireRefreshEntities();
+    gameMap.processDeletionQueues();
+}
+
+static void writeResults(std::ostream& os, const std::string& levelFilename, uint64_t seed, KeeperAIType aiType,
+    GameMap& gameMap, std::vector<double>& turnMillis, double totalMillis, uint64_t nbPathCalls,
+    uint64_t nbFlowFieldHits, uint64_t nbFlowFieldMisses)
+{
+    const GameMap::TurnTimings& timings = gameMap.getTurnTimings();
+    uint32_t nbTurns = static_cast<uint32_t>(turnMillis.size());
+    double meanMillis = (nbTurns == 0) ? 0.0 : totalMillis / nbTurns;
+    double maxMillis = 0.0;
+    double medianMillis = 0.0;
+    if(nbTurns > 0)
+    {
+        maxMillis = *std::max_element(turnMillis.begin(), turnMillis.end());
+        std::nth_element(turnMillis.begin(), turnMillis.begin() + nbTurns / 2, turnMillis.end());
+        medianMillis = turnMillis[nbTurns / 2];
+    }
+
+    std::stringstream checksum;
+    checksum << std::hex << std::setw(16) << std::setfill('0') << gameMap.getStateChecksum().getGlobalHash();
+
+    os << std::fixed << std::setprecision(3);
+    os << "{\n";
+    os << "  \"level\": " << jsonString(levelFilename) << ",\n";
+    os << "  \"seed\": " << seed << ",\n";
+    os << "  \"ai\": " << jsonString(KeeperAITypes::toString(aiType)) << ",\n";
+    os << "  \"threads\": " << gameMap.getThreadPool()->getNbThreads() << ",\n";
+    os << "  \"turns\": " << nbTurns << ",\n";
+    os << "  \"creatures\": " << gameMap.getCreatures().size() << ",\n";
+    os << "  \"turn_ms\": {\"total\": " << totalMillis << ", \"mean\": " << meanMillis
+        << ", \"median\": " << medianMillis << ", \"max\": " << maxMillis << "},\n";
+    os << "  \"phases_ms\": {\"misc\": " << microsToMillis(timings.mMisc)
+        << ", \"vision\": " << microsToMillis(timings.mVision)
+        << ", \"search_order\": " << microsToMillis(timings.mSearchOrder)
+        << ", \"upkeep\": " << microsToMillis(timings.mUpkeep)
+        << ", \"seats\": " << microsToMillis(timings.mSeats)
+        << ", \"players\": " << microsToMillis(timings.mPlayers)
+        << ", \"ai\": " << microsToMillis(timings.mAI)
+        << ", \"flood_fill\": " << microsToMillis(timings.mFloodFill) << "},\n";
+    os << "  \"flood_fill_refreshes\": " << timings.mNbFloodFillRefreshes << ",\n";
+    os << "  \"path_calls\": " << nbPathCalls << ",\n";
+    os << "  \"path_ms\": " << static_cast<double>(timings.mPath) / 1000000.0 << ",\n";
+    os << "  \"flow_field_hits\": " << nbFlowFieldHits << ",\n";
+    os << "  \"flow_field_misses\": " << nbFlowFieldMisses << ",\n";
+    os << "  \"state_checksum\": \"" << checksum.str() << "\"\n";
+    os << "}\n";
+    os.flush();
+}
+
+int main(int argc, char** argv)
+{
+    boost::program_options::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("level", boost::program_options::value<std::string>(), "level file to load")
+        ("turns", boost::program_options::value<uint32_t>()->default_value(1000), "number of turns to compute")
+        ("ai", boost::program_options::value<std::string>()->default_value("normal"), "keeper AI given to every seat (easy or normal)")
+        ("threads", boost::program_options::value<uint32_t>()->default_value(0), "number of threads used for the upkeep (0 for the number of hardware threads)")
+    ;
+    ResourceManager::buildCommandOptions(desc);
+    boost::program_options::positional_options_description positional;
+    positional.add("level", 1);
+
+    boost::program_options::variables_map options;
+    try
+    {
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv)
+            .options(desc).positional(positional).run(), options);
+        boost::program_options::notify(options);
+    }
+    catch(const boost::program_options::error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if((options.count("help") > 0) || (options.count("level") == 0))
+    {
+        std::cerr << "Usage: " << argv[0] << " [options] map.level\n" << desc << std::endl;
+        return 1;
+    }
+
+    const std::string& levelFilename = options["level"].as<std::string>();
+    uint32_t nbTurns = options["turns"].as<uint32_t>();
+
+    ResourceManager resMgr(options);
+
+    // The results are written to stdout so, unless asked otherwise, only warnings and errors are logged
+    LogManager logMgr;
+    logMgr.addSink(std::unique_ptr<LogSink>(new LogSinkConsole()));
+    if(options.count("loglevel") > 0)
+        logMgr.setLevel(resMgr.getLogLevel());
+    else
+        logMgr.setLevel(LogMessageLevel::WARNING);
+
+    KeeperAIType aiType = KeeperAITypes::fromString(options["ai"].as<std::string>());
+    if(aiType >= KeeperAIType::nbAI)
+        return 1;
+
+    uint64_t seed = resMgr.getForcedRandomSeed();
+    if(seed == 0)
+        seed = DEFAULT_SEED;
+    Random::initialize(seed);
+
+    ConfigManager configManager(resMgr.getConfigPath(), "", resMgr.getSoundPath());
+
+    // The game code queues its notifications to the server. As long as it is not started, they are dropped
+    ODServer server;
+
+    GameMap gameMap(true);
+    gameMap.setNbThreads(options["threads"].as<uint32_t>());
+    // In lockstep mode, the state checksum is computed at the end of each turn
+    gameMap.setLockstep(true);
+    if(!gameMap.loadLevel(levelFilename))
+    {
+        std::cerr << levelFilename << ": cannot load level" << std::endl;
+        return 1;
+    }
+
+    startGame(gameMap, aiType);
+
+    // Only the turns are measured, not the level loading
+    gameMap.resetTurnTimings();
+    uint64_t nbPathCallsAtStart = gameMap.getNumCallsToPath();
+    uint64_t nbFlowFieldHitsAtStart = gameMap.getFlowFieldCache().getNbHits();
+    uint64_t nbFlowFieldMissesAtStart = gameMap.getFlowFieldCache().getNbMisses();
+
+    double timeSinceLastTurn = 1.0 / ODApplication::turnsPerSecond;
+    std::vector<double> turnMillis;
+    turnMillis.reserve(nbTurns);
+    Clock::time_point start = Clock::now();
+    for(uint32_t turn = 0; turn < nbTurns; ++turn)
+    {
+        Clock::time_point turnStart = Clock::now();
+        computeTurn(gameMap, timeSinceLastTurn);
+        turnMillis.push_back(toMillis(Clock::now() - turnStart));
+    }
+    double totalMillis = toMillis(Clock::now() - start);
+
+    writeResults(std::cout, levelFilename, seed, aiType, gameMap, turnMillis, totalMillis,
+        gameMap.getNumCallsToPath() - nbPathCallsAtStart,
+        gameMap.getFlowFieldCache().getNbHits() - nbFlowFieldHitsAtStart,
+        gameMap.getFlowFieldCache().getNbMisses() - nbFlowFieldMissesAtStart);
+
+    return 0;
+}
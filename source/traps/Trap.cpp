@@ -246,6 +246,8 @@ void Trap::activate(Tile* tile)
 
     TrapTileData* trapTileData = static_cast<TrapTileData*>(mTileData[tile]);
     trapTileData->setActivated(true);
+    // Some traps (like doors) only block vision when activated
+    getGameMap()->getVisionMap().tileVisionChanged(*tile);
     trapTileData->setNbShootsBeforeDeactivation(mNbShootsBeforeDeactivation);
     trapTileData->setReloadTime(0);
 
@@ -263,6 +265,7 @@ void Trap::deactivate(Tile* tile)
 
     TrapTileData* trapTileData = static_cast<TrapTileData*>(mTileData[tile]);
     trapTileData->setActivated(false);
+    getGameMap()->getVisionMap().tileVisionChanged(*tile);
 
     BuildingObject* entity = getBuildingObjectFromTile(tile);
     if (entity == nullptr)
@@ -273,7 +276,7 @@ void Trap::deactivate(Tile* tile)
 
 bool Trap::isActivated(Tile* tile) const
 {
-    std::map<Tile*, TileData*>::const_iterator it = mTileData.find(tile);
+    std::map<Tile*, TileData*, TilePositionLess>::const_iterator it = mTileData.find(tile);
     if (it == mTileData.end())
         return false;
 
@@ -648,7 +651,8 @@ void Trap::fireTrapSound(Tile& tile, const std::string& soundFamily)
 
         ServerNotification *serverNotification = new ServerNotification(
             ServerNotificationType::playSpatialSound, seat->getPlayer());
-        serverNotification->mPacket << sound << tile.getX() << tile.getY();
+        uint32_t soundId = ODServer::getSingleton().internString(sound);
+        serverNotification->mPacket << soundId << tile.getX() << tile.getY();
         ODServer::getSingleton().queueServerNotification(serverNotification);
     }
 }
@@ -134,14 +134,19 @@ TrapCannon::TrapCannon(GameMap* gameMap) :
 
 bool TrapCannon::shoot(Tile* tile)
 {
-    std::vector<Tile*> visibleTiles = getGameMap()->visibleTiles(tile->getX(), tile->getY(), mRange);
+    // No need to compute the line of sight if there is no enemy around
+    if(!getGameMap()->mayHaveForceAround(tile, static_cast<int>(mRange), getSeat(), true, false))
+        return false;
+
+    std::vector<Tile*> visibleTiles;
+    getGameMap()->visibleTiles(tile->getX(), tile->getY(), mRange, visibleTiles);
     std::vector<GameEntity*> enemyObjects = getGameMap()->getVisibleCreatures(visibleTiles, getSeat(), true);
 
     if(enemyObjects.empty())
         return false;
 
     // Select an enemy to shoot at.
-    GameEntity* targetEnemy = enemyObjects[Random::Uint(0, enemyObjects.size()-1)];
+    GameEntity* targetEnemy = enemyObjects[Random::getStream(Random::Subsystem::trap).Uint(0, enemyObjects.size()-1)];
 
     // Create the cannonball to move toward the enemy creature.
     Ogre::Vector3 direction(static_cast<Ogre::Real>(targetEnemy->getCoveredTile(0)->getX()),
@@ -156,7 +161,7 @@ bool TrapCannon::shoot(Tile* tile)
     direction.normalise();
     MissileOneHit* missile = new MissileOneHit(getGameMap(), getSeat(), getName(), "Cannonball",
         "", direction, ConfigManager::getSingleton().getTrapConfigDouble("CannonSpeed"),
-        Random::Double(mMinDamage, mMaxDamage), 0.0, 0.0, nullptr, false, false, true);
+        Random::getStream(Random::Subsystem::trap).Double(mMinDamage, mMaxDamage), 0.0, 0.0, nullptr, false, false, true);
     missile->addToGameMap();
     missile->createMesh();
     missile->setPosition(position);
@@ -168,7 +173,8 @@ bool TrapCannon::shoot(Tile* tile)
     ServerNotification *serverNotification = new ServerNotification(
         ServerNotificationType::orientEntity, nullptr);
 
-    serverNotification->mPacket << savedTrapEntityName;
+    uint32_t nameId = ODServer::getSingleton().internString(savedTrapEntityName);
+    serverNotification->mPacket << nameId;
     serverNotification->mPacket << direction;    
     ODServer::getSingleton().queueServerNotification(serverNotification);
 
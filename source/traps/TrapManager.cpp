@@ -34,6 +34,8 @@
 #include "utils/Helper.h"
 #include "utils/LogManager.h"
 
+#include <algorithm>
+
 static const std::string EMPTY_STRING;
 
 namespace
@@ -549,7 +551,9 @@ void TrapManager::sellTrapTiles(GameMap* gameMap, Seat* seatSell, ODPacket& pack
     uint32_t nbTiles;
     OD_ASSERT_TRUE(packet >> nbTiles);
     int32_t price = 0;
-    std::set<Trap*> traps;
+    // The traps are kept in the order of the tiles so that they are updated the same way whatever
+    // their address
+    std::vector<Trap*> traps;
     std::vector<Tile*> tiles;
     while(nbTiles > 0)
     {
@@ -575,7 +579,8 @@ void TrapManager::sellTrapTiles(GameMap* gameMap, Seat* seatSell, ODPacket& pack
 
         price += costPerTile(trap->getType()) / 2;
         tiles.push_back(tile);
-        traps.insert(trap);
+        if(std::find(traps.begin(), traps.end(), trap) == traps.end())
+            traps.push_back(trap);
     }
 
     gameMap->addGoldToSeat(price, seatSell->getId());
@@ -669,7 +674,9 @@ void TrapManager::sellTrapTilesEditor(GameMap* gameMap, ODPacket& packet)
 {
     uint32_t nbTiles;
     OD_ASSERT_TRUE(packet >> nbTiles);
-    std::set<Trap*> traps;
+    // The traps are kept in the order of the tiles so that they are updated the same way whatever
+    // their address
+    std::vector<Trap*> traps;
     std::vector<Tile*> tiles;
     while(nbTiles > 0)
     {
@@ -691,7 +698,8 @@ void TrapManager::sellTrapTilesEditor(GameMap* gameMap, ODPacket& packet)
         }
 
         tiles.push_back(tile);
-        traps.insert(trap);
+        if(std::find(traps.begin(), traps.end(), trap) == traps.end())
+            traps.push_back(trap);
     }
 
     // We notify the clients with vision of the changed tiles. Note that we need
@@ -135,14 +135,14 @@ bool TrapSpike::shoot(Tile* tile)
     for(GameEntity* target : enemyCreatures)
     {
         Tile* tile = target->getCoveredTile(0);
-        target->takeDamage(this, 0.0, Random::Double(mMinDamage, mMaxDamage), 0.0, 0.0, tile, false);
+        target->takeDamage(this, 0.0, Random::getStream(Random::Subsystem::trap).Double(mMinDamage, mMaxDamage), 0.0, 0.0, tile, false);
         target->notifyFightPlayer(tile);
     }
     std::vector<GameEntity*> alliedCreatures = getGameMap()->getVisibleCreatures(visibleTiles, getSeat(), false);
     for(GameEntity* target : alliedCreatures)
     {
         Tile* tile = target->getCoveredTile(0);
-        target->takeDamage(this, 0.0, Random::Double(mMinDamage, mMaxDamage), 0.0, 0.0, tile, false);
+        target->takeDamage(this, 0.0, Random::getStream(Random::Subsystem::trap).Double(mMinDamage, mMaxDamage), 0.0, 0.0, tile, false);
         target->notifyFightPlayer(tile);
     }
     return true;
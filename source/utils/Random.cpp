@@ -27,84 +27,169 @@
 #include <cmath>
 #include <ctime>
 
-unsigned long myRandomSeed;
-const unsigned long MAX = 32768;
+//! \brief Weyl sequence increment used by SplitMix64
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
 
-static unsigned long randgen()
-{
-    myRandomSeed = myRandomSeed * 1103515245 + 12345;
-    //TODO: What is the purpose of the cast?
-    unsigned long returnVal = static_cast<unsigned int>(myRandomSeed / 65536) % MAX;
+static uint64_t sessionSeed = 0;
+static RandomStream subsystemStreams[static_cast<uint32_t>(Random::Subsystem::nb)];
 
-    return returnVal;
+//! \brief SplitMix64 finalizer
+static inline uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
-//! \brief uniformly distributed number [0;1)
-static double uniform()
+//! \brief uniformly distributed number [0;1) from the 53 high bits of value
+static inline double toUniform(uint64_t value)
 {
-    return randgen() * 1.0 / static_cast<double>(MAX);
+    return static_cast<double>(value >> 11) * (1.0 / 9007199254740992.0);
 }
 
-//! \brief uniformly distributed number [lo;hi)
-static double uniform(double lo, double hi)
+RandomStream::RandomStream(uint64_t seed, uint64_t streamId) :
+    mKey(mix64(seed + mix64(streamId + GOLDEN_GAMMA))),
+    mCounter(0)
 {
-    return uniform() * (hi - lo) + lo;
 }
 
-//! \brief random integer [lo;hi]
-static int randint(int lo, int hi)
+uint32_t RandomStream::next()
 {
-    return static_cast<int>(uniform() * (hi - lo + 1) + lo);
+    ++mCounter;
+    return static_cast<uint32_t>(mix64(mKey + mCounter * GOLDEN_GAMMA) >> 32);
 }
 
-//! \brief random unsigned integer [lo;hi]
-static unsigned int randuint(unsigned int lo, unsigned int hi)
+double RandomStream::uniform()
 {
-    return static_cast<unsigned int>(uniform() * (hi - lo + 1) + lo);
+    ++mCounter;
+    return toUniform(mix64(mKey + mCounter * GOLDEN_GAMMA));
 }
 
-
-namespace Random
+double RandomStream::Double(double min, double max)
 {
+    if (min > max)
+    {
+        std::swap(min, max);
+    }
 
-void initialize()
-{
-    myRandomSeed = static_cast<unsigned long>(std::time(0));
+    return uniform() * (max - min) + min;
 }
 
-double Double(double min, double max)
+int RandomStream::Int(int min, int max)
 {
     if (min > max)
     {
         std::swap(min, max);
     }
 
-    return uniform(min, max);
+    // We floor before adding min because casting truncates towards 0 and min would never be returned if negative
+    return static_cast<int>(std::floor(uniform() * (static_cast<double>(max) - min + 1))) + min;
 }
 
-int Int(int min, int max)
+unsigned int RandomStream::Uint(unsigned int min, unsigned int max)
 {
     if (min > max)
     {
         std::swap(min, max);
     }
 
-    return randint(min, max);
+    return static_cast<unsigned int>(uniform() * (max - min + 1) + min);
 }
 
-unsigned int Uint(unsigned int min, unsigned int max)
+double RandomStream::gaussianRandomDouble()
+{
+    return std::sqrt(-2.0 * log(Double(0.0, 1.0))) * cos(2.0 * PI * Double(0.0, 1.0));
+}
+
+void RandomStream::fillUint(uint32_t* values, uint32_t count)
+{
+    // Each value only depends on its counter so there is no dependency between iterations
+    uint64_t key = mKey;
+    uint64_t counter = mCounter;
+    for(uint32_t i = 0; i < count; ++i)
+        values[i] = static_cast<uint32_t>(mix64(key + (counter + i + 1) * GOLDEN_GAMMA) >> 32);
+
+    mCounter += count;
+}
+
+void RandomStream::fillDouble(double* values, uint32_t count, double min, double max)
 {
     if (min > max)
     {
         std::swap(min, max);
     }
 
-    return randuint(min, max);
+    uint64_t key = mKey;
+    uint64_t counter = mCounter;
+    double range = max - min;
+    for(uint32_t i = 0; i < count; ++i)
+        values[i] = toUniform(mix64(key + (counter + i + 1) * GOLDEN_GAMMA)) * range + min;
+
+    mCounter += count;
+}
+
+namespace Random
+{
+
+void initialize()
+{
+    initialize(static_cast<uint64_t>(std::time(0)));
+}
+
+void initialize(uint64_t seed)
+{
+    sessionSeed = seed;
+    for(uint32_t i = 0; i < static_cast<uint32_t>(Subsystem::nb); ++i)
+        subsystemStreams[i] = createStream(static_cast<Subsystem>(i), 0);
+}
+
+uint64_t getSessionSeed()
+{
+    return sessionSeed;
+}
+
+RandomStream createStream(Subsystem subsystem, uint64_t id)
+{
+    // The subsystem is mixed in first so that ids of different subsystems do not collide
+    uint64_t streamId = mix64(static_cast<uint64_t>(subsystem) + GOLDEN_GAMMA) ^ id;
+    return RandomStream(sessionSeed, streamId);
+}
+
+RandomStream createStream(Subsystem subsystem, const std::string& name)
+{
+    // FNV-1a hash of the name
+    uint64_t id = 0xcbf29ce484222325ULL;
+    for(char c : name)
+    {
+        id ^= static_cast<uint8_t>(c);
+        id *= 0x100000001b3ULL;
+    }
+    return createStream(subsystem, id);
+}
+
+RandomStream& getStream(Subsystem subsystem)
+{
+    return subsystemStreams[static_cast<uint32_t>(subsystem)];
+}
+
+double Double(double min, double max)
+{
+    return getStream(Subsystem::global).Double(min, max);
+}
+
+int Int(int min, int max)
+{
+    return getStream(Subsystem::global).Int(min, max);
+}
+
+unsigned int Uint(unsigned int min, unsigned int max)
+{
+    return getStream(Subsystem::global).Uint(min, max);
 }
 
 double gaussianRandomDouble()
 {
-    return std::sqrt(-2.0 * log(Double(0.0, 1.0))) * cos(2.0 * PI * Double(0.0, 1.0));
+    return getStream(Subsystem::global).gaussianRandomDouble();
 }
 
 } // namespace Random
@@ -23,11 +23,90 @@
 #ifndef RANDOM_H_
 #define RANDOM_H_
 
+#include <cstdint>
+#include <string>
+
+/*! \brief Counter based random number stream.
+ *
+ * The n-th value of a stream only depends on the stream key and on n. It allows to have independent
+ * streams for each seat, creature, ... that give the same values whatever the order they are used in
+ * and to generate many values at once (see fillUint/fillDouble) without a dependency between them.
+ * Values are generated by hashing the counter with the SplitMix64 finalizer.
+ */
+class RandomStream
+{
+public:
+    RandomStream() :
+        mKey(0),
+        mCounter(0)
+    {}
+
+    RandomStream(uint64_t seed, uint64_t streamId);
+
+    //! \brief Returns a uniformly distributed 32 bits value
+    uint32_t next();
+
+    //! \brief Same as the functions in the Random namespace but using this stream
+    double Double(double min, double max);
+    int Int(int min, int max);
+    unsigned int Uint(unsigned int min, unsigned int max);
+    double gaussianRandomDouble();
+
+    //! \brief Fills values with the next count values. Gives the same values as calling next count times
+    void fillUint(uint32_t* values, uint32_t count);
+
+    //! \brief Fills values with the next count values of Double(min, max)
+    void fillDouble(double* values, uint32_t count, double min, double max);
+
+    //! \brief Number of values already generated. Can be used to check two streams are in the same state
+    inline uint64_t getCounter() const
+    { return mCounter; }
+
+private:
+    uint64_t mKey;
+    uint64_t mCounter;
+
+    //! \brief uniformly distributed number [0;1)
+    double uniform();
+};
+
 namespace Random
 {
-    //! \brief initializes the semaphore and seeds the generator
+    //! \brief Subsystems having their own streams. The id given to createStream allows
+    //! to have one stream for each seat, creature, ... of the subsystem
+    enum class Subsystem : uint32_t
+    {
+        global, // Used by the functions in this namespace
+        creature, // One stream per creature (id = name)
+        keeperAI, // One stream per seat (id = seat id)
+        room, // Shared by the rooms (see getStream)
+        trap, // Shared by the traps (see getStream)
+        client, // Client side effects like sounds (see getStream)
+        nb
+    };
+
+    //! \brief seeds the generator with the current time
     void initialize();
 
+    //! \brief seeds the generator with the given session seed. Every stream is derived from it so
+    //! using the same seed gives the same values. The server sends its session seed to the clients
+    void initialize(uint64_t sessionSeed);
+
+    uint64_t getSessionSeed();
+
+    //! \brief Creates the stream of the given subsystem with the given id from the session seed
+    RandomStream createStream(Subsystem subsystem, uint64_t id);
+    RandomStream createStream(Subsystem subsystem, const std::string& name);
+
+    /*! \brief Stream shared by the given subsystem, created with id 0 by initialize. The client stream
+     * should only be used by the rendering thread and the other ones by the server thread. That way,
+     * when the game is hosted, what the client draws does not change the values the server gets.
+     */
+    RandomStream& getStream(Subsystem subsystem);
+
+    // The following functions use the global stream. Like the other server streams, they should
+    // not be used by client side code
+
     /*! \brief generate a random double
      *
      *  \param min, max One or both can be negative
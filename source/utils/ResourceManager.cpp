@@ -87,6 +87,8 @@ const std::string ResourceManager::RESOURCEGROUPSOUND = "Sound";
 ResourceManager::ResourceManager(boost::program_options::variables_map& options) :
         mServerMode(false),
         mForcedNetworkPort(-1),
+        mForcedRandomSeed(0),
+        mLockstepMode(false),
         mLogLevel(LogMessageLevel::NORMAL),
         mGameDataPath("./"),
         mUserDataPath("./"),
@@ -438,6 +440,12 @@ void ResourceManager::setupUserDataFolders(boost::program_options::variables_map
     if(itOption != options.end())
         mForcedNetworkPort = itOption->second.as<int32_t>();
 
+    itOption = options.find("seed");
+    if(itOption != options.end())
+        mForcedRandomSeed = itOption->second.as<uint64_t>();
+
+    mLockstepMode = (options.find("lockstep") != options.end());
+
     itOption = options.find("loglevel");
     if(itOption != options.end())
         mLogLevel = static_cast<LogMessageLevel>(itOption->second.as<int32_t>());
@@ -599,6 +607,8 @@ void ResourceManager::buildCommandOptions(boost::program_options::options_descri
         ("appData", boost::program_options::value<std::string>(), "Sets appData to the given path (where logs, replays, ... are saved)")
         ("mscreator", boost::program_options::value<std::string>(), "Sets the creator for this map to connect to the master server. server/servercustom/serversave option needs to be on")
         ("port", boost::program_options::value<int32_t>(), "Sets the port used. Note that the port is used for both single and multi player")
+        ("seed", boost::program_options::value<uint64_t>(), "Sets the random seed of the games launched by this server. By default, the current time is used")
+        ("lockstep", "Runs the games launched by this server in lockstep mode: fixed turn length and state checksums sent to the clients")
         ("loglevel", boost::program_options::value<int32_t>(), "Sets the log level (between 0=Trivial and 3=Critical)")
     ;
 }
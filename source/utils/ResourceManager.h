@@ -148,6 +148,14 @@ public:
     inline int32_t getForcedNetworkPort() const
     { return mForcedNetworkPort; }
 
+    //! \brief Session seed given on the command line. 0 if not forced
+    inline uint64_t getForcedRandomSeed() const
+    { return mForcedRandomSeed; }
+
+    //! \brief True if the games launched by this server should run in lockstep mode (see GameMap::setLockstep)
+    inline bool isLockstepMode() const
+    { return mLockstepMode; }
+
     inline LogMessageLevel getLogLevel() const
     { return mLogLevel; }
 
@@ -160,6 +168,11 @@ private:
     //! \brief used when the network port is forced
     int32_t mForcedNetworkPort;
 
+    //! \brief used when the random seed is forced
+    uint64_t mForcedRandomSeed;
+
+    bool mLockstepMode;
+
     //! \brief The log level
     LogMessageLevel mLogLevel;
 
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*! \brief Bounded lock free queue between exactly one producer thread and one consumer thread.
+ *
+ * push should only be called by the producer and pop/front by the consumer. The capacity is
+ * rounded up to a power of 2. When the queue is full, push fails and the producer has to decide
+ * what to do with the value (keep it and retry later, drop it, ...). Values are moved in and out
+ * of the ring so T only needs to be default constructible and movable.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    SpscQueue(uint32_t capacity) :
+        mHead(0),
+        mTail(0)
+    {
+        uint32_t size = 1;
+        while(size < capacity)
+            size <<= 1;
+
+        mSlots.resize(size);
+        mMask = size - 1;
+    }
+
+    inline uint32_t capacity() const
+    { return mMask + 1; }
+
+    //! \brief Number of values in the queue. Exact only when called from the producer or the consumer
+    //! while the other is not running. Otherwise, it is a snapshot that can be used for statistics
+    inline uint32_t size() const
+    { return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire); }
+
+    inline bool empty() const
+    { return size() == 0; }
+
+    //! \brief Producer side. Returns false (and leaves value untouched) if the queue is full
+    bool push(T& value)
+    {
+        uint32_t tail = mTail.load(std::memory_order_relaxed);
+        if(tail - mHead.load(std::memory_order_acquire) > mMask)
+            return false;
+
+        mSlots[tail & mMask] = std::move(value);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Consumer side. Returns false if the queue is empty
+    bool pop(T& value)
+    {
+        uint32_t head = mHead.load(std::memory_order_relaxed);
+        if(head == mTail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(mSlots[head & mMask]);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Consumer side. Returns the next value without removing it or nullptr if the queue is empty
+    T* front()
+    {
+        uint32_t head = mHead.load(std::memory_order_relaxed);
+        if(head == mTail.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &mSlots[head & mMask];
+    }
+
+private:
+    std::vector<T> mSlots;
+    uint32_t mMask;
+    //! \brief Head is only written by the consumer and tail by the producer. They are kept on
+    //! different cache lines so that both threads do not keep invalidating each other. We pad
+    //! instead of using alignas so that the queue can be allocated with new in C++11
+    char mPaddingHead[64];
+    std::atomic<uint32_t> mHead;
+    char mPaddingTail[64];
+    std::atomic<uint32_t> mTail;
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t nbThreads) :
+    mGeneration(0),
+    mNbWorkersBusy(0),
+    mIsStopping(false),
+    mFunc(nullptr),
+    mCount(0),
+    mChunkSize(1)
+{
+    if(nbThreads == 0)
+        nbThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(uint32_t i = 0; i < nbThreads; ++i)
+        mWorkQueues.emplace_back(new WorkQueue());
+
+    // The calling thread is thread 0
+    for(uint32_t i = 1; i < nbThreads; ++i)
+        mThreads.emplace_back(&ThreadPool::workerThread, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mWorkAvailable.notify_all();
+
+    for(std::thread& thread : mThreads)
+        thread.join();
+}
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t chunkSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+    if(count == 0)
+        return;
+
+    chunkSize = std::max(1u, chunkSize);
+    uint32_t nbChunks = (count + chunkSize - 1) / chunkSize;
+    if(mThreads.empty() || (nbChunks == 1))
+    {
+        for(uint32_t index = 0; index < count; ++index)
+            func(index, 0);
+        return;
+    }
+
+    // The workers are waiting so nobody else uses the queues
+    uint32_t nbThreads = getNbThreads();
+    for(uint32_t i = 0; i < nbThreads; ++i)
+    {
+        WorkQueue& queue = *mWorkQueues[i];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        queue.mBegin = static_cast<uint32_t>(static_cast<uint64_t>(nbChunks) * i / nbThreads);
+        queue.mEnd = static_cast<uint32_t>(static_cast<uint64_t>(nbChunks) * (i + 1) / nbThreads);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFunc = &func;
+        mCount = count;
+        mChunkSize = chunkSize;
+        mNbWorkersBusy = static_cast<uint32_t>(mThreads.size());
+        ++mGeneration;
+    }
+    mWorkAvailable.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this]() { return mNbWorkersBusy == 0; });
+    mFunc = nullptr;
+}
+
+void ThreadPool::workerThread(uint32_t threadIndex)
+{
+    uint64_t generation = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [this, generation]() { return mIsStopping || (mGeneration != generation); });
+            if(mIsStopping)
+                return;
+
+            generation = mGeneration;
+        }
+
+        runChunks(threadIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mNbWorkersBusy;
+        }
+        mWorkDone.notify_one();
+    }
+}
+
+void ThreadPool::runChunks(uint32_t threadIndex)
+{
+    do
+    {
+        uint32_t chunk;
+        while(popChunk(threadIndex, chunk))
+        {
+            uint32_t begin = chunk * mChunkSize;
+            uint32_t end = std::min(mCount, begin + mChunkSize);
+            for(uint32_t index = begin; index < end; ++index)
+                (*mFunc)(index, threadIndex);
+        }
+    } while(stealChunks(threadIndex));
+}
+
+bool ThreadPool::popChunk(uint32_t threadIndex, uint32_t& chunk)
+{
+    WorkQueue& queue = *mWorkQueues[threadIndex];
+    std::lock_guard<std::mutex> lock(queue.mMutex);
+    if(queue.mBegin >= queue.mEnd)
+        return false;
+
+    chunk = queue.mBegin;
+    ++queue.mBegin;
+    return true;
+}
+
+bool ThreadPool::stealChunks(uint32_t threadIndex)
+{
+    uint32_t nbThreads = getNbThreads();
+    for(uint32_t offset = 1; offset < nbThreads; ++offset)
+    {
+        WorkQueue& victim = *mWorkQueues[(threadIndex + offset) % nbThreads];
+        uint32_t begin;
+        uint32_t end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mMutex);
+            if(victim.mBegin >= victim.mEnd)
+                continue;
+
+            // We take the second half (rounded up so that the last chunk can be stolen)
+            end = victim.mEnd;
+            begin = victim.mEnd - (victim.mEnd - victim.mBegin + 1) / 2;
+            victim.mEnd = begin;
+        }
+
+        // Our queue is empty so we can replace it. Only 1 lock is held at a time to avoid deadlocks
+        WorkQueue& queue = *mWorkQueues[threadIndex];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        queue.mBegin = begin;
+        queue.mEnd = end;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright (C) 2011-2016  OpenDungeons Team
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! \brief Pool of worker threads running loops in parallel (see parallelFor).
+ *
+ * The loop is split in chunks. Each thread starts with its own contiguous part of the chunks and,
+ * once done, steals half of what is left to another thread. The calling thread takes part in the
+ * loop as thread 0 so a pool with 1 thread runs everything in the caller.
+ * Because the chunks are not processed by the same thread or in the same order from one run to
+ * another, the loop body should only write data owned by its index (or working buffers owned by
+ * its thread index) for the result to be deterministic.
+ */
+class ThreadPool
+{
+public:
+    //! \brief nbThreads includes the calling thread. If 0, the number of hardware threads is used
+    ThreadPool(uint32_t nbThreads = 0);
+    ~ThreadPool();
+
+    inline uint32_t getNbThreads() const
+    { return static_cast<uint32_t>(mWorkQueues.size()); }
+
+    /*! \brief Calls func(index, threadIndex) for every index in [0, count) and returns once every call
+     * is done. The indexes are given to the threads by chunks of chunkSize. threadIndex is in
+     * [0, getNbThreads()). Should not be called from func.
+     */
+    void parallelFor(uint32_t count, uint32_t chunkSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+private:
+    //! \brief Chunks [mBegin, mEnd) not processed yet. The owner takes them from the front and the
+    //! other threads steal from the back
+    struct WorkQueue
+    {
+        WorkQueue() :
+            mBegin(0),
+            mEnd(0)
+        {}
+
+        std::mutex mMutex;
+        uint32_t mBegin;
+        uint32_t mEnd;
+    };
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::vector<std::unique_ptr<WorkQueue>> mWorkQueues;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    //! \brief Incremented for each loop so that the workers know when there is a new one
+    uint64_t mGeneration;
+    uint32_t mNbWorkersBusy;
+    bool mIsStopping;
+
+    //! \brief Loop being run. Set before the workers are woken up
+    const std::function<void(uint32_t, uint32_t)>* mFunc;
+    uint32_t mCount;
+    uint32_t mChunkSize;
+
+    void workerThread(uint32_t threadIndex);
+
+    //! \brief Processes the chunks of the given thread and steals from the others until there is nothing left
+    void runChunks(uint32_t threadIndex);
+
+    bool popChunk(uint32_t threadIndex, uint32_t& chunk);
+
+    //! \brief Moves half of the chunks left to another thread to the given thread. Returns false if
+    //! there was nothing to steal
+    bool stealChunks(uint32_t threadIndex);
+};
+
+#endif // THREADPOOL_H